@@ -22,6 +22,7 @@
 #include <fstream>
 #include "Vocab.h"
 #include "PhraseNode.h"
+#include "util/mmap.hh"
 
 namespace OnDiskPt
 {
@@ -39,6 +40,10 @@ protected:
   int m_numSourceFactors, m_numTargetFactors, m_numScores;
   std::fstream m_fileMisc, m_fileVocab, m_fileSource, m_fileTarget, m_fileTargetInd, m_fileTargetColl;
 
+  // read-only mappings of Source.dat, TargetInd.dat & TargetColl.dat when loading.
+  // Nodes and rules are decoded straight from these, so a loaded table can be shared between threads
+  util::scoped_memory m_memSource, m_memTargetInd, m_memTargetColl;
+
   size_t m_defaultNodeSize;
   PhraseNode *m_rootSourceNode;
 
@@ -46,6 +51,7 @@ protected:
 
   void SaveMisc();
   bool OpenForLoad(const std::string &filePath);
+  void MapForLoad(const std::string &path, util::scoped_memory &mem);
   bool LoadMisc();
 
 public:
@@ -83,6 +89,19 @@ public:
     return m_fileVocab;
   }
 
+  const char *GetMemSource() const {
+    return static_cast<const char*>(m_memSource.get());
+  }
+  size_t GetMemSourceSize() const {
+    return m_memSource.size();
+  }
+  const char *GetMemTargetInd() const {
+    return static_cast<const char*>(m_memTargetInd.get());
+  }
+  const char *GetMemTargetColl() const {
+    return static_cast<const char*>(m_memTargetColl.get());
+  }
+
   size_t GetNumSourceFactors() const {
     return m_numSourceFactors;
   }
@@ -45,46 +45,35 @@ PhraseNode::PhraseNode()
 {
 }
 
-PhraseNode::PhraseNode(uint64_t filePos, OnDiskWrapper &onDiskWrapper)
+PhraseNode::PhraseNode(uint64_t filePos, const OnDiskWrapper &onDiskWrapper)
   :m_counts(onDiskWrapper.GetNumCounts())
 {
-  // load saved node
+  // load saved node. Nothing is copied, the node is read in place from the mapped file
   m_filePos = filePos;
 
   size_t countSize = onDiskWrapper.GetNumCounts();
 
-  std::fstream &file = onDiskWrapper.GetFileSource();
-  file.seekg(filePos);
-  assert(filePos == (uint64_t)file.tellg());
+  UTIL_THROW_IF2(filePos + sizeof(uint64_t) * 2 > onDiskWrapper.GetMemSourceSize(),
+                 "Source node at " << filePos << " is outside Source.dat");
+  m_memLoad = onDiskWrapper.GetMemSource() + filePos;
 
-  file.read((char*) &m_numChildrenLoad, sizeof(uint64_t));
+  const uint64_t *memArray = (const uint64_t*) m_memLoad;
+  m_numChildrenLoad = memArray[0];
+  m_value = memArray[1];
 
   size_t memAlloc = GetNodeSize(m_numChildrenLoad, onDiskWrapper.GetSourceWordSize(), countSize);
-  m_memLoad = (char*) malloc(memAlloc);
-
-  // go to start of node again
-  file.seekg(filePos);
-  assert(filePos == (uint64_t)file.tellg());
-
-  // read everything into memory
-  file.read(m_memLoad, memAlloc);
-  assert(filePos + memAlloc == (uint64_t)file.tellg());
-
-  // get value
-  m_value = ((uint64_t*)m_memLoad)[1];
+  UTIL_THROW_IF2(filePos + memAlloc > onDiskWrapper.GetMemSourceSize(),
+                 "Source node at " << filePos << " is truncated");
 
   // get counts
-  float *memFloat = (float*) (m_memLoad + sizeof(uint64_t) * 2);
+  const float *memFloat = (const float*) (m_memLoad + sizeof(uint64_t) * 2);
 
   assert(countSize == 1);
   m_counts[0] = memFloat[0];
-
-  m_memLoadLast = m_memLoad + memAlloc;
 }
 
 PhraseNode::~PhraseNode()
 {
-  free(m_memLoad);
 }
 
 float PhraseNode::GetCount(size_t ind) const
@@ -194,7 +183,7 @@ void PhraseNode::AddTargetPhrase(size_t pos, const SourcePhrase &sourcePhrase
   }
 }
 
-const PhraseNode *PhraseNode::GetChild(const Word &wordSought, OnDiskWrapper &onDiskWrapper) const
+const PhraseNode *PhraseNode::GetChild(const Word &wordSought, const OnDiskWrapper &onDiskWrapper) const
 {
   const PhraseNode *ret = NULL;
 
@@ -222,13 +211,13 @@ const PhraseNode *PhraseNode::GetChild(const Word &wordSought, OnDiskWrapper &on
   return ret;
 }
 
-void PhraseNode::GetChild(Word &wordFound, uint64_t &childFilePos, size_t ind, OnDiskWrapper &onDiskWrapper) const
+void PhraseNode::GetChild(Word &wordFound, uint64_t &childFilePos, size_t ind, const OnDiskWrapper &onDiskWrapper) const
 {
 
   size_t wordSize = onDiskWrapper.GetSourceWordSize();
   size_t childSize = wordSize + sizeof(uint64_t);
 
-  char *currMem = m_memLoad
+  const char *currMem = m_memLoad
                   + sizeof(uint64_t) * 2 // size & file pos of target phrase coll
                   + sizeof(float) * onDiskWrapper.GetNumCounts() // count info
                   + childSize * ind;
@@ -251,7 +240,7 @@ size_t PhraseNode::ReadChild(Word &wordFound, uint64_t &childFilePos, const char
 
 TargetPhraseCollection::shared_ptr
 PhraseNode::
-GetTargetPhraseCollection(size_t tableLimit, OnDiskWrapper &onDiskWrapper) const
+GetTargetPhraseCollection(size_t tableLimit, const OnDiskWrapper &onDiskWrapper) const
 {
   TargetPhraseCollection::shared_ptr ret(new TargetPhraseCollection);
   if (m_value > 0) ret->ReadFromFile(tableLimit, m_value, onDiskWrapper);
@@ -47,20 +47,21 @@ protected:
 
   TargetPhraseCollection m_targetPhraseColl;
 
-  char *m_memLoad, *m_memLoadLast;
+  // points into the mapped Source.dat of the wrapper the node was loaded from
+  const char *m_memLoad;
   uint64_t m_numChildrenLoad;
 
   void AddTargetPhrase(size_t pos, const SourcePhrase &sourcePhrase
                        , TargetPhrase *targetPhrase, OnDiskWrapper &onDiskWrapper
                        , size_t tableLimit, const std::vector<float> &counts, OnDiskPt::PhrasePtr spShort);
   size_t ReadChild(Word &wordFound, uint64_t &childFilePos, const char *mem) const;
-  void GetChild(Word &wordFound, uint64_t &childFilePos, size_t ind, OnDiskWrapper &onDiskWrapper) const;
+  void GetChild(Word &wordFound, uint64_t &childFilePos, size_t ind, const OnDiskWrapper &onDiskWrapper) const;
 
 public:
   static size_t GetNodeSize(size_t numChildren, size_t wordSize, size_t countSize);
 
   PhraseNode(); // unsaved node
-  PhraseNode(uint64_t filePos, OnDiskWrapper &onDiskWrapper); // load saved node
+  PhraseNode(uint64_t filePos, const OnDiskWrapper &onDiskWrapper); // load saved node
   ~PhraseNode();
 
   void Add(const Word &word, uint64_t nextFilePos, size_t wordSize);
@@ -91,11 +92,11 @@ public:
     m_pos = pos;
   }
 
-  const PhraseNode *GetChild(const Word &wordSought, OnDiskWrapper &onDiskWrapper) const;
+  const PhraseNode *GetChild(const Word &wordSought, const OnDiskWrapper &onDiskWrapper) const;
 
   TargetPhraseCollection::shared_ptr
   GetTargetPhraseCollection(size_t tableLimit,
-                            OnDiskWrapper &onDiskWrapper) const;
+                            const OnDiskWrapper &onDiskWrapper) const;
 
   void AddCounts(const std::vector<float> &counts) {
     m_counts = counts;
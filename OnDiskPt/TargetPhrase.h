@@ -59,9 +59,9 @@ protected:
   size_t WriteScoresToMemory(char *mem) const;
   size_t WriteStringToMemory(char *mem, const std::string &str) const;
 
-  uint64_t ReadAlignFromFile(std::fstream &fileTPColl);
-  uint64_t ReadScoresFromFile(std::fstream &fileTPColl);
-  uint64_t ReadStringFromFile(std::fstream &fileTPColl, std::string &outStr);
+  uint64_t ReadAlignFromMemory(const char *mem);
+  uint64_t ReadScoresFromMemory(const char *mem);
+  uint64_t ReadStringFromMemory(const char *mem, std::string &outStr);
 
 public:
   TargetPhrase() {
@@ -102,8 +102,10 @@ public:
     return m_scores[ind];
   }
 
-  uint64_t ReadOtherInfoFromFile(uint64_t filePos, std::fstream &fileTPColl);
-  uint64_t ReadFromFile(std::fstream &fileTP);
+  //! read from TargetColl.dat contents, returns bytes read
+  uint64_t ReadOtherInfoFromMemory(const char *mem);
+  //! read from TargetInd.dat contents at GetFilePos(), returns bytes read
+  uint64_t ReadFromMemory(const char *mem);
 
   virtual void DebugPrint(std::ostream &out, const Vocab &vocab) const;
 
@@ -56,6 +56,15 @@ template <class Search, class VocabularyT> class GenericModel : public base::Mod
      */
     FullScoreReturn FullScore(const State &in_state, const WordIndex new_word, State &out_state) const;
 
+    /* Hint that FullScore(in_state, new_word, ...) is coming.  With the
+     * probing data structure, this prefetches the hash table entries that
+     * query will probe.  Calling it for a batch of queries before scoring
+     * any of them overlaps their cache misses.  A no-op for the trie.
+     */
+    void Prefetch(const State &in_state, const WordIndex new_word) const {
+      search_.Prefetch(new_word, in_state.words, in_state.words + in_state.length);
+    }
+
     /* Slower call without in_state.  Try to remember state, but sometimes it
      * would cost too much memory or your decoder isn't setup properly.
      * To use this function, make an array of WordIndex containing the context
@@ -27,6 +27,12 @@ inline uint64_t CombineWordHash(uint64_t current, const WordIndex next) {
   return ret;
 }
 
+inline void PrefetchRead(const void *address) {
+#ifdef __GNUC__
+  __builtin_prefetch(address);
+#endif
+}
+
 #pragma pack(push)
 #pragma pack(4)
 struct ProbEntry {
@@ -125,6 +131,19 @@ template <class Value> class HashedSearch {
       return LongestPointer(found->value.prob);
     }
 
+    // Start loading every entry that scoring word after the context [context_rbegin, context_rend) will probe.
+    // Issuing this for several queries before scoring any of them overlaps their cache misses.
+    void Prefetch(WordIndex word, const WordIndex *context_rbegin, const WordIndex *context_rend) const {
+      PrefetchRead(&unigram_.Lookup(word));
+      Node node = static_cast<Node>(word);
+      const WordIndex *i = context_rbegin;
+      for (std::size_t order_minus_2 = 0; i != context_rend && order_minus_2 < middle_.size(); ++i, ++order_minus_2) {
+        node = CombineWordHash(node, *i);
+        PrefetchRead(&*middle_[order_minus_2].Ideal(node));
+      }
+      if (i != context_rend) PrefetchRead(&*longest_.Ideal(CombineWordHash(node, *i)));
+    }
+
     // Generate a node without necessarily checking that it actually exists.
     // Optionally return false if it's know to not exist.
     bool FastMakeNode(const WordIndex *begin, const WordIndex *end, Node &node) const {
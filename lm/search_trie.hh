@@ -88,6 +88,9 @@ template <class Quant, class Bhiksha> class TrieSearch {
       return LongestPointer(quant_, longest_.Find(word, node));
     }
 
+    // Each level's position depends on the previous level's lookup, so there is nothing to fetch in advance.
+    void Prefetch(WordIndex /*word*/, const WordIndex * /*context_rbegin*/, const WordIndex * /*context_rend*/) const {}
+
     bool FastMakeNode(const WordIndex *begin, const WordIndex *end, Node &node) const {
       assert(begin != end);
       bool independent_left;
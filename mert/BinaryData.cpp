@@ -0,0 +1,255 @@
+#include "BinaryData.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "util/exception.hh"
+#include "util/file.hh"
+
+#include "FeatureArray.h"
+#include "ScoreArray.h"
+
+using namespace std;
+
+namespace MosesTuning
+{
+
+namespace
+{
+
+inline uint64_t Padded(uint64_t size)
+{
+  return (size + 7) & ~static_cast<uint64_t>(7);
+}
+
+// Offsets of the sections of a block from its start.
+struct BlockLayout {
+  explicit BlockLayout(const BinaryBlockHeader& header) {
+    names = sizeof(BinaryBlockHeader);
+    dense = names + Padded(header.names_size);
+    sparse_begin = dense + Padded(static_cast<uint64_t>(header.count) * header.dense * sizeof(float));
+    if (header.sparse_count) {
+      sparse = sparse_begin + Padded((static_cast<uint64_t>(header.count) + 1) * sizeof(uint32_t));
+      sparse_names = sparse + Padded(static_cast<uint64_t>(header.sparse_count) * sizeof(BinarySparseEntry));
+      size = sparse_names + Padded(header.sparse_names_size);
+    } else {
+      sparse = sparse_names = size = sparse_begin;
+    }
+  }
+
+  uint64_t names, dense, sparse_begin, sparse, sparse_names, size;
+};
+
+void WritePadded(ostream& out, const void* data, uint64_t size)
+{
+  static const char zeros[8] = {0};
+  if (size) {
+    out.write(static_cast<const char*>(data), size);
+  }
+  out.write(zeros, Padded(size) - size);
+}
+
+void WriteBlock(ostream& out, BinaryBlockHeader& header, const string& names,
+                const vector<float>& dense, const vector<uint32_t>& sparse_begin,
+                const vector<BinarySparseEntry>& sparse, const string& sparse_names)
+{
+  memcpy(header.magic, kBinaryDataMagic, sizeof(header.magic));
+  header.version = kBinaryDataVersion;
+  header.names_size = names.size();
+  header.sparse_count = sparse.size();
+  header.sparse_names_size = sparse_names.size();
+  header.size = BlockLayout(header).size;
+
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  WritePadded(out, names.data(), names.size());
+  WritePadded(out, dense.empty() ? NULL : &dense[0], dense.size() * sizeof(float));
+  if (!sparse.empty()) {
+    WritePadded(out, &sparse_begin[0], sparse_begin.size() * sizeof(uint32_t));
+    WritePadded(out, &sparse[0], sparse.size() * sizeof(BinarySparseEntry));
+    WritePadded(out, sparse_names.data(), sparse_names.size());
+  }
+  UTIL_THROW_IF(!out, util::Exception, "Failed to write binary data");
+}
+
+} // namespace
+
+bool IsBinaryDataFile(const string& file)
+{
+  ifstream in(file.c_str(), ios::in | ios::binary);
+  char magic[sizeof(kBinaryDataMagic)];
+  return in.read(magic, sizeof(magic)) && !memcmp(magic, kBinaryDataMagic, sizeof(magic));
+}
+
+void WriteBinaryData(ostream& out, const FeatureArray& array)
+{
+  BinaryBlockHeader header;
+  memset(&header, 0, sizeof(header));
+  header.kind = kBinaryFeatures;
+  header.index = array.getIndex();
+  header.count = array.size();
+  // the stats include the merged sparse features, if any
+  header.dense = array.size() ? array.get(0).size() : array.NumberOfFeatures();
+
+  vector<float> dense;
+  dense.reserve(static_cast<size_t>(header.count) * header.dense);
+  vector<uint32_t> sparse_begin(1, 0);
+  vector<BinarySparseEntry> sparse;
+  string sparse_names;
+  map<string, uint32_t> name_offsets;
+  for (size_t i = 0; i < array.size(); ++i) {
+    const FeatureStats& stats = array.get(i);
+    UTIL_THROW_IF(stats.size() != header.dense, util::Exception,
+                  "Candidate " << i << " of sentence " << header.index << " has "
+                  << stats.size() << " features instead of " << header.dense);
+    dense.insert(dense.end(), stats.getArray(), stats.getArray() + stats.size());
+
+    const SparseVector& features = stats.getSparse();
+    const vector<size_t> ids = features.feats();
+    for (size_t j = 0; j < ids.size(); ++j) {
+      const string name = SparseVector::decode(ids[j]);
+      map<string, uint32_t>::iterator offset = name_offsets.find(name);
+      if (offset == name_offsets.end()) {
+        offset = name_offsets.insert(make_pair(name, static_cast<uint32_t>(sparse_names.size()))).first;
+        sparse_names.append(name.c_str(), name.size() + 1);
+      }
+      BinarySparseEntry entry;
+      entry.name = offset->second;
+      entry.value = features.get(ids[j]);
+      sparse.push_back(entry);
+    }
+    sparse_begin.push_back(sparse.size());
+  }
+  WriteBlock(out, header, array.Features(), dense, sparse_begin, sparse, sparse_names);
+}
+
+void WriteBinaryData(ostream& out, const ScoreArray& array, const string& score_type)
+{
+  BinaryBlockHeader header;
+  memset(&header, 0, sizeof(header));
+  header.kind = kBinaryScores;
+  header.index = array.getIndex();
+  header.count = array.size();
+  header.dense = array.size() ? array.get(0).size() : array.NumberOfScores();
+
+  vector<float> dense;
+  dense.reserve(static_cast<size_t>(header.count) * header.dense);
+  for (size_t i = 0; i < array.size(); ++i) {
+    const ScoreStats& stats = array.get(i);
+    UTIL_THROW_IF(stats.size() != header.dense, util::Exception,
+                  "Candidate " << i << " of sentence " << header.index << " has "
+                  << stats.size() << " scores instead of " << header.dense);
+    dense.insert(dense.end(), stats.getArray(), stats.getArray() + stats.size());
+  }
+  WriteBlock(out, header, score_type, dense, vector<uint32_t>(),
+             vector<BinarySparseEntry>(), string());
+}
+
+BinaryDataReader::BinaryDataReader(const string& file)
+  : m_file(file), m_begin(NULL), m_end(NULL), m_block(NULL), m_header(NULL),
+    m_names(NULL), m_dense(NULL), m_sparse_begin(NULL), m_sparse(NULL),
+    m_sparse_names(NULL)
+{
+  util::scoped_fd fd(util::OpenReadOrThrow(file.c_str()));
+  const uint64_t size = util::SizeOrThrow(fd.get());
+  if (size) {
+    util::MapRead(util::POPULATE_OR_READ, fd.get(), 0, size, m_mem);
+    m_begin = static_cast<const char*>(m_mem.get());
+    m_end = m_begin + size;
+  }
+}
+
+void BinaryDataReader::Check(bool condition, const char* what) const
+{
+  UTIL_THROW_IF(!condition, util::Exception,
+                what << " in the binary data block at byte " << Offset() << " of " << m_file);
+}
+
+bool BinaryDataReader::Next()
+{
+  m_block = m_header ? m_block + m_header->size : m_begin;
+  m_header = NULL;
+  if (m_block == m_end) return false;
+
+  Check(static_cast<uint64_t>(m_end - m_block) >= sizeof(BinaryBlockHeader), "Truncated header");
+  const BinaryBlockHeader* header = reinterpret_cast<const BinaryBlockHeader*>(m_block);
+  Check(!memcmp(header->magic, kBinaryDataMagic, sizeof(header->magic)), "Bad magic number");
+  Check(header->version == kBinaryDataVersion, "Unsupported version");
+  Check(header->kind == kBinaryFeatures || header->kind == kBinaryScores, "Unknown kind of data");
+  const BlockLayout layout(*header);
+  Check(header->size == layout.size, "Inconsistent size");
+  Check(header->size <= static_cast<uint64_t>(m_end - m_block), "Truncated block");
+
+  m_header = header;
+  m_names = m_block + layout.names;
+  m_dense = reinterpret_cast<const float*>(m_block + layout.dense);
+  if (header->sparse_count) {
+    m_sparse_begin = reinterpret_cast<const uint32_t*>(m_block + layout.sparse_begin);
+    m_sparse = reinterpret_cast<const BinarySparseEntry*>(m_block + layout.sparse);
+    m_sparse_names = m_block + layout.sparse_names;
+    Check(m_sparse_begin[0] == 0 && m_sparse_begin[header->count] == header->sparse_count,
+          "Bad sparse offsets");
+    for (size_t i = 0; i < header->count; ++i) {
+      Check(m_sparse_begin[i] <= m_sparse_begin[i + 1], "Bad sparse offsets");
+    }
+    Check(header->sparse_names_size && !m_sparse_names[header->sparse_names_size - 1],
+          "Bad sparse names");
+    for (size_t i = 0; i < header->sparse_count; ++i) {
+      Check(m_sparse[i].name < header->sparse_names_size, "Bad sparse name");
+    }
+  } else {
+    m_sparse_begin = NULL;
+    m_sparse = NULL;
+    m_sparse_names = NULL;
+  }
+  return true;
+}
+
+void BinaryDataReader::Read(FeatureArray& array, const SparseVector& sparseWeights) const
+{
+  Check(m_header->kind == kBinaryFeatures, "Expected features");
+  array.clear();
+  array.setIndex(m_header->index);
+  array.NumberOfFeatures(m_header->dense);
+  array.Features(Names().as_string());
+
+  FeatureStats entry;
+  for (size_t i = 0; i < m_header->count; ++i) {
+    entry.reset();
+    const float* dense = Dense(i);
+    for (size_t k = 0; k < m_header->dense; ++k) {
+      entry.add(dense[k]);
+    }
+    for (size_t j = SparseBegin(i); j < SparseEnd(i); ++j) {
+      entry.addSparse(SparseName(Sparse(j)), Sparse(j).value);
+    }
+    if (sparseWeights.size()) {
+      entry.add(inner_product(sparseWeights, entry.getSparse()));
+    }
+    array.add(entry);
+  }
+}
+
+void BinaryDataReader::Read(ScoreArray& array) const
+{
+  Check(m_header->kind == kBinaryScores, "Expected scores");
+  array.clear();
+  array.setIndex(m_header->index);
+  array.NumberOfScores(m_header->dense);
+  string score_type = Names().as_string();
+  array.name(score_type);
+
+  ScoreStats entry;
+  for (size_t i = 0; i < m_header->count; ++i) {
+    entry.reset();
+    const float* dense = Dense(i);
+    for (size_t k = 0; k < m_header->dense; ++k) {
+      entry.add(dense[k]);
+    }
+    array.add(entry);
+  }
+}
+
+}
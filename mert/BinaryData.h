@@ -0,0 +1,163 @@
+#ifndef MERT_BINARY_DATA_H_
+#define MERT_BINARY_DATA_H_
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+#include <stdint.h>
+
+#include "util/mmap.hh"
+#include "util/string_piece.hh"
+
+namespace MosesTuning
+{
+
+class FeatureArray;
+class ScoreArray;
+class SparseVector;
+
+/**
+ * Binary feature and score data, written by extractor --binary and
+ * convert-mert-data, and read by everything that reads the text format.
+ *
+ * A file is a sequence of blocks, one per FeatureArray or ScoreArray.
+ * Blocks are independent, so the data of another iteration can simply be
+ * appended; blocks for the same sentence are merged on loading as if they
+ * came from separate files.  A block is
+ *
+ *   BinaryBlockHeader
+ *   names          feature names or score type
+ *   dense          count * dense floats
+ *
+ * and, only if sparse_count is not zero,
+ *
+ *   sparse begin   count + 1 uint32_t, the first sparse entry of each candidate
+ *   sparse         sparse_count BinarySparseEntry
+ *   sparse names   NUL-terminated names the entries point into
+ *
+ * with each section padded to 8 bytes.  Numbers are in the byte order of
+ * the machine that wrote them: the text format is the portable one.
+ */
+const char kBinaryDataMagic[8] = {'M', 'E', 'R', 'T', 'B', 'I', 'N', '\0'};
+const uint32_t kBinaryDataVersion = 1;
+
+enum BinaryDataKind {
+  kBinaryFeatures = 0,
+  kBinaryScores = 1
+};
+
+struct BinaryBlockHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t kind;
+  // the index of the sentence
+  uint32_t index;
+  // number of candidates
+  uint32_t count;
+  // numbers per candidate
+  uint32_t dense;
+  // unpadded sizes of the names sections
+  uint32_t names_size;
+  uint32_t sparse_names_size;
+  uint32_t sparse_count;
+  // size of the whole block, header and padding included
+  uint64_t size;
+};
+
+struct BinarySparseEntry {
+  // offset of the name in the sparse names
+  uint32_t name;
+  float value;
+};
+
+/**
+ * Whether the file starts with a binary block.  Compressed files never do.
+ */
+bool IsBinaryDataFile(const std::string& file);
+
+void WriteBinaryData(std::ostream& out, const FeatureArray& array);
+void WriteBinaryData(std::ostream& out, const ScoreArray& array,
+                     const std::string& score_type);
+
+/**
+ * Reads the blocks of a binary file through a read-only memory map.
+ */
+class BinaryDataReader
+{
+public:
+  explicit BinaryDataReader(const std::string& file);
+
+  /**
+   * Move to the next block.  False at the end of the file.
+   */
+  bool Next();
+
+  const std::string& FileName() const {
+    return m_file;
+  }
+
+  /**
+   * Offset of the current block in the file.
+   */
+  uint64_t Offset() const {
+    return m_block - m_begin;
+  }
+
+  const BinaryBlockHeader& Header() const {
+    return *m_header;
+  }
+
+  StringPiece Names() const {
+    return StringPiece(m_names, m_header->names_size);
+  }
+
+  const float* Dense(std::size_t candidate) const {
+    return m_dense + candidate * m_header->dense;
+  }
+
+  std::size_t SparseBegin(std::size_t candidate) const {
+    return m_sparse_begin ? m_sparse_begin[candidate] : 0;
+  }
+  std::size_t SparseEnd(std::size_t candidate) const {
+    return m_sparse_begin ? m_sparse_begin[candidate + 1] : 0;
+  }
+  const BinarySparseEntry& Sparse(std::size_t entry) const {
+    return m_sparse[entry];
+  }
+  const char* SparseName(const BinarySparseEntry& entry) const {
+    return m_sparse_names + entry.name;
+  }
+
+  /**
+   * Copy the current block, which must hold features, into array.  As
+   * when loading text, the sparse features weighted by sparseWeights are
+   * added up into an extra dense feature if there are any weights.
+   */
+  void Read(FeatureArray& array, const SparseVector& sparseWeights) const;
+
+  /**
+   * Copy the current block, which must hold scores, into array.
+   */
+  void Read(ScoreArray& array) const;
+
+private:
+  void Check(bool condition, const char* what) const;
+
+  std::string m_file;
+  util::scoped_memory m_mem;
+  const char* m_begin;
+  const char* m_end;
+  const char* m_block;
+
+  const BinaryBlockHeader* m_header;
+  const char* m_names;
+  const float* m_dense;
+  const uint32_t* m_sparse_begin;
+  const BinarySparseEntry* m_sparse;
+  const char* m_sparse_names;
+};
+
+}
+
+#endif  // MERT_BINARY_DATA_H_
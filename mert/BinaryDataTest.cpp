@@ -0,0 +1,138 @@
+#include "BinaryData.h"
+
+#define BOOST_TEST_MODULE MertBinaryData
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#include "FeatureArray.h"
+#include "FeatureData.h"
+#include "FeatureDataIterator.h"
+#include "ScoreArray.h"
+#include "ScoreDataIterator.h"
+
+using namespace std;
+using namespace MosesTuning;
+
+namespace
+{
+
+// A file name that is removed again at the end of the test.
+class TempFile
+{
+public:
+  TempFile() : m_path(boost::filesystem::temp_directory_path() /
+                        boost::filesystem::unique_path("mert-binary-%%%%-%%%%")) {}
+  ~TempFile() {
+    boost::filesystem::remove(m_path);
+  }
+  string Name() const {
+    return m_path.string();
+  }
+private:
+  boost::filesystem::path m_path;
+};
+
+FeatureArray MakeFeatures(int index, float offset)
+{
+  FeatureArray array;
+  array.setIndex(index);
+  array.NumberOfFeatures(2);
+  array.Features("a_0 b_0 ");
+  for (int i = 0; i < 2; ++i) {
+    FeatureStats stats;
+    stats.add(offset + i);
+    stats.add(-offset - i);
+    if (i == 1) stats.addSparse("sparse_x", offset);
+    array.add(stats);
+  }
+  return array;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(binary_features_round_trip)
+{
+  TempFile file;
+  BOOST_CHECK(!IsBinaryDataFile(file.Name()));
+  {
+    ofstream out(file.Name().c_str(), ios::binary);
+    MakeFeatures(0, 1.5).savebin(&out);
+    MakeFeatures(1, 3.25).savebin(&out);
+  }
+  // the data of another iteration
+  {
+    ofstream out(file.Name().c_str(), ios::binary | ios::app);
+    MakeFeatures(0, 10).savebin(&out);
+  }
+  BOOST_REQUIRE(IsBinaryDataFile(file.Name()));
+
+  FeatureData data;
+  data.load(file.Name(), SparseVector());
+  BOOST_REQUIRE_EQUAL(data.size(), 2u);
+  BOOST_CHECK_EQUAL(data.Features(), "a_0 b_0 ");
+  BOOST_REQUIRE_EQUAL(data.get(0).size(), 4u);
+  BOOST_REQUIRE_EQUAL(data.get(1).size(), 2u);
+  BOOST_CHECK_EQUAL(data.get(0, 1).get(0), 2.5);
+  BOOST_CHECK_EQUAL(data.get(0, 1).get(1), -2.5);
+  BOOST_CHECK_EQUAL(data.get(0, 3).get(0), 11);
+  BOOST_CHECK_EQUAL(data.get(1, 0).get(1), -3.25);
+  BOOST_CHECK_EQUAL(data.get(0, 0).getSparse().size(), 0u);
+  BOOST_CHECK_EQUAL(data.get(1, 1).getSparse().get("sparse_x"), 3.25);
+
+  // the sparse features are merged into a dense one if there are weights
+  SparseVector weights;
+  weights.set("sparse_x", 2);
+  FeatureData merged;
+  merged.load(file.Name(), weights);
+  BOOST_REQUIRE_EQUAL(merged.get(1, 1).size(), 3u);
+  BOOST_CHECK_EQUAL(merged.get(1, 1).get(2), 6.5);
+  BOOST_CHECK_EQUAL(merged.get(1, 0).get(2), 0);
+
+  size_t blocks = 0;
+  for (FeatureDataIterator it(file.Name()); it != FeatureDataIterator::end(); ++it, ++blocks) {
+    BOOST_REQUIRE_EQUAL(it->size(), 2u);
+    BOOST_CHECK_EQUAL((*it)[1].dense.size(), 2u);
+    BOOST_CHECK_EQUAL((*it)[1].sparse.size(), 1u);
+  }
+  BOOST_CHECK_EQUAL(blocks, 3u);
+}
+
+BOOST_AUTO_TEST_CASE(binary_scores_round_trip)
+{
+  TempFile file;
+  {
+    ScoreArray array;
+    array.setIndex(7);
+    for (int i = 0; i < 3; ++i) {
+      ScoreStats stats;
+      for (int k = 0; k < 9; ++k) stats.add(i * 10 + k);
+      array.add(stats);
+    }
+    ofstream out(file.Name().c_str(), ios::binary);
+    array.savebin(&out, "BLEU");
+  }
+
+  BinaryDataReader reader(file.Name());
+  BOOST_REQUIRE(reader.Next());
+  BOOST_CHECK_EQUAL(reader.Header().kind, static_cast<uint32_t>(kBinaryScores));
+  ScoreArray array;
+  reader.Read(array);
+  BOOST_CHECK_EQUAL(array.getIndex(), 7);
+  BOOST_CHECK_EQUAL(array.name(), "BLEU");
+  BOOST_REQUIRE_EQUAL(array.size(), 3u);
+  BOOST_CHECK_EQUAL(array.get(2).get(8), 28);
+  BOOST_CHECK(!reader.Next());
+
+  ScoreDataIterator it(file.Name());
+  BOOST_REQUIRE(it != ScoreDataIterator::end());
+  BOOST_REQUIRE_EQUAL(it->size(), 3u);
+  BOOST_CHECK_EQUAL((*it)[1][4], 14);
+  ++it;
+  BOOST_CHECK(it == ScoreDataIterator::end());
+
+  // features are not scores
+  BOOST_CHECK_THROW(FeatureDataIterator features(file.Name()), util::Exception);
+}
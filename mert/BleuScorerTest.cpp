@@ -5,6 +5,7 @@
 
 #include <cmath>
 #include "Ngram.h"
+#include "ScoreData.h"
 #include "Vocabulary.h"
 #include "Util.h"
 
@@ -288,3 +289,51 @@ BOOST_AUTO_TEST_CASE(sentence_level_bleu)
   BOOST_CHECK_CLOSE(0.5624f, smoothedSentenceBleu(stats, 0.5), 0.01 );
   BOOST_CHECK_CLOSE(0.5067f, smoothedSentenceBleu(stats, 1.0, true), 0.01);
 }
+
+namespace
+{
+// one candidate for sentence sid whose counts are all n
+void AddCandidate(ScoreData& data, int sid, ScoreStatsType n)
+{
+  ScoreStats stats;
+  for (int i = 0; i < 2 * kBleuNgramOrder; ++i) {
+    stats.add(i % 2 ? n : n - i / 2);
+  }
+  stats.add(n);  // reference-length
+  data.add(stats, sid);
+}
+
+statscore_t Score(const Scorer& scorer)
+{
+  candidates_t candidates(2, 0);
+  return scorer.score(candidates);
+}
+}
+
+BOOST_AUTO_TEST_CASE(score_data_changes)
+{
+  BleuScorer scorer;
+  std::vector<statscore_t> scores;
+  // as in the bootstrap of the evaluator, each score data is likely to be
+  // at the same address and of the same shape
+  for (int n = 6; n <= 8; ++n) {
+    ScoreData data(&scorer);
+    AddCandidate(data, 0, n);
+    AddCandidate(data, 1, n);
+    scorer.setScoreData(&data);
+    scores.push_back(Score(scorer));
+  }
+  BOOST_CHECK_LT(scores[0], scores[1]);
+  BOOST_CHECK_LT(scores[1], scores[2]);
+
+  // changed in place
+  ScoreData data(&scorer);
+  AddCandidate(data, 0, 6);
+  AddCandidate(data, 1, 6);
+  scorer.setScoreData(&data);
+  BOOST_CHECK_EQUAL(scores[0], Score(scorer));
+  data.clear();
+  AddCandidate(data, 0, 8);
+  AddCandidate(data, 1, 8);
+  BOOST_CHECK_EQUAL(scores[2], Score(scorer));
+}
@@ -9,6 +9,7 @@
 #include <iostream>
 #include <fstream>
 #include "FeatureArray.h"
+#include "BinaryData.h"
 #include "FileStream.h"
 #include "Util.h"
 
@@ -36,12 +37,7 @@ void FeatureArray::savetxt(ostream* os)
 
 void FeatureArray::savebin(ostream* os)
 {
-  *os << FEATURES_BIN_BEGIN << " " << m_index << " " << m_array.size()
-      << " " << m_num_features << " " << m_features << endl;
-  for (featarray_t::iterator i = m_array.begin(); i != m_array.end(); ++i)
-    i->savebin(os);
-
-  *os << FEATURES_BIN_END << endl;
+  WriteBinaryData(*os, *this);
 }
 
 
@@ -19,6 +19,8 @@ namespace MosesTuning
 
 const char FEATURES_TXT_BEGIN[] = "FEATURES_TXT_BEGIN_0";
 const char FEATURES_TXT_END[] = "FEATURES_TXT_END_0";
+// The old binary format, which is still read.  See BinaryData.h for the
+// one that is written.
 const char FEATURES_BIN_BEGIN[] = "FEATURES_BIN_BEGIN_0";
 const char FEATURES_BIN_END[] = "FEATURES_BIN_END_0";
 
@@ -9,6 +9,7 @@
 #include "FeatureData.h"
 
 #include <limits>
+#include "BinaryData.h"
 #include "FileStream.h"
 #include "Util.h"
 
@@ -70,6 +71,19 @@ void FeatureData::load(istream* is, const SparseVector& sparseWeights)
 void FeatureData::load(const string &file, const SparseVector& sparseWeights)
 {
   TRACE_ERR("loading feature data from " << file << endl);
+  if (IsBinaryDataFile(file)) {
+    BinaryDataReader reader(file);
+    FeatureArray entry;
+    while (reader.Next()) {
+      reader.Read(entry, sparseWeights);
+      if (entry.size() == 0)
+        continue;
+      if (size() == 0)
+        setFeatureMap(entry.Features());
+      add(entry);
+    }
+    return;
+  }
   inputfilestream input_stream(file); // matches a stream with a file. Opens the file
   if (!input_stream) {
     throw runtime_error("Unable to open feature file: " + file);
@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "util/file_piece.hh"
 #include "util/tokenize_piece.hh"
 
+#include "BinaryData.h"
 #include "FeatureArray.h"
 #include "FeatureDataIterator.h"
 
@@ -73,7 +74,11 @@ FeatureDataIterator::FeatureDataIterator() {}
 
 FeatureDataIterator::FeatureDataIterator(const string& filename)
 {
-  m_in.reset(new FilePiece(filename.c_str()));
+  if (IsBinaryDataFile(filename)) {
+    m_binary.reset(new BinaryDataReader(filename));
+  } else {
+    m_in.reset(new FilePiece(filename.c_str()));
+  }
   readNext();
 }
 
@@ -82,6 +87,25 @@ FeatureDataIterator::~FeatureDataIterator() {}
 void FeatureDataIterator::readNext()
 {
   m_next.clear();
+  if (m_binary) {
+    if (!m_binary->Next()) {
+      m_binary.reset();
+      return;
+    }
+    const BinaryBlockHeader& header = m_binary->Header();
+    UTIL_THROW_IF(header.kind != kBinaryFeatures, util::Exception,
+                  m_binary->FileName() << " holds scores, not features");
+    m_next.resize(header.count);
+    for (size_t i = 0; i < header.count; ++i) {
+      const float* dense = m_binary->Dense(i);
+      m_next[i].dense.assign(dense, dense + header.dense);
+      for (size_t j = m_binary->SparseBegin(i); j < m_binary->SparseEnd(i); ++j) {
+        const BinarySparseEntry& entry = m_binary->Sparse(j);
+        m_next[i].sparse.set(m_binary->SparseName(entry), entry.value);
+      }
+    }
+    return;
+  }
   try {
     StringPiece marker = m_in->ReadDelimited();
     if (marker != StringPiece(FEATURES_TXT_BEGIN)) {
@@ -131,6 +155,11 @@ void FeatureDataIterator::increment()
 
 bool FeatureDataIterator::equal(const FeatureDataIterator& rhs) const
 {
+  if (m_binary || rhs.m_binary) {
+    return m_binary && rhs.m_binary &&
+           m_binary->FileName() == rhs.m_binary->FileName() &&
+           m_binary->Offset() == rhs.m_binary->Offset();
+  }
   if (!m_in && !rhs.m_in) {
     return true;
   } else if (!m_in) {
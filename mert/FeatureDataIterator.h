@@ -45,6 +45,7 @@ class FilePiece;
 namespace MosesTuning
 {
 
+class BinaryDataReader;
 
 class FileFormatException : public util::Exception
 {
@@ -97,6 +98,8 @@ private:
   void readNext();
 
   boost::shared_ptr<util::FilePiece> m_in;
+  // instead of m_in for binary files
+  boost::shared_ptr<BinaryDataReader> m_binary;
   std::vector<FeatureDataItem> m_next;
 };
 
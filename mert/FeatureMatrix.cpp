@@ -0,0 +1,66 @@
+#include "FeatureMatrix.h"
+
+#include <algorithm>
+
+#include "FeatureData.h"
+#include "util/exception.hh"
+
+using namespace std;
+
+namespace MosesTuning
+{
+
+FeatureMatrix::FeatureMatrix() : m_num_features(0) {}
+
+FeatureMatrix::FeatureMatrix(const FeatureData& data) : m_num_features(0)
+{
+  Load(data);
+}
+
+void FeatureMatrix::Load(const FeatureData& data)
+{
+  m_num_features = data.NumberOfFeatures();
+  m_offsets.resize(data.size() + 1);
+  m_offsets[0] = 0;
+  for (size_t i = 0; i < data.size(); ++i) {
+    m_offsets[i + 1] = m_offsets[i] + data.get(i).size();
+  }
+
+  m_values.assign(m_offsets.back() * m_num_features, 0);
+  for (size_t i = 0; i < data.size(); ++i) {
+    const FeatureArray& array = data.get(i);
+    const size_t n = array.size();
+    FeatureStatsType* block = &m_values[0] + m_offsets[i] * m_num_features;
+    for (size_t j = 0; j < n; ++j) {
+      const FeatureStats& stats = array.get(j);
+      const size_t dense = min(stats.size(), m_num_features);
+      for (size_t k = 0; k < dense; ++k) {
+        block[k * n + j] = stats.get(k);
+      }
+    }
+  }
+}
+
+void FeatureMatrix::Score(size_t sentence, const vector<Weight>& weights,
+                          vector<double>& out) const
+{
+  const size_t n = NumberOfCandidates(sentence);
+  out.assign(n, 0.0);
+  if (n == 0) return;
+  const FeatureStatsType* block = &m_values[0] + m_offsets[sentence] * m_num_features;
+  double* sums = &out[0];
+  for (size_t w = 0; w < weights.size(); ++w) {
+    UTIL_THROW_IF(weights[w].first >= m_num_features, util::Exception,
+                  "Weight for feature " << weights[w].first << " but there are only "
+                  << m_num_features << " features");
+    const parameter_t weight = weights[w].second;
+    const FeatureStatsType* column = block + weights[w].first * n;
+    for (size_t j = 0; j < n; ++j) {
+      // rounded to float before the sum, like in Point::operator*
+      const float term = weight * column[j];
+      sums[j] += term;
+    }
+  }
+}
+
+}
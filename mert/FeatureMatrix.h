@@ -0,0 +1,71 @@
+#ifndef MERT_FEATURE_MATRIX_H_
+#define MERT_FEATURE_MATRIX_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "Types.h"
+
+namespace MosesTuning
+{
+
+/**
+ * A read-only copy of the dense features of a FeatureData, laid out for
+ * the line search: the candidates of all sentences share one block of
+ * memory, and within a sentence each feature is a contiguous column.
+ * Scoring every candidate of a sentence with a weight vector then runs
+ * down the columns instead of chasing a heap array per candidate.
+ */
+class FeatureMatrix
+{
+public:
+  /**
+   * A weight for the feature with the given index.
+   */
+  typedef std::pair<std::size_t, parameter_t> Weight;
+
+  FeatureMatrix();
+  explicit FeatureMatrix(const FeatureData& data);
+
+  void Load(const FeatureData& data);
+
+  /**
+   * Number of sentences.
+   */
+  std::size_t size() const {
+    return m_offsets.empty() ? 0 : m_offsets.size() - 1;
+  }
+
+  std::size_t NumberOfFeatures() const {
+    return m_num_features;
+  }
+
+  std::size_t NumberOfCandidates(std::size_t sentence) const {
+    return m_offsets[sentence + 1] - m_offsets[sentence];
+  }
+
+  FeatureStatsType get(std::size_t sentence, std::size_t candidate,
+                       std::size_t feature) const {
+    return m_values[m_offsets[sentence] * m_num_features
+                    + feature * NumberOfCandidates(sentence) + candidate];
+  }
+
+  /**
+   * Set out[j] to the weighted sum of the features of candidate j of the
+   * sentence.  The terms are added in the order of the weights, as
+   * Point::operator* does, so that the results are the same.
+   */
+  void Score(std::size_t sentence, const std::vector<Weight>& weights,
+             std::vector<double>& out) const;
+
+private:
+  std::size_t m_num_features;
+  // index of the first candidate of each sentence, and the total at the end
+  std::vector<std::size_t> m_offsets;
+  std::vector<FeatureStatsType> m_values;
+};
+
+}
+
+#endif  // MERT_FEATURE_MATRIX_H_
@@ -0,0 +1,69 @@
+#include "FeatureMatrix.h"
+
+#define BOOST_TEST_MODULE MertFeatureMatrix
+#include <boost/test/unit_test.hpp>
+
+#include "FeatureData.h"
+#include "FeatureStats.h"
+#include "util/exception.hh"
+
+using namespace std;
+using namespace MosesTuning;
+
+namespace
+{
+
+void AddCandidate(FeatureData& data, int sentence, float f0, float f1, float f2)
+{
+  FeatureStats stats;
+  stats.add(f0);
+  stats.add(f1);
+  stats.add(f2);
+  data.add(stats, sentence);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(feature_matrix_layout)
+{
+  FeatureData data;
+  data.setFeatureMap("a_0 b_0 c_0 ");
+  AddCandidate(data, 0, 1, 2, 3);
+  AddCandidate(data, 0, 4, 5, 6);
+  AddCandidate(data, 1, 7, 8, 9);
+
+  FeatureMatrix matrix(data);
+  BOOST_REQUIRE_EQUAL(matrix.size(), 2u);
+  BOOST_CHECK_EQUAL(matrix.NumberOfFeatures(), 3u);
+  BOOST_CHECK_EQUAL(matrix.NumberOfCandidates(0), 2u);
+  BOOST_CHECK_EQUAL(matrix.NumberOfCandidates(1), 1u);
+  for (size_t i = 0; i < data.size(); ++i) {
+    for (size_t j = 0; j < data.get(i).size(); ++j) {
+      for (size_t k = 0; k < 3; ++k) {
+        BOOST_CHECK_EQUAL(matrix.get(i, j, k), data.get(i, j).get(k));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(feature_matrix_score)
+{
+  FeatureData data;
+  data.setFeatureMap("a_0 b_0 c_0 ");
+  AddCandidate(data, 0, 1, 2, 3);
+  AddCandidate(data, 0, 4, 5, 6);
+  FeatureMatrix matrix(data);
+
+  // only some of the features, out of order
+  vector<FeatureMatrix::Weight> weights;
+  weights.push_back(FeatureMatrix::Weight(2, 0.5f));
+  weights.push_back(FeatureMatrix::Weight(0, -1.0f));
+  vector<double> scores;
+  matrix.Score(0, weights, scores);
+  BOOST_REQUIRE_EQUAL(scores.size(), 2u);
+  BOOST_CHECK_EQUAL(scores[0], 0.5);
+  BOOST_CHECK_EQUAL(scores[1], -1.0);
+
+  weights.push_back(FeatureMatrix::Weight(3, 1.0f));
+  BOOST_CHECK_THROW(matrix.Score(0, weights, scores), util::Exception);
+}
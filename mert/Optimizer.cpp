@@ -1,5 +1,6 @@
 #include "Optimizer.h"
 
+#include <algorithm>
 #include <cmath>
 #include "util/exception.hh"
 #include <vector>
@@ -9,6 +10,12 @@
 #include <iostream>
 #include <stdint.h>
 
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include "moses/ThreadPool.h"
+#endif
+
 #include "Point.h"
 #include "Util.h"
 
@@ -32,6 +39,17 @@ inline float intersect(float m1, float b1, float m2, float b2)
   return isect;
 }
 
+/**
+ * Orders candidates by gradient only; with a stable sort, candidates with
+ * the same gradient stay in order as in a multimap.
+ */
+struct LessGradient {
+  bool operator()(const std::pair<float, unsigned>& a,
+                  const std::pair<float, unsigned>& b) const {
+    return a.first < b.first;
+  }
+};
+
 } // namespace
 
 namespace MosesTuning
@@ -39,7 +57,7 @@ namespace MosesTuning
 
 
 Optimizer::Optimizer(unsigned Pd, const vector<unsigned>& i2O, const vector<bool>& pos, const vector<parameter_t>& start, unsigned int nrandom)
-  : m_scorer(NULL), m_feature_data(), m_num_random_directions(nrandom), m_positive(pos)
+  : m_scorer(NULL), m_feature_data(), m_num_random_directions(nrandom), m_threads(1), m_positive(pos)
 {
   // Warning: the init vector is a full set of parameters, of dimension m_pdim!
   Point::m_pdim = Pd;
@@ -63,6 +81,15 @@ Optimizer::Optimizer(unsigned Pd, const vector<unsigned>& i2O, const vector<bool
 
 Optimizer::~Optimizer() {}
 
+void Optimizer::SetThreads(size_t threads)
+{
+  m_threads = max<size_t>(1, threads);
+#ifdef WITH_THREADS
+  // the thread running a line search works as well
+  m_pool.reset(m_threads > 1 ? new Moses::ThreadPool(m_threads - 1) : NULL);
+#endif
+}
+
 statscore_t Optimizer::GetStatScore(const Point& param) const
 {
   vector<unsigned> bests;
@@ -90,92 +117,132 @@ map<float,diff_t >::iterator AddThreshold(map<float,diff_t >& thresholdmap, floa
   return it;
 }
 
-statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction, Point& bestpoint) const
+void Optimizer::GetWeights(const Point& point, vector<FeatureMatrix::Weight>& weights)
 {
-  // We are looking for the best Point on the line y=Origin+x*direction
-  float min_int = 0.0001;
-  //typedef pair<unsigned,unsigned> diff;//first the sentence that changes, second is the new 1best for this sentence
-  //list<threshold> thresholdlist;
+  // the same terms in the same order as Point::operator*
+  weights.clear();
+  if (Point::OptimizeAll()) {
+    for (unsigned i = 0; i < point.size(); i++)
+      weights.push_back(FeatureMatrix::Weight(i, point[i]));
+  } else {
+    for (unsigned i = 0; i < point.size(); i++)
+      weights.push_back(FeatureMatrix::Weight(Point::m_opt_indices[i], point[i]));
+    for (map<unsigned, float>::const_iterator it = Point::m_fixed_weights.begin();
+         it != Point::m_fixed_weights.end(); ++it)
+      weights.push_back(FeatureMatrix::Weight(it->first, it->second));
+  }
+}
 
-  map<float,diff_t> thresholdmap;
-  thresholdmap[MIN_FLOAT] = diff_t();
-  vector<unsigned> first1best;       // the vector of nbests for x=-inf
-  for (unsigned int S = 0; S < size(); S++) {
-    map<float,diff_t >::iterator previnserted = thresholdmap.begin();
+void Optimizer::GetEnvelopes(size_t begin, size_t end,
+                             const vector<FeatureMatrix::Weight>& origin,
+                             const vector<FeatureMatrix::Weight>& direction,
+                             vector<Envelope>& envelopes) const
+{
+  vector<double> scores;
+  vector<pair<float, unsigned> > gradient;
+  vector<float> f0;
+  for (size_t S = begin; S < end; S++) {
     // First, we determine the translation with the best feature score
     // for each sentence and each value of x.
-    //cerr << "Sentence " << S << endl;
-    multimap<float, unsigned> gradient;
-    vector<float> f0;
-    f0.resize(m_feature_data->get(S).size());
-    for (unsigned j = 0; j < m_feature_data->get(S).size(); j++) {
-      // gradient of the feature function for this particular target sentence
-      gradient.insert(pair<float, unsigned>(direction * (m_feature_data->get(S,j)), j));
-      // compute the feature function at the origin point
-      f0[j] = origin * m_feature_data->get(S, j);
-    }
-    // Now let's compute the 1best for each value of x.
-
-    //    vector<pair<float,unsigned> > onebest;
-
+    // The candidates sorted by the gradient of their feature function,
+    // candidates with the same gradient in order.
+    m_features.Score(S, direction, scores);
+    UTIL_THROW_IF(scores.empty(), util::Exception, "No candidates for sentence " << S);
+    gradient.resize(scores.size());
+    for (unsigned j = 0; j < scores.size(); j++)
+      gradient[j] = pair<float, unsigned>(scores[j], j);
+    stable_sort(gradient.begin(), gradient.end(), LessGradient());
+    // the feature function at the origin point
+    m_features.Score(S, origin, scores);
+    f0.assign(scores.begin(), scores.end());
 
-    multimap<float,unsigned>::iterator gradientit = gradient.begin();
-    multimap<float,unsigned>::iterator highest_f0 = gradient.begin();
-
-    float smallest = gradientit->first;//smallest gradient
+    // Now let's compute the 1best for each value of x.
     // Several candidates can have the lowest slope (e.g., for word penalty where the gradient is an integer).
-
-    gradientit++;
-    while (gradientit != gradient.end() && gradientit->first == smallest) {
-      //   cerr<<"ni"<<gradientit->second<<endl;;
-      //cerr<<"fos"<<f0[gradientit->second]<<" "<<f0[index]<<" "<<index<<endl;
-      if (f0[gradientit->second] > f0[highest_f0->second])
-        highest_f0 = gradientit;//the highest line is the one with he highest f0
-      gradientit++;
+    const float smallest = gradient[0].first;
+    size_t highest_f0 = 0;
+    for (size_t i = 1; i < gradient.size() && gradient[i].first == smallest; i++) {
+      if (f0[gradient[i].second] > f0[gradient[highest_f0].second])
+        highest_f0 = i;//the highest line is the one with he highest f0
     }
 
-    gradientit = highest_f0;
-    first1best.push_back(highest_f0->second);
+    Envelope& envelope = envelopes[S];
+    envelope.first = gradient[highest_f0].second;
+    envelope.changes.clear();
 
     // Now we look for the intersections points indicating a change of 1 best.
     // We use the fact that the function is convex, which means that the gradient can only go up.
-    while (gradientit != gradient.end()) {
-      map<float,unsigned>::iterator leftmost = gradientit;
-      float m = gradientit->first;
-      float b = f0[gradientit->second];
-      multimap<float,unsigned>::iterator gradientit2 = gradientit;
-      gradientit2++;
+    size_t current = highest_f0;
+    while (true) {
+      size_t leftmost = current;
+      const float m = gradient[current].first;
+      const float b = f0[gradient[current].second];
       float leftmostx = MAX_FLOAT;
-      for (; gradientit2 != gradient.end(); gradientit2++) {
-        //cerr<<"--"<<d++<<' '<<gradientit2->first<<' '<<gradientit2->second<<endl;
+      for (size_t i = current + 1; i < gradient.size(); i++) {
         // Look for all candidate with a gradient bigger than the current one, and
         // find the one with the leftmost intersection.
-        float curintersect;
-        if (m != gradientit2->first) {
-          curintersect = intersect(m, b, gradientit2->first, f0[gradientit2->second]);
-          //cerr << "curintersect: " << curintersect << " leftmostx: " << leftmostx << endl;
-          if (curintersect<=leftmostx) {
+        if (m != gradient[i].first) {
+          float curintersect = intersect(m, b, gradient[i].first, f0[gradient[i].second]);
+          if (curintersect <= leftmostx) {
             // We have found an intersection to the left of the leftmost we had so far.
             // We might have curintersect==leftmostx for example is 2 candidates are the same
             // in that case its better its better to update leftmost to gradientit2 to avoid some recomputing later.
             leftmostx = curintersect;
-            leftmost = gradientit2; // this is the new reference
+            leftmost = i; // this is the new reference
           }
         }
       }
-      if (leftmost == gradientit) {
+      if (leftmost == current) {
         // We didn't find any more intersections.
         // The rightmost bestindex is the one with the highest slope.
 
         // They should be equal but there might be.
-        UTIL_THROW_IF(abs(leftmost->first-gradient.rbegin()->first) >= 0.0001,
+        UTIL_THROW_IF(abs(gradient[leftmost].first - gradient.back().first) >= 0.0001,
                       util::Exception, "Error");
         // A small difference due to rounding error
         break;
       }
       // We have found the next intersection!
+      envelope.changes.push_back(pair<float, unsigned>(leftmostx, gradient[leftmost].second));
+      current = leftmost;
+    }
+  }
+}
+
+statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction, Point& bestpoint) const
+{
+  // We are looking for the best Point on the line y=Origin+x*direction
+  float min_int = 0.0001;
+  //typedef pair<unsigned,unsigned> diff;//first the sentence that changes, second is the new 1best for this sentence
+  //list<threshold> thresholdlist;
+
+  // The envelopes of the sentences do not depend on each other, so they are
+  // computed in parallel.  Merging them into the thresholds is not, because
+  // nearby thresholds are combined.
+  vector<FeatureMatrix::Weight> originWeights, directionWeights;
+  GetWeights(origin, originWeights);
+  GetWeights(direction, directionWeights);
+  vector<Envelope> envelopes(size());
+#ifdef WITH_THREADS
+  if (m_pool) {
+    Moses::ParallelFor(*m_pool, size(), m_threads,
+                       boost::bind(&Optimizer::GetEnvelopes, this, _1, _2,
+                                   boost::cref(originWeights), boost::cref(directionWeights),
+                                   boost::ref(envelopes)));
+  } else
+#endif
+    GetEnvelopes(0, size(), originWeights, directionWeights, envelopes);
+
+  map<float,diff_t> thresholdmap;
+  thresholdmap[MIN_FLOAT] = diff_t();
+  vector<unsigned> first1best;       // the vector of nbests for x=-inf
+  for (unsigned int S = 0; S < size(); S++) {
+    map<float,diff_t >::iterator previnserted = thresholdmap.begin();
+    const Envelope& envelope = envelopes[S];
+    first1best.push_back(envelope.first);
 
-      pair<unsigned,unsigned> newd(S, leftmost->second);//new onebest for Sentence S is leftmost->second
+    for (size_t c = 0; c < envelope.changes.size(); c++) {
+      const float leftmostx = envelope.changes[c].first;
+      pair<unsigned,unsigned> newd(S, envelope.changes[c].second);//new onebest for Sentence S
 
       if (leftmostx-previnserted->first < min_int) {
         // Require that the intersection Point be at least min_int to the right of the previous
@@ -221,8 +288,7 @@ statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction,
       } else { //normal insertion process
         previnserted = AddThreshold(thresholdmap, leftmostx, newd);
       }
-      gradientit = leftmost;
-    } // while (gradientit!=gradient.end()){
+    } // loop on the changes of 1best
   }   // loop on S
 
   // Now the thresholdlist is up to date: it contains a list of all the parameter_ts where
@@ -325,12 +391,15 @@ void Optimizer::Get1bests(const Point& P, vector<unsigned>& bests) const
   bests.clear();
   bests.resize(size());
 
+  vector<FeatureMatrix::Weight> weights;
+  GetWeights(P, weights);
+  vector<double> scores;
   for (unsigned i = 0; i < size(); i++) {
+    m_features.Score(i, weights, scores);
     float bestfs = MIN_FLOAT;
     unsigned idx = 0;
-    unsigned j;
-    for (j = 0; j < m_feature_data->get(i).size(); j++) {
-      float curfs = P * m_feature_data->get(i, j);
+    for (unsigned j = 0; j < scores.size(); j++) {
+      float curfs = scores[j];
       if (curfs > bestfs) {
         bestfs = curfs;
         idx = j;
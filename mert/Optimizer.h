@@ -3,13 +3,20 @@
 
 #include <vector>
 #include <string>
+#include <boost/scoped_ptr.hpp>
 #include "Data.h"
 #include "FeatureData.h"
+#include "FeatureMatrix.h"
 #include "Scorer.h"
 #include "Types.h"
 
 static const float kMaxFloat = std::numeric_limits<float>::max();
 
+namespace Moses
+{
+class ThreadPool;
+}
+
 namespace MosesTuning
 {
 
@@ -24,7 +31,12 @@ class Optimizer
 protected:
   Scorer *m_scorer;      // no accessor for them only child can use them
   FeatureDataHandle m_feature_data;  // no accessor for them only child can use them
+  FeatureMatrix m_features;  // the dense features of m_feature_data, by column
   unsigned int m_num_random_directions;
+  std::size_t m_threads;
+#ifdef WITH_THREADS
+  boost::scoped_ptr<Moses::ThreadPool> m_pool; // shared by all line searches
+#endif
 
   const std::vector<bool>& m_positive;
 
@@ -36,7 +48,15 @@ public:
   }
   void SetFeatureData(FeatureDataHandle feature_data) {
     m_feature_data = feature_data;
+    if (m_feature_data) {
+      m_features.Load(*m_feature_data);
+    }
   }
+  /**
+   * Number of threads that each line search splits the sentences over.
+   * Starts the pool that the line searches share.
+   */
+  void SetThreads(std::size_t threads);
   virtual ~Optimizer();
 
   unsigned size() const {
@@ -73,6 +93,27 @@ public:
    * Get the optimal Lambda and the best score in a particular direction from a given Point.
    */
   statscore_t LineOptimize(const Point& start, const Point& direction, Point& best) const;
+
+private:
+  /**
+   * The upper envelope of the candidates of a sentence on a line: the 1best
+   * at x=-inf, then each x where the 1best changes along with the new one.
+   */
+  struct Envelope {
+    unsigned first;
+    std::vector<std::pair<float, unsigned> > changes;
+  };
+
+  static void GetWeights(const Point& point, std::vector<FeatureMatrix::Weight>& weights);
+
+  /**
+   * Compute the envelopes of sentences [begin, end) on the line
+   * origin + x * direction.
+   */
+  void GetEnvelopes(std::size_t begin, std::size_t end,
+                    const std::vector<FeatureMatrix::Weight>& origin,
+                    const std::vector<FeatureMatrix::Weight>& direction,
+                    std::vector<Envelope>& envelopes) const;
 };
 
 
@@ -7,6 +7,7 @@
  */
 
 #include "ScoreArray.h"
+#include "BinaryData.h"
 #include "Util.h"
 #include "FileStream.h"
 
@@ -32,13 +33,7 @@ void ScoreArray::savetxt(ostream* os, const string& sctype)
 
 void ScoreArray::savebin(ostream* os, const string& score_type)
 {
-  *os << SCORES_BIN_BEGIN << " " << m_index << " " << m_array.size()
-      << " " << m_num_scores << " " << score_type << endl;
-  for (scorearray_t::iterator i = m_array.begin();
-       i != m_array.end(); i++) {
-    i->savebin(os);
-  }
-  *os << SCORES_BIN_END << endl;
+  WriteBinaryData(*os, *this, score_type);
 }
 
 void ScoreArray::save(ostream* os, const string& score_type, bool bin)
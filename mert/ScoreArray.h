@@ -20,6 +20,8 @@ namespace MosesTuning
 
 const char SCORES_TXT_BEGIN[] = "SCORES_TXT_BEGIN_0";
 const char SCORES_TXT_END[] = "SCORES_TXT_END_0";
+// The old binary format, which is still read.  See BinaryData.h for the
+// one that is written.
 const char SCORES_BIN_BEGIN[] = "SCORES_BIN_BEGIN_0";
 const char SCORES_BIN_END[] = "SCORES_BIN_END_0";
 
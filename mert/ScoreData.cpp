@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <fstream>
+#include "BinaryData.h"
 #include "Scorer.h"
 #include "Util.h"
 #include "FileStream.h"
@@ -21,7 +22,7 @@ namespace MosesTuning
 
 
 ScoreData::ScoreData(Scorer* scorer) :
-  m_scorer(scorer)
+  m_scorer(scorer), m_generation(0)
 {
   m_score_type = m_scorer->getName();
   // This is not dangerous: we don't use the this pointer in SetScoreData.
@@ -75,6 +76,16 @@ void ScoreData::load(istream* is)
 void ScoreData::load(const string &file)
 {
   TRACE_ERR("loading score data from " << file << endl);
+  if (IsBinaryDataFile(file)) {
+    BinaryDataReader reader(file);
+    ScoreArray entry;
+    while (reader.Next()) {
+      reader.Read(entry);
+      if (entry.size() > 0)
+        add(entry);
+    }
+    return;
+  }
   inputfilestream input_stream(file); // matches a stream with a file. Opens the file
   if (!input_stream) {
     throw runtime_error("Unable to open score file: " + file);
@@ -86,6 +97,7 @@ void ScoreData::load(const string &file)
 
 void ScoreData::add(ScoreArray& e)
 {
+  ++m_generation;
   if (exists(e.getIndex())) { // array at position e.getIndex() already exists
     //enlarge array at position e.getIndex()
     size_t pos = getIndex(e.getIndex());
@@ -98,6 +110,7 @@ void ScoreData::add(ScoreArray& e)
 
 void ScoreData::add(const ScoreStats& e, int sent_idx)
 {
+  ++m_generation;
   if (exists(sent_idx)) { // array at position e.getIndex() already exists
     // Enlarge array at position e.getIndex()
     size_t pos = getIndex(sent_idx);
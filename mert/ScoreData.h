@@ -36,6 +36,7 @@ private:
   Scorer* m_scorer;
   std::string m_score_type;
   std::size_t m_num_scores;
+  std::size_t m_generation;
 
 public:
   ScoreData(Scorer* scorer);
@@ -43,6 +44,7 @@ public:
 
   void clear() {
     m_array.clear();
+    ++m_generation;
   }
 
   inline ScoreArray& get(std::size_t idx) {
@@ -87,6 +89,14 @@ public:
     return m_array.size();
   }
 
+  /**
+   * Changes with every add and clear, so that scorers can tell that
+   * statistics they have cached are out of date.
+   */
+  std::size_t generation() const {
+    return m_generation;
+  }
+
   void save(const std::string &file, bool bin=false);
   void save(std::ostream* os, bool bin=false);
   void save(bool bin=false);
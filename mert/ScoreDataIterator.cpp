@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "util/file_piece.hh"
 #include "util/tokenize_piece.hh"
 
+#include "BinaryData.h"
 #include "ScoreArray.h"
 #include "ScoreDataIterator.h"
 
@@ -35,7 +36,11 @@ ScoreDataIterator::ScoreDataIterator() {}
 
 ScoreDataIterator::ScoreDataIterator(const string& filename)
 {
-  m_in.reset(new FilePiece(filename.c_str()));
+  if (IsBinaryDataFile(filename)) {
+    m_binary.reset(new BinaryDataReader(filename));
+  } else {
+    m_in.reset(new FilePiece(filename.c_str()));
+  }
   readNext();
 }
 
@@ -44,6 +49,21 @@ ScoreDataIterator::~ScoreDataIterator() {}
 void ScoreDataIterator::readNext()
 {
   m_next.clear();
+  if (m_binary) {
+    if (!m_binary->Next()) {
+      m_binary.reset();
+      return;
+    }
+    const BinaryBlockHeader& header = m_binary->Header();
+    UTIL_THROW_IF(header.kind != kBinaryScores, util::Exception,
+                  m_binary->FileName() << " holds features, not scores");
+    m_next.resize(header.count);
+    for (size_t i = 0; i < header.count; ++i) {
+      const float* dense = m_binary->Dense(i);
+      m_next[i].assign(dense, dense + header.dense);
+    }
+    return;
+  }
   try {
     StringPiece marker = m_in->ReadDelimited();
     if (marker != StringPiece(SCORES_TXT_BEGIN)) {
@@ -82,6 +102,11 @@ void ScoreDataIterator::increment()
 
 bool ScoreDataIterator::equal(const ScoreDataIterator& rhs) const
 {
+  if (m_binary || rhs.m_binary) {
+    return m_binary && rhs.m_binary &&
+           m_binary->FileName() == rhs.m_binary->FileName() &&
+           m_binary->Offset() == rhs.m_binary->Offset();
+  }
   if (!m_in && !rhs.m_in) {
     return true;
   } else if (!m_in) {
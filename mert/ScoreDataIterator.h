@@ -41,6 +41,7 @@ class FilePiece;
 namespace MosesTuning
 {
 
+class BinaryDataReader;
 
 typedef std::vector<float> ScoreDataItem;
 
@@ -69,6 +70,8 @@ private:
   void readNext();
 
   boost::shared_ptr<util::FilePiece> m_in;
+  // instead of m_in for binary files
+  boost::shared_ptr<BinaryDataReader> m_binary;
   std::vector<ScoreDataItem> m_next;
 };
 
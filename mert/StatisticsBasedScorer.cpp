@@ -66,38 +66,66 @@ void  StatisticsBasedScorer::score(const candidates_t& candidates, const diffs_t
   if (candidates.size() == 0) {
     throw runtime_error("No candidates supplied");
   }
+  boost::shared_ptr<const StatisticsCache> cache = GetCache();
   int numCounts = m_score_data->get(0,candidates[0]).size();
   vector<ScoreStatsType> totals(numCounts);
-  for (size_t i = 0; i < candidates.size(); ++i) {
-    ScoreStats stats = m_score_data->get(i,candidates[i]);
-    if (stats.size() != totals.size()) {
-      stringstream msg;
-      msg << "Statistics for (" << "," << candidates[i] << ") have incorrect "
-          << "number of fields. Found: " << stats.size() << " Expected: "
-          << totals.size();
-      throw runtime_error(msg.str());
+  if (cache->uniform && candidates.size() <= m_score_data->size()) {
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      const ScoreStatsType* stats = cache->get(i, candidates[i]);
+      for (size_t k = 0; k < totals.size(); ++k) {
+        totals[k] += stats[k];
+      }
     }
-    for (size_t k = 0; k < totals.size(); ++k) {
-      totals[k] += stats.get(k);
+    scores.push_back(calculateScore(totals));
+
+    candidates_t last_candidates(candidates);
+    // apply each of the diffs, and get new scores
+    for (size_t i = 0; i < diffs.size(); ++i) {
+      for (size_t j = 0; j < diffs[i].size(); ++j) {
+        size_t sid = diffs[i][j].first;
+        size_t nid = diffs[i][j].second;
+        const ScoreStatsType* stats = cache->get(sid, nid);
+        const ScoreStatsType* last_stats = cache->get(sid, last_candidates[sid]);
+        for (size_t k  = 0; k < totals.size(); ++k) {
+          int diff = stats[k] - last_stats[k];
+          totals[k] += diff;
+        }
+        last_candidates[sid] = nid;
+      }
+      scores.push_back(calculateScore(totals));
     }
-  }
-  scores.push_back(calculateScore(totals));
-
-  candidates_t last_candidates(candidates);
-  // apply each of the diffs, and get new scores
-  for (size_t i = 0; i < diffs.size(); ++i) {
-    for (size_t j = 0; j < diffs[i].size(); ++j) {
-      size_t sid = diffs[i][j].first;
-      size_t nid = diffs[i][j].second;
-      size_t last_nid = last_candidates[sid];
-      for (size_t k  = 0; k < totals.size(); ++k) {
-        int diff = m_score_data->get(sid,nid).get(k)
-                   - m_score_data->get(sid,last_nid).get(k);
-        totals[k] += diff;
+  } else {
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      const ScoreStats& stats = m_score_data->get(i,candidates[i]);
+      if (stats.size() != totals.size()) {
+        stringstream msg;
+        msg << "Statistics for (" << "," << candidates[i] << ") have incorrect "
+            << "number of fields. Found: " << stats.size() << " Expected: "
+            << totals.size();
+        throw runtime_error(msg.str());
+      }
+      for (size_t k = 0; k < totals.size(); ++k) {
+        totals[k] += stats.get(k);
       }
-      last_candidates[sid] = nid;
     }
     scores.push_back(calculateScore(totals));
+
+    candidates_t last_candidates(candidates);
+    // apply each of the diffs, and get new scores
+    for (size_t i = 0; i < diffs.size(); ++i) {
+      for (size_t j = 0; j < diffs[i].size(); ++j) {
+        size_t sid = diffs[i][j].first;
+        size_t nid = diffs[i][j].second;
+        size_t last_nid = last_candidates[sid];
+        for (size_t k  = 0; k < totals.size(); ++k) {
+          int diff = m_score_data->get(sid,nid).get(k)
+                     - m_score_data->get(sid,last_nid).get(k);
+          totals[k] += diff;
+        }
+        last_candidates[sid] = nid;
+      }
+      scores.push_back(calculateScore(totals));
+    }
   }
 
   // Regularisation. This can either be none, or the min or average as described in
@@ -123,5 +151,59 @@ void  StatisticsBasedScorer::score(const candidates_t& candidates, const diffs_t
   }
 }
 
+void StatisticsBasedScorer::setScoreData(ScoreData* data)
+{
+  Scorer::setScoreData(data);
+  // new score data can have the address and the generation of the old
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_cache_lock);
+#endif
+  m_cache.reset();
 }
 
+boost::shared_ptr<const StatisticsBasedScorer::StatisticsCache> StatisticsBasedScorer::GetCache() const
+{
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_cache_lock);
+#endif
+  // catches score data that is loaded or changed after a first use
+  if (m_cache && m_cache->data == m_score_data
+      && m_cache->generation == m_score_data->generation()) {
+    return m_cache;
+  }
+
+  boost::shared_ptr<StatisticsCache> cache(new StatisticsCache);
+  cache->data = m_score_data;
+  cache->generation = m_score_data->generation();
+  cache->num_counts = 0;
+  cache->uniform = true;
+  cache->offsets.resize(m_score_data->size() + 1);
+  cache->offsets[0] = 0;
+  for (size_t i = 0; i < m_score_data->size(); ++i) {
+    cache->offsets[i + 1] = cache->offsets[i] + m_score_data->get(i).size();
+  }
+  if (cache->offsets.back() > 0) {
+    cache->num_counts = m_score_data->get(0, 0).size();
+  }
+  cache->stats.reserve(cache->offsets.back() * cache->num_counts);
+  for (size_t i = 0; i < m_score_data->size(); ++i) {
+    const ScoreArray& array = m_score_data->get(i);
+    for (size_t j = 0; j < array.size(); ++j) {
+      const ScoreStats& stats = array.get(j);
+      if (stats.size() != cache->num_counts) {
+        // leave it to the slow path to complain if these are used
+        cache->uniform = false;
+        cache->stats.clear();
+        m_cache = cache;
+        return m_cache;
+      }
+      for (size_t k = 0; k < cache->num_counts; ++k) {
+        cache->stats.push_back(stats.get(k));
+      }
+    }
+  }
+  m_cache = cache;
+  return m_cache;
+}
+
+}
@@ -9,6 +9,13 @@
 #ifndef mert_lib_StatisticsBasedScorer_h
 #define mert_lib_StatisticsBasedScorer_h
 
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
 #include "Scorer.h"
 
 #include "util/exception.hh"
@@ -28,6 +35,7 @@ class StatisticsBasedScorer : public Scorer
 public:
   StatisticsBasedScorer(const std::string& name, const std::string& config);
   virtual ~StatisticsBasedScorer() {}
+  virtual void setScoreData(ScoreData* data);
   virtual void score(const candidates_t& candidates, const diffs_t& diffs,
                      statscores_t& scores) const;
 
@@ -52,6 +60,37 @@ protected:
   // regularisation
   RegularisationType m_regularization_type;
   std::size_t  m_regularization_window;
+
+private:
+  /**
+   * The statistics of all candidates in one block, the counts of each
+   * candidate next to each other, as the diffs replace a whole candidate.
+   */
+  struct StatisticsCache {
+    const ScoreData* data;
+    std::size_t generation;
+    // whether all candidates have num_counts statistics; if not, stats is
+    // empty
+    bool uniform;
+    std::size_t num_counts;
+    std::vector<std::size_t> offsets;  // first candidate of each sentence
+    std::vector<ScoreStatsType> stats;
+
+    const ScoreStatsType* get(std::size_t i, std::size_t j) const {
+      return &stats[(offsets[i] + j) * num_counts];
+    }
+  };
+
+  /**
+   * The cache for the current score data, built on first use and again if
+   * the score data has changed since.
+   */
+  boost::shared_ptr<const StatisticsCache> GetCache() const;
+
+  mutable boost::shared_ptr<const StatisticsCache> m_cache;
+#ifdef WITH_THREADS
+  mutable boost::mutex m_cache_lock;
+#endif
 };
 
 } // namespace
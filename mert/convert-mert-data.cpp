@@ -0,0 +1,165 @@
+/**
+ * Convert feature and score data files between the text format and the
+ * binary format of BinaryData.h.
+ **/
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <getopt.h>
+
+#include "BinaryData.h"
+#include "FeatureArray.h"
+#include "FileStream.h"
+#include "ScoreArray.h"
+#include "Util.h"
+
+using namespace std;
+using namespace MosesTuning;
+
+namespace
+{
+
+void usage()
+{
+  cerr << "usage: convert-mert-data [options] INPUT OUTPUT" << endl;
+  cerr << "Converts the feature or score data in INPUT, as written by extractor," << endl;
+  cerr << "to the binary format, which mert, pro and kbmira load without parsing." << endl;
+  cerr << "[--text|-t] write the text format instead, e.g. to look at a binary file" << endl;
+  cerr << "[--append|-a] append to OUTPUT, e.g. the data of another iteration" << endl;
+  cerr << "[--help|-h] print this message and exit" << endl;
+  exit(1);
+}
+
+static struct option long_options[] = {
+  {"text", no_argument, 0, 't'},
+  {"append", no_argument, 0, 'a'},
+  {"help", no_argument, 0, 'h'},
+  {0, 0, 0, 0}
+};
+
+void LoadArray(FeatureArray& array, istream& in)
+{
+  array.load(&in, SparseVector());
+}
+
+void LoadArray(ScoreArray& array, istream& in)
+{
+  array.load(&in);
+}
+
+void SaveArray(FeatureArray& array, ostream& out, bool binary)
+{
+  array.save(&out, binary);
+}
+
+void SaveArray(ScoreArray& array, ostream& out, bool binary)
+{
+  array.save(&out, array.name(), binary);
+}
+
+// Copies all arrays of a text (or old binary) file, which starts with a
+// header line, to out.
+template <class Array>
+size_t ConvertText(const string& input, ostream& out, bool binary)
+{
+  inputfilestream in(input);
+  if (!in) {
+    cerr << "Unable to open " << input << endl;
+    exit(1);
+  }
+  size_t count = 0;
+  Array array;
+  while (true) {
+    array.clear();
+    LoadArray(array, in);
+    if (array.size() == 0) break;
+    SaveArray(array, out, binary);
+    ++count;
+  }
+  return count;
+}
+
+size_t ConvertBinary(const string& input, ostream& out, bool binary)
+{
+  BinaryDataReader reader(input);
+  size_t count = 0;
+  FeatureArray features;
+  ScoreArray scores;
+  while (reader.Next()) {
+    if (reader.Header().kind == kBinaryFeatures) {
+      reader.Read(features, SparseVector());
+      SaveArray(features, out, binary);
+    } else {
+      reader.Read(scores);
+      SaveArray(scores, out, binary);
+    }
+    ++count;
+  }
+  return count;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  bool text = false;
+  bool append = false;
+  int c;
+  int option_index;
+  while ((c = getopt_long(argc, argv, "tah", long_options, &option_index)) != -1) {
+    switch (c) {
+    case 't':
+      text = true;
+      break;
+    case 'a':
+      append = true;
+      break;
+    default:
+      usage();
+    }
+  }
+  if (argc - optind != 2) usage();
+  const string input(argv[optind]);
+  const string output(argv[optind + 1]);
+
+  try {
+    ofstream out(output.c_str(), ios::out | ios::binary | (append ? ios::app : ios::trunc));
+    if (!out) {
+      cerr << "Unable to open " << output << endl;
+      exit(1);
+    }
+
+    size_t count;
+    if (IsBinaryDataFile(input)) {
+      count = ConvertBinary(input, out, !text);
+    } else {
+      // tell features from scores by the header of the first array
+      string header;
+      {
+        inputfilestream in(input);
+        getline(in, header);
+      }
+      if (header.find(FEATURES_TXT_BEGIN) == 0 || header.find(FEATURES_BIN_BEGIN) == 0) {
+        count = ConvertText<FeatureArray>(input, out, !text);
+      } else if (header.find(SCORES_TXT_BEGIN) == 0 || header.find(SCORES_BIN_BEGIN) == 0) {
+        count = ConvertText<ScoreArray>(input, out, !text);
+      } else {
+        cerr << input << " holds neither features nor scores" << endl;
+        exit(1);
+      }
+    }
+    out.close();
+    if (!out) {
+      cerr << "Failed to write " << output << endl;
+      exit(1);
+    }
+    cerr << "Converted " << count << " sentences" << endl;
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
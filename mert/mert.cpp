@@ -2,6 +2,7 @@
  * \description This is the main for the new version of the mert algorithm developed during the 2nd MT marathon
 */
 
+#include <algorithm>
 #include <limits>
 #include <unistd.h>
 #include <cstdlib>
@@ -118,6 +119,7 @@ void usage(int ret)
   cerr<<"[--sparse-weights|-p] required for merging sparse features"<<endl;
 #ifdef WITH_THREADS
   cerr<<"[--threads|-T] use multiple threads (default 1)"<<endl;
+  cerr<<"[--work-stealing] use per-thread task queues with work stealing"<<endl;
 #endif
   cerr<<"[--shard-count] Split data into shards, optimize for each shard and average"<<endl;
   cerr<<"[--shard-size] Shard size as proportion of data. If 0, use non-overlapping shards"<<endl;
@@ -141,6 +143,7 @@ static struct option long_options[] = {
   {"sparse-weights",required_argument,0,'p'},
 #ifdef WITH_THREADS
   {"threads", required_argument,0,'T'},
+  {"work-stealing", no_argument,0,'W'},
 #endif
   {"shard-count", required_argument, 0, 'a'},
   {"shard-size", required_argument, 0, 'b'},
@@ -165,6 +168,7 @@ struct ProgramOption {
   string positive_string;
   string sparse_weights_file;
   size_t num_threads;
+  bool work_stealing;
   float shard_size;
   size_t shard_count;
 
@@ -184,6 +188,7 @@ struct ProgramOption {
       positive_string(kDefaultPositiveString),
       sparse_weights_file(kDefaultSparseWeightsFile),
       num_threads(1),
+      work_stealing(false),
       shard_size(0),
       shard_count(0) { }
 };
@@ -240,6 +245,9 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt)
       opt->num_threads = strtol(optarg, NULL, 10);
       if (opt->num_threads < 1) opt->num_threads = 1;
       break;
+    case 'W':
+      opt->work_stealing = true;
+      break;
 #endif
     case 'a':
       opt->shard_count = strtof(optarg, NULL);
@@ -433,7 +441,7 @@ int main(int argc, char **argv)
 
 #ifdef WITH_THREADS
   cerr << "Creating a pool of " << option.num_threads << " threads" << endl;
-  Moses::ThreadPool pool(option.num_threads);
+  Moses::ThreadPool pool(option.num_threads, option.work_stealing);
 #endif
 
   Point::setpdim(option.pdim);
@@ -461,6 +469,12 @@ int main(int argc, char **argv)
     allTasks.resize(option.shard_count);
   }
 
+  // Threads left over from the restarts go to the line searches of each.
+  const size_t line_threads = std::max<size_t>(1, option.num_threads / (allTasks.size() * startingPoints.size()));
+  if (line_threads > 1) {
+    cerr << "Using " << line_threads << " threads in each line search" << endl;
+  }
+
   // launch tasks
   for (size_t i = 0; i < allTasks.size(); ++i) {
     Data& data_ref = data;
@@ -471,6 +485,7 @@ int main(int argc, char **argv)
     Optimizer *optimizer = OptimizerFactory::BuildOptimizer(option.pdim, to_optimize, positive, start_list[0], option.optimize_type, option.nrandom);
     optimizer->SetScorer(data_ref.getScorer());
     optimizer->SetFeatureData(data_ref.getFeatureData());
+    optimizer->SetThreads(line_threads);
     // A task for each start point
     for (size_t j = 0; j < startingPoints.size(); ++j) {
       boost::shared_ptr<OptimizationTask>
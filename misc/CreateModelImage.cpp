@@ -0,0 +1,60 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+#include "moses/ModelImage.h"
+#include "util/exception.hh"
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+  string image;
+  vector<string> models;
+
+  namespace po = boost::program_options;
+  po::options_description desc("Copies binarized models into a model image, "
+                               "a directory on tmpfs that decoders started with "
+                               "-model-image DIR map instead of the models. Do not "
+                               "update an image while decoders are using it.\n\nOptions");
+  desc.add_options()
+  ("help", "Print help messages")
+  ("image", po::value<string>()->required(), "Image directory, e.g. /dev/shm/moses")
+  ("model", po::value<vector<string> >()->required(), "Model file or directory (ProbingPT), as given to the decoder. For compact tables, give the .minphr or .minlexr file")
+  ;
+  po::positional_options_description positional;
+  positional.add("model", -1);
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(desc).positional(positional).run(),
+              vm); // can throw
+
+    if ( vm.count("help")) {
+      std::cout << desc << std::endl;
+      return EXIT_SUCCESS;
+    }
+
+    po::notify(vm); // throws on error, so do after help in case
+    // there are any problems
+  } catch(po::error& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl << std::endl;
+    std::cerr << desc << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  image = vm["image"].as<string>();
+  models = vm["model"].as<vector<string> >();
+
+  try {
+    for (size_t i = 0; i < models.size(); ++i) {
+      size_t bytes = Moses::CopyToModelImage(image, models[i]);
+      std::cerr << models[i] << " -> " << Moses::ModelImagePath(image, models[i])
+                << " (" << bytes << " bytes)" << std::endl;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
@@ -0,0 +1,137 @@
+// Lookup throughput of a binary ProbingPT table, one key at a time as opposed
+// to the batched, prefetching lookup that the decoder does for each sentence.
+// Every source phrase of the input sentences up to the maximum phrase length
+// is looked up and the head of its target phrase collection read.  Each
+// method is timed first with the table files evicted from the page cache
+// (cold) and then again with them resident (warm).
+#include <fcntl.h>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <boost/unordered_map.hpp>
+#include "util/file.hh"
+#include "util/mmap.hh"
+#include "util/usage.hh"
+#include "moses/TranslationModel/ProbingPT/querying.hh"
+#include "moses/Util.h"
+
+using namespace std;
+
+namespace
+{
+
+typedef vector<uint64_t> Keys;
+
+void Evict(const string &path)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(path.c_str()));
+  posix_fadvise(file.get(), 0, 0, POSIX_FADV_DONTNEED);
+}
+
+uint64_t LookupEach(Moses::QueryEngine &engine, const char *data, const vector<Keys> &sentences)
+{
+  uint64_t sink = 0;
+  for (size_t s = 0; s < sentences.size(); ++s) {
+    const Keys &keys = sentences[s];
+    for (size_t i = 0; i < keys.size(); ++i) {
+      std::pair<bool, uint64_t> result = engine.query(keys[i]);
+      if (result.first) {
+        sink += *(const uint64_t*) (data + result.second);
+      }
+    }
+  }
+  return sink;
+}
+
+uint64_t LookupBatch(Moses::QueryEngine &engine, const char *data, const vector<Keys> &sentences)
+{
+  uint64_t sink = 0;
+  std::vector<std::pair<bool, uint64_t> > results;
+  for (size_t s = 0; s < sentences.size(); ++s) {
+    const Keys &keys = sentences[s];
+    if (keys.empty()) continue;
+    results.resize(keys.size());
+    engine.query(&keys[0], keys.size(), &results[0]);
+    for (size_t i = 0; i < results.size(); ++i) {
+      if (results[i].first) Moses::prefetchMem(data + results[i].second);
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+      if (results[i].first) {
+        sink += *(const uint64_t*) (data + results[i].second);
+      }
+    }
+  }
+  return sink;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " path_to_directory [max_phrase_length=7] < sentences" << std::endl;
+    return 1;
+  }
+  const string dir = argv[1];
+  const size_t maxLength = argc > 2 ? Moses::Scan<size_t>(argv[2]) : 7;
+
+  // source vocab, word -> pt id
+  boost::unordered_map<string, uint64_t> vocab;
+  {
+    Moses::QueryEngine engine(dir.c_str());
+    const std::map<uint64_t, std::string> &sourceVocab = engine.getSourceVocab();
+    std::map<uint64_t, std::string>::const_iterator iter;
+    for (iter = sourceVocab.begin(); iter != sourceVocab.end(); ++iter) {
+      vocab[iter->second] = iter->first;
+    }
+  }
+
+  // keys of all known source phrases, per sentence
+  vector<Keys> sentences;
+  size_t numKeys = 0;
+  string line;
+  while (getline(std::cin, line)) {
+    vector<string> toks = Moses::Tokenize(line);
+    vector<uint64_t> ids(toks.size());
+    vector<bool> known(toks.size());
+    for (size_t i = 0; i < toks.size(); ++i) {
+      boost::unordered_map<string, uint64_t>::const_iterator iter = vocab.find(toks[i]);
+      known[i] = iter != vocab.end();
+      if (known[i]) ids[i] = iter->second;
+    }
+
+    sentences.push_back(Keys());
+    Keys &keys = sentences.back();
+    for (size_t start = 0; start < toks.size(); ++start) {
+      for (size_t end = start; end < toks.size() && end - start < maxLength && known[end]; ++end) {
+        keys.push_back(Moses::getKey(&ids[start], end - start + 1));
+      }
+    }
+    numKeys += keys.size();
+  }
+  std::cerr << sentences.size() << " sentences, " << numKeys << " lookups" << std::endl;
+
+  for (int batch = 0; batch < 2; ++batch) {
+    // a fresh engine and mapping, with nothing of the table files in memory
+    Moses::QueryEngine engine(dir.c_str());
+    util::scoped_fd targetFile(util::OpenReadOrThrow((dir + "/TargetColl.dat").c_str()));
+    util::scoped_memory target;
+    util::MapRead(util::LAZY, targetFile.get(), 0, util::SizeOrThrow(targetFile.get()), target);
+    const char *data = static_cast<const char*>(target.get());
+    Evict(dir + "/probing_hash.dat");
+    Evict(dir + "/TargetColl.dat");
+
+    for (int warm = 0; warm < 2; ++warm) {
+      double start = util::WallTime();
+      uint64_t sink = batch ? LookupBatch(engine, data, sentences) : LookupEach(engine, data, sentences);
+      double seconds = util::WallTime() - start;
+      std::cout << (batch ? "batched" : "single ")
+                << (warm ? " warm" : " cold")
+                << " seconds=" << seconds
+                << " lookups/s=" << numKeys / seconds
+                << " checksum=" << sink << std::endl;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,234 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2011 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+#ifndef moses_AsyncInputReader_h
+#define moses_AsyncInputReader_h
+
+#ifdef WITH_THREADS
+
+#include <deque>
+#include <exception>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include <boost/bind/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "util/exception.hh"
+
+namespace Moses
+{
+/**
+* Reads one-line inputs ahead of the decoder.  A reader thread takes lines
+* from the stream in blocks and a few parser threads turn them into inputs,
+* while Next() hands the inputs out in the order of the stream.  At most a
+* couple of blocks per parser are buffered.
+*
+* The parser gets each line with its newline, if it had one, so that it can
+* read it like the stream itself.  A result that converts to false ends the
+* input, like a failed read.
+*
+* Without waitForReader the destructor doesn't wait for the reader thread,
+* which may be blocked reading a terminal.  The thread then ends after its
+* read returns, so the stream has to live until the program exits, like
+* std::cin.
+**/
+template <class Item> class AsyncInputReader
+{
+public:
+  typedef boost::function<Item (const std::string&)> Parser;
+
+  AsyncInputReader(std::istream& in, const Parser& parser,
+                   size_t threads, size_t blockSize = 32,
+                   bool waitForReader = true)
+    : m_shared(new Shared(in, blockSize ? blockSize : 1,
+                          2 * (threads ? threads : 1) + 1))
+    , m_parser(parser)
+    , m_waitForReader(waitForReader) {
+    m_reader = boost::thread(boost::bind(&AsyncInputReader::Read, m_shared));
+    for (size_t i = 0; i < (threads ? threads : 1); ++i) {
+      m_parsers.create_thread(boost::bind(&AsyncInputReader::Parse, this));
+    }
+  }
+
+  ~AsyncInputReader() {
+    {
+      boost::mutex::scoped_lock lock(m_shared->mutex);
+      m_shared->stop = true;
+    }
+    m_shared->changed.notify_all();
+    m_parsers.join_all();
+    if (m_waitForReader) {
+      m_reader.join();
+    } else {
+      m_reader.detach();
+    }
+  }
+
+  /** The next input in stream order, or a false Item at the end. */
+  Item Next() {
+    Shared &shared = *m_shared;
+    boost::mutex::scoped_lock lock(shared.mutex);
+    while (true) {
+      while (!shared.blocks.empty() && shared.blocks.front()->state == Block::kParsed
+             && shared.position == shared.blocks.front()->items.size()) {
+        shared.blocks.pop_front();
+        shared.position = 0;
+        shared.changed.notify_all();
+      }
+      if (!shared.blocks.empty() && shared.blocks.front()->state == Block::kParsed) break;
+      if (shared.blocks.empty() && shared.readAll) return Item();
+      shared.changed.wait(lock);
+    }
+    boost::shared_ptr<Block> block = shared.blocks.front();
+    const size_t position = shared.position++;
+    Item item = block->items[position];
+    if (!item) {
+      // like a failed read, this ends the input
+      shared.readAll = true;
+      shared.blocks.clear();
+      shared.position = 0;
+      shared.changed.notify_all();
+      if (position == block->failedAt) UTIL_THROW2(block->error);
+    }
+    return item;
+  }
+
+private:
+  struct Block {
+    enum State { kRead, kParsing, kParsed };
+
+    Block() : state(kRead), failedAt(-1) {}
+
+    State state;
+    std::vector<std::string> lines;
+    std::vector<Item> items;
+    // the item that raised an exception, if any, and its message
+    size_t failedAt;
+    std::string error;
+  };
+
+  // Shared with the reader thread, which can outlive this object.
+  struct Shared {
+    Shared(std::istream& in, size_t blockSize, size_t maxBlocks)
+      : in(in), blockSize(blockSize), maxBlocks(maxBlocks)
+      , position(0), readAll(false), stop(false) {}
+
+    std::istream& in;
+    const size_t blockSize;
+    const size_t maxBlocks;
+
+    boost::mutex mutex;
+    boost::condition_variable changed;
+    // blocks in stream order, from the one being consumed to the last read
+    std::deque<boost::shared_ptr<Block> > blocks;
+    // next item of the front block
+    size_t position;
+    // no more blocks will be added
+    bool readAll;
+    bool stop;
+  };
+
+  static void Read(boost::shared_ptr<Shared> shared) {
+    while (true) {
+      {
+        boost::mutex::scoped_lock lock(shared->mutex);
+        while (!shared->stop && !shared->readAll && shared->blocks.size() >= shared->maxBlocks)
+          shared->changed.wait(lock);
+        if (shared->stop || shared->readAll) return;
+      }
+      boost::shared_ptr<Block> block(new Block);
+      bool end = false;
+      std::string line;
+      while (block->lines.size() < shared->blockSize) {
+        if (!std::getline(shared->in, line)) {
+          end = true;
+          break;
+        }
+        if (!shared->in.eof()) line += '\n';
+        block->lines.push_back(line);
+        // don't wait for more lines if none are buffered, e.g. when
+        // somebody types the input
+        if (shared->in.rdbuf()->in_avail() <= 0) break;
+      }
+      boost::mutex::scoped_lock lock(shared->mutex);
+      if (shared->stop || shared->readAll) return;
+      if (!block->lines.empty()) shared->blocks.push_back(block);
+      if (end) shared->readAll = true;
+      shared->changed.notify_all();
+      if (end) return;
+    }
+  }
+
+  void Parse() {
+    Shared &shared = *m_shared;
+    boost::mutex::scoped_lock lock(shared.mutex);
+    while (true) {
+      boost::shared_ptr<Block> block;
+      for (typename std::deque<boost::shared_ptr<Block> >::iterator i = shared.blocks.begin();
+           i != shared.blocks.end(); ++i) {
+        if ((*i)->state == Block::kRead) {
+          block = *i;
+          break;
+        }
+      }
+      if (!block) {
+        if (shared.stop || (shared.readAll && shared.blocks.empty())) return;
+        shared.changed.wait(lock);
+        continue;
+      }
+      block->state = Block::kParsing;
+      lock.unlock();
+      block->items.reserve(block->lines.size());
+      try {
+        for (size_t i = 0; i < block->lines.size(); ++i) {
+          block->items.push_back(m_parser(block->lines[i]));
+          if (!block->items.back()) break;
+        }
+      } catch (const std::exception& e) {
+        block->failedAt = block->items.size();
+        block->error = e.what();
+        block->items.push_back(Item());
+      }
+      block->lines.clear();
+      lock.lock();
+      block->state = Block::kParsed;
+      shared.changed.notify_all();
+    }
+  }
+
+  boost::shared_ptr<Shared> m_shared;
+  const Parser m_parser;
+  const bool m_waitForReader;
+
+  boost::thread m_reader;
+  boost::thread_group m_parsers;
+};
+
+} // namespace Moses
+
+#endif // WITH_THREADS
+
+#endif
@@ -0,0 +1,146 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2011 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#ifdef WITH_THREADS
+
+#include <sstream>
+
+#include "AsyncInputReader.h"
+#include "Util.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+typedef boost::shared_ptr<string> Line;
+
+// Stops at "stop" and throws at "throw".  Later lines are slower, so that
+// blocks finish out of order.
+Line ParseLine(const string& line)
+{
+  size_t number = 0;
+  std::istringstream(line) >> number;
+  if (number % 7 == 0)
+    boost::this_thread::sleep(boost::posix_time::microseconds(number));
+  if (line == "stop\n") return Line();
+  if (line == "throw\n") throw util::Exception();
+  return Line(new string(line));
+}
+
+// Reads block until Release(), like a terminal nobody types into.
+class BlockingBuf : public std::streambuf
+{
+public:
+  BlockingBuf() : m_reading(false), m_released(false) {}
+
+  void WaitForRead() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (!m_reading) m_changed.wait(lock);
+  }
+
+  void Release() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_released = true;
+    m_changed.notify_all();
+  }
+
+protected:
+  int_type underflow() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_reading = true;
+    m_changed.notify_all();
+    while (!m_released) m_changed.wait(lock);
+    return traits_type::eof();
+  }
+
+private:
+  boost::mutex m_mutex;
+  boost::condition_variable m_changed;
+  bool m_reading;
+  bool m_released;
+};
+}
+
+BOOST_AUTO_TEST_SUITE(async_input_reader)
+
+BOOST_AUTO_TEST_CASE(in_order)
+{
+  ostringstream text;
+  for (size_t i = 0; i < 1000; ++i) text << i << "\n";
+  text << "last";
+  istringstream in(text.str());
+  AsyncInputReader<Line> reader(in, &ParseLine, 3, 5);
+  for (size_t i = 0; i < 1000; ++i) {
+    Line line = reader.Next();
+    BOOST_REQUIRE(line);
+    BOOST_CHECK_EQUAL(*line, SPrint(i) + "\n");
+  }
+  // without a newline
+  Line last = reader.Next();
+  BOOST_REQUIRE(last);
+  BOOST_CHECK_EQUAL(*last, "last");
+  BOOST_CHECK(!reader.Next());
+  BOOST_CHECK(!reader.Next());
+}
+
+BOOST_AUTO_TEST_CASE(failed_parse_ends_input)
+{
+  istringstream in("1\n2\nstop\n4\n5\n");
+  AsyncInputReader<Line> reader(in, &ParseLine, 2, 1);
+  BOOST_CHECK_EQUAL(*reader.Next(), "1\n");
+  BOOST_CHECK_EQUAL(*reader.Next(), "2\n");
+  BOOST_CHECK(!reader.Next());
+  BOOST_CHECK(!reader.Next());
+}
+
+BOOST_AUTO_TEST_CASE(exception_reaches_caller)
+{
+  istringstream in("1\nthrow\n3\n");
+  AsyncInputReader<Line> reader(in, &ParseLine, 2);
+  BOOST_CHECK_EQUAL(*reader.Next(), "1\n");
+  BOOST_CHECK_THROW(reader.Next(), util::Exception);
+  BOOST_CHECK(!reader.Next());
+}
+
+BOOST_AUTO_TEST_CASE(empty_input)
+{
+  istringstream in("");
+  AsyncInputReader<Line> reader(in, &ParseLine, 4);
+  BOOST_CHECK(!reader.Next());
+}
+
+BOOST_AUTO_TEST_CASE(blocked_reader_left_behind)
+{
+  // the reader thread outlives the test, so the stream must too
+  static BlockingBuf buf;
+  static istream in(&buf);
+  {
+    AsyncInputReader<Line> reader(in, &ParseLine, 2, 32, false);
+    buf.WaitForRead();
+  }
+  // the destructor returned while the reader is still blocked
+  buf.Release();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
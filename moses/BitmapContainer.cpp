@@ -212,8 +212,7 @@ BackwardsEdge::Initialize()
   const Range &newRange = m_translations.Get(0)->GetSourceWordsRange();
   m_estimatedScore = m_estimatedScores.CalcEstimatedScore(bm, newRange.GetStartPos(), newRange.GetEndPos());
 
-  Hypothesis *expanded = CreateHypothesis(*m_hypotheses[0], *m_translations.Get(0));
-  m_parent.Enqueue(0, 0, expanded, this);
+  Expand(0, 0);
   SetSeenPosition(0, 0);
   m_initialized = true;
 }
@@ -234,6 +233,53 @@ Hypothesis *BackwardsEdge::CreateHypothesis(const Hypothesis &hypothesis, const
   return newHypo;
 }
 
+/**
+ * Queue the candidate at x, y.  With lazy scoring, it is queued with an
+ * estimate: the score of the hypothesis it extends, the score of the
+ * translation option (including its language model estimate) and the future
+ * cost.  Stateful feature functions only score it when it reaches the top.
+ */
+void
+BackwardsEdge::Expand(const size_t x, const size_t y)
+{
+  if (m_parent.GetLazyBatchSize()) {
+    const TranslationOption &transOpt = *m_translations.Get(y);
+    const float estimate = m_hypotheses[x]->GetScore() + transOpt.GetFutureScore() + m_estimatedScore;
+    m_parent.Enqueue(x, y, estimate, transOpt, this);
+  } else {
+    m_parent.Enqueue(x, y, CreateHypothesis(*m_hypotheses[x], *m_translations.Get(y)), this);
+  }
+}
+
+/**
+ * Create and score the hypotheses of candidates queued by Expand() as one
+ * batch.
+ */
+void
+BackwardsEdge::ScoreCandidates(const std::vector<HypothesisQueueItem*> &items)
+{
+  Manager &manager = m_hypotheses[0]->GetManager();
+  IFVERBOSE(2) {
+    manager.GetSentenceStats().StartTimeBuildHyp();
+  }
+  const Bitmap &bitmap = m_parent.GetWordsBitmap();
+  std::vector<Hypothesis*> hypos;
+  hypos.reserve(items.size());
+  for (size_t i = 0; i < items.size(); ++i) {
+    hypos.push_back(new Hypothesis(*m_hypotheses[items[i]->GetHypothesisPos()]
+                                   , *m_translations.Get(items[i]->GetTranslationPos())
+                                   , bitmap
+                                   , manager.GetNextHypoId()));
+  }
+  IFVERBOSE(2) {
+    manager.GetSentenceStats().StopTimeBuildHyp();
+  }
+  Hypothesis::EvaluateWhenApplied(hypos, m_estimatedScore);
+  for (size_t i = 0; i < items.size(); ++i) {
+    items[i]->SetHypothesis(hypos[i]);
+  }
+}
+
 bool
 BackwardsEdge::SeenPosition(const size_t x, const size_t y)
 {
@@ -266,22 +312,14 @@ BackwardsEdge::GetBitmapContainer() const
 void
 BackwardsEdge::PushSuccessors(const size_t x, const size_t y)
 {
-  Hypothesis *newHypo;
-
   if(y + 1 < m_translations.size() && !SeenPosition(x, y + 1)) {
     SetSeenPosition(x, y + 1);
-    newHypo = CreateHypothesis(*m_hypotheses[x], *m_translations.Get(y + 1));
-    if(newHypo != NULL) {
-      m_parent.Enqueue(x, y + 1, newHypo, (BackwardsEdge*)this);
-    }
+    Expand(x, y + 1);
   }
 
   if(x + 1 < m_hypotheses.size() && !SeenPosition(x + 1, y)) {
     SetSeenPosition(x + 1, y);
-    newHypo = CreateHypothesis(*m_hypotheses[x + 1], *m_translations.Get(y));
-    if(newHypo != NULL) {
-      m_parent.Enqueue(x + 1, y, newHypo, (BackwardsEdge*)this);
-    }
+    Expand(x + 1, y);
   }
 }
 
@@ -292,11 +330,13 @@ BackwardsEdge::PushSuccessors(const size_t x, const size_t y)
 
 BitmapContainer::BitmapContainer(const Bitmap &bitmap
                                  , HypothesisStackCubePruning &stack
-                                 , bool deterministic)
+                                 , bool deterministic
+                                 , size_t lazyBatchSize)
   : m_bitmap(bitmap)
   , m_stack(stack)
   , m_numStackInsertions(0)
   , m_deterministic(deterministic)
+  , m_lazyBatchSize(lazyBatchSize)
 {
   m_hypotheses = HypothesisSet();
   m_edges = BackwardsEdgeSet();
@@ -345,6 +385,21 @@ BitmapContainer::Enqueue(int hypothesis_pos
   }
 }
 
+void
+BitmapContainer::Enqueue(int hypothesis_pos
+                         , int translation_pos
+                         , float estimate
+                         , const TranslationOption &transOpt
+                         , BackwardsEdge *edge)
+{
+  const TargetPhrase *target_phrase = m_deterministic ? &transOpt.GetTargetPhrase() : NULL;
+  m_queue.push(new HypothesisQueueItem(hypothesis_pos
+                                       , translation_pos
+                                       , estimate
+                                       , edge
+                                       , target_phrase));
+}
+
 HypothesisQueueItem*
 BitmapContainer::Dequeue(bool keepValue)
 {
@@ -437,6 +492,48 @@ BitmapContainer::InitializeEdges()
   }
 }
 
+/**
+ * If the best candidate is not scored yet, score it together with the
+ * unscored candidates among the next ones, up to the batch size, and queue
+ * them again by their real scores.  Returns whether anything was scored, in
+ * which case the best candidate may have changed.
+ */
+bool
+BitmapContainer::ScoreBestCandidates()
+{
+  if (m_queue.empty() || m_queue.top()->IsScored()) {
+    return false;
+  }
+
+  // candidates of the same edge share its future cost and are scored together
+  std::vector<HypothesisQueueItem*> taken;
+  std::vector<std::pair<BackwardsEdge*, std::vector<HypothesisQueueItem*> > > batches;
+  while (!m_queue.empty() && taken.size() < m_lazyBatchSize) {
+    HypothesisQueueItem *item = m_queue.top();
+    m_queue.pop();
+    taken.push_back(item);
+    if (item->IsScored()) {
+      continue;
+    }
+    size_t batch = 0;
+    while (batch < batches.size() && batches[batch].first != item->GetBackwardsEdge()) {
+      ++batch;
+    }
+    if (batch == batches.size()) {
+      batches.push_back(std::make_pair(item->GetBackwardsEdge(), std::vector<HypothesisQueueItem*>()));
+    }
+    batches[batch].second.push_back(item);
+  }
+
+  for (size_t batch = 0; batch < batches.size(); ++batch) {
+    batches[batch].first->ScoreCandidates(batches[batch].second);
+  }
+  for (size_t i = 0; i < taken.size(); ++i) {
+    m_queue.push(taken[i]);
+  }
+  return true;
+}
+
 void
 BitmapContainer::EnsureMinStackHyps(const size_t minNumHyps)
 {
@@ -448,6 +545,9 @@ BitmapContainer::EnsureMinStackHyps(const size_t minNumHyps)
 void
 BitmapContainer::ProcessBestHypothesis()
 {
+  // With lazy scoring, only a scored candidate goes on the stack.
+  while (ScoreBestCandidates()) {}
+
   if (m_queue.empty()) {
     return;
   }
@@ -461,10 +561,10 @@ BitmapContainer::ProcessBestHypothesis()
   // check we are pulling things off of priority queue in right order
   if (!Empty()) {
     HypothesisQueueItem *check = Dequeue(true);
-    UTIL_THROW_IF2(item->GetHypothesis()->GetFutureScore() < check->GetHypothesis()->GetFutureScore(),
+    UTIL_THROW_IF2(item->GetScore() < check->GetScore(),
                    "Non-monotonic total score: "
-                   << item->GetHypothesis()->GetFutureScore() << " vs. "
-                   << check->GetHypothesis()->GetFutureScore());
+                   << item->GetScore() << " vs. "
+                   << check->GetScore());
   }
 
   // Logging for the criminally insane
@@ -62,6 +62,7 @@ private:
   Hypothesis *m_hypothesis;
   BackwardsEdge *m_edge;
   boost::shared_ptr<TargetPhrase> m_target_phrase;
+  float m_score;
 
   HypothesisQueueItem();
 
@@ -74,7 +75,24 @@ public:
     : m_hypothesis_pos(hypothesis_pos)
     , m_translation_pos(translation_pos)
     , m_hypothesis(hypothesis)
-    , m_edge(edge) {
+    , m_edge(edge)
+    , m_score(hypothesis->GetFutureScore()) {
+    if (target_phrase != NULL) {
+      m_target_phrase.reset(new TargetPhrase(*target_phrase));
+    }
+  }
+
+  //! a candidate that is not scored yet, with an estimate of its score
+  HypothesisQueueItem(const size_t hypothesis_pos
+                      , const size_t translation_pos
+                      , float estimate
+                      , BackwardsEdge *edge
+                      , const TargetPhrase *target_phrase = NULL)
+    : m_hypothesis_pos(hypothesis_pos)
+    , m_translation_pos(translation_pos)
+    , m_hypothesis(NULL)
+    , m_edge(edge)
+    , m_score(estimate) {
     if (target_phrase != NULL) {
       m_target_phrase.reset(new TargetPhrase(*target_phrase));
     }
@@ -95,6 +113,20 @@ public:
     return m_hypothesis;
   }
 
+  bool IsScored() const {
+    return m_hypothesis != NULL;
+  }
+
+  //! the future score of the hypothesis, or the estimate if it is not scored yet
+  float GetScore() const {
+    return m_score;
+  }
+
+  void SetHypothesis(Hypothesis *hypothesis) {
+    m_hypothesis = hypothesis;
+    m_score = hypothesis->GetFutureScore();
+  }
+
   BackwardsEdge *GetBackwardsEdge() {
     return m_edge;
   }
@@ -109,8 +141,8 @@ class QueueItemOrderer
 {
 public:
   bool operator()(HypothesisQueueItem* itemA, HypothesisQueueItem* itemB) const {
-    float scoreA = itemA->GetHypothesis()->GetFutureScore();
-    float scoreB = itemB->GetHypothesis()->GetFutureScore();
+    float scoreA = itemA->GetScore();
+    float scoreB = itemB->GetScore();
 
     if (scoreA < scoreB) {
       return true;
@@ -196,6 +228,8 @@ private:
   BackwardsEdge();
 
   Hypothesis *CreateHypothesis(const Hypothesis &hypothesis, const TranslationOption &transOpt);
+  void Expand(const size_t x, const size_t y);
+  void ScoreCandidates(const std::vector<HypothesisQueueItem*> &items);
   bool SeenPosition(const size_t x, const size_t y);
   void SetSeenPosition(const size_t x, const size_t y);
 
@@ -235,6 +269,8 @@ private:
   HypothesisQueue m_queue;
   size_t m_numStackInsertions;
   bool m_deterministic;
+  // with lazy scoring, the number of candidates scored together, else 0
+  size_t m_lazyBatchSize;
 
   // We always require a corresponding bitmap to be supplied.
   BitmapContainer();
@@ -242,13 +278,15 @@ private:
 public:
   BitmapContainer(const Bitmap &bitmap
                   , HypothesisStackCubePruning &stack
-                  , bool deterministic = false);
+                  , bool deterministic = false
+                  , size_t lazyBatchSize = 0);
 
   // The destructor will also delete all the edges that are
   // connected to this BitmapContainer.
   ~BitmapContainer();
 
   void Enqueue(int hypothesis_pos, int translation_pos, Hypothesis *hypothesis, BackwardsEdge *edge);
+  void Enqueue(int hypothesis_pos, int translation_pos, float estimate, const TranslationOption &transOpt, BackwardsEdge *edge);
   HypothesisQueueItem *Dequeue(bool keepValue=false);
   HypothesisQueueItem *Top() const;
   size_t Size();
@@ -258,11 +296,16 @@ public:
     return m_bitmap;
   }
 
+  size_t GetLazyBatchSize() const {
+    return m_lazyBatchSize;
+  }
+
   const HypothesisSet &GetHypotheses() const;
   size_t GetHypothesesSize() const;
   const BackwardsEdgeSet &GetBackwardsEdges();
 
   void InitializeEdges();
+  bool ScoreBestCandidates();
   void ProcessBestHypothesis();
   void EnsureMinStackHyps(const size_t minNumHyps);
   void AddHypothesis(Hypothesis *hypothesis);
@@ -32,11 +32,24 @@
 #include "ChartManager.h"
 #include "util/exception.hh"
 
+#include <boost/bind.hpp>
+
 using namespace std;
 
 namespace Moses
 {
 
+namespace
+{
+// Score the best hypothesis of each of the rule cubes cubes[begin, end).
+void ScoreRuleCubes(std::vector<RuleCube*> &cubes, size_t begin, size_t end)
+{
+  for (size_t i = begin; i < end; ++i) {
+    cubes[i]->ScoreTopLeft();
+  }
+}
+}
+
 ChartCellBase::ChartCellBase(size_t startPos, size_t endPos) :
   m_coverage(startPos, endPos),
   m_targetLabelSet(m_coverage) {}
@@ -94,10 +107,16 @@ void ChartCell::Decode(const ChartTranslationOptionList &transOptList
   RuleCubeQueue queue(m_manager);
 
   // add all trans opt into queue. using only 1st child node.
-  for (size_t i = 0; i < transOptList.GetSize(); ++i) {
-    const ChartTranslationOptions &transOpt = transOptList.Get(i);
-    RuleCube *ruleCube = new RuleCube(transOpt, allChartCells, m_manager);
-    queue.Add(ruleCube);
+  // the cubes are created in order, which numbers their hypotheses as
+  // serially, and are scored in parallel with --chart-threads
+  std::vector<RuleCube*> cubes(transOptList.GetSize());
+  for (size_t i = 0; i < cubes.size(); ++i) {
+    cubes[i] = new RuleCube(transOptList.Get(i), allChartCells, m_manager);
+  }
+  m_manager.ParallelFor(cubes.size(), boost::bind(&ScoreRuleCubes,
+                        boost::ref(cubes), _1, _2));
+  for (size_t i = 0; i < cubes.size(); ++i) {
+    queue.Add(cubes[i]);
   }
 
   // pluck things out of queue and add to hypo collection
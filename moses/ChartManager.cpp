@@ -36,6 +36,10 @@
 #include "moses/HypergraphOutput.h"
 #include "moses/TranslationTask.h"
 
+#ifdef WITH_THREADS
+#include "moses/ThreadPool.h"
+#endif
+
 using namespace std;
 
 namespace Moses
@@ -63,6 +67,22 @@ ChartManager::~ChartManager()
 
 }
 
+void ChartManager::ParallelFor(size_t size, boost::function<void (size_t, size_t)> const& body) const
+{
+#ifdef WITH_THREADS
+  ThreadPool *pool = StaticData::Instance().GetChartThreadPool();
+  const size_t numThreads = options()->syntax.chart_threads;
+  // not worth handing out tiny ranges
+  const size_t minRange = 8;
+  if (pool && numThreads > 1 && size >= 2 * minRange) {
+    Moses::ParallelFor(*pool, size,
+                       std::min(numThreads * 4, size / minRange), body);
+    return;
+  }
+#endif
+  if (size) body(0, size);
+}
+
 //! decode the sentence. This contains the main laps. Basically, the CKY++ algorithm
 void ChartManager::Decode()
 {
@@ -310,6 +330,10 @@ void ChartManager::OutputBest(OutputCollector *collector) const
     const size_t translationId = m_source.GetTranslationId();
     const ChartHypothesis *bestHypo = GetBestHypothesis();
     OutputBestHypo(collector, bestHypo, translationId);
+  } else if (collector) {
+    // the collector waits for every sentence, so write an empty line
+    VERBOSE(1, "NO BEST TRANSLATION" << std::endl);
+    collector->Write(m_source.GetTranslationId(), "\n");
   }
 }
 
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <vector>
+#include <boost/function.hpp>
 #include <boost/unordered_map.hpp>
 #include "ChartCell.h"
 #include "ChartCellCollection.h"
@@ -136,6 +137,12 @@ public:
     return m_hypothesisId++;
   }
 
+  /** Call body(begin, end) on consecutive ranges covering [0, size), on
+   *  --chart-threads threads. Ranges run concurrently, so body may only
+   *  touch the chart read-only, plus whatever belongs to its own range.
+   */
+  void ParallelFor(size_t size, boost::function<void (size_t, size_t)> const& body) const;
+
   const ChartParser &GetParser() const {
     return m_parser;
   }
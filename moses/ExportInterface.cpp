@@ -197,7 +197,7 @@ batch_run()
   }
 
 #ifdef WITH_THREADS
-  ThreadPool pool(staticData.ThreadCount());
+  ThreadPool pool(staticData.ThreadCount(), staticData.ThreadWorkStealing());
 #endif
 
   // using context for adaptation:
@@ -232,6 +232,11 @@ batch_run()
   while ((source = ioWrapper->ReadInput(cw)) != NULL) {
     IFVERBOSE(1) ResetUserTime();
 
+#ifdef WITH_THREADS
+    // don't let output pile up behind a slow sentence
+    ioWrapper->WaitForOutputWindow(source->GetTranslationId());
+#endif
+
     // set up task of translating one sentence
     boost::shared_ptr<ContextScope>  lscope;
     if (gscope) lscope = gscope;
@@ -1,8 +1,36 @@
 #include "KenOSM.h"
+#include "moses/Util.h"
 
 namespace Moses
 {
 
+namespace
+{
+// jumps back over more open gaps than this are looked up by name
+const size_t kInternedJumps = 64;
+}
+
+void KenOSMBase::InternOperations()
+{
+  m_insertGap = Index("_INS_GAP_");
+  m_jumpForward = Index("_JMP_FWD_");
+  m_continueCept = Index("_CONT_CEPT_");
+  m_translateSelf = Index("_TRANS_SLF_");
+
+  m_jumpBack.resize(kInternedJumps + 1);
+  for (size_t gaps = 0; gaps <= kInternedJumps; ++gaps) {
+    m_jumpBack[gaps] = Index("_JMP_BCK_" + SPrint(gaps));
+  }
+}
+
+lm::WordIndex KenOSMBase::JumpBack(size_t gaps) const
+{
+  if (gaps < m_jumpBack.size()) {
+    return m_jumpBack[gaps];
+  }
+  return Index("_JMP_BCK_" + SPrint(gaps));
+}
+
 OSMLM* ConstructOSMLM(const char *file, util::LoadMethod load_method)
 {
   lm::ngram::ModelType model_type;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "lm/model.hh"
 
 namespace Moses
@@ -14,9 +15,37 @@ public:
   virtual float Score(const lm::ngram::State&, StringPiece,
                       lm::ngram::State&) const = 0;
 
+  virtual float Score(const lm::ngram::State&, lm::WordIndex,
+                      lm::ngram::State&) const = 0;
+
+  virtual lm::WordIndex Index(StringPiece) const = 0;
+
   virtual const lm::ngram::State &BeginSentenceState() const = 0;
 
   virtual const lm::ngram::State &NullContextState() const = 0;
+
+  // Vocabulary ids of the operations that don't carry words, interned
+  // when the model is loaded
+  lm::WordIndex InsertGap() const {
+    return m_insertGap;
+  }
+  lm::WordIndex JumpForward() const {
+    return m_jumpForward;
+  }
+  lm::WordIndex ContinueCept() const {
+    return m_continueCept;
+  }
+  lm::WordIndex TranslateSelf() const {
+    return m_translateSelf;
+  }
+  lm::WordIndex JumpBack(size_t gaps) const;
+
+protected:
+  void InternOperations();
+
+private:
+  lm::WordIndex m_insertGap, m_jumpForward, m_continueCept, m_translateSelf;
+  std::vector<lm::WordIndex> m_jumpBack; // _JMP_BCK_n at index n
 };
 
 template <class KenModel>
@@ -24,7 +53,9 @@ class KenOSM : public KenOSMBase
 {
 public:
   KenOSM(const char *file, const lm::ngram::Config &config)
-    : m_kenlm(file, config) {}
+    : m_kenlm(file, config) {
+    InternOperations();
+  }
 
   float Score(const lm::ngram::State &in_state,
               StringPiece word,
@@ -33,6 +64,16 @@ public:
                          out_state);
   }
 
+  float Score(const lm::ngram::State &in_state,
+              lm::WordIndex word,
+              lm::ngram::State &out_state) const {
+    return m_kenlm.Score(in_state, word, out_state);
+  }
+
+  lm::WordIndex Index(StringPiece word) const {
+    return m_kenlm.GetVocabulary().Index(word);
+  }
+
   const lm::ngram::State &BeginSentenceState() const {
     return m_kenlm.BeginSentenceState();
   }
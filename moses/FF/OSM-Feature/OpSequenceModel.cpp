@@ -27,12 +27,11 @@ OpSequenceModel::~OpSequenceModel()
 
 void OpSequenceModel :: readLanguageModel(const char *lmFile)
 {
-  string unkOp = "_TRANS_SLF_";
   OSM = ConstructOSMLM(m_lmPath.c_str(), load_method);
 
   State startState = OSM->NullContextState();
   State endState;
-  unkOpProb = OSM->Score(startState,unkOp,endState);
+  unkOpProb = OSM->Score(startState,OSM->TranslateSelf(),endState);
 }
 
 
@@ -50,11 +49,11 @@ void OpSequenceModel:: EvaluateInIsolation(const Phrase &source
     , ScoreComponentCollection &estimatedScores) const
 {
 
-  osmHypothesis obj;
+  osmHypothesis obj(*OSM);
   obj.setState(OSM->NullContextState());
   Bitmap myBitmap(source.GetSize());
-  vector <string> mySourcePhrase;
-  vector <string> myTargetPhrase;
+  vector <StringPiece> mySourcePhrase;
+  vector <StringPiece> myTargetPhrase;
   vector<float> scores;
   vector <int> alignments;
   int startIndex = 0;
@@ -72,17 +71,17 @@ void OpSequenceModel:: EvaluateInIsolation(const Phrase &source
     if (targetPhrase.GetWord(i).IsOOV() && sFactor == 0 && tFactor == 0)
       myTargetPhrase.push_back("_TRANS_SLF_");
     else
-      myTargetPhrase.push_back(targetPhrase.GetWord(i).GetFactor(tFactor)->GetString().as_string());
+      myTargetPhrase.push_back(targetPhrase.GetWord(i).GetFactor(tFactor)->GetString());
   }
 
   for (size_t i = 0; i < source.GetSize(); i++) {
-    mySourcePhrase.push_back(source.GetWord(i).GetFactor(sFactor)->GetString().as_string());
+    mySourcePhrase.push_back(source.GetWord(i).GetFactor(sFactor)->GetString());
   }
 
   obj.setPhrases(mySourcePhrase , myTargetPhrase);
   obj.constructCepts(alignments,startIndex,endIndex-1,targetPhrase.GetSize());
   obj.computeOSMFeature(startIndex,myBitmap);
-  obj.calculateOSMProb(*OSM);
+  obj.calculateOSMProb();
   obj.populateScores(scores,numFeatures);
   estimatedScores.PlusEquals(this, scores);
 
@@ -100,9 +99,9 @@ FFState* OpSequenceModel::EvaluateWhenApplied(
   const Manager &manager = cur_hypo.GetManager();
   const InputType &source = manager.GetSource();
   // const Sentence &sourceSentence = static_cast<const Sentence&>(source);
-  osmHypothesis obj;
-  vector <string> mySourcePhrase;
-  vector <string> myTargetPhrase;
+  osmHypothesis obj(*OSM);
+  vector <StringPiece> mySourcePhrase;
+  vector <StringPiece> myTargetPhrase;
   vector<float> scores;
 
 
@@ -147,7 +146,7 @@ FFState* OpSequenceModel::EvaluateWhenApplied(
 
   for (int i = startIndex; i <= endIndex; i++) {
     myBitmap.SetValue(i,0); // resetting coverage of this phrase ...
-    mySourcePhrase.push_back(source.GetWord(i).GetFactor(sFactor)->GetString().as_string());
+    mySourcePhrase.push_back(source.GetWord(i).GetFactor(sFactor)->GetString());
     // cerr<<mySourcePhrase[i]<<endl;
   }
 
@@ -156,7 +155,7 @@ FFState* OpSequenceModel::EvaluateWhenApplied(
     if (target.GetWord(i).IsOOV() && sFactor == 0 && tFactor == 0)
       myTargetPhrase.push_back("_TRANS_SLF_");
     else
-      myTargetPhrase.push_back(target.GetWord(i).GetFactor(tFactor)->GetString().as_string());
+      myTargetPhrase.push_back(target.GetWord(i).GetFactor(tFactor)->GetString());
 
   }
 
@@ -167,7 +166,7 @@ FFState* OpSequenceModel::EvaluateWhenApplied(
   obj.constructCepts(alignments,startIndex,endIndex,target.GetSize());
   obj.setPhrases(mySourcePhrase , myTargetPhrase);
   obj.computeOSMFeature(startIndex,myBitmap);
-  obj.calculateOSMProb(*OSM);
+  obj.calculateOSMProb();
   obj.populateScores(scores,numFeatures);
   //obj.print();
 
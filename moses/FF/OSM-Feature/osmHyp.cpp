@@ -1,4 +1,5 @@
 #include "osmHyp.h"
+#include <cstring>
 #include <sstream>
 
 using namespace std;
@@ -6,6 +7,119 @@ using namespace lm::ngram;
 
 namespace Moses
 {
+
+namespace
+{
+int countBits(boost::uint64_t word)
+{
+  int count = 0;
+  for (; word; word &= word - 1)
+    count++;
+  return count;
+}
+
+int highestBit(boost::uint64_t word)
+{
+  int bit = 63;
+  while (!(word >> bit))
+    bit--;
+  return bit;
+}
+}
+
+osmGaps::osmGaps()
+{
+  memset(m_inline, 0, sizeof(m_inline));
+}
+
+void osmGaps::setBit(int pos, int which, bool value)
+{
+  size_t w = pos / 64;
+  boost::uint64_t mask = boost::uint64_t(1) << (pos % 64);
+  boost::uint64_t *word;
+
+  if (w < kInlineWords) {
+    word = &m_inline[which][w];
+  } else {
+    size_t index = 2 * (w - kInlineWords) + which;
+    if (index >= m_overflow.size()) {
+      if (!value)
+        return;
+      m_overflow.resize(2 * (w - kInlineWords + 1), 0);
+    }
+    word = &m_overflow[index];
+  }
+
+  if (value)
+    *word |= mask;
+  else
+    *word &= ~mask;
+}
+
+int osmGaps::countUnfilled() const
+{
+  int nd = 0;
+  for (size_t w = 0; w < numWords(); w++)
+    nd += countBits(getWord(w, 0));
+  return nd;
+}
+
+int osmGaps::closestGap(int j1, int & gp) const
+{
+  gp = 0;
+  if (j1 < 0)
+    return -1;
+
+  // the right-most open gap at or before j1 ...
+  int value = -1;
+  size_t w = j1 / 64;
+  boost::uint64_t word = getWord(w, 0) & ((boost::uint64_t(2) << (j1 % 64)) - 1);
+  while (true) {
+    if (word) {
+      value = w * 64 + highestBit(word);
+      break;
+    }
+    if (w == 0)
+      return -1;
+    word = getWord(--w, 0);
+  }
+
+  // ... and the number of open gaps from it to the right-most one
+  gp = countBits(getWord(w, 0) >> (value % 64));
+  for (w++; w < numWords(); w++)
+    gp += countBits(getWord(w, 0));
+
+  return value;
+}
+
+size_t osmGaps::hash() const
+{
+  size_t ret = 0;
+  for (size_t w = 0; w < numWords(); w++) {
+    if (getWord(w, 0) || getWord(w, 1)) {
+      boost::hash_combine(ret, w);
+      boost::hash_combine(ret, getWord(w, 0));
+      boost::hash_combine(ret, getWord(w, 1));
+    }
+  }
+  return ret;
+}
+
+bool osmGaps::operator==(const osmGaps &other) const
+{
+  if (memcmp(m_inline, other.m_inline, sizeof(m_inline)) != 0)
+    return false;
+
+  size_t words = std::max(numWords(), other.numWords());
+  for (size_t w = kInlineWords; w < words; w++) {
+    if (getWord(w, 0) != other.getWord(w, 0) || getWord(w, 1) != other.getWord(w, 1))
+      return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+
 osmState::osmState(const State & val)
   :j(0)
   ,E(0)
@@ -14,9 +128,8 @@ osmState::osmState(const State & val)
 
 }
 
-void osmState::saveState(int jVal, int eVal, map <int , string> & gapVal)
+void osmState::saveState(int jVal, int eVal, const osmGaps & gapVal)
 {
-  gap.clear();
   gap = gapVal;
   j = jVal;
   E = eVal;
@@ -27,7 +140,7 @@ size_t osmState::hash() const
   size_t ret = j;
 
   boost::hash_combine(ret, E);
-  boost::hash_combine(ret, gap);
+  boost::hash_combine(ret, gap.hash());
   boost::hash_combine(ret, lmState.length);
 
   return ret;
@@ -40,7 +153,7 @@ bool osmState::operator==(const FFState& otherBase) const
     return false;
   if (E != other.E)
     return false;
-  if (gap != other.gap)
+  if (!(gap == other.gap))
     return false;
   if (lmState.length != other.lmState.length)
     return false;
@@ -56,7 +169,8 @@ std::string osmState :: getName() const
 
 //////////////////////////////////////////////////
 
-osmHypothesis :: osmHypothesis()
+osmHypothesis :: osmHypothesis(const OSMLM &osm)
+  :osm(osm)
 {
   opProb = 0;
   gapWidth = 0;
@@ -66,18 +180,18 @@ osmHypothesis :: osmHypothesis()
   gapCount = 0;
   j = 0;
   E = 0;
-  gap.clear();
 }
 
 void osmHypothesis :: setState(const FFState* prev_state)
 {
 
   if(prev_state != NULL) {
+    const osmState *state = static_cast <const osmState *> (prev_state);
 
-    j = static_cast <const osmState *> (prev_state)->getJ();
-    E =  static_cast <const osmState *> (prev_state)->getE();
-    gap = static_cast <const osmState *> (prev_state)->getGap();
-    lmState = static_cast <const osmState *> (prev_state)->getLMState();
+    j = state->getJ();
+    E = state->getE();
+    gap = state->getGap();
+    lmState = state->getLMState();
   }
 }
 
@@ -89,47 +203,7 @@ osmState * osmHypothesis :: saveState()
   return statePtr;
 }
 
-int osmHypothesis :: isTranslationOperation(int x)
-{
-  if (operations[x].find("_JMP_BCK_") != -1)
-    return 0;
-
-  if (operations[x].find("_JMP_FWD_") != -1)
-    return 0;
-
-  if (operations[x].find("_CONT_CEPT_") != -1)
-    return 0;
-
-  if (operations[x].find("_INS_GAP_") != -1)
-    return 0;
-
-  return 1;
-
-}
-
-void osmHypothesis :: removeReorderingOperations()
-{
-  gapCount = 0;
-  deletionCount = 0;
-  openGapCount = 0;
-  gapWidth = 0;
-
-  std::vector <std::string> tupleSequence;
-
-  for (int x = 0; x < operations.size(); x++) {
-    // cout<<operations[x]<<endl;
-
-    if(isTranslationOperation(x) == 1) {
-      tupleSequence.push_back(operations[x]);
-    }
-
-  }
-
-  operations.clear();
-  operations = tupleSequence;
-}
-
-void osmHypothesis :: calculateOSMProb(OSMLM& ptrOp)
+void osmHypothesis :: calculateOSMProb()
 {
 
   opProb = 0;
@@ -138,7 +212,7 @@ void osmHypothesis :: calculateOSMProb(OSMLM& ptrOp)
 
   for (size_t i = 0; i<operations.size(); i++) {
     temp = currState;
-    opProb += ptrOp.Score(temp,operations[i],currState);
+    opProb += osm.Score(temp,operations[i],currState);
   }
 
   lmState = currState;
@@ -163,13 +237,14 @@ int osmHypothesis :: firstOpenGap(vector <int> & coverageVector)
 
 }
 
-string osmHypothesis :: intToString(int num)
+void osmHypothesis :: pushOperation(StringPiece prefix, StringPiece word)
 {
-  return SPrint(num);
-
+  opBuffer.assign(prefix.data(), prefix.size());
+  opBuffer.append(word.data(), word.size());
+  operations.push_back(osm.Index(opBuffer));
 }
 
-void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFlag , Bitmap & coverageVector , string english , string german , set <int> & targetNullWords , vector <string> & currF)
+void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFlag , Bitmap & coverageVector , StringPiece english , StringPiece german , set <int> & targetNullWords , vector <StringPiece> & currF)
 {
 
   int gFlag = 0;
@@ -180,14 +255,14 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
   if ( j < j1) { // j1 is the index of the source word we are about to generate ...
     //if(coverageVector[j]==0) // if source word at j is not generated yet ...
     if(coverageVector.GetValue(j)==0) { // if source word at j is not generated yet ...
-      operations.push_back("_INS_GAP_");
+      operations.push_back(osm.InsertGap());
       gFlag++;
-      gap[j]="Unfilled";
+      gap.setUnfilled(j);
     }
     if (j == E) {
       j = j1;
     } else {
-      operations.push_back("_JMP_FWD_");
+      operations.push_back(osm.JumpForward());
       j=E;
     }
   }
@@ -195,24 +270,24 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
   if (j1 < j) {
     // if(j < E && coverageVector[j]==0)
     if(j < E && coverageVector.GetValue(j)==0) {
-      operations.push_back("_INS_GAP_");
+      operations.push_back(osm.InsertGap());
       gFlag++;
-      gap[j]="Unfilled";
+      gap.setUnfilled(j);
     }
 
-    j=closestGap(gap,j1,gp);
-    operations.push_back("_JMP_BCK_"+ intToString(gp));
+    j=gap.closestGap(j1,gp);
+    operations.push_back(osm.JumpBack(gp));
 
     //cout<<"I am j "<<j<<endl;
     //cout<<"I am j1 "<<j1<<endl;
 
     if(j==j1)
-      gap[j]="Filled";
+      gap.setFilled(j);
   }
 
   if (j < j1) {
-    operations.push_back("_INS_GAP_");
-    gap[j] = "Unfilled";
+    operations.push_back(osm.InsertGap());
+    gap.setUnfilled(j);
     gFlag++;
     j=j1;
   }
@@ -220,9 +295,13 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
   if(contFlag == 0) { // First words of the multi-word cept ...
 
     if(english == "_TRANS_SLF_") { // Unknown word ...
-      operations.push_back("_TRANS_SLF_");
+      operations.push_back(osm.TranslateSelf());
     } else {
-      operations.push_back("_TRANS_" + english + "_TO_" + german);
+      opBuffer.assign("_TRANS_");
+      opBuffer.append(english.data(), english.size());
+      opBuffer.append("_TO_");
+      opBuffer.append(german.data(), german.size());
+      operations.push_back(osm.Index(opBuffer));
     }
 
     //ans = firstOpenGap(coverageVector);
@@ -233,14 +312,14 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
 
   } else if (contFlag == 2) {
 
-    operations.push_back("_INS_" + german);
+    pushOperation("_INS_", german);
     ans = coverageVector.GetFirstGapPos();
 
     if (ans != -1)
       gapWidth += j - ans;
     deletionCount++;
   } else {
-    operations.push_back("_CONT_CEPT_");
+    operations.push_back(osm.ContinueCept());
   }
 
   //coverageVector[j]=1;
@@ -253,7 +332,7 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
   if (gFlag > 0)
     gapCount++;
 
-  openGapCount += getOpenGaps();
+  openGapCount += gap.countUnfilled();
 
   //if (coverageVector[j] == 0 && targetNullWords.find(j) != targetNullWords.end())
   if (j < coverageVector.GetSize()) {
@@ -285,70 +364,10 @@ void osmHypothesis :: print()
   cerr<<"_______________"<<endl;
 }
 
-int osmHypothesis :: closestGap(map <int,string> gap, int j1, int & gp)
+void osmHypothesis :: generateDeleteOperations(StringPiece english, int currTargetIndex, const std::set <int> & doneTargetIndexes)
 {
 
-  int dist=1172;
-  int value=-1;
-  int temp=0;
-  gp=0;
-  int opGap=0;
-
-  map <int,string> :: iterator iter;
-
-  iter=gap.end();
-
-  do {
-    iter--;
-    //cout<<"Trapped "<<iter->first<<endl;
-
-    if(iter->first==j1 && iter->second== "Unfilled") {
-      opGap++;
-      gp = opGap;
-      return j1;
-
-    }
-
-    if(iter->second =="Unfilled") {
-      opGap++;
-      temp = iter->first - j1;
-
-      if(temp<0)
-        temp=temp * -1;
-
-      if(dist>temp && iter->first < j1) {
-        dist=temp;
-        value=iter->first;
-        gp=opGap;
-      }
-    }
-
-
-  } while(iter!=gap.begin());
-
-  return value;
-}
-
-
-
-int osmHypothesis :: getOpenGaps()
-{
-  map <int,string> :: iterator iter;
-
-  int nd = 0;
-  for (iter = gap.begin(); iter!=gap.end(); iter++) {
-    if(iter->second == "Unfilled")
-      nd++;
-  }
-
-  return nd;
-
-}
-
-void osmHypothesis :: generateDeleteOperations(std::string english, int currTargetIndex, std::set <int> doneTargetIndexes)
-{
-
-  operations.push_back("_DEL_" + english);
+  pushOperation("_DEL_", english);
   currTargetIndex++;
 
   while(doneTargetIndexes.find(currTargetIndex) != doneTargetIndexes.end()) {
@@ -366,9 +385,7 @@ void osmHypothesis :: computeOSMFeature(int startIndex , Bitmap & coverageVector
 {
 
   set <int> doneTargetIndexes;
-  set <int> eSide;
-  set <int> fSide;
-  set <int> :: iterator iter;
+  set <int> :: const_iterator iter;
   string english;
   string source;
   int j1;
@@ -382,28 +399,25 @@ void osmHypothesis :: computeOSMFeature(int startIndex , Bitmap & coverageVector
     if (*iter == startIndex) {
 
       j1 = startIndex;
-      source = currF[j1-startIndex];
-      english = "_INS_";
-      generateOperations(startIndex, j1, 2 , coverageVector , english , source , targetNullWords , currF);
+      generateOperations(startIndex, j1, 2 , coverageVector , "_INS_" , currF[j1-startIndex] , targetNullWords , currF);
     }
   }
 
   if (sourceNullWords.find(targetIndex) != sourceNullWords.end()) { // first word has to be deleted ...
-    english = currE[targetIndex];
-    generateDeleteOperations(english,targetIndex, doneTargetIndexes);
+    generateDeleteOperations(currE[targetIndex],targetIndex, doneTargetIndexes);
   }
 
 
   for (size_t i = 0; i < ceptsInPhrase.size(); i++) {
-    source = "";
-    english = "";
+    source.clear();
+    english.clear();
 
-    fSide = ceptsInPhrase[i].first;
-    eSide = ceptsInPhrase[i].second;
+    const set <int> & fSide = ceptsInPhrase[i].first;
+    const set <int> & eSide = ceptsInPhrase[i].second;
 
     iter = eSide.begin();
     targetIndex = *iter;
-    english += currE[*iter];
+    english.append(currE[*iter].data(), currE[*iter].size());
     iter++;
 
     for (; iter != eSide.end(); iter++) {
@@ -413,16 +427,16 @@ void osmHypothesis :: computeOSMFeature(int startIndex , Bitmap & coverageVector
         doneTargetIndexes.insert(*iter);
 
       english += "^_^";
-      english += currE[*iter];
+      english.append(currE[*iter].data(), currE[*iter].size());
     }
 
     iter = fSide.begin();
-    source += currF[*iter];
+    source.append(currF[*iter].data(), currF[*iter].size());
     iter++;
 
     for (; iter != fSide.end(); iter++) {
       source += "^_^";
-      source += currF[*iter];
+      source.append(currF[*iter].data(), currF[*iter].size());
     }
 
     iter = fSide.begin();
@@ -444,8 +458,7 @@ void osmHypothesis :: computeOSMFeature(int startIndex , Bitmap & coverageVector
     }
 
     if(sourceNullWords.find(targetIndex) != sourceNullWords.end()) {
-      english = currE[targetIndex];
-      generateDeleteOperations(english,targetIndex, doneTargetIndexes);
+      generateDeleteOperations(currE[targetIndex],targetIndex, doneTargetIndexes);
     }
   }
 
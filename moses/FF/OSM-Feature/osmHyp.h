@@ -6,12 +6,62 @@
 # include <map>
 # include <string>
 # include <vector>
+# include <boost/cstdint.hpp>
 
 #include "KenOSM.h"
 
 namespace Moses
 {
 
+/** Gap history of an OSM hypothesis: the source positions at which a gap
+ was inserted, and whether it has been filled by jumping back to it since.
+ Positions are bits in two fixed blocks of words, so the history is copied,
+ hashed and compared without allocating; only sentences longer than the
+ inline blocks spill into a vector. */
+class osmGaps
+{
+public:
+  osmGaps();
+
+  void setUnfilled(int pos) {
+    setBit(pos, 0, true);
+    setBit(pos, 1, false);
+  }
+  void setFilled(int pos) {
+    setBit(pos, 0, false);
+    setBit(pos, 1, true);
+  }
+
+  // number of gaps that are still open
+  int countUnfilled() const;
+
+  /* the open gap closest to j1 from the left (j1 included), or -1.  gp is
+   its rank counting open gaps from the right-most one, starting at 1 */
+  int closestGap(int j1, int & gp) const;
+
+  size_t hash() const;
+  bool operator==(const osmGaps &other) const;
+
+private:
+  enum { kInlineWords = 4 };
+
+  // word w of the unfilled (which = 0) or filled (which = 1) positions
+  boost::uint64_t getWord(size_t w, int which) const {
+    if (w < kInlineWords) {
+      return m_inline[which][w];
+    }
+    w = 2 * (w - kInlineWords) + which;
+    return w < m_overflow.size() ? m_overflow[w] : 0;
+  }
+  void setBit(int pos, int which, bool value);
+  size_t numWords() const {
+    return kInlineWords + m_overflow.size() / 2;
+  }
+
+  boost::uint64_t m_inline[2][kInlineWords];
+  std::vector<boost::uint64_t> m_overflow; // interleaved unfilled/filled words
+};
+
 class osmState : public FFState
 {
 public:
@@ -19,18 +69,18 @@ public:
   virtual size_t hash() const;
   virtual bool operator==(const FFState& other) const;
 
-  void saveState(int jVal, int eVal, std::map <int , std::string> & gapVal);
+  void saveState(int jVal, int eVal, const osmGaps & gapVal);
   int getJ()const {
     return j;
   }
   int getE()const {
     return E;
   }
-  std::map <int , std::string> getGap() const {
+  const osmGaps &getGap() const {
     return gap;
   }
 
-  lm::ngram::State getLMState() const {
+  const lm::ngram::State &getLMState() const {
     return lmState;
   }
 
@@ -39,7 +89,7 @@ public:
 
 protected:
   int j, E;
-  std::map <int,std::string> gap;
+  osmGaps gap;
   lm::ngram::State lmState;
 };
 
@@ -49,8 +99,10 @@ class osmHypothesis
 private:
 
 
-  std::vector <std::string> operations;	// List of operations required to generated this hyp ...
-  std::map <int,std::string> gap;	// Maintains gap history ...
+  const OSMLM &osm;
+  std::vector <lm::WordIndex> operations;	// List of operations required to generated this hyp ...
+  std::string opBuffer;	// Spelling of the lexical operation being looked up ...
+  osmGaps gap;	// Maintains gap history ...
   int j;	// Position after the last source word generated ...
   int E; // Position after the right most source word so far generated ...
   lm::ngram::State lmState; // KenLM's Model State ...
@@ -61,33 +113,29 @@ private:
   int gapWidth;
   double opProb;
 
-  std::vector <std::string> currE;
-  std::vector <std::string> currF;
+  std::vector <StringPiece> currE;
+  std::vector <StringPiece> currF;
   std::vector < std::pair < std::set <int> , std::set <int> > > ceptsInPhrase;
   std::set <int> targetNullWords;
   std::set <int> sourceNullWords;
 
-  int closestGap(std::map <int,std::string> gap,int j1, int & gp);
   int firstOpenGap(std::vector <int> & coverageVector);
-  std::string intToString(int);
-  int  getOpenGaps();
-  int isTranslationOperation(int j);
-  void removeReorderingOperations();
+  void pushOperation(StringPiece prefix, StringPiece word);
 
   void getMeCepts ( std::set <int> & eSide , std::set <int> & fSide , std::map <int , std::vector <int> > & tS , std::map <int , std::vector <int> > & sT);
 
 public:
 
-  osmHypothesis();
+  osmHypothesis(const OSMLM &osm);
   ~osmHypothesis() {};
-  void generateOperations(int & startIndex, int j1 , int contFlag , Bitmap & coverageVector , std::string english , std::string german , std::set <int> & targetNullWords , std::vector <std::string> & currF);
-  void generateDeleteOperations(std::string english, int currTargetIndex, std::set <int> doneTargetIndexes);
-  void calculateOSMProb(OSMLM& ptrOp);
+  void generateOperations(int & startIndex, int j1 , int contFlag , Bitmap & coverageVector , StringPiece english , StringPiece german , std::set <int> & targetNullWords , std::vector <StringPiece> & currF);
+  void generateDeleteOperations(StringPiece english, int currTargetIndex, const std::set <int> & doneTargetIndexes);
+  void calculateOSMProb();
   void computeOSMFeature(int startIndex , Bitmap & coverageVector);
   void constructCepts(std::vector <int> & align , int startIndex , int endIndex, int targetPhraseLength);
-  void setPhrases(std::vector <std::string> & val1 , std::vector <std::string> & val2) {
-    currF = val1;
-    currE = val2;
+  void setPhrases(std::vector <StringPiece> & val1 , std::vector <StringPiece> & val2) {
+    currF.swap(val1);
+    currE.swap(val2);
   }
   void setState(const FFState* prev_state);
   osmState * saveState();
@@ -19,5 +19,18 @@ StatefulFeatureFunction
   m_statefulFFs.push_back(this);
 }
 
+void
+StatefulFeatureFunction
+::EvaluateWhenAppliedBatch(const std::vector<const Hypothesis*>& hypos,
+                           const std::vector<const FFState*>& prev_states,
+                           const std::vector<ScoreComponentCollection*>& accumulators,
+                           std::vector<FFState*>& new_states) const
+{
+  new_states.resize(hypos.size());
+  for (size_t i = 0; i < hypos.size(); ++i) {
+    new_states[i] = EvaluateWhenApplied(*hypos[i], prev_states[i], accumulators[i]);
+  }
+}
+
 }
 
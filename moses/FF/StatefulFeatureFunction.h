@@ -42,6 +42,19 @@ public:
     const FFState* prev_state,
     ScoreComponentCollection* accumulator) const = 0;
 
+  /**
+   * EvaluateWhenApplied() for several hypotheses at once, eg. all expansions
+   * of one hypothesis. hypos[i] has the previous state prev_states[i], adds
+   * its scores to accumulators[i] and gets the new state new_states[i].
+   * The default evaluates them one by one. Override it to overlap the
+   * memory accesses of the hypotheses, as the language model does.
+   */
+  virtual void EvaluateWhenAppliedBatch(
+    const std::vector<const Hypothesis*>& hypos,
+    const std::vector<const FFState*>& prev_states,
+    const std::vector<ScoreComponentCollection*>& accumulators,
+    std::vector<FFState*>& new_states) const;
+
   // virtual FFState* EvaluateWhenAppliedWithContext(
   //   ttasksptr const& ttasks,
   //   const Hypothesis& cur_hypo,
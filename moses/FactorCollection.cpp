@@ -19,15 +19,16 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
-#include <boost/version.hpp>
+#include <new>
+#include <ostream>
+#include <string>
+#include <cstring>
 #ifdef WITH_THREADS
 #include <boost/thread/locks.hpp>
 #endif
-#include <ostream>
-#include <string>
 #include "FactorCollection.h"
 #include "Util.h"
-#include "util/pool.hh"
+#include "util/murmur_hash.hh"
 
 using namespace std;
 
@@ -35,52 +36,125 @@ namespace Moses
 {
 FactorCollection FactorCollection::s_instance;
 
-const Factor *FactorCollection::AddFactor(const StringPiece &factorString, bool isNonTerminal)
+namespace
 {
-  FactorFriend to_ins;
-  to_ins.in.m_string = factorString;
-  to_ins.in.m_id = (isNonTerminal) ? m_factorIdNonTerminal : m_factorId;
-  Set & set = (isNonTerminal) ? m_set : m_setNonTerminal;
-  // If we're threaded, hope a read-only lock is sufficient.
-#ifdef WITH_THREADS
-  {
-    // read=lock scope
-    boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
-    Set::const_iterator i = set.find(to_ins);
-    if (i != set.end()) return &i->in;
+inline size_t HashString(const StringPiece &str)
+{
+  return util::MurmurHashNative(str.data(), str.size());
+}
+}
+
+FactorCollection::Table::Table(size_t size)
+  : mask(size - 1)
+  , slots(new Slot[size])
+{
+  for (size_t i = 0; i < size; ++i) {
+    slots[i].hash.store(0, boost::memory_order_relaxed);
+    slots[i].factor.store(NULL, boost::memory_order_relaxed);
   }
-  boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
-#endif // WITH_THREADS
-  std::pair<Set::iterator, bool> ret(set.insert(to_ins));
-  if (ret.second) {
-    ret.first->in.m_string.set(
-      memcpy(m_string_backing.Allocate(factorString.size()), factorString.data(), factorString.size()),
-      factorString.size());
-    if (isNonTerminal) {
-      m_factorIdNonTerminal++;
-      UTIL_THROW_IF2(m_factorIdNonTerminal >= moses_MaxNumNonterminals, "Number of non-terminals exceeds maximum size reserved. Adjust parameter moses_MaxNumNonterminals, then recompile");
-    } else {
-      m_factorId++;
+}
+
+FactorCollection::Table::~Table()
+{
+  delete [] slots;
+}
+
+FactorCollection::Shard::~Shard()
+{
+  delete table.load(boost::memory_order_relaxed);
+  for (size_t i = 0; i < retired.size(); ++i) {
+    delete retired[i];
+  }
+}
+
+const Factor *FactorCollection::Find(const Table *table, const StringPiece &factorString, size_t hash)
+{
+  if (table == NULL) return NULL;
+  // the slot comes from the hash bits above the ones that picked the shard
+  for (size_t i = (hash / NumShards) & table->mask;; i = (i + 1) & table->mask) {
+    const Slot &slot = table->slots[i];
+    // the acquire pairs with the release in Place(), so the Factor is fully written
+    const Factor *factor = slot.factor.load(boost::memory_order_acquire);
+    if (factor == NULL) return NULL;
+    if (slot.hash.load(boost::memory_order_relaxed) == hash && factor->m_string == factorString) {
+      return factor;
     }
   }
-  return &ret.first->in;
 }
 
-const Factor *FactorCollection::GetFactor(const StringPiece &factorString, bool isNonTerminal)
+void FactorCollection::Place(Table &table, const Factor *factor, size_t hash)
+{
+  for (size_t i = (hash / NumShards) & table.mask;; i = (i + 1) & table.mask) {
+    Slot &slot = table.slots[i];
+    if (slot.factor.load(boost::memory_order_relaxed) == NULL) {
+      slot.hash.store(hash, boost::memory_order_relaxed);
+      slot.factor.store(factor, boost::memory_order_release);
+      return;
+    }
+  }
+}
+
+const Factor *FactorCollection::Insert(Shard &shard, const StringPiece &factorString, size_t hash, bool isNonTerminal)
 {
-  FactorFriend to_find;
-  to_find.in.m_string = factorString;
-  to_find.in.m_id = (isNonTerminal) ? m_factorIdNonTerminal : m_factorId;
-  Set & set = (isNonTerminal) ? m_set : m_setNonTerminal;
-  {
-    // read=lock scope
 #ifdef WITH_THREADS
-    boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
-#endif // WITH_THREADS
-    Set::const_iterator i = set.find(to_find);
-    if (i != set.end()) return &i->in;
+  boost::lock_guard<boost::mutex> lock(shard.lock);
+#endif
+  // somebody may have added it since we looked
+  Table *table = shard.table.load(boost::memory_order_relaxed);
+  const Factor *found = Find(table, factorString, hash);
+  if (found) return found;
+
+  // keep the table at most half full
+  if (table == NULL || (shard.count + 1) * 2 > table->mask + 1) {
+    Table *bigger = new Table(table ? (table->mask + 1) * 2 : 64);
+    if (table) {
+      for (size_t i = 0; i <= table->mask; ++i) {
+        const Slot &slot = table->slots[i];
+        const Factor *factor = slot.factor.load(boost::memory_order_relaxed);
+        if (factor) Place(*bigger, factor, slot.hash.load(boost::memory_order_relaxed));
+      }
+      shard.retired.push_back(table);
+    }
+    shard.table.store(bigger, boost::memory_order_release);
+    table = bigger;
   }
-  return NULL;
+
+  size_t id;
+  if (isNonTerminal) {
+    id = m_factorIdNonTerminal.fetch_add(1);
+    UTIL_THROW_IF2(id + 1 >= moses_MaxNumNonterminals, "Number of non-terminals exceeds maximum size reserved. Adjust parameter moses_MaxNumNonterminals, then recompile");
+  } else {
+    id = m_factorId.fetch_add(1);
+  }
+
+  // the Factor and its string in one block, rounded up so the next Factor is aligned
+  size_t size = (sizeof(Factor) + factorString.size() + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+  char *mem = static_cast<char*>(shard.backing.Allocate(size));
+  Factor *factor = new (mem) Factor();
+  char *str = mem + sizeof(Factor);
+  memcpy(str, factorString.data(), factorString.size());
+  factor->m_string = StringPiece(str, factorString.size());
+  factor->m_id = id;
+
+  Place(*table, factor, hash);
+  ++shard.count;
+  return factor;
+}
+
+const Factor *FactorCollection::AddFactor(const StringPiece &factorString, bool isNonTerminal)
+{
+  size_t hash = HashString(factorString);
+  Shard &shard = (isNonTerminal ? m_shardsNonTerminal : m_shards)[hash % NumShards];
+  const Factor *ret = Find(shard.table.load(boost::memory_order_acquire), factorString, hash);
+  if (ret) return ret;
+  return Insert(shard, factorString, hash, isNonTerminal);
+}
+
+const Factor *FactorCollection::GetFactor(const StringPiece &factorString, bool isNonTerminal)
+{
+  size_t hash = HashString(factorString);
+  const Shard &shard = (isNonTerminal ? m_shardsNonTerminal : m_shards)[hash % NumShards];
+  return Find(shard.table.load(boost::memory_order_acquire), factorString, hash);
 }
 
 
@@ -91,15 +165,15 @@ TO_STRING_BODY(FactorCollection);
 // friend
 ostream& operator<<(ostream& out, const FactorCollection& factorCollection)
 {
-#ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(factorCollection.m_accessLock);
-#endif
-  for (FactorCollection::Set::const_iterator i = factorCollection.m_set.begin(); i != factorCollection.m_set.end(); ++i) {
-    out << i->in;
+  for (size_t s = 0; s < FactorCollection::NumShards; ++s) {
+    const FactorCollection::Table *table = factorCollection.m_shards[s].table.load(boost::memory_order_acquire);
+    if (table == NULL) continue;
+    for (size_t i = 0; i <= table->mask; ++i) {
+      const Factor *factor = table->slots[i].factor.load(boost::memory_order_acquire);
+      if (factor) out << *factor;
+    }
   }
   return out;
 }
 
 }
-
-
@@ -28,14 +28,17 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #endif
 
 #ifdef WITH_THREADS
-#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/mutex.hpp>
 #endif
 
+#include <boost/atomic.hpp>
+
 #include "util/murmur_hash.hh"
 #include <boost/unordered_set.hpp>
 
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "util/string_piece.hh"
 #include "util/pool.hh"
@@ -46,17 +49,6 @@ class System;
 namespace Moses
 {
 
-/** We don't want Factor to be copyable by anybody.  But we also want to store
- * it in an STL container.  The solution is that Factor's copy constructor is
- * private and friended to FactorFriend.  The STL containers can delegate
- * copying, so friending the container isn't sufficient.  STL containers see
- * FactorFriend's public copy constructor and everybody else sees Factor's
- * private copy constructor.
- */
-struct FactorFriend {
-  Factor in;
-};
-
 /** collection of factors
  *
  * All Factors in moses are accessed and created by a FactorCollection.
@@ -64,36 +56,53 @@ struct FactorFriend {
  * from being created on the stack, etc), their memory addresses can
  * be used as keys to uniquely identify them.
  * Only 1 FactorCollection object should be created.
+ *
+ * Lookups take no locks. Factors are kept in open-addressing hash tables,
+ * split into shards by hash. A slot is written once and never changes, and
+ * a table that gets too full is replaced by a bigger copy. Old tables are
+ * only freed with the collection, so readers never see freed memory. Inserts
+ * lock only their shard. Factors never move once created.
  */
 class FactorCollection
 {
   friend std::ostream& operator<<(std::ostream&, const FactorCollection&);
   friend class ::System;
 
-  struct HashFactor : public std::unary_function<const FactorFriend &, std::size_t> {
-    std::size_t operator()(const FactorFriend &factor) const {
-      return util::MurmurHashNative(factor.in.m_string.data(), factor.in.m_string.size());
-    }
+  static const std::size_t NumShards = 64;
+
+  struct Slot {
+    boost::atomic<std::size_t> hash;
+    boost::atomic<const Factor*> factor;
   };
-  struct EqualsFactor : public std::binary_function<const FactorFriend &, const FactorFriend &, bool> {
-    bool operator()(const FactorFriend &left, const FactorFriend &right) const {
-      return left.in.GetString() == right.in.GetString();
-    }
+
+  struct Table {
+    explicit Table(std::size_t size);
+    ~Table();
+
+    std::size_t mask; // size - 1, size is a power of 2
+    Slot *slots;
   };
-  typedef boost::unordered_set<FactorFriend, HashFactor, EqualsFactor> Set;
-  Set m_set;
-  Set m_setNonTerminal;
 
-  util::Pool m_string_backing;
+  struct Shard {
+    Shard() : table(NULL), count(0) {}
+    ~Shard();
 
-  static FactorCollection s_instance;
+    boost::atomic<Table*> table; // NULL until the 1st insert
+    std::size_t count;
+    std::vector<Table*> retired; // replaced tables, may still be read
+    util::Pool backing; // the Factors and their strings
 #ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::shared_mutex m_accessLock;
+    boost::mutex lock;
 #endif
+  };
 
-  size_t m_factorIdNonTerminal; /**< unique, contiguous ids, starting from 0, for each non-terminal factor */
-  size_t m_factorId; /**< unique, contiguous ids, starting from moses_MaxNumNonterminals, for each terminal factor */
+  Shard m_shards[NumShards];
+  Shard m_shardsNonTerminal[NumShards];
+
+  static FactorCollection s_instance;
+
+  boost::atomic<size_t> m_factorIdNonTerminal; /**< unique, contiguous ids, starting from 0, for each non-terminal factor */
+  boost::atomic<size_t> m_factorId; /**< unique, contiguous ids, starting from moses_MaxNumNonterminals, for each terminal factor */
 
   //! constructor. only the 1 static variable can be created
   FactorCollection()
@@ -101,6 +110,10 @@ class FactorCollection
     , m_factorId(moses_MaxNumNonterminals) {
   }
 
+  static const Factor *Find(const Table *table, const StringPiece &factorString, std::size_t hash);
+  static void Place(Table &table, const Factor *factor, std::size_t hash);
+  const Factor *Insert(Shard &shard, const StringPiece &factorString, std::size_t hash, bool isNonTerminal);
+
 public:
   static FactorCollection& Instance() {
     return s_instance;
@@ -114,7 +127,7 @@ public:
   const Factor *AddFactor(const StringPiece &factorString, bool isNonTerminal = false);
 
   size_t GetNumNonTerminals() {
-    return m_factorIdNonTerminal;
+    return m_factorIdNonTerminal.load(boost::memory_order_acquire);
   }
 
   const Factor *GetFactor(const StringPiece &factorString, bool isNonTerminal = false);
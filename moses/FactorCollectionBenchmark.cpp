@@ -0,0 +1,174 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+/**
+ * Contention benchmark for FactorCollection. N threads intern words like
+ * decoding threads do: almost all of them are already known, skewed towards
+ * frequent words, and a few are new. The lock-free FactorCollection is
+ * compared with the reader-writer locked hash set it replaced.
+ *
+ * usage: factor_collection_benchmark [threads] [lookups per thread] [vocabulary size]
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "FactorCollection.h"
+
+#ifdef WITH_THREADS
+
+#include <boost/thread.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "util/murmur_hash.hh"
+#include "util/pool.hh"
+
+using namespace Moses;
+
+namespace
+{
+
+// The previous implementation: one hash set behind a reader-writer lock.
+class LockedCollection
+{
+public:
+  const StringPiece *AddFactor(const StringPiece &str) {
+    {
+      boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
+      Set::const_iterator i = m_set.find(str);
+      if (i != m_set.end()) return &*i;
+    }
+    boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
+    std::pair<Set::iterator, bool> ret(m_set.insert(str));
+    if (ret.second) {
+      // point the key at pool-backed memory, which doesn't change its hash
+      const_cast<StringPiece&>(*ret.first).set(
+        memcpy(m_string_backing.Allocate(str.size()), str.data(), str.size()), str.size());
+    }
+    return &*ret.first;
+  }
+
+private:
+  struct Hash {
+    std::size_t operator()(const StringPiece &str) const {
+      return util::MurmurHashNative(str.data(), str.size());
+    }
+  };
+  typedef boost::unordered_set<StringPiece, Hash> Set;
+  Set m_set;
+  util::Pool m_string_backing;
+  boost::shared_mutex m_accessLock;
+};
+
+struct Workload {
+  std::vector<std::string> words;
+  size_t lookups;
+};
+
+// word of rank r is picked with probability roughly proportional to 1/r
+size_t Skewed(unsigned int &seed, size_t size)
+{
+  seed = seed * 1103515245u + 12345u;
+  double x = (seed >> 8) / double(1 << 24);
+  return std::min(size - 1, size_t(std::pow(double(size), x)) - 1);
+}
+
+template <class Collection>
+void Run(Collection &collection, const Workload &workload, unsigned int seed, size_t &sink)
+{
+  size_t local = 0;
+  for (size_t i = 0; i < workload.lookups; ++i) {
+    if (i % 1000 == 999) {
+      // an unseen word, eg. an OOV of the input
+      char buf[64];
+      int len = std::sprintf(buf, "new-%u-%lu", seed, (unsigned long) i);
+      local += (size_t) collection.AddFactor(StringPiece(buf, len));
+    } else {
+      local += (size_t) collection.AddFactor(workload.words[Skewed(seed, workload.words.size())]);
+    }
+  }
+  sink += local;
+}
+
+template <class Collection>
+double Time(Collection &collection, const Workload &workload, size_t threads)
+{
+  std::vector<size_t> sinks(threads);
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+  boost::thread_group group;
+  for (size_t t = 0; t < threads; ++t) {
+    group.create_thread(boost::bind(&Run<Collection>, boost::ref(collection),
+                                    boost::cref(workload), (unsigned int) (t + 1), boost::ref(sinks[t])));
+  }
+  group.join_all();
+  boost::posix_time::ptime end = boost::posix_time::microsec_clock::universal_time();
+  return (end - start).total_microseconds() / 1000000.0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  size_t threads = argc > 1 ? std::atoi(argv[1]) : boost::thread::hardware_concurrency();
+  Workload workload;
+  workload.lookups = argc > 2 ? std::atoi(argv[2]) : 2000000;
+  size_t vocabSize = argc > 3 ? std::atoi(argv[3]) : 100000;
+  if (threads == 0) threads = 1;
+
+  for (size_t i = 0; i < vocabSize; ++i) {
+    char buf[32];
+    std::sprintf(buf, "word%lu", (unsigned long) i);
+    workload.words.push_back(buf);
+  }
+
+  // both start out knowing the vocabulary
+  LockedCollection locked;
+  FactorCollection &factors = FactorCollection::Instance();
+  for (size_t i = 0; i < vocabSize; ++i) {
+    locked.AddFactor(workload.words[i]);
+    factors.AddFactor(workload.words[i]);
+  }
+
+  size_t total = threads * workload.lookups;
+  double seconds = Time(locked, workload, threads);
+  std::cout << "locked    threads=" << threads << " lookups=" << total
+            << " seconds=" << seconds << " lookups/s=" << total / seconds << std::endl;
+  seconds = Time(factors, workload, threads);
+  std::cout << "lock-free threads=" << threads << " lookups=" << total
+            << " seconds=" << seconds << " lookups/s=" << total / seconds << std::endl;
+  return 0;
+}
+
+#else
+
+int main()
+{
+  std::cerr << "factor_collection_benchmark requires a multi-threaded build" << std::endl;
+  return 1;
+}
+
+#endif // WITH_THREADS
@@ -0,0 +1,108 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#ifdef WITH_THREADS
+#include <boost/bind/bind.hpp>
+#include <boost/thread.hpp>
+#endif
+
+#include "FactorCollection.h"
+#include "Util.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+// the collection is a singleton, so every test uses its own words
+vector<const Factor*> AddWords(const string &prefix, size_t count)
+{
+  vector<const Factor*> ret;
+  for (size_t i = 0; i < count; ++i) {
+    ret.push_back(FactorCollection::Instance().AddFactor(prefix + SPrint(i)));
+  }
+  return ret;
+}
+
+#ifdef WITH_THREADS
+void AddWordsInto(const string &prefix, size_t count, vector<const Factor*> &out)
+{
+  out = AddWords(prefix, count);
+}
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE(factor_collection)
+
+BOOST_AUTO_TEST_CASE(add_and_get)
+{
+  FactorCollection &collection = FactorCollection::Instance();
+  BOOST_CHECK(collection.GetFactor("fct-add") == NULL);
+
+  const Factor *factor = collection.AddFactor("fct-add");
+  BOOST_CHECK_EQUAL(factor->GetString(), "fct-add");
+  BOOST_CHECK_EQUAL(collection.AddFactor("fct-add"), factor);
+  BOOST_CHECK_EQUAL(collection.GetFactor("fct-add"), factor);
+
+  // terminals and non-terminals are separate
+  BOOST_CHECK(collection.GetFactor("fct-add", true) == NULL);
+  const Factor *nonTerm = collection.AddFactor("fct-add", true);
+  BOOST_CHECK(nonTerm != factor);
+  BOOST_CHECK(nonTerm->GetId() < collection.GetNumNonTerminals());
+  BOOST_CHECK(factor->GetId() >= moses_MaxNumNonterminals);
+}
+
+BOOST_AUTO_TEST_CASE(stable_while_growing)
+{
+  vector<const Factor*> first = AddWords("fct-grow-", 10000);
+  vector<const Factor*> again = AddWords("fct-grow-", 10000);
+  BOOST_CHECK(first == again);
+
+  set<size_t> ids;
+  for (size_t i = 0; i < first.size(); ++i) {
+    BOOST_CHECK_EQUAL(first[i]->GetString(), "fct-grow-" + SPrint(i));
+    ids.insert(first[i]->GetId());
+  }
+  BOOST_CHECK_EQUAL(ids.size(), first.size());
+}
+
+#ifdef WITH_THREADS
+BOOST_AUTO_TEST_CASE(concurrent_add)
+{
+  const size_t numThreads = 4;
+  vector<vector<const Factor*> > results(numThreads);
+  boost::thread_group threads;
+  for (size_t t = 0; t < numThreads; ++t) {
+    threads.create_thread(boost::bind(&AddWordsInto, "fct-thread-", 5000, boost::ref(results[t])));
+  }
+  threads.join_all();
+
+  for (size_t t = 1; t < numThreads; ++t) {
+    BOOST_CHECK(results[t] == results[0]);
+  }
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -162,20 +162,76 @@ bool FName::operator!=(const FName& rhs) const
   return ! (*this == rhs);
 }
 
+FCoreVector::FCoreVector(size_t size)
+  : m_size(size)
+  , m_data(size > MAX_INLINE_CORE_FEATURES ? new FValue[size] : m_inline)
+{
+  std::fill(m_data, m_data + m_size, FValue(0));
+}
+
+FCoreVector::FCoreVector(const FCoreVector &other)
+  : m_size(other.m_size)
+  , m_data(other.m_size > MAX_INLINE_CORE_FEATURES ? new FValue[other.m_size] : m_inline)
+{
+  std::copy(other.begin(), other.end(), m_data);
+}
+
+FCoreVector &FCoreVector::operator=(const FCoreVector &other)
+{
+  if (this == &other) return *this;
+  if (other.m_size != m_size) {
+    if (m_data != m_inline) delete [] m_data;
+    m_data = other.m_size > MAX_INLINE_CORE_FEATURES ? new FValue[other.m_size] : m_inline;
+    m_size = other.m_size;
+  }
+  std::copy(other.begin(), other.end(), m_data);
+  return *this;
+}
+
+void FCoreVector::resize(size_t size)
+{
+  if (size == m_size) return;
+  FValue *data = size > MAX_INLINE_CORE_FEATURES ? new FValue[size] : m_inline;
+  if (data != m_data) {
+    std::copy(m_data, m_data + min(size, m_size), data);
+    if (m_data != m_inline) delete [] m_data;
+    m_data = data;
+  }
+  if (size > m_size) std::fill(m_data + m_size, m_data + size, FValue(0));
+  m_size = size;
+}
+
+FValue FCoreVector::sum() const
+{
+  FValue sum = 0;
+  for (size_t i = 0; i < m_size; ++i) {
+    sum += m_data[i];
+  }
+  return sum;
+}
+
+void swap(FCoreVector &first, FCoreVector &second)
+{
+  if (first.m_data != first.m_inline && second.m_data != second.m_inline) {
+    std::swap(first.m_data, second.m_data);
+    std::swap(first.m_size, second.m_size);
+  } else {
+    FCoreVector tmp(first);
+    first = second;
+    second = tmp;
+  }
+}
+
 FVector::FVector(size_t coreFeatures) : m_coreFeatures(coreFeatures) {}
 
 void FVector::resize(size_t newsize)
 {
-  valarray<FValue> oldValues(m_coreFeatures);
   m_coreFeatures.resize(newsize);
-  for (size_t i = 0; i < min(m_coreFeatures.size(), oldValues.size()); ++i) {
-    m_coreFeatures[i] = oldValues[i];
-  }
 }
 
 void FVector::clear()
 {
-  m_coreFeatures.resize(m_coreFeatures.size(), 0);
+  std::fill(m_coreFeatures.begin(), m_coreFeatures.end(), FValue(0));
   m_features.clear();
 }
 
@@ -370,10 +426,16 @@ FVector& FVector::operator+= (const FVector& rhs)
 {
   if (rhs.m_coreFeatures.size() > m_coreFeatures.size())
     resize(rhs.m_coreFeatures.size());
-  for (const_iterator i = rhs.cbegin(); i != rhs.cend(); ++i)
-    set(i->first, get(i->first) + i->second);
-  for (size_t i = 0; i < rhs.m_coreFeatures.size(); ++i)
-    m_coreFeatures[i] += rhs.m_coreFeatures[i];
+  if (!rhs.m_features.empty()) {
+    for (const_iterator i = rhs.cbegin(); i != rhs.cend(); ++i)
+      set(i->first, get(i->first) + i->second);
+  }
+  // plain pointer loop, so that the compiler vectorises it
+  FValue *dst = m_coreFeatures.begin();
+  const FValue *src = rhs.m_coreFeatures.begin();
+  const size_t size = rhs.m_coreFeatures.size();
+  for (size_t i = 0; i < size; ++i)
+    dst[i] += src[i];
   return *this;
 }
 
@@ -389,8 +451,11 @@ void FVector::corePlusEquals(const FVector& rhs)
 {
   if (rhs.m_coreFeatures.size() > m_coreFeatures.size())
     resize(rhs.m_coreFeatures.size());
-  for (size_t i = 0; i < rhs.m_coreFeatures.size(); ++i)
-    m_coreFeatures[i] += rhs.m_coreFeatures[i];
+  FValue *dst = m_coreFeatures.begin();
+  const FValue *src = rhs.m_coreFeatures.begin();
+  const size_t size = rhs.m_coreFeatures.size();
+  for (size_t i = 0; i < size; ++i)
+    dst[i] += src[i];
 }
 
 // assign only core features
@@ -608,7 +673,8 @@ FVector& FVector::operator*= (const FValue& rhs)
   for (iterator i = begin(); i != end(); ++i) {
     i->second *= rhs;
   }
-  m_coreFeatures *= rhs;
+  for (size_t i = 0; i < m_coreFeatures.size(); ++i)
+    m_coreFeatures[i] *= rhs;
   return *this;
 }
 
@@ -617,7 +683,8 @@ FVector& FVector::operator/= (const FValue& rhs)
   for (iterator i = begin(); i != end(); ++i) {
     i->second /= rhs;
   }
-  m_coreFeatures /= rhs;
+  for (size_t i = 0; i < m_coreFeatures.size(); ++i)
+    m_coreFeatures[i] /= rhs;
   return *this;
 }
 
@@ -806,11 +873,16 @@ FValue FVector::inner_product(const FVector& rhs) const
 {
   assert(m_coreFeatures.size() == rhs.m_coreFeatures.size());
   FValue product = 0.0;
-  for (const_iterator i = cbegin(); i != cend(); ++i) {
-    product += ((i->second)*(rhs.get(i->first)));
+  if (!m_features.empty() && !rhs.m_features.empty()) {
+    for (const_iterator i = cbegin(); i != cend(); ++i) {
+      product += ((i->second)*(rhs.get(i->first)));
+    }
   }
-  for (size_t i = 0; i < m_coreFeatures.size(); ++i) {
-    product += m_coreFeatures[i]*rhs.m_coreFeatures[i];
+  const FValue *lhsCore = m_coreFeatures.begin();
+  const FValue *rhsCore = rhs.m_coreFeatures.begin();
+  const size_t size = m_coreFeatures.size();
+  for (size_t i = 0; i < size; ++i) {
+    product += lhsCore[i]*rhsCore[i];
   }
   return product;
 }
@@ -26,7 +26,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <map>
 #include <sstream>
 #include <string>
-#include <valarray>
 #include <vector>
 
 #include <boost/functional/hash.hpp>
@@ -37,7 +36,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <boost/serialization/split_member.hpp>
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/vector.hpp>
-#include <boost/serialization/valarray.hpp>
 #endif
 
 #ifdef WITH_THREADS
@@ -119,6 +117,63 @@ struct FNameHash
   }
 };
 
+#ifndef MAX_INLINE_CORE_FEATURES
+#define MAX_INLINE_CORE_FEATURES 24
+#endif
+
+/**
+ * The core (dense) features of an FVector, in one contiguous array whose
+ * layout is fixed when the feature functions are registered. Up to
+ * MAX_INLINE_CORE_FEATURES values are kept inside the object, so copying a
+ * vector without sparse features does not allocate.
+ **/
+class FCoreVector
+{
+public:
+  explicit FCoreVector(size_t size = 0);
+  FCoreVector(const FCoreVector &other);
+  ~FCoreVector() {
+    if (m_data != m_inline) delete [] m_data;
+  }
+
+  FCoreVector &operator=(const FCoreVector &other);
+
+  size_t size() const {
+    return m_size;
+  }
+  //! change the size, keeping existing values and zeroing new ones
+  void resize(size_t size);
+
+  FValue &operator[](size_t index) {
+    return m_data[index];
+  }
+  FValue operator[](size_t index) const {
+    return m_data[index];
+  }
+
+  FValue *begin() {
+    return m_data;
+  }
+  FValue *end() {
+    return m_data + m_size;
+  }
+  const FValue *begin() const {
+    return m_data;
+  }
+  const FValue *end() const {
+    return m_data + m_size;
+  }
+
+  FValue sum() const;
+
+  friend void swap(FCoreVector &first, FCoreVector &second);
+
+private:
+  size_t m_size;
+  FValue *m_data; // either m_inline or a heap array
+  FValue m_inline[MAX_INLINE_CORE_FEATURES];
+};
+
 class ProxyFVector;
 
 /**
@@ -184,7 +239,7 @@ public:
     return m_coreFeatures.size();
   }
 
-  const std::valarray<FValue> &getCoreFeatures() const {
+  const FCoreVector &getCoreFeatures() const {
     return m_coreFeatures;
   }
 
@@ -273,7 +328,7 @@ private:
   void set(const FName& name, const FValue& value);
 
   FNVmap m_features;
-  std::valarray<FValue> m_coreFeatures;
+  FCoreVector m_coreFeatures;
 
 #ifdef MPI_ENABLE
   //serialization
@@ -287,9 +342,10 @@ private:
       names.push_back(ostr.str());
       values.push_back(i->second);
     }
+    std::vector<FValue> core(m_coreFeatures.begin(), m_coreFeatures.end());
     ar << names;
     ar << values;
-    ar << m_coreFeatures;
+    ar << core;
   }
 
   template<class Archive>
@@ -297,9 +353,12 @@ private:
     clear();
     std::vector<std::string> names;
     std::vector<FValue> values;
+    std::vector<FValue> core;
     ar >> names;
     ar >> values;
-    ar >> m_coreFeatures;
+    ar >> core;
+    m_coreFeatures.resize(core.size());
+    std::copy(core.begin(), core.end(), m_coreFeatures.begin());
     UTIL_THROW_IF2(names.size() != values.size(), "Error");
     for (size_t i = 0; i < names.size(); ++i) {
       set(FName(names[i]), values[i]);
@@ -307,5 +307,31 @@ BOOST_AUTO_TEST_CASE(ip)
 }
 
 
+BOOST_AUTO_TEST_CASE(core_resize)
+{
+  // grow from inline storage onto the heap and back, keeping values
+  FVector f1(3);
+  f1[0] = 1;
+  f1[2] = 3;
+  f1.resize(MAX_INLINE_CORE_FEATURES + 5);
+  BOOST_CHECK_EQUAL(f1.coreSize(), MAX_INLINE_CORE_FEATURES + 5);
+  BOOST_CHECK_EQUAL(f1[0], 1);
+  BOOST_CHECK_EQUAL(f1[2], 3);
+  BOOST_CHECK_EQUAL(f1[MAX_INLINE_CORE_FEATURES + 4], 0);
+  FVector f2(f1);
+  f2[1] = 2;
+  f1 += f2;
+  BOOST_CHECK_EQUAL(f1[1], 2);
+  BOOST_CHECK_EQUAL(f2[0], 1);
+  f1.resize(2);
+  BOOST_CHECK_EQUAL(f1.coreSize(), 2);
+  BOOST_CHECK_EQUAL(f1[0], 2);
+  swap(f1, f2);
+  BOOST_CHECK_EQUAL(f1.coreSize(), MAX_INLINE_CORE_FEATURES + 5);
+  BOOST_CHECK_EQUAL(f2.coreSize(), 2);
+  BOOST_CHECK_EQUAL(f2[1], 2);
+}
+
+
 BOOST_AUTO_TEST_SUITE_END()
 
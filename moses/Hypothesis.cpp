@@ -187,6 +187,57 @@ EvaluateWhenApplied(float estimatedScore)
   if (m_prevHypo) m_futureScore += m_prevHypo->GetScore();
 }
 
+void
+Hypothesis::
+EvaluateWhenApplied(const std::vector<Hypothesis*> &hypos, float estimatedScore)
+{
+  const StaticData &staticData = StaticData::Instance();
+
+  const vector<const StatelessFeatureFunction*>& sfs =
+    StatelessFeatureFunction::GetStatelessFeatureFunctions();
+  for (unsigned i = 0; i < sfs.size(); ++i) {
+    const StatelessFeatureFunction &ff = *sfs[i];
+    if(!staticData.IsFeatureFunctionIgnored(ff)) {
+      for (size_t h = 0; h < hypos.size(); ++h) {
+        ff.EvaluateWhenApplied(*hypos[h], &hypos[h]->m_currScoreBreakdown);
+      }
+    }
+  }
+
+  // one feature function at a time over all hypotheses, so that eg. the
+  // language model can overlap its lookups
+  vector<const Hypothesis*> batch(hypos.begin(), hypos.end());
+  vector<const FFState*> prevStates(hypos.size());
+  vector<ScoreComponentCollection*> accumulators(hypos.size());
+  vector<FFState*> newStates;
+  for (size_t h = 0; h < hypos.size(); ++h) {
+    accumulators[h] = &hypos[h]->m_currScoreBreakdown;
+  }
+
+  const vector<const StatefulFeatureFunction*>& ffs =
+    StatefulFeatureFunction::GetStatefulFeatureFunctions();
+  for (unsigned i = 0; i < ffs.size(); ++i) {
+    const StatefulFeatureFunction &ff = *ffs[i];
+    if(!staticData.IsFeatureFunctionIgnored(ff)) {
+      for (size_t h = 0; h < hypos.size(); ++h) {
+        const Hypothesis *prevHypo = hypos[h]->m_prevHypo;
+        prevStates[h] = prevHypo ? prevHypo->m_ffStates[i] : NULL;
+      }
+      ff.EvaluateWhenAppliedBatch(batch, prevStates, accumulators, newStates);
+      for (size_t h = 0; h < hypos.size(); ++h) {
+        hypos[h]->m_ffStates[i] = newStates[h];
+      }
+    }
+  }
+
+  for (size_t h = 0; h < hypos.size(); ++h) {
+    Hypothesis &hypo = *hypos[h];
+    hypo.m_estimatedScore = estimatedScore;
+    hypo.m_futureScore = hypo.m_currScoreBreakdown.GetWeightedScore() + estimatedScore;
+    if (hypo.m_prevHypo) hypo.m_futureScore += hypo.m_prevHypo->GetScore();
+  }
+}
+
 const Hypothesis* Hypothesis::GetPrevHypo()const
 {
   return m_prevHypo;
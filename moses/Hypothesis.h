@@ -36,6 +36,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "ScoreComponentCollection.h"
 #include "InputType.h"
 #include "ObjectPool.h"
+#include "MemPool.h"
 #include "xmlrpc-c.h"
 
 namespace Moses
@@ -52,7 +53,12 @@ class StatefulFeatureFunction;
 class Manager;
 struct ReportingOptions;
 
-typedef std::vector<Hypothesis*> ArcList;
+/** Hypotheses recombined into a better one. The list and its storage come
+ * from the MemPool of the search, like the hypotheses.
+ */
+class ArcList : public std::vector<Hypothesis*, PoolAllocator<Hypothesis*> >, public PoolAllocated
+{
+};
 
 /** Used to store a state in the beam search
     for the best translation. With its link back to the previous hypothesis
@@ -62,7 +68,7 @@ typedef std::vector<Hypothesis*> ArcList;
 		The expansion of hypotheses is handled in the class Manager, which
     stores active hypothesis in the search in hypothesis stacks.
 ***/
-class Hypothesis
+class Hypothesis : public PoolAllocated
 {
   friend std::ostream& operator<<(std::ostream&, const Hypothesis&);
 protected:
@@ -122,6 +128,10 @@ public:
 
   void EvaluateWhenApplied(float estimatedScore);
 
+  /** EvaluateWhenApplied() for expansions that share the estimated score,
+   * eg. those of one backwards edge. Stateful feature functions score them as a batch. */
+  static void EvaluateWhenApplied(const std::vector<Hypothesis*> &hypos, float estimatedScore);
+
   int GetId()const {
     return m_id;
   }
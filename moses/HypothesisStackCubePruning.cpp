@@ -40,6 +40,8 @@ HypothesisStackCubePruning::HypothesisStackCubePruning(Manager& manager) :
   m_bestScore = -std::numeric_limits<float>::infinity();
   m_worstScore = -std::numeric_limits<float>::infinity();
   m_deterministic = manager.options()->cube.deterministic_search;
+  m_lazyBatchSize = manager.options()->cube.lazy_scoring
+                    ? std::max<size_t>(manager.options()->cube.lazy_batch_size, 1) : 0;
 }
 
 /** remove all hypotheses from the collection */
@@ -300,7 +302,7 @@ BitmapContainer *HypothesisStackCubePruning::AddBitmapContainer(const Bitmap &bi
 
   BitmapContainer *bmContainer;
   if (iter == m_bitmapAccessor.end()) {
-    bmContainer = new BitmapContainer(bitmap, stack, m_deterministic);
+    bmContainer = new BitmapContainer(bitmap, stack, m_deterministic, m_lazyBatchSize);
     m_bitmapAccessor[&bitmap] = bmContainer;
   } else {
     bmContainer = iter->second;
@@ -56,6 +56,7 @@ protected:
   size_t m_maxHypoStackSize; /**< maximum number of hypothesis allowed in this stack */
   bool m_nBestIsEnabled; /**< flag to determine whether to keep track of old arcs */
   bool m_deterministic; /**< flag to determine whether to sort hypotheses deterministically */
+  size_t m_lazyBatchSize; /**< candidates scored together with lazy scoring, 0 for none */
 
   /** add hypothesis to stack. Prune if necessary.
    * Returns false if equiv hypo exists in collection, otherwise returns true
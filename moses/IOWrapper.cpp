@@ -44,6 +44,8 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "moses/StaticData.h"
 #include "moses/InputFileStream.h"
 #include "moses/FF/StatefulFeatureFunction.h"
+#include "moses/FF/DynamicCacheBasedLanguageModel.h"
+#include "moses/TranslationModel/PhraseDictionaryDynamicCacheBased.h"
 #include "moses/TreeInput.h"
 #include "moses/ForestInput.h"
 #include "moses/ConfusionNet.h"
@@ -63,6 +65,23 @@ using namespace std;
 namespace Moses
 {
 
+namespace
+{
+// Whether input markup can change global state: weight-setting picks
+// alternate weights, dlt markup updates cache-based models.
+bool InputChangesGlobalState(StaticData const& staticData)
+{
+  if (staticData.GetHasAlternateWeightSettings())
+    return true;
+  BOOST_FOREACH(FeatureFunction const* ff, FeatureFunction::GetFeatureFunctions()) {
+    if (dynamic_cast<PhraseDictionaryDynamicCacheBased const*>(ff)
+        || dynamic_cast<DynamicCacheBasedLanguageModel const*>(ff))
+      return true;
+  }
+  return false;
+}
+}
+
 IOWrapper::IOWrapper(AllOptions const& opts)
   : m_options(new AllOptions(opts))
   , m_nBestStream(NULL)
@@ -70,6 +89,7 @@ IOWrapper::IOWrapper(AllOptions const& opts)
   , m_look_ahead(0)
   , m_look_back(0)
   , m_buffered_ahead(0)
+  , m_inputThreads(0)
   , spe_src(NULL)
   , spe_trg(NULL)
   , spe_aln(NULL)
@@ -85,6 +105,19 @@ IOWrapper::IOWrapper(AllOptions const& opts)
   UTIL_THROW_IF2((m_look_ahead || m_look_back) && m_inputType != SentenceInput,
                  "Context-sensitive decoding currently works only with sentence input.");
 
+  // only inputs of one line each can be handed out to parser threads
+  if (m_inputType == SentenceInput || m_inputType == TabbedSentenceInput
+      || m_inputType == TreeInputType || m_inputType == WordLatticeInput)
+    m_inputThreads = m_options->input.threads;
+
+  // markup that changes global state has to take effect in input order,
+  // which only one parser thread keeps
+  if (m_inputThreads > 1 && InputChangesGlobalState(staticData)) {
+    TRACE_ERR("Input markup can change global state, so input is parsed on one thread instead of "
+              << m_inputThreads << endl);
+    m_inputThreads = 1;
+  }
+
   m_currentLine = m_options->output.start_translation_id;
   m_inputFactorOrder = &m_options->input.factor_order;
 
@@ -165,10 +198,33 @@ IOWrapper::IOWrapper(AllOptions const& opts)
     spe_trg = new ifstream(staticData.GetParameter().GetParam("spe-trg")->at(0).c_str());
     spe_aln = new ifstream(staticData.GetParameter().GetParam("spe-aln")->at(0).c_str());
   }
+
+  // output is collected in order of the sentence ids, which start here
+  OutputCollector* collectors[] = {
+    m_singleBestOutputCollector.get(), m_nBestOutputCollector.get(),
+    m_unknownsCollector.get(), m_alignmentInfoCollector.get(),
+    m_searchGraphOutputCollector.get(), m_detailedTranslationCollector.get(),
+    m_wordGraphCollector.get(), m_latticeSamplesCollector.get(),
+    m_detailTreeFragmentsOutputCollector.get()
+  };
+  for (size_t i = 0; i < sizeof(collectors) / sizeof(collectors[0]); ++i) {
+    if (collectors[i]) collectors[i]->SetFirstSourceId(m_currentLine);
+  }
+  if (m_singleBestOutputCollector.get())
+    m_singleBestOutputCollector->SetUnordered(m_options->output.unordered);
+
+  // the window is kept on the main output, which all sentences write to;
+  // the other collectors can't get further behind than that
+  OutputCollector* main = GetMainOutputCollector();
+  if (main) main->SetReorderWindow(m_options->output.reorder_window);
 }
 
 IOWrapper::~IOWrapper()
 {
+#ifdef WITH_THREADS
+  // stop reading before the input goes away
+  m_asyncInput.reset();
+#endif
   if (m_inputFile != NULL)
     delete m_inputFile;
   // if (m_nBestStream != NULL && !m_surpressSingleBestOutput) {
@@ -184,6 +240,23 @@ IOWrapper::~IOWrapper()
   // delete m_latticeSamplesStream;
 }
 
+OutputCollector*
+IOWrapper::
+GetMainOutputCollector()
+{
+  if (m_singleBestOutputCollector.get())
+    return m_singleBestOutputCollector.get();
+  return m_nBestOutputCollector.get();
+}
+
+void
+IOWrapper::
+WaitForOutputWindow(long translationId)
+{
+  OutputCollector* main = GetMainOutputCollector();
+  if (main) main->WaitForWindow(translationId);
+}
+
 // InputType*
 // IOWrapper::
 // GetInput(InputType* inputType)
@@ -41,6 +41,7 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include <cassert>
 #include <fstream>
+#include <sstream>
 #include <ostream>
 #include <vector>
 #include <list>
@@ -54,6 +55,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "moses/FactorCollection.h"
 #include "moses/Hypothesis.h"
 #include "moses/OutputCollector.h"
+#include "moses/AsyncInputReader.h"
 #include "moses/TrellisPathList.h"
 #include "moses/InputFileStream.h"
 #include "moses/InputType.h"
@@ -65,6 +67,7 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/format.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 
 namespace Moses
 {
@@ -126,6 +129,11 @@ protected:
 
   std::string m_hypergraph_output_filepattern;
 
+  size_t m_inputThreads; /// threads parsing input ahead, 0 for none
+#ifdef WITH_THREADS
+  boost::scoped_ptr<AsyncInputReader<boost::shared_ptr<InputType> > > m_asyncInput;
+#endif
+
 public:
   IOWrapper(AllOptions const& opts);
   ~IOWrapper();
@@ -142,10 +150,16 @@ public:
   void SetOutputStream2SingleBestOutputCollector(std::ostream* outStream) {
     if (m_singleBestOutputCollector.get())
       m_singleBestOutputCollector->SetOutputStream(outStream);
-    else
+    else {
       m_singleBestOutputCollector.reset(new Moses::OutputCollector(outStream));
+      m_singleBestOutputCollector->SetFirstSourceId(m_options->output.start_translation_id);
+    }
   }
 
+  /** Block until the sentence with this id may be submitted for translation
+   * without exceeding the output reorder window (--output-reorder-window). */
+  void WaitForOutputWindow(long translationId);
+
   Moses::OutputCollector *GetNBestOutputCollector() {
     return m_nBestOutputCollector.get();
   }
@@ -179,6 +193,9 @@ public:
   }
 
   void SetInputStreamFromString(std::istringstream &input) {
+#ifdef WITH_THREADS
+    m_asyncInput.reset();
+#endif
     m_inputStream = &input;
   }
 
@@ -203,10 +220,17 @@ public:
   }
 
 private:
+  //! collector that every translated sentence writes to, if any
+  Moses::OutputCollector* GetMainOutputCollector();
+
   template<class itype>
   boost::shared_ptr<InputType>
   BufferInput();
 
+  template<class itype>
+  boost::shared_ptr<InputType>
+  ReadOneInput();
+
   boost::shared_ptr<InputType>
   GetBufferedInput();
 
@@ -214,26 +238,67 @@ private:
   GetCurrentContextWindow() const;
 };
 
+//! parses one line of input, NULL if it doesn't read
+template<class itype>
+class InputLineParser
+{
+  AllOptions::ptr m_options;
+public:
+  InputLineParser(AllOptions::ptr const& opts) : m_options(opts) {}
+
+  boost::shared_ptr<InputType>
+  operator()(std::string const& line) const {
+    boost::shared_ptr<InputType> source(new itype(m_options));
+    std::istringstream in(line);
+    if (!source->Read(in))
+      source.reset();
+    return source;
+  }
+};
+
+template<class itype>
+boost::shared_ptr<InputType>
+IOWrapper::
+ReadOneInput()
+{
+#ifdef WITH_THREADS
+  if (m_inputThreads) {
+    if (!m_asyncInput) {
+      // don't wait at shutdown for a line from a terminal
+      m_asyncInput.reset(new AsyncInputReader<boost::shared_ptr<InputType> >(
+                           *m_inputStream,
+                           InputLineParser<itype>(m_options),
+                           m_inputThreads, 32,
+                           m_inputStream != &std::cin));
+    }
+    return m_asyncInput->Next();
+  }
+#endif
+  boost::shared_ptr<InputType> source(new itype(m_options));
+  if (!source->Read(*m_inputStream))
+    source.reset();
+  return source;
+}
+
 template<class itype>
 boost::shared_ptr<InputType>
 IOWrapper::
 BufferInput()
 {
-  boost::shared_ptr<itype>  source;
+  boost::shared_ptr<InputType> source;
   boost::shared_ptr<InputType> ret;
   if (m_future_input.size()) {
     ret = m_future_input.front();
     m_future_input.pop_front();
     m_buffered_ahead -= ret->GetSize();
   } else {
-    source.reset(new itype(m_options));
-    if (!source->Read(*m_inputStream))
+    ret = ReadOneInput<itype>();
+    if (!ret)
       return ret;
-    ret = source;
   }
   while (m_buffered_ahead < m_look_ahead) {
-    source.reset(new itype(m_options));
-    if (!source->Read(*m_inputStream))
+    source = ReadOneInput<itype>();
+    if (!source)
       break;
     m_future_input.push_back(source);
     m_buffered_ahead += source->GetSize();
@@ -226,18 +226,80 @@ template <class Model> FFState *LanguageModelKen<Model>::EvaluateWhenApplied(con
     ret->state = *state0;
   }
 
-  score = TransformLMScore(score);
+  PlusEqualsLMScore(TransformLMScore(score), out);
 
-  if (OOVFeatureEnabled()) {
-    std::vector<float> scores(2);
-    scores[0] = score;
-    scores[1] = 0.0;
-    out->PlusEquals(this, scores);
-  } else {
-    out->PlusEquals(this, score);
+  return ret.release();
+}
+
+template <class Model> void LanguageModelKen<Model>::EvaluateWhenAppliedBatch(
+  const std::vector<const Hypothesis*> &hypos,
+  const std::vector<const FFState*> &prev_states,
+  const std::vector<ScoreComponentCollection*> &accumulators,
+  std::vector<FFState*> &new_states) const
+{
+  // Same as EvaluateWhenApplied, but the hypotheses advance together one
+  // word at a time.  Each round prefetches what every hypothesis' query will
+  // probe before scoring any of them, so their cache misses overlap.
+  const std::size_t count = hypos.size();
+  std::vector<std::size_t> positions(count), adjust_ends(count);
+  std::vector<typename Model::State> states(count);
+  std::vector<lm::WordIndex> words(count);
+  std::vector<float> scores(count, 0.0);
+  std::size_t rounds = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    const Hypothesis &hypo = *hypos[i];
+    states[i] = static_cast<const KenLMState&>(*prev_states[i]).state;
+    positions[i] = hypo.GetCurrTargetWordsRange().GetStartPos();
+    adjust_ends[i] = positions[i];
+    if (hypo.GetCurrTargetLength()) {
+      const std::size_t end = hypo.GetCurrTargetWordsRange().GetEndPos() + 1;
+      adjust_ends[i] = std::min(end, positions[i] + m_ngram->Order() - 1);
+    }
+    rounds = std::max(rounds, adjust_ends[i] - positions[i]);
   }
 
-  return ret.release();
+  typename Model::State aux_state;
+  for (std::size_t round = 0; round < rounds; ++round) {
+    for (std::size_t i = 0; i < count; ++i) {
+      if (positions[i] == adjust_ends[i]) continue;
+      words[i] = TranslateID(hypos[i]->GetWord(positions[i]));
+      m_ngram->Prefetch(states[i], words[i]);
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+      if (positions[i] == adjust_ends[i]) continue;
+      scores[i] += m_ngram->Score(states[i], words[i], aux_state);
+      states[i] = aux_state;
+      ++positions[i];
+    }
+  }
+
+  new_states.resize(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const Hypothesis &hypo = *hypos[i];
+    KenLMState *ret = new KenLMState();
+    new_states[i] = ret;
+    if (!hypo.GetCurrTargetLength()) {
+      ret->state = states[i];
+      continue;
+    }
+
+    const std::size_t end = hypo.GetCurrTargetWordsRange().GetEndPos() + 1;
+    if (hypo.IsSourceCompleted()) {
+      // Score end of sentence.
+      std::vector<lm::WordIndex> indices(m_ngram->Order() - 1);
+      const lm::WordIndex *last = LastIDs(hypo, &indices.front());
+      scores[i] += m_ngram->FullScoreForgotState(&indices.front(), last, m_ngram->GetVocabulary().EndSentence(), ret->state).prob;
+    } else if (adjust_ends[i] < end) {
+      // Get state after adding a long phrase.
+      std::vector<lm::WordIndex> indices(m_ngram->Order() - 1);
+      const lm::WordIndex *last = LastIDs(hypo, &indices.front());
+      m_ngram->GetState(&indices.front(), last, ret->state);
+    } else {
+      ret->state = states[i];
+    }
+
+    PlusEqualsLMScore(TransformLMScore(scores[i]), accumulators[i]);
+  }
 }
 
 class LanguageModelChartStateKenLM : public FFState
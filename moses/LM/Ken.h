@@ -58,6 +58,8 @@ public:
 
   virtual FFState *EvaluateWhenApplied(const Hypothesis &hypo, const FFState *ps, ScoreComponentCollection *out) const;
 
+  virtual void EvaluateWhenAppliedBatch(const std::vector<const Hypothesis*> &hypos, const std::vector<const FFState*> &prev_states, const std::vector<ScoreComponentCollection*> &accumulators, std::vector<FFState*> &new_states) const;
+
   virtual FFState *EvaluateWhenApplied(const ChartHypothesis& cur_hypo, int featureID, ScoreComponentCollection *accumulator) const;
 
   virtual FFState *EvaluateWhenApplied(const Syntax::SHyperedge& hyperedge, int featureID, ScoreComponentCollection *accumulator) const;
@@ -86,6 +88,18 @@ protected:
 private:
   LanguageModelKen(const LanguageModelKen<Model> &copy_from);
 
+  // Add a phrase-based LM score, with a zero OOV count if that feature is enabled.
+  void PlusEqualsLMScore(float score, ScoreComponentCollection *out) const {
+    if (OOVFeatureEnabled()) {
+      std::vector<float> scores(2);
+      scores[0] = score;
+      scores[1] = 0.0;
+      out->PlusEquals(this, scores);
+    } else {
+      out->PlusEquals(this, score);
+    }
+  }
+
   // Convert last words of hypothesis into vocab ids, returning an end pointer.
   lm::WordIndex *LastIDs(const Hypothesis &hypo, lm::WordIndex *indices) const {
     lm::WordIndex *index = indices;
@@ -34,7 +34,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "Util.h"
 #include "TargetPhrase.h"
 #include "TrellisPath.h"
-#include "TrellisPathCollection.h"
+#include "TrellisKBestExtractor.h"
 #include "TranslationOption.h"
 #include "TranslationOptionCollection.h"
 #include "Timer.h"
@@ -50,6 +50,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/SearchNormal.h"
 #include "moses/SearchCubePruning.h"
 #include <boost/foreach.hpp>
+#include <boost/unordered_set.hpp>
 
 #ifdef HAVE_PROTOBUF
 #include "hypergraph.pb.h"
@@ -144,9 +145,17 @@ void Manager::Decode()
   // search for best translation with the specified algorithm
   Timer searchTime;
   searchTime.start();
-  m_search->Decode();
+  {
+    MemPool::Scope poolScope(m_pool);
+    m_search->Decode();
+  }
   VERBOSE(1, "Line " << m_source.GetTranslationId()
           << ": Search took " << searchTime << " seconds" << endl);
+  VERBOSE(1, "Line " << m_source.GetTranslationId()
+          << ": Search allocated " << m_pool.GetNumAllocations()
+          << " objects (" << m_pool.GetNumRecycled() << " recycled) with "
+          << m_pool.GetNumSystemAllocations() << " system allocations, "
+          << m_pool.GetNumBytes() << " bytes" << endl);
   IFVERBOSE(2) {
     GetSentenceStats().StopTimeTotal();
     TRACE_ERR(GetSentenceStats());
@@ -247,7 +256,8 @@ printThisHypothesis(long translationId, const Hypothesis* hypo,
 /**
  * After decoding, the hypotheses in the stacks and additional arcs
  * form a search graph that can be mined for n-best lists.
- * The heavy lifting is done in the TrellisPath and TrellisPathCollection
+ * The heavy lifting is done in the TrellisKBestExtractor, which
+ * enumerates the paths lazily, best first;
  * this function controls this for one sentence.
  *
  * \param count the number of n-best translations to produce
@@ -265,17 +275,10 @@ void Manager::CalcNBest(size_t count, TrellisPathList &ret, bool onlyDistinct) c
   if (sortedPureHypo.size() == 0)
     return;
 
-  TrellisPathCollection contenders;
+  TrellisKBestExtractor extractor(sortedPureHypo);
 
-  set<Phrase> distinctHyps;
-
-  // add all pure paths
-  vector<const Hypothesis*>::const_iterator iterBestHypo;
-  for (iterBestHypo = sortedPureHypo.begin()
-                      ; iterBestHypo != sortedPureHypo.end()
-       ; ++iterBestHypo) {
-    contenders.Add(new TrellisPath(*iterBestHypo));
-  }
+  std::vector<FactorType> const& outputFactors = options()->output.factor_order;
+  boost::unordered_set<Phrase> distinctHyps;
 
   // factor defines stopping point for distinct n-best list if too
   // many candidates identical
@@ -283,32 +286,19 @@ void Manager::CalcNBest(size_t count, TrellisPathList &ret, bool onlyDistinct) c
   if (nBestFactor < 1) nBestFactor = 1000; // 0 = unlimited
 
   // MAIN loop
-  for (size_t iteration = 0 ; (onlyDistinct ? distinctHyps.size() : ret.GetSize()) < count && contenders.GetSize() > 0 && (iteration < count * nBestFactor) ; iteration++) {
-    // get next best from list of contenders
-    TrellisPath *path = contenders.pop();
-    UTIL_THROW_IF2(path == NULL, "path is NULL");
-    // create deviations from current best
-    path->CreateDeviantPaths(contenders);
-    if(onlyDistinct) {
-      Phrase tgtPhrase = path->GetSurfacePhrase();
-      if (distinctHyps.insert(tgtPhrase).second) {
-        ret.Add(path);
-      } else {
-        delete path;
-        path = NULL;
-      }
-    } else {
-      ret.Add(path);
+  for (size_t iteration = 0 ; ret.GetSize() < count && (iteration < count * nBestFactor) ; iteration++) {
+    // get next best path
+    boost::shared_ptr<const TrellisKBestExtractor::Derivation> derivation = extractor.Get(iteration);
+    if (!derivation) {
+      break;
     }
-
-
     if(onlyDistinct) {
-      const size_t nBestFactor = options()->nbest.factor;
-      if (nBestFactor > 0)
-        contenders.Prune(count * nBestFactor);
-    } else {
-      contenders.Prune(count);
+      Phrase tgtPhrase = TrellisKBestExtractor::GetOutputPhrase(*derivation, outputFactors);
+      if (!distinctHyps.insert(tgtPhrase).second) {
+        continue;
+      }
     }
+    ret.Add(new TrellisPath(*derivation));
   }
 }
 
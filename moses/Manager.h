@@ -35,6 +35,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "Search.h"
 #include "SearchCubePruning.h"
 #include "BaseManager.h"
+#include "MemPool.h"
 
 namespace Moses
 {
@@ -112,6 +113,7 @@ private:
 
 protected:
   // data
+  MemPool m_pool; /**< backs the hypotheses, feature function states and arc lists of the search, released with the manager */
   TranslationOptionCollection *m_transOptColl; /**< pre-computed list of translation options for the phrases in this sentence */
   Search *m_search;
 
@@ -0,0 +1,173 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <cstdlib>
+#include <new>
+
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#endif
+
+#include "MemPool.h"
+
+namespace Moses
+{
+
+namespace
+{
+#ifdef WITH_THREADS
+void NoCleanup(MemPool *) {}
+boost::thread_specific_ptr<MemPool> s_current(&NoCleanup);
+#else
+MemPool *s_current = NULL;
+#endif
+
+// In front of all memory from AllocateFromCurrent(). Keeps it 16-byte aligned.
+union PoolHeader {
+  struct {
+    MemPool *pool;
+    std::size_t size;
+  } info;
+  char align[16];
+};
+}
+
+MemPool::MemPool(std::size_t pageSize)
+  : m_pageSize(pageSize)
+  , m_current(NULL)
+  , m_end(NULL)
+  , m_freeLists(MaxPooledSize / Granularity + 1, NULL)
+  , m_numAllocations(0)
+  , m_numRecycled(0)
+  , m_numLarge(0)
+  , m_numBytes(0)
+{
+}
+
+MemPool::~MemPool()
+{
+  for (size_t i = 0; i < m_pages.size(); ++i) {
+    std::free(m_pages[i]);
+  }
+}
+
+void *MemPool::Allocate(std::size_t size)
+{
+  ++m_numAllocations;
+  size = (size + Granularity - 1) & ~(Granularity - 1);
+  if (size > MaxPooledSize) {
+    ++m_numLarge;
+    void *ret = std::malloc(size);
+    if (!ret) throw std::bad_alloc();
+    return ret;
+  }
+
+  FreeBlock *&head = m_freeLists[size / Granularity];
+  if (head) {
+    ++m_numRecycled;
+    FreeBlock *ret = head;
+    head = head->next;
+    return ret;
+  }
+
+  if (m_current + size > m_end) {
+    // the unused tail of the old page is abandoned
+    char *page = static_cast<char*>(std::malloc(m_pageSize));
+    if (!page) throw std::bad_alloc();
+    m_pages.push_back(page);
+    m_numBytes += m_pageSize;
+    m_current = page;
+    m_end = page + m_pageSize;
+  }
+  char *ret = m_current;
+  m_current += size;
+  return ret;
+}
+
+void MemPool::Free(void *p, std::size_t size)
+{
+  size = (size + Granularity - 1) & ~(Granularity - 1);
+  if (size > MaxPooledSize) {
+    std::free(p);
+    return;
+  }
+  FreeBlock *block = static_cast<FreeBlock*>(p);
+  block->next = m_freeLists[size / Granularity];
+  m_freeLists[size / Granularity] = block;
+}
+
+MemPool *MemPool::Current()
+{
+#ifdef WITH_THREADS
+  return s_current.get();
+#else
+  return s_current;
+#endif
+}
+
+void MemPool::SetCurrent(MemPool *pool)
+{
+#ifdef WITH_THREADS
+  s_current.reset(pool);
+#else
+  s_current = pool;
+#endif
+}
+
+MemPool::Scope::Scope(MemPool &pool)
+  : m_prev(MemPool::Current())
+{
+  MemPool::SetCurrent(&pool);
+}
+
+MemPool::Scope::~Scope()
+{
+  MemPool::SetCurrent(m_prev);
+}
+
+void *MemPool::AllocateFromCurrent(std::size_t size)
+{
+  MemPool *pool = MemPool::Current();
+  std::size_t total = size + sizeof(PoolHeader);
+  void *mem;
+  if (pool) {
+    mem = pool->Allocate(total);
+  } else {
+    mem = std::malloc(total);
+    if (!mem) throw std::bad_alloc();
+  }
+  PoolHeader *header = static_cast<PoolHeader*>(mem);
+  header->info.pool = pool;
+  header->info.size = total;
+  return header + 1;
+}
+
+void MemPool::Release(void *p)
+{
+  if (!p) return;
+  PoolHeader *header = static_cast<PoolHeader*>(p) - 1;
+  if (header->info.pool) {
+    header->info.pool->Free(header, header->info.size);
+  } else {
+    std::free(header);
+  }
+}
+
+}
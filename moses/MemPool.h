@@ -0,0 +1,180 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace Moses
+{
+
+/** Memory pool for the small, short-lived objects of one search
+ * (hypotheses, feature function states). Memory is carved out of large
+ * pages, objects that are freed go onto a free list for their size and are
+ * reused, and all pages are released at once when the pool is destroyed.
+ *
+ * A pool belongs to one Manager and is not thread-safe.
+ */
+class MemPool
+{
+public:
+  explicit MemPool(std::size_t pageSize = 1 << 16);
+  ~MemPool();
+
+  void *Allocate(std::size_t size);
+  void Free(void *p, std::size_t size);
+
+  //! number of objects handed out, ie. allocations without the pool
+  std::size_t GetNumAllocations() const {
+    return m_numAllocations;
+  }
+  //! number of those that reused a freed object
+  std::size_t GetNumRecycled() const {
+    return m_numRecycled;
+  }
+  //! number of calls to malloc, ie. allocations with the pool
+  std::size_t GetNumSystemAllocations() const {
+    return m_pages.size() + m_numLarge;
+  }
+  std::size_t GetNumBytes() const {
+    return m_numBytes;
+  }
+
+  //! pool that PoolAllocated objects created on this thread come from, or NULL
+  static MemPool *Current();
+
+  /** Memory from the current pool, or from the heap if there is none. It
+   * remembers where it came from, so Release() can be called anywhere as
+   * long as that pool is still alive.
+   */
+  static void *AllocateFromCurrent(std::size_t size);
+  static void Release(void *p);
+
+  /** Makes a pool the current one for this thread while in scope */
+  class Scope
+  {
+  public:
+    explicit Scope(MemPool &pool);
+    ~Scope();
+  private:
+    MemPool *m_prev;
+  };
+
+private:
+  static const std::size_t Granularity = 16;
+  static const std::size_t MaxPooledSize = 1024;
+
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  std::size_t m_pageSize;
+  std::vector<char*> m_pages;
+  char *m_current, *m_end;
+  std::vector<FreeBlock*> m_freeLists; // indexed by size / Granularity
+
+  std::size_t m_numAllocations, m_numRecycled, m_numLarge, m_numBytes;
+
+  static void SetCurrent(MemPool *pool);
+
+  // no copying
+  MemPool(const MemPool &);
+  MemPool &operator=(const MemPool &);
+};
+
+/** Base class for objects that are allocated from the current MemPool of
+ * the thread that creates them, if there is one, and from the heap
+ * otherwise. Each object remembers where it came from, so it can be
+ * deleted anywhere as long as its pool is still alive.
+ */
+class PoolAllocated
+{
+public:
+  static void *operator new(std::size_t size) {
+    return MemPool::AllocateFromCurrent(size);
+  }
+  static void operator delete(void *p) {
+    MemPool::Release(p);
+  }
+
+protected:
+  PoolAllocated() {}
+  ~PoolAllocated() {}
+};
+
+/** STL allocator taking memory like PoolAllocated, for the containers of
+ * pooled objects. It has no state, so containers can be copied and
+ * swapped freely.
+ */
+template <class T> class PoolAllocator
+{
+public:
+  typedef T value_type;
+  typedef T *pointer;
+  typedef const T *const_pointer;
+  typedef T &reference;
+  typedef const T &const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+
+  template <class U> struct rebind {
+    typedef PoolAllocator<U> other;
+  };
+
+  PoolAllocator() {}
+  template <class U> PoolAllocator(const PoolAllocator<U> &) {}
+
+  pointer address(reference x) const {
+    return &x;
+  }
+  const_pointer address(const_reference x) const {
+    return &x;
+  }
+
+  pointer allocate(size_type n, const void * = 0) {
+    return static_cast<pointer>(MemPool::AllocateFromCurrent(n * sizeof(T)));
+  }
+  void deallocate(pointer p, size_type) {
+    MemPool::Release(p);
+  }
+
+  size_type max_size() const {
+    return static_cast<size_type>(-1) / sizeof(T);
+  }
+
+  void construct(pointer p, const T &value) {
+    new (p) T(value);
+  }
+  void destroy(pointer p) {
+    p->~T();
+  }
+};
+
+template <class T, class U> bool operator==(const PoolAllocator<T> &, const PoolAllocator<U> &)
+{
+  return true;
+}
+template <class T, class U> bool operator!=(const PoolAllocator<T> &, const PoolAllocator<U> &)
+{
+  return false;
+}
+
+}
@@ -0,0 +1,137 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+/**
+ * Allocation benchmark for the per-sentence MemPool of the search.  Each
+ * sentence creates hypotheses with feature function states, recombines
+ * some into the arc lists of others and prunes some right away, like
+ * SearchNormal with a large stack.  The same sentences run with the
+ * objects on the heap and in a pool.  Without a pool every object and
+ * every arc list growth is a call to malloc, which is what the pool counts
+ * as allocations.
+ *
+ * usage: mem_pool_benchmark [sentences] [hypotheses per sentence]
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "MemPool.h"
+
+using namespace Moses;
+
+namespace
+{
+
+// about the sizes of a phrase-based Hypothesis and of an LM state
+struct BenchmarkState : public PoolAllocated {
+  char data[40];
+};
+
+struct BenchmarkHypothesis : public PoolAllocated {
+  BenchmarkHypothesis() : state(new BenchmarkState), arcs(NULL) {}
+  ~BenchmarkHypothesis() {
+    delete state;
+    if (arcs) {
+      for (size_t i = 0; i < arcs->size(); ++i) {
+        delete (*arcs)[i];
+      }
+      delete arcs;
+    }
+  }
+
+  void AddArc(BenchmarkHypothesis *loser) {
+    if (!arcs) arcs = new Arcs;
+    arcs->push_back(loser);
+  }
+
+  struct Arcs : public std::vector<BenchmarkHypothesis*, PoolAllocator<BenchmarkHypothesis*> >, public PoolAllocated {
+  };
+
+  char data[200];
+  BenchmarkState *state;
+  Arcs *arcs;
+};
+
+void Search(size_t hypotheses, unsigned int seed)
+{
+  std::vector<BenchmarkHypothesis*> stack;
+  for (size_t i = 0; i < hypotheses; ++i) {
+    BenchmarkHypothesis *hypo = new BenchmarkHypothesis;
+    unsigned int r = (seed = seed * 1103515245 + 12345) >> 16;
+    if (!stack.empty() && r % 4 == 0) {
+      // recombined into an earlier hypothesis
+      stack[r % stack.size()]->AddArc(hypo);
+    } else if (!stack.empty() && r % 4 == 1) {
+      // pruned: replaces an earlier hypothesis, which is deleted
+      size_t victim = r % stack.size();
+      delete stack[victim];
+      stack[victim] = hypo;
+    } else {
+      stack.push_back(hypo);
+    }
+  }
+  for (size_t i = 0; i < stack.size(); ++i) {
+    delete stack[i];
+  }
+}
+
+double Time(size_t sentences, size_t hypotheses, bool pooled, size_t &allocations, size_t &systemAllocations)
+{
+  allocations = systemAllocations = 0;
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+  for (size_t s = 0; s < sentences; ++s) {
+    MemPool pool;
+    if (pooled) {
+      MemPool::Scope scope(pool);
+      Search(hypotheses, s);
+    } else {
+      Search(hypotheses, s);
+    }
+    allocations += pool.GetNumAllocations();
+    systemAllocations += pool.GetNumSystemAllocations();
+  }
+  boost::posix_time::ptime end = boost::posix_time::microsec_clock::universal_time();
+  return (end - start).total_microseconds() / 1000000.0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  size_t sentences = argc > 1 ? std::atoi(argv[1]) : 100;
+  size_t hypotheses = argc > 2 ? std::atoi(argv[2]) : 200000;
+  if (sentences == 0) sentences = 1;
+
+  // the heap run makes no pool allocations; the pooled run counts them
+  size_t allocations, systemAllocations;
+  double heapSeconds = Time(sentences, hypotheses, false, allocations, systemAllocations);
+  double pooledSeconds = Time(sentences, hypotheses, true, allocations, systemAllocations);
+
+  std::cout << "heap  hypotheses=" << hypotheses
+            << " mallocs/sentence=" << allocations / sentences
+            << " seconds=" << heapSeconds << std::endl;
+  std::cout << "pool  hypotheses=" << hypotheses
+            << " mallocs/sentence=" << systemAllocations / sentences
+            << " seconds=" << pooledSeconds << std::endl;
+  return 0;
+}
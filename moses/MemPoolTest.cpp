@@ -0,0 +1,101 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+#include "MemPool.h"
+
+using namespace Moses;
+
+namespace
+{
+struct PooledInt : public PoolAllocated {
+  PooledInt(int value) : value(value) {}
+  int value;
+};
+}
+
+BOOST_AUTO_TEST_SUITE(mem_pool)
+
+BOOST_AUTO_TEST_CASE(recycle)
+{
+  MemPool pool(1024);
+  void *a = pool.Allocate(24);
+  void *b = pool.Allocate(24);
+  BOOST_CHECK(a != b);
+  BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(a) % 16, 0);
+  pool.Free(a, 24);
+  BOOST_CHECK_EQUAL(pool.Allocate(20), a);
+  BOOST_CHECK_EQUAL(pool.GetNumAllocations(), 3);
+  BOOST_CHECK_EQUAL(pool.GetNumRecycled(), 1);
+  BOOST_CHECK_EQUAL(pool.GetNumSystemAllocations(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(scope)
+{
+  BOOST_CHECK(MemPool::Current() == NULL);
+  PooledInt *outside = new PooledInt(1);
+  MemPool pool;
+  PooledInt *inside;
+  {
+    MemPool::Scope scope(pool);
+    BOOST_CHECK(MemPool::Current() == &pool);
+    inside = new PooledInt(2);
+  }
+  BOOST_CHECK(MemPool::Current() == NULL);
+  BOOST_CHECK_EQUAL(pool.GetNumAllocations(), 1);
+  BOOST_CHECK_EQUAL(inside->value, 2);
+  // each object goes back where it came from, whatever the current pool
+  {
+    MemPool::Scope scope(pool);
+    delete outside;
+  }
+  delete inside;
+  BOOST_CHECK_EQUAL(pool.GetNumRecycled(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(allocator)
+{
+  typedef std::vector<int, PoolAllocator<int> > Vector;
+  MemPool pool;
+  Vector *vec;
+  {
+    MemPool::Scope scope(pool);
+    vec = new Vector;
+    for (int i = 0; i < 100; ++i) {
+      vec->push_back(i);
+    }
+  }
+  size_t allocations = pool.GetNumAllocations();
+  BOOST_CHECK(allocations > 0);
+  BOOST_CHECK(pool.GetNumRecycled() > 0);
+  // growing outside the scope takes heap memory and gives the old storage
+  // back to the pool
+  for (int i = 100; i < 1000; ++i) {
+    vec->push_back(i);
+  }
+  BOOST_CHECK_EQUAL(pool.GetNumAllocations(), allocations);
+  BOOST_CHECK_EQUAL((*vec)[999], 999);
+  delete vec;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
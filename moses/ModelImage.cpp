@@ -0,0 +1,123 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2011 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "ModelImage.h"
+
+#include <vector>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
+
+#include "Util.h"
+#include "util/file.hh"
+#include "util/mmap.hh"
+
+namespace fs = boost::filesystem;
+
+namespace Moses
+{
+namespace
+{
+// Absolute, with the directory resolved if it exists, so that the tool and
+// the decoder agree however the path was written.
+fs::path Resolve(const std::string& path)
+{
+  fs::path ret = fs::absolute(path);
+  // a trailing slash
+  if (ret.filename() == ".") ret = ret.parent_path();
+  if (fs::is_directory(ret.parent_path()))
+    ret = fs::canonical(ret.parent_path()) / ret.filename();
+  return ret;
+}
+
+// The extensions feature adds to its path= argument before opening it.
+std::vector<std::string> AddedExtensions(const std::string& feature)
+{
+  std::vector<std::string> ret;
+  if (feature == "PhraseDictionaryCompact") {
+    ret.push_back(".minphr");
+  } else if (feature == "LexicalReordering") {
+    ret.push_back(".minlexr");
+  }
+  return ret;
+}
+
+size_t CopyFile(const fs::path& from, const fs::path& to)
+{
+  util::scoped_fd in(util::OpenReadOrThrow(from.string().c_str()));
+  util::scoped_fd out(util::CreateOrThrow(to.string().c_str()));
+  util::CopyToImage(in.get(), out.get());
+  return util::SizeOrThrow(in.get());
+}
+}
+
+std::string ModelImagePath(const std::string& image, const std::string& path)
+{
+  return (fs::path(image) / Resolve(path).relative_path()).string();
+}
+
+std::string FindInModelImage(const std::string& image, const std::string& path,
+                             const std::vector<std::string>& extensions)
+{
+  fs::path copy(ModelImagePath(image, path));
+  if (fs::exists(copy)) return copy.string();
+  for (size_t i = 0; i < extensions.size(); ++i) {
+    if (fs::exists(copy.string() + extensions[i])) return copy.string();
+  }
+  return "";
+}
+
+size_t CopyToModelImage(const std::string& image, const std::string& path)
+{
+  fs::path from(Resolve(path));
+  fs::path to(ModelImagePath(image, path));
+  UTIL_THROW_IF2(!fs::exists(from), "Model " << path << " does not exist");
+  fs::create_directories(to.parent_path());
+  if (!fs::is_directory(from)) return CopyFile(from, to);
+
+  fs::create_directories(to);
+  size_t bytes = 0;
+  const size_t prefix = from.string().size();
+  for (fs::recursive_directory_iterator i(from); i != fs::recursive_directory_iterator(); ++i) {
+    fs::path target(to.string() + i->path().string().substr(prefix));
+    if (fs::is_directory(i->path())) {
+      fs::create_directories(target);
+    } else {
+      bytes += CopyFile(i->path(), target);
+    }
+  }
+  return bytes;
+}
+
+std::string UseModelImage(const std::string& image, const std::string& line)
+{
+  std::vector<std::string> toks = Tokenize(line);
+  if (toks.empty()) return line;
+  const std::vector<std::string> extensions = AddedExtensions(toks[0]);
+  for (size_t i = 1; i < toks.size(); ++i) {
+    if (!boost::algorithm::starts_with(toks[i], "path=")) continue;
+    std::string copy = FindInModelImage(image, toks[i].substr(5), extensions);
+    if (copy.empty()) continue;
+    toks[i] = "path=" + copy;
+  }
+  return Join(" ", toks);
+}
+
+}
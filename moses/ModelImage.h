@@ -0,0 +1,57 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2011 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Moses
+{
+/** A model image is a directory on tmpfs (e.g. /dev/shm/moses) holding
+ *  copies of binarized models under their absolute paths, so that
+ *  /work/lm.bin is kept as /dev/shm/moses/work/lm.bin.  CreateModelImage
+ *  fills it once; decoders started with -model-image then map the copies,
+ *  which the kernel shares between all of them and which are already in
+ *  memory.
+ *
+ *  This relies on the models mapping their files rather than reading them:
+ *  KenLM with the default load=populate, compact tables without
+ *  -minphr-memory or -minlexr-memory, and ProbingPT.
+ */
+
+//! where path is kept in image
+std::string ModelImagePath(const std::string& image, const std::string& path);
+
+/** The copy of path in image, if there is one, else the empty string.  As
+ *  the compact tables add their extension to path themselves, this also
+ *  accepts a copy of path with one of extensions, and then returns the path
+ *  without it.
+ */
+std::string FindInModelImage(const std::string& image, const std::string& path,
+                             const std::vector<std::string>& extensions = std::vector<std::string>());
+
+//! copy file or directory path into image, returning the number of bytes
+size_t CopyToModelImage(const std::string& image, const std::string& path);
+
+//! point the path= arguments of a feature line at their copies in image
+std::string UseModelImage(const std::string& image, const std::string& line);
+
+}
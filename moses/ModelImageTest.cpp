@@ -0,0 +1,105 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2011 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <fstream>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "ModelImage.h"
+
+using namespace Moses;
+using namespace std;
+namespace fs = boost::filesystem;
+
+namespace
+{
+// A model directory and an image directory, removed at the end.
+struct ImageFixture {
+  ImageFixture()
+    : models(fs::canonical(fs::temp_directory_path()) / fs::unique_path("models-%%%%-%%%%"))
+    , image(fs::temp_directory_path() / fs::unique_path("image-%%%%-%%%%")) {
+    fs::create_directories(models / "probing");
+    Write(models / "lm.bin", "language model");
+    Write(models / "pt.minphr", "phrase table");
+    Write(models / "probing" / "binfile.dat", "probing table");
+  }
+
+  ~ImageFixture() {
+    fs::remove_all(models);
+    fs::remove_all(image);
+  }
+
+  static void Write(const fs::path& path, const string& text) {
+    ofstream out(path.string().c_str());
+    out << text;
+  }
+
+  static string Read(const string& path) {
+    ifstream in(path.c_str());
+    stringstream text;
+    text << in.rdbuf();
+    return text.str();
+  }
+
+  fs::path models;
+  fs::path image;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(model_image, ImageFixture)
+
+BOOST_AUTO_TEST_CASE(copies_files_and_directories)
+{
+  const string lm = (models / "lm.bin").string();
+  BOOST_CHECK_EQUAL(FindInModelImage(image.string(), lm), "");
+  BOOST_CHECK_EQUAL(CopyToModelImage(image.string(), lm), 14u);
+  BOOST_CHECK_EQUAL(CopyToModelImage(image.string(), (models / "probing").string() + "/"), 13u);
+
+  const string copy = ModelImagePath(image.string(), lm);
+  BOOST_CHECK_EQUAL(copy, (image / models.relative_path() / "lm.bin").string());
+  BOOST_CHECK_EQUAL(Read(copy), "language model");
+  BOOST_CHECK_EQUAL(FindInModelImage(image.string(), lm), copy);
+  // however the path is written
+  BOOST_CHECK_EQUAL(FindInModelImage(image.string(), (models / "probing" / ".." / "lm.bin").string()), copy);
+
+  const string probing = FindInModelImage(image.string(), (models / "probing").string());
+  BOOST_REQUIRE(!probing.empty());
+  BOOST_CHECK_EQUAL(Read((fs::path(probing) / "binfile.dat").string()), "probing table");
+}
+
+BOOST_AUTO_TEST_CASE(rewrites_feature_paths)
+{
+  CopyToModelImage(image.string(), (models / "pt.minphr").string());
+  const string pt = (models / "pt").string();
+  const string lm = (models / "lm.bin").string();
+  // the compact table adds .minphr to the path itself
+  const string line = "PhraseDictionaryCompact name=TM0 path=" + pt + " input-factor=0";
+  BOOST_CHECK_EQUAL(UseModelImage(image.string(), line),
+                    "PhraseDictionaryCompact name=TM0 path=" + ModelImagePath(image.string(), pt) + " input-factor=0");
+  // only the compact table adds .minphr
+  const string other = "KENLM name=LM1 factor=0 path=" + pt + " order=5";
+  BOOST_CHECK_EQUAL(UseModelImage(image.string(), other), other);
+  // not in the image
+  const string kenlm = "KENLM name=LM0 factor=0 path=" + lm + " order=5";
+  BOOST_CHECK_EQUAL(UseModelImage(image.string(), kenlm), kenlm);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -22,6 +22,7 @@
 #define moses_OutputCollector_h
 
 #ifdef WITH_THREADS
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
 #endif
 
@@ -32,13 +33,18 @@
 #include <iostream>
 #include <map>
 #include <ostream>
+#include <set>
 #include <string>
 #include "Util.h"
 #include "util/exception.hh"
 namespace Moses
 {
 /**
-* Makes sure output goes in the correct order when multi-threading
+* Makes sure output goes in the correct order when multi-threading.
+* Finished translations are buffered until all earlier ones are written;
+* WaitForWindow() lets the input side bound how far ahead it can get.
+* In unordered mode, output is written as soon as it arrives and each
+* line is tagged with its source id instead.
 **/
 class OutputCollector
 {
@@ -46,13 +52,17 @@ public:
   OutputCollector(std::ostream* outStream= &std::cout,
                   std::ostream* debugStream=&std::cerr)
     : m_nextOutput(0)
+    , m_window(0)
+    , m_unordered(false)
     , m_outStream(outStream)
     , m_debugStream(debugStream)
     , m_isHoldingOutputStream(false)
     , m_isHoldingDebugStream(false) {}
 
   OutputCollector(std::string xout, std::string xerr = "")
-    : m_nextOutput(0) {
+    : m_nextOutput(0)
+    , m_window(0)
+    , m_unordered(false) {
     // TO DO open magic streams instead of regular ofstreams! [UG]
 
     if (xout == "/dev/stderr") {
@@ -101,6 +111,37 @@ public:
     return (m_outStream == &std::cout);
   }
 
+  //! id of the first sentence, if not 0
+  void SetFirstSourceId(int sourceId) {
+    m_nextOutput = sourceId;
+  }
+
+  //! at most this many sentences past the first unwritten one may be
+  //! submitted (see WaitForWindow()); 0 means no limit
+  void SetReorderWindow(size_t window) {
+    m_window = window;
+  }
+
+  //! write output as it comes, each line prefixed with the source id and a tab
+  void SetUnordered(bool unordered) {
+    m_unordered = unordered;
+  }
+
+  /**
+    * Block until the output for sourceId falls within the reorder window,
+    * ie. until fewer than window sentences before it are still unwritten.
+    * Call this before submitting the sentence for translation.
+    **/
+  void WaitForWindow(int sourceId) {
+#ifdef WITH_THREADS
+    if (!m_window) return;
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (sourceId - m_nextOutput >= static_cast<int>(m_window)) {
+      m_windowCond.wait(lock);
+    }
+#endif
+  }
+
   /**
     * Write or cache the output, as appropriate.
     **/
@@ -108,7 +149,17 @@ public:
 #ifdef WITH_THREADS
     boost::mutex::scoped_lock lock(m_mutex);
 #endif
-    if (sourceId == m_nextOutput) {
+    if (m_unordered) {
+      WriteTagged(sourceId, output);
+      *m_debugStream << debug << std::flush;
+      // only remember which ids are done, to keep track of the window
+      m_finished.insert(sourceId);
+      std::set<int>::iterator iter;
+      while ((iter = m_finished.find(m_nextOutput)) != m_finished.end()) {
+        m_finished.erase(iter);
+        ++m_nextOutput;
+      }
+    } else if (sourceId == m_nextOutput) {
       //This is the one we were expecting
       *m_outStream << output << std::flush;
       *m_debugStream << debug << std::flush;
@@ -129,22 +180,42 @@ public:
       //save for later
       m_outputs[sourceId] = output;
       m_debugs[sourceId] = debug;
+      return;
     }
+#ifdef WITH_THREADS
+    m_windowCond.notify_all();
+#endif
   }
 
 
 private:
   std::map<int,std::string> m_outputs;
   std::map<int,std::string> m_debugs;
+  std::set<int> m_finished; // unordered mode: written, but not m_nextOutput yet
   int m_nextOutput;
+  size_t m_window;
+  bool m_unordered;
   std::ostream* m_outStream;
   std::ostream* m_debugStream;
   bool m_isHoldingOutputStream;
   bool m_isHoldingDebugStream;
 #ifdef WITH_THREADS
   boost::mutex m_mutex;
+  boost::condition_variable m_windowCond;
 #endif
 
+  void WriteTagged(int sourceId, const std::string& output) {
+    size_t start = 0;
+    while (start < output.size()) {
+      size_t end = output.find('\n', start);
+      end = (end == std::string::npos) ? output.size() : end + 1;
+      *m_outStream << sourceId << '\t';
+      m_outStream->write(output.data() + start, end - start);
+      start = end;
+    }
+    *m_outStream << std::flush;
+  }
+
 public:
   void SetOutputStream(std::ostream* outStream) {
     m_outStream = outStream;
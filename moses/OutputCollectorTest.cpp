@@ -0,0 +1,84 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2011 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+#ifdef WITH_THREADS
+#include <boost/bind/bind.hpp>
+#include <boost/thread.hpp>
+#endif
+
+#include "OutputCollector.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+#ifdef WITH_THREADS
+void WriteAfter(OutputCollector *collector, int sourceId, int milliseconds)
+{
+  boost::this_thread::sleep(boost::posix_time::milliseconds(milliseconds));
+  collector->Write(sourceId, SPrint(sourceId) + "\n");
+}
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE(output_collector)
+
+BOOST_AUTO_TEST_CASE(ordered)
+{
+  ostringstream out, debug;
+  OutputCollector collector(&out, &debug);
+  collector.SetFirstSourceId(3);
+  collector.Write(4, "b\n", "4");
+  BOOST_CHECK_EQUAL(out.str(), "");
+  collector.Write(3, "a\n", "3");
+  BOOST_CHECK_EQUAL(out.str(), "a\nb\n");
+  BOOST_CHECK_EQUAL(debug.str(), "34");
+}
+
+BOOST_AUTO_TEST_CASE(unordered)
+{
+  ostringstream out, debug;
+  OutputCollector collector(&out, &debug);
+  collector.SetUnordered(true);
+  collector.Write(1, "b\nc\n");
+  collector.Write(0, "a\n");
+  BOOST_CHECK_EQUAL(out.str(), "1\tb\n1\tc\n0\ta\n");
+}
+
+#ifdef WITH_THREADS
+BOOST_AUTO_TEST_CASE(window)
+{
+  ostringstream out, debug;
+  OutputCollector collector(&out, &debug);
+  collector.SetReorderWindow(2);
+  collector.WaitForWindow(1); // returns at once
+  // sentence 2 may only start once the slow sentence 0 is written
+  boost::thread slow(boost::bind(&WriteAfter, &collector, 0, 100));
+  collector.WaitForWindow(2);
+  slow.join();
+  BOOST_CHECK_EQUAL(out.str(), "0\n");
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
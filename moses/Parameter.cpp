@@ -109,6 +109,7 @@ Parameter::Parameter()
   AddParam(search_opts,"disable-discarding", "dd", "disable hypothesis discarding"); // ??? memory management? UG
   AddParam(search_opts,"phrase-drop-allowed", "da", "if present, allow dropping of source words"); //da = drop any (word); see -du for comparison
   AddParam(search_opts,"threads","th", "number of threads to use in decoding (defaults to single-threaded)");
+  AddParam(search_opts,"thread-work-stealing", "give each decoding thread its own task queue and let idle threads steal work (default false)");
 
   // distortion options
   po::options_description disto_opts("Distortion options");
@@ -121,7 +122,8 @@ Parameter::Parameter()
   po::options_description cube_opts("Cube pruning options.");
   AddParam(cube_opts,"cube-pruning-pop-limit", "cbp", "How many hypotheses should be popped for each stack. (default = 1000)");
   AddParam(cube_opts,"cube-pruning-diversity", "cbd", "How many hypotheses should be created for each coverage. (default = 0)");
-  AddParam(cube_opts,"cube-pruning-lazy-scoring", "cbls", "Don't fully score a hypothesis until it is popped");
+  AddParam(cube_opts,"cube-pruning-lazy-scoring", "cbls", "Queue candidates by an estimate without stateful features and only fully score them when they reach the top");
+  AddParam(cube_opts,"cube-pruning-lazy-batch-size", "How many candidates to fully score together with lazy scoring. (default = 8)");
   AddParam(cube_opts,"cube-pruning-deterministic-search", "cbds", "Break ties deterministically during search");
 
   ///////////////////////////////////////////////////////////////////////////////////////
@@ -162,6 +164,7 @@ Parameter::Parameter()
   AddParam(input_opts,"xml-input", "xi", "allows markup of input with desired translations and probabilities. values can be 'pass-through' (default), 'inclusive', 'exclusive', 'constraint', 'ignore'");
   AddParam(input_opts,"xml-brackets", "xb", "specify strings to be used as xml tags opening and closing, e.g. \"{{ }}\" (default \"< >\"). Avoid square brackets because of configuration file format. Valid only with text input mode" );
   AddParam(input_opts,"start-translation-id", "Id of 1st input. Default = 0");
+  AddParam(input_opts,"input-threads", "when multi-threaded, parse one-line input (text, tabbed, tree, lattice) on this many threads ahead of decoding. Default = 0 (parse on the main thread)");
   AddParam(input_opts,"alternate-weight-setting", "aws", "alternate set of weights to used per xml specification");
 
   ///////////////////////////////////////////////////////////////////////////////////////
@@ -170,6 +173,8 @@ Parameter::Parameter()
   AddParam(output_opts,"report-all-factors", "report all factors in output, not just first");
   AddParam(output_opts,"output-factors", "list if factors in the output");
   AddParam(output_opts,"print-id", "prefix translations with id. Default if false");
+  AddParam(output_opts,"output-reorder-window", "when multi-threaded, read at most this many sentences past the first one whose translation hasn't been written, to bound buffered output. Default = 0 (no limit)");
+  AddParam(output_opts,"output-unordered", "write translations as soon as they are done, each line prefixed with the sentence id and a tab. Default is false");
   AddParam(output_opts,"print-passthrough", "output the sgml tag <passthrough> without any computation on that. Default is false");
   AddParam(output_opts,"print-passthrough-in-n-best", "output the sgml tag <passthrough> without any computation on that in each entry of the n-best-list. Default is false");
   AddParam(output_opts,"output-factors", "list of factors in the output");
@@ -240,6 +245,8 @@ Parameter::Parameter()
            "Timeout for sessions, e.g. '2h30m' or 1d (=24h)");
   AddParam(server_opts,"session-cache-size", string("Max. number of sessions cached.")
            +"Least recently used session is dumped first.");
+  AddParam(server_opts,"server-result-cache-size", string("Max. number of translation results cached ")
+           +"for repeated requests (default 0 = no caching).");
 
   po::options_description irstlm_opts("IRSTLM Options");
   AddParam(irstlm_opts,"clean-lm-cache",
@@ -247,6 +254,7 @@ Parameter::Parameter()
 
   po::options_description chart_opts("Chart Decoding Options");
   AddParam(chart_opts,"max-chart-span", "maximum num. of source word chart rules can consume (default 10)");
+  AddParam(chart_opts,"chart-threads", "number of threads that score the rule cubes of one chart cell, to lower the latency of long sentences (default 1)");
   AddParam(chart_opts,"non-terminals", "list of non-term symbols, space separated");
   AddParam(chart_opts,"rule-limit", "a little like table limit. But for chart decoding rules. Default is DEFAULT_MAX_TRANS_OPT_SIZE");
   AddParam(chart_opts,"source-label-overlap", "What happens if a span already has a label. 0=add more. 1=replace. 2=discard. Default is 0");
@@ -267,6 +275,7 @@ Parameter::Parameter()
   AddParam(misc_opts,"feature-name-overwrite", "Override feature name (NOT arguments). Eg. SRILM-->KENLM, PhraseDictionaryMemory-->PhraseDictionaryScope3");
 
   AddParam(misc_opts,"feature", "All the feature functions should be here");
+  AddParam(misc_opts,"model-image", "Directory made by CreateModelImage (e.g. on /dev/shm); models found there are mapped from it instead of their paths");
   AddParam(misc_opts,"context-string",
            "A (tokenized) string containing context words for context-sensitive translation.");
   AddParam(misc_opts,"context-weights", "A key-value map for context-sensitive translation.");
@@ -45,11 +45,19 @@ RuleCube::RuleCube(const ChartTranslationOptions &transOpt,
   if (StaticData::Instance().options()->cube.lazy_scoring) {
     item->EstimateScore();
   } else {
-    item->CreateHypothesis(transOpt, manager);
+    item->CreateUnscoredHypothesis(transOpt, manager);
   }
   m_queue.push(item);
 }
 
+// the queue holds only the top-left item, so its order doesn't change
+void RuleCube::ScoreTopLeft()
+{
+  if (!StaticData::Instance().options()->cube.lazy_scoring) {
+    m_queue.top()->ScoreHypothesis();
+  }
+}
+
 RuleCube::~RuleCube()
 {
   RemoveAllInColl(m_covered);
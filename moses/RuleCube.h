@@ -86,11 +86,15 @@ class RuleCube
   friend std::ostream& operator<<(std::ostream &out, const RuleCube &obj);
 
 public:
+  // Unless scoring is lazy, the hypothesis of the top-left item is created
+  // but only scored by ScoreTopLeft().
   RuleCube(const ChartTranslationOptions &, const ChartCellCollection &,
            ChartManager &);
 
   ~RuleCube();
 
+  void ScoreTopLeft();
+
   float GetTopScore() const {
     UTIL_THROW_IF2(m_queue.empty(), "Empty queue, nothing to pop");
     RuleCubeItem *item = m_queue.top();
@@ -77,8 +77,19 @@ void RuleCubeItem::EstimateScore()
 
 void RuleCubeItem::CreateHypothesis(const ChartTranslationOptions &transOpt,
                                     ChartManager &manager)
+{
+  CreateUnscoredHypothesis(transOpt, manager);
+  ScoreHypothesis();
+}
+
+void RuleCubeItem::CreateUnscoredHypothesis(const ChartTranslationOptions &transOpt,
+    ChartManager &manager)
 {
   m_hypothesis = new ChartHypothesis(transOpt, *this, manager);
+}
+
+void RuleCubeItem::ScoreHypothesis()
+{
   m_hypothesis->EvaluateWhenApplied();
   m_score = m_hypothesis->GetFutureScore();
 }
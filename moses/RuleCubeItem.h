@@ -133,6 +133,11 @@ public:
 
   void CreateHypothesis(const ChartTranslationOptions &, ChartManager &);
 
+  // The two steps of CreateHypothesis(). Only the first takes a hypothesis
+  // id, so the second can run on another thread.
+  void CreateUnscoredHypothesis(const ChartTranslationOptions &, ChartManager &);
+  void ScoreHypothesis();
+
   ChartHypothesis *ReleaseHypothesis();
 
   bool operator<(const RuleCubeItem &) const;
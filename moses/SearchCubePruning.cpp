@@ -24,8 +24,9 @@ public:
     }
 
     // Compare the top hypothesis of each bitmap container using the TotalScore, which includes future cost
-    const float scoreA = A->Top()->GetHypothesis()->GetFutureScore();
-    const float scoreB = B->Top()->GetHypothesis()->GetFutureScore();
+    // (or its estimate, with lazy scoring)
+    const float scoreA = A->Top()->GetScore();
+    const float scoreB = B->Top()->GetScore();
 
     if (scoreA < scoreB) {
       return true;
@@ -135,6 +136,20 @@ void SearchCubePruning::Decode()
       BitmapContainer *bc = BCQueue.top();
       BCQueue.pop();
       m_manager.GetSentenceStats().StopTimeManageCubes();
+      // with lazy scoring, the best candidate may only have an estimate:
+      // score it and compare again, which doesn't count as a pop
+      IFVERBOSE(2) {
+        m_manager.GetSentenceStats().StartTimeOtherScore();
+      }
+      const bool rescored = bc->ScoreBestCandidates();
+      IFVERBOSE(2) {
+        m_manager.GetSentenceStats().StopTimeOtherScore();
+      }
+      if (rescored) {
+        BCQueue.push(bc);
+        --numpops;
+        continue;
+      }
       IFVERBOSE(2) {
         m_manager.GetSentenceStats().AddPopped();
       }
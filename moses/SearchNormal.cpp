@@ -263,9 +263,37 @@ ExpandAllHypotheses(const Hypothesis &hypothesis, size_t startPos, size_t endPos
   const Bitmap &nextBitmap = m_bitmaps.GetBitmap(sourceCompleted, nextRange);
 
   TranslationOptionList::const_iterator iter;
+  if (m_options.search.UseEarlyDiscarding()) {
+    for (iter = tol->begin() ; iter != tol->end() ; ++iter) {
+      const TranslationOption &transOpt = **iter;
+      ExpandHypothesis(hypothesis, transOpt, expectedScore, estimatedScore, nextBitmap);
+    }
+    return;
+  }
+
+  // nothing is discarded before scoring, so build all expansions and score
+  // them as one batch, which lets the language model overlap its lookups
+  SentenceStats &stats = m_manager.GetSentenceStats();
+  IFVERBOSE(2) {
+    stats.StartTimeBuildHyp();
+  }
+  std::vector<Hypothesis*> newHypos;
+  newHypos.reserve(tol->size());
   for (iter = tol->begin() ; iter != tol->end() ; ++iter) {
     const TranslationOption &transOpt = **iter;
-    ExpandHypothesis(hypothesis, transOpt, expectedScore, estimatedScore, nextBitmap);
+    newHypos.push_back(new Hypothesis(hypothesis, transOpt, nextBitmap, m_manager.GetNextHypoId()));
+  }
+  IFVERBOSE(2) {
+    stats.StopTimeBuildHyp();
+    stats.StartTimeOtherScore();
+  }
+  Hypothesis::EvaluateWhenApplied(newHypos, estimatedScore);
+  IFVERBOSE(2) {
+    stats.StopTimeOtherScore();
+  }
+
+  for (size_t i = 0; i < newHypos.size(); ++i) {
+    AddHypothesisToStack(newHypos[i]);
   }
 }
 
@@ -360,6 +388,16 @@ void SearchNormal::ExpandHypothesis(const Hypothesis &hypothesis,
 
   }
 
+  AddHypothesisToStack(newHypo);
+}
+
+/**
+ * Add a scored hypothesis to the stack for its number of covered words
+ */
+void SearchNormal::AddHypothesisToStack(Hypothesis *newHypo)
+{
+  SentenceStats &stats = m_manager.GetSentenceStats();
+
   // logging for the curious
   IFVERBOSE(3) {
     newHypo->PrintHypothesis();
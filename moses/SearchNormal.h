@@ -48,6 +48,9 @@ protected:
                    float estimatedScore,
                    const Bitmap &bitmap);
 
+  void
+  AddHypothesisToStack(Hypothesis *newHypo);
+
 public:
   SearchNormal(Manager& manager, const TranslationOptionCollection &transOptColl);
   ~SearchNormal();
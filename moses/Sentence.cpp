@@ -23,6 +23,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <stdexcept>
 #include <boost/algorithm/string.hpp>
 #include <boost/foreach.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#endif
 
 #include "Sentence.h"
 #include "TranslationOptionCollectionText.h"
@@ -40,6 +44,15 @@ using namespace std;
 namespace Moses
 {
 
+#ifdef WITH_THREADS
+namespace
+{
+// markup that changes global state, which inputs parsed on several
+// threads (--input-threads) would otherwise change concurrently
+boost::mutex s_global_markup_lock;
+}
+#endif
+
 Sentence::
 Sentence(AllOptions::ptr const& opts) : Phrase(0) , InputType(opts)
 {
@@ -110,6 +123,9 @@ aux_interpret_sgml_markup(string& line)
   if ((i = meta.find("weight-setting")) != meta.end()) {
     this->SetWeightSetting(i->second);
     this->SetSpecifiesWeightSetting(true);
+#ifdef WITH_THREADS
+    boost::lock_guard<boost::mutex> lock(s_global_markup_lock);
+#endif
     StaticData::Instance().SetWeightSetting(i->second);
     // oh this is so horrible! Why does this have to be propagated globally?
     // --- UG
@@ -124,6 +140,9 @@ aux_interpret_dlt(string& line) // whatever DLT means ... --- UG
   typedef map<string, string> str2str_map;
   m_dlt_meta = ProcessAndStripDLT(line);
   // what's happening below is most likely not thread-safe! UG
+#ifdef WITH_THREADS
+  boost::lock_guard<boost::mutex> lock(s_global_markup_lock);
+#endif
   BOOST_FOREACH(str2str_map const& M, m_dlt_meta) {
     str2str_map::const_iterator i,j;
     if ((i = M.find("type")) != M.end()) {
@@ -37,6 +37,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "GenerationDictionary.h"
 #include "StaticData.h"
 #include "Util.h"
+#include "ModelImage.h"
 #include "FactorCollection.h"
 #include "Timer.h"
 #include "TranslationOption.h"
@@ -49,6 +50,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #ifdef WITH_THREADS
 #include <boost/thread.hpp>
+#include "ThreadPool.h"
 #endif
 #ifdef HAVE_CMPH
 #include "moses/TranslationModel/CompactPT/PhraseDictionaryCompact.h"
@@ -76,6 +78,9 @@ StaticData::StaticData()
 
 StaticData::~StaticData()
 {
+#ifdef WITH_THREADS
+  m_chartThreadPool.reset();
+#endif
   RemoveAllInColl(m_decodeGraphs);
   Phrase::FinalizeMemPool();
 }
@@ -94,9 +99,14 @@ StaticData
   // all features
   map<string, int> featureIndexMap;
 
+  string modelImage;
+  m_parameter->SetParameter<string>(modelImage, "model-image", "");
+
   const PARAM_VEC* params = m_parameter->GetParam("feature");
   for (size_t i = 0; params && i < params->size(); ++i) {
-    const string &line = Trim(params->at(i));
+    string line = Trim(params->at(i));
+    if (!modelImage.empty())
+      line = UseModelImage(modelImage, line);
     VERBOSE(1,"line=" << line << endl);
     if (line.empty())
       continue;
@@ -170,6 +180,15 @@ StaticData
 #endif
     }
   }
+  m_parameter->SetParameter(m_threadWorkStealing, "thread-work-stealing", false);
+
+#ifdef WITH_THREADS
+  // The thread decoding a sentence works on its own ranges too, so the
+  // pool has one thread fewer than --chart-threads.
+  if (m_options->syntax.chart_threads > 1) {
+    m_chartThreadPool.reset(new ThreadPool(m_options->syntax.chart_threads - 1));
+  }
+#endif
   return true;
 }
 
@@ -34,6 +34,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <string>
 
 #ifdef WITH_THREADS
+#include <boost/scoped_ptr.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
 #endif
@@ -56,6 +57,9 @@ class DecodeStep;
 
 class DynamicCacheBasedLanguageModel;
 class PhraseDictionaryDynamicCacheBased;
+#ifdef WITH_THREADS
+class ThreadPool;
+#endif
 
 typedef std::pair<std::string, float> UnknownLHSEntry;
 typedef std::vector<UnknownLHSEntry>  UnknownLHSList;
@@ -111,6 +115,10 @@ protected:
   UnknownLHSList m_unknownLHS;
 
   int m_threadCount;
+  bool m_threadWorkStealing;
+#ifdef WITH_THREADS
+  boost::scoped_ptr<ThreadPool> m_chartThreadPool; //! shared by all sentences for --chart-threads
+#endif
   // long m_startTranslationId;
 
   // alternate weight settings
@@ -265,6 +273,17 @@ public:
     return m_threadCount;
   }
 
+  bool ThreadWorkStealing() const {
+    return m_threadWorkStealing;
+  }
+
+#ifdef WITH_THREADS
+  //! threads that help the decoding thread of a chart sentence, NULL with one --chart-threads
+  ThreadPool *GetChartThreadPool() const {
+    return m_chartThreadPool.get();
+  }
+#endif
+
   void SetExecPath(const std::string &path);
   const std::string &GetBinDirectory() const;
 
@@ -20,6 +20,10 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
 
+#include <algorithm>
+
+#include <boost/exception_ptr.hpp>
+
 #include "ThreadPool.h"
 
 #ifdef WITH_THREADS
@@ -30,11 +34,21 @@ using namespace Moses;
 namespace Moses
 {
 
-ThreadPool::ThreadPool( size_t numThreads )
+ThreadPool::ThreadPool( size_t numThreads, bool workStealing )
   : m_stopped(false), m_stopping(false), m_queueLimit(0)
+  , m_pending(0), m_active(0), m_idle(0), m_nextQueue(0)
 {
+  if (workStealing) {
+    for (size_t i = 0; i < std::max(numThreads, size_t(1)); ++i) {
+      m_workerQueues.push_back(boost::shared_ptr<WorkerQueue>(new WorkerQueue));
+    }
+  }
   for (size_t i = 0; i < numThreads; ++i) {
-    m_threads.create_thread(boost::bind(&ThreadPool::Execute,this));
+    if (workStealing) {
+      m_threads.create_thread(boost::bind(&ThreadPool::ExecuteStealing,this,i));
+    } else {
+      m_threads.create_thread(boost::bind(&ThreadPool::Execute,this));
+    }
   }
 }
 
@@ -61,8 +75,121 @@ void ThreadPool::Execute()
   } while (!m_stopped);
 }
 
+void ThreadPool::ExecuteStealing(size_t index)
+{
+  m_workerIndex.reset(new size_t(index));
+  while (!m_stopped) {
+    boost::shared_ptr<Task> task = PopTask(index);
+    if (task) {
+      RunTask(task);
+      continue;
+    }
+    // Nothing to do anywhere: sleep until a job is submitted. m_idle is
+    // raised before m_pending is checked, and Submit raises m_pending before
+    // checking m_idle, so a wakeup cannot be lost.
+    boost::mutex::scoped_lock lock(m_mutex);
+    ++m_idle;
+    while (m_pending == 0 && !m_stopped) {
+      m_threadNeeded.wait(lock);
+    }
+    --m_idle;
+  }
+}
+
+boost::shared_ptr<Task> ThreadPool::PopTask(size_t index)
+{
+  boost::shared_ptr<Task> task;
+  const size_t numQueues = m_workerQueues.size();
+  // own deque first, from the front (most recent subtasks, then oldest jobs)
+  {
+    WorkerQueue &own = *m_workerQueues[index];
+    boost::mutex::scoped_lock lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = own.tasks.front();
+      own.tasks.pop_front();
+    }
+  }
+  // then steal from the back of the other deques
+  for (size_t i = 1; !task && i < numQueues; ++i) {
+    WorkerQueue &victim = *m_workerQueues[(index + i) % numQueues];
+    boost::mutex::scoped_lock lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = victim.tasks.back();
+      victim.tasks.pop_back();
+    }
+  }
+  if (task) {
+    ++m_active;
+    --m_pending;
+  }
+  return task;
+}
+
+void ThreadPool::RunTask(boost::shared_ptr<Task> task)
+{
+  task->Run();
+  --m_active;
+  // wake Submit (queue limit) and Stop (drain) if they might be waiting
+  if (m_queueLimit > 0 || (m_stopping && m_pending == 0 && m_active == 0)) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_threadAvailable.notify_all();
+  }
+}
+
+bool ThreadPool::RunPendingTask()
+{
+  if (IsWorkStealing()) {
+    size_t *index = m_workerIndex.get();
+    boost::shared_ptr<Task> task = PopTask(index ? *index : 0);
+    if (!task) return false;
+    RunTask(task);
+    return true;
+  }
+
+  boost::shared_ptr<Task> task;
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (m_tasks.empty()) return false;
+    task = m_tasks.front();
+    m_tasks.pop();
+  }
+  task->Run();
+  m_threadAvailable.notify_all();
+  return true;
+}
+
 void ThreadPool::Submit(boost::shared_ptr<Task> task)
 {
+  if (IsWorkStealing()) {
+    size_t *index = m_workerIndex.get();
+    if (index) {
+      // subtask: keep it on this thread, run before older work
+      WorkerQueue &own = *m_workerQueues[*index];
+      ++m_pending;
+      boost::mutex::scoped_lock lock(own.mutex);
+      own.tasks.push_front(task);
+    } else {
+      if (m_stopping) {
+        throw runtime_error("ThreadPool stopping - unable to accept new jobs");
+      }
+      if (m_queueLimit > 0) {
+        boost::mutex::scoped_lock lock(m_mutex);
+        while (m_pending >= m_queueLimit) {
+          m_threadAvailable.wait(lock);
+        }
+      }
+      WorkerQueue &target = *m_workerQueues[m_nextQueue++ % m_workerQueues.size()];
+      ++m_pending;
+      boost::mutex::scoped_lock lock(target.mutex);
+      target.tasks.push_back(task);
+    }
+    if (m_idle > 0) {
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_threadNeeded.notify_one();
+    }
+    return;
+  }
+
   boost::mutex::scoped_lock lock(m_mutex);
   if (m_stopping) {
     throw runtime_error("ThreadPool stopping - unable to accept new jobs");
@@ -85,8 +212,15 @@ void ThreadPool::Stop(bool processRemainingJobs)
   if (processRemainingJobs) {
     boost::mutex::scoped_lock lock(m_mutex);
     //wait for queue to drain.
-    while (!m_tasks.empty() && !m_stopped) {
-      m_threadAvailable.wait(lock);
+    if (IsWorkStealing()) {
+      // running jobs may still submit subtasks, so wait for those too
+      while ((m_pending > 0 || m_active > 0) && !m_stopped) {
+        m_threadAvailable.wait(lock);
+      }
+    } else {
+      while (!m_tasks.empty() && !m_stopped) {
+        m_threadAvailable.wait(lock);
+      }
     }
   }
   //tell all threads to stop
@@ -99,6 +233,83 @@ void ThreadPool::Stop(bool processRemainingJobs)
   m_threads.join_all();
 }
 
+namespace
+{
+// Ranges of one ParallelFor call, taken in order by whoever comes first.
+struct ParallelForState {
+  ParallelForState(size_t size, size_t numChunks,
+                   boost::function<void (size_t, size_t)> const& body)
+    : size(size), numChunks(numChunks), body(body), next(0), done(0) {}
+
+  // Run ranges until there are none left to take.
+  void Work() {
+    size_t chunk;
+    while ((chunk = next++) < numChunks) {
+      try {
+        body(size * chunk / numChunks, size * (chunk + 1) / numChunks);
+      } catch (...) {
+        boost::mutex::scoped_lock lock(mutex);
+        if (!error) error = boost::current_exception();
+      }
+      if (++done == numChunks) {
+        boost::mutex::scoped_lock lock(mutex);
+        finished.notify_all();
+      }
+    }
+  }
+
+  size_t const size;
+  size_t const numChunks;
+  boost::function<void (size_t, size_t)> const& body;
+  boost::atomic<size_t> next;
+  boost::atomic<size_t> done;
+  boost::mutex mutex;
+  boost::condition_variable finished;
+  boost::exception_ptr error;
+};
+
+class ParallelForTask : public Task
+{
+public:
+  ParallelForTask(boost::shared_ptr<ParallelForState> const& state)
+    : m_state(state) {}
+
+  virtual void Run() {
+    m_state->Work();
+  }
+
+private:
+  boost::shared_ptr<ParallelForState> m_state;
+};
+}
+
+void ParallelFor(ThreadPool &pool, size_t size, size_t numChunks,
+                 boost::function<void (size_t, size_t)> const& body)
+{
+  numChunks = std::min(numChunks, size);
+  if (numChunks <= 1) {
+    if (size) body(0, size);
+    return;
+  }
+
+  boost::shared_ptr<ParallelForState> state(new ParallelForState(size, numChunks, body));
+  // one helper fewer than ranges: the calling thread works as well
+  for (size_t i = 1; i < numChunks; ++i) {
+    pool.Submit(boost::shared_ptr<Task>(new ParallelForTask(state)));
+  }
+  state->Work();
+
+  // whatever is left is already running elsewhere; helpers that start
+  // after this returns find no ranges and don't touch body
+  {
+    boost::mutex::scoped_lock lock(state->mutex);
+    while (state->done < numChunks) {
+      state->finished.wait(lock);
+    }
+  }
+  if (state->error) boost::rethrow_exception(state->error);
+}
+
 }
 #endif //WITH_THREADS
 
@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_ThreadPool_h
 #define moses_ThreadPool_h
 
+#include <deque>
 #include <iostream>
 #include <queue>
 #include <vector>
@@ -29,8 +30,11 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <boost/shared_ptr.hpp>
 
 #ifdef WITH_THREADS
+#include <boost/atomic.hpp>
 #include <boost/bind.hpp>
+#include <boost/function.hpp>
 #include <boost/thread.hpp>
+#include <boost/thread/tss.hpp>
 #endif
 
 #ifdef BOOST_HAS_PTHREADS
@@ -63,8 +67,10 @@ class ThreadPool
 public:
   /**
    * Construct a thread pool of a fixed size.
+   * If workStealing is set, each thread gets its own task deque and idle
+   * threads steal from the others, instead of all threads sharing one queue.
    **/
-  explicit ThreadPool(size_t numThreads);
+  explicit ThreadPool(size_t numThreads, bool workStealing = false);
 
   ~ThreadPool() {
     Stop();
@@ -72,9 +78,20 @@ public:
 
   /**
    * Add a job to the threadpool.
+   * In work-stealing mode, a job submitted from one of the pool's own
+   * threads (a subtask) goes to the front of that thread's deque, never
+   * blocks on the queue limit and is still accepted while Stop(true) drains
+   * the pool.
    **/
   void Submit(boost::shared_ptr<Task> task);
 
+  /**
+   * Run one queued job in the calling thread, if there is one. Returns false
+   * if no job was available. A task waiting for its own subtasks should call
+   * this in a loop rather than block, so that it cannot starve the pool.
+   **/
+  bool RunPendingTask();
+
   /**
    * Wait until all queued jobs have completed, and shut down
    * the ThreadPool.
@@ -88,22 +105,63 @@ public:
     m_queueLimit = limit;
   }
 
+  bool IsWorkStealing() const {
+    return !m_workerQueues.empty();
+  }
+
 private:
+  /** Per-thread task deque for the work-stealing mode. */
+  struct WorkerQueue {
+    boost::mutex mutex;
+    std::deque<boost::shared_ptr<Task> > tasks;
+  };
+
   /**
    * The main loop executed by each thread.
    **/
   void Execute();
 
+  /**
+   * The main loop executed by each thread in work-stealing mode.
+   **/
+  void ExecuteStealing(size_t index);
+
+  /**
+   * Take a job from the given thread's deque, or steal one from another
+   * thread's deque. Returns an empty pointer if there is none.
+   **/
+  boost::shared_ptr<Task> PopTask(size_t index);
+
+  void RunTask(boost::shared_ptr<Task> task);
+
   std::queue<boost::shared_ptr<Task> > m_tasks;
   boost::thread_group m_threads;
   boost::mutex m_mutex;
   boost::condition_variable m_threadNeeded;
   boost::condition_variable m_threadAvailable;
-  bool m_stopped;
-  bool m_stopping;
+  boost::atomic<bool> m_stopped;
+  boost::atomic<bool> m_stopping;
   size_t m_queueLimit;
+
+  // work-stealing mode only
+  std::vector<boost::shared_ptr<WorkerQueue> > m_workerQueues;
+  boost::thread_specific_ptr<size_t> m_workerIndex;
+  boost::atomic<size_t> m_pending; // queued, not yet started
+  boost::atomic<size_t> m_active; // currently running
+  boost::atomic<size_t> m_idle; // threads waiting for work
+  boost::atomic<size_t> m_nextQueue;
 };
 
+/**
+ * Split [0, size) into numChunks ranges and call body(begin, end) for each,
+ * on the pool's threads and on the calling thread. Returns when all ranges
+ * are done; an exception thrown by body is rethrown here. The caller takes
+ * ranges too, so this never waits on a busy pool, and it is safe to call
+ * from a task running in the same pool.
+ **/
+void ParallelFor(ThreadPool &pool, size_t size, size_t numChunks,
+                 boost::function<void (size_t, size_t)> const& body);
+
 class TestTask : public Task
 {
 public:
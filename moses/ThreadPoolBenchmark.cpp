@@ -0,0 +1,146 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2009 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+/**
+ * Throughput benchmark comparing the single-queue ThreadPool with the
+ * work-stealing one.  Jobs have skewed costs (every 50th job is 100 times
+ * longer, like an outlier sentence) and optionally split into subtasks.
+ *
+ * usage: thread_pool_benchmark [threads] [jobs] [subtasks per job]
+ */
+
+#include <cstdlib>
+#include <iostream>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "ThreadPool.h"
+
+#ifdef WITH_THREADS
+
+using namespace Moses;
+
+namespace
+{
+
+// keep the optimiser from dropping the work
+boost::atomic<unsigned long> g_sink(0);
+
+void Spin(size_t iterations)
+{
+  unsigned long x = iterations;
+  for (size_t i = 0; i < iterations; ++i) {
+    x = x * 6364136223846793005UL + 1442695040888963407UL;
+  }
+  g_sink += x;
+}
+
+class SubTask : public Task
+{
+public:
+  SubTask(size_t cost, boost::atomic<size_t> &remaining)
+    : m_cost(cost), m_remaining(remaining) {}
+
+  void Run() {
+    Spin(m_cost);
+    --m_remaining;
+  }
+
+private:
+  size_t m_cost;
+  boost::atomic<size_t> &m_remaining;
+};
+
+class BenchmarkTask : public Task
+{
+public:
+  BenchmarkTask(ThreadPool &pool, size_t cost, size_t subtasks, boost::atomic<size_t> &unfinished)
+    : m_pool(pool), m_cost(cost), m_subtasks(subtasks), m_unfinished(unfinished) {}
+
+  void Run() {
+    if (m_subtasks == 0) {
+      Spin(m_cost);
+    } else {
+      boost::atomic<size_t> remaining(m_subtasks);
+      for (size_t i = 0; i < m_subtasks; ++i) {
+        m_pool.Submit(boost::shared_ptr<Task>(new SubTask(m_cost / m_subtasks, remaining)));
+      }
+      while (remaining > 0) {
+        if (!m_pool.RunPendingTask()) boost::this_thread::yield();
+      }
+    }
+    --m_unfinished;
+  }
+
+private:
+  ThreadPool &m_pool;
+  size_t m_cost;
+  size_t m_subtasks;
+  boost::atomic<size_t> &m_unfinished;
+};
+
+double Time(size_t threads, size_t jobs, size_t subtasks, bool workStealing)
+{
+  boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+  ThreadPool pool(threads, workStealing);
+  boost::atomic<size_t> unfinished(jobs);
+  for (size_t i = 0; i < jobs; ++i) {
+    size_t cost = (i % 50 == 49) ? 2000000 : 20000;
+    pool.Submit(boost::shared_ptr<Task>(new BenchmarkTask(pool, cost, subtasks, unfinished)));
+  }
+  // the single-queue pool does not accept subtasks once it is stopping, so
+  // wait for every job before shutting either pool down
+  while (unfinished > 0) {
+    boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+  }
+  pool.Stop(true);
+  boost::posix_time::ptime end = boost::posix_time::microsec_clock::universal_time();
+  return (end - start).total_microseconds() / 1000000.0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  size_t threads = argc > 1 ? std::atoi(argv[1]) : boost::thread::hardware_concurrency();
+  size_t jobs = argc > 2 ? std::atoi(argv[2]) : 20000;
+  size_t subtasks = argc > 3 ? std::atoi(argv[3]) : 0;
+  if (threads == 0) threads = 1;
+
+  for (int workStealing = 0; workStealing < 2; ++workStealing) {
+    double seconds = Time(threads, jobs, subtasks, workStealing);
+    std::cout << (workStealing ? "work-stealing" : "single-queue ")
+              << " threads=" << threads
+              << " jobs=" << jobs
+              << " subtasks=" << subtasks
+              << " seconds=" << seconds
+              << " jobs/s=" << jobs / seconds << std::endl;
+  }
+  return 0;
+}
+
+#else
+
+int main()
+{
+  std::cerr << "thread_pool_benchmark requires a multi-threaded build" << std::endl;
+  return 1;
+}
+
+#endif // WITH_THREADS
@@ -0,0 +1,102 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2009 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "ThreadPool.h"
+
+#ifdef WITH_THREADS
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+void Increment(vector<int> &counts, size_t begin, size_t end)
+{
+  for (size_t i = begin; i < end; ++i) ++counts[i];
+}
+
+void Throw(size_t begin, size_t /*end*/)
+{
+  if (begin == 0) throw runtime_error("range failed");
+}
+
+// a task that splits its own work on the pool it runs in
+class NestedTask : public Task
+{
+public:
+  NestedTask(ThreadPool &pool, vector<int> &counts)
+    : m_pool(pool), m_counts(counts) {}
+
+  virtual void Run() {
+    ParallelFor(m_pool, m_counts.size(), 8,
+                boost::bind(&Increment, boost::ref(m_counts), _1, _2));
+  }
+
+private:
+  ThreadPool &m_pool;
+  vector<int> &m_counts;
+};
+}
+
+BOOST_AUTO_TEST_SUITE(thread_pool)
+
+BOOST_AUTO_TEST_CASE(parallel_for)
+{
+  ThreadPool pool(3);
+  vector<int> counts(1000, 0);
+  ParallelFor(pool, counts.size(), 7,
+              boost::bind(&Increment, boost::ref(counts), _1, _2));
+  BOOST_CHECK_EQUAL(count(counts.begin(), counts.end(), 1), 1000);
+
+  // fewer elements than ranges
+  vector<int> few(3, 0);
+  ParallelFor(pool, few.size(), 16,
+              boost::bind(&Increment, boost::ref(few), _1, _2));
+  BOOST_CHECK_EQUAL(count(few.begin(), few.end(), 1), 3);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_for_exception)
+{
+  ThreadPool pool(2);
+  BOOST_CHECK_THROW(ParallelFor(pool, 100, 4, &Throw), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_for_in_pool)
+{
+  // every thread of the pool waits in ParallelFor, the ranges still get done
+  ThreadPool pool(2, true);
+  vector<vector<int> > counts(4, vector<int>(100, 0));
+  for (size_t i = 0; i < counts.size(); ++i) {
+    pool.Submit(boost::shared_ptr<Task>(new NestedTask(pool, counts[i])));
+  }
+  pool.Stop(true);
+  for (size_t i = 0; i < counts.size(); ++i) {
+    BOOST_CHECK_EQUAL(count(counts[i].begin(), counts[i].end(), 1), 100);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif // WITH_THREADS
@@ -50,12 +50,24 @@ PhraseDictionaryCompact::PhraseDictionaryCompact(const std::string &line)
   :PhraseDictionary(line, true)
   ,m_inMemory(s_inMemoryByDefault)
   ,m_useAlignmentInfo(true)
+  ,m_decodingCacheBytes(64 * 1024 * 1024)
   ,m_hash(10, 16)
   ,m_phraseDecoder(0)
 {
   ReadParameters();
 }
 
+void
+PhraseDictionaryCompact::
+SetParameter(const std::string& key, const std::string& value)
+{
+  if (key == "decoding-cache-bytes") {
+    m_decodingCacheBytes = Scan<size_t>(value);
+  } else {
+    PhraseDictionary::SetParameter(key, value);
+  }
+}
+
 void PhraseDictionaryCompact::Load(AllOptions::ptr const& opts)
 {
   m_options = opts;
@@ -72,6 +84,7 @@ void PhraseDictionaryCompact::Load(AllOptions::ptr const& opts)
 
   m_phraseDecoder
   = new PhraseDecoder(*this, &m_input, &m_output, m_numScoreComponents);
+  m_phraseDecoder->m_decodingCache.SetMaxBytes(m_decodingCacheBytes);
 
   std::FILE* pFile = std::fopen(tFilePath.c_str() , "r");
 
@@ -180,6 +193,17 @@ CleanUpAfterSentenceProcessing(const InputType &source)
   m_phraseDecoder->PruneCache();
   m_sentenceCache->clear();
 
+  IFVERBOSE(2) {
+    TargetPhraseCollectionCache::Stats stats
+    = m_phraseDecoder->m_decodingCache.GetStats();
+    TRACE_ERR(GetScoreProducerDescription() << " decoding cache: "
+              << stats.hits << " hits, " << stats.misses << " misses, "
+              << stats.evictions << " evictions, " << stats.entries
+              << " entries, " << stats.bytes << " of "
+              << m_phraseDecoder->m_decodingCache.GetMaxBytes()
+              << " bytes" << std::endl);
+  }
+
   ReduceCache();
 }
 
@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #define moses_PhraseDictionaryCompact_h
 
 #include <boost/unordered_map.hpp>
+#include <boost/thread/tss.hpp>
 
 #ifdef WITH_THREADS
 #ifdef BOOST_HAS_PTHREADS
@@ -51,6 +52,7 @@ protected:
   static bool s_inMemoryByDefault;
   bool m_inMemory;
   bool m_useAlignmentInfo;
+  size_t m_decodingCacheBytes;
 
   typedef std::vector<TargetPhraseCollection::shared_ptr > PhraseCache;
   typedef boost::thread_specific_ptr<PhraseCache> SentenceCache;
@@ -68,6 +70,7 @@ public:
   ~PhraseDictionaryCompact();
 
   void Load(AllOptions::ptr const& opts);
+  void SetParameter(const std::string& key, const std::string& value);
 
   TargetPhraseCollection::shared_ptr  GetTargetPhraseCollectionNonCacheLEGACY(const Phrase &source) const;
   TargetPhraseVectorPtr GetTargetPhraseCollectionRaw(const Phrase &source) const;
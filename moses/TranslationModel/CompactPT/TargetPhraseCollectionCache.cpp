@@ -19,14 +19,166 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <algorithm>
+
 #include "TargetPhraseCollectionCache.h"
 
 namespace Moses
 {
 
+#ifdef WITH_THREADS
+#define SHARD_LOCK(shard) boost::mutex::scoped_lock lock((shard).m_mutex)
+#else
+#define SHARD_LOCK(shard)
+#endif
+
+TargetPhraseCollectionCache::TargetPhraseCollectionCache(size_t maxBytes,
+    size_t numShards)
+  : m_maxBytes(maxBytes)
+{
+  for(size_t i = 0; i < std::max(numShards, size_t(1)); ++i)
+    m_shards.push_back(boost::shared_ptr<Shard>(new Shard()));
+}
+
+void TargetPhraseCollectionCache::Cache(const Phrase &sourcePhrase,
+                                        TargetPhraseVectorPtr tpv,
+                                        size_t bitsLeft, size_t maxRank)
+{
+  if(maxRank && tpv->size() > maxRank) {
+    TargetPhraseVectorPtr tpv_temp(new TargetPhraseVector(tpv->begin(),
+                                   tpv->begin() + maxRank));
+    tpv = tpv_temp;
+  }
+  size_t bytes = EstimateBytes(sourcePhrase, *tpv);
+  size_t shardBudget = m_maxBytes / m_shards.size();
+
+  Shard &shard = GetShard(sourcePhrase);
+  SHARD_LOCK(shard);
+
+  // check if source phrase is already in cache
+  CacheMap::iterator it = shard.m_map.find(sourcePhrase);
+  if(it != shard.m_map.end()) {
+    // if found, just mark as used
+    shard.m_clock[it->second.m_slot].m_referenced = true;
+    return;
+  }
 
-boost::thread_specific_ptr<TargetPhraseCollectionCache::CacheMap>
-TargetPhraseCollectionCache::m_phraseCache;
+  // too big to ever fit
+  if(bytes > shardBudget)
+    return;
 
+  while(!shard.m_map.empty() && shard.m_bytes + bytes > shardBudget)
+    EvictOne(shard);
+
+  std::pair<CacheMap::iterator, bool> inserted
+  = shard.m_map.insert(std::make_pair(sourcePhrase, Entry()));
+  Entry &entry = inserted.first->second;
+  entry.m_tpv = tpv;
+  entry.m_bitsLeft = bitsLeft;
+  entry.m_bytes = bytes;
+
+  if(shard.m_freeSlots.empty()) {
+    entry.m_slot = shard.m_clock.size();
+    shard.m_clock.push_back(Slot());
+  } else {
+    entry.m_slot = shard.m_freeSlots.back();
+    shard.m_freeSlots.pop_back();
+  }
+  // elements of a boost::unordered_map do not move, so the key can be kept
+  shard.m_clock[entry.m_slot].m_key = &inserted.first->first;
+  shard.m_clock[entry.m_slot].m_referenced = false;
+  shard.m_bytes += bytes;
 }
 
+std::pair<TargetPhraseVectorPtr, size_t>
+TargetPhraseCollectionCache::Retrieve(const Phrase &sourcePhrase)
+{
+  Shard &shard = GetShard(sourcePhrase);
+  SHARD_LOCK(shard);
+  CacheMap::iterator it = shard.m_map.find(sourcePhrase);
+  if(it != shard.m_map.end()) {
+    ++shard.m_hits;
+    Entry &entry = it->second;
+    shard.m_clock[entry.m_slot].m_referenced = true;
+    return std::make_pair(entry.m_tpv, entry.m_bitsLeft);
+  } else {
+    ++shard.m_misses;
+    return std::make_pair(TargetPhraseVectorPtr(), 0);
+  }
+}
+
+void TargetPhraseCollectionCache::EvictOne(Shard &shard)
+{
+  // second chance: skip and clear referenced slots until an unreferenced
+  // one comes round. Terminates within two turns of the clock.
+  while(true) {
+    if(shard.m_hand >= shard.m_clock.size())
+      shard.m_hand = 0;
+    Slot &slot = shard.m_clock[shard.m_hand++];
+    if(!slot.m_key)
+      continue;
+    if(slot.m_referenced) {
+      slot.m_referenced = false;
+      continue;
+    }
+    CacheMap::iterator it = shard.m_map.find(*slot.m_key);
+    shard.m_bytes -= it->second.m_bytes;
+    shard.m_freeSlots.push_back(it->second.m_slot);
+    shard.m_map.erase(it);
+    slot.m_key = NULL;
+    ++shard.m_evictions;
+    return;
+  }
+}
+
+void TargetPhraseCollectionCache::Prune()
+{
+  size_t shardBudget = m_maxBytes / m_shards.size();
+  for(size_t i = 0; i < m_shards.size(); ++i) {
+    Shard &shard = *m_shards[i];
+    SHARD_LOCK(shard);
+    while(!shard.m_map.empty() && shard.m_bytes > shardBudget)
+      EvictOne(shard);
+  }
+}
+
+void TargetPhraseCollectionCache::CleanUp()
+{
+  for(size_t i = 0; i < m_shards.size(); ++i) {
+    Shard &shard = *m_shards[i];
+    SHARD_LOCK(shard);
+    shard.m_map.clear();
+    shard.m_clock.clear();
+    shard.m_freeSlots.clear();
+    shard.m_hand = 0;
+    shard.m_bytes = 0;
+  }
+}
+
+TargetPhraseCollectionCache::Stats
+TargetPhraseCollectionCache::GetStats() const
+{
+  Stats stats;
+  for(size_t i = 0; i < m_shards.size(); ++i) {
+    Shard &shard = *m_shards[i];
+    SHARD_LOCK(shard);
+    stats.hits += shard.m_hits;
+    stats.misses += shard.m_misses;
+    stats.evictions += shard.m_evictions;
+    stats.entries += shard.m_map.size();
+    stats.bytes += shard.m_bytes;
+  }
+  return stats;
+}
+
+size_t TargetPhraseCollectionCache::EstimateBytes(const Phrase &sourcePhrase,
+    const TargetPhraseVector &tpv)
+{
+  size_t bytes = sizeof(Entry) + sizeof(Slot) + sizeof(TargetPhraseVector)
+                 + sizeof(Phrase) + sourcePhrase.GetSize() * sizeof(Word);
+  for(TargetPhraseVector::const_iterator it = tpv.begin(); it != tpv.end(); ++it)
+    bytes += sizeof(TargetPhrase) + it->GetSize() * sizeof(Word);
+  return bytes;
+}
+
+}
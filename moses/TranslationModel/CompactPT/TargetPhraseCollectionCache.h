@@ -22,12 +22,14 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_TargetPhraseCollectionCache_h
 #define moses_TargetPhraseCollectionCache_h
 
-#include <map>
-#include <set>
 #include <vector>
 
-#include <boost/thread/tss.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
 
 #include "moses/Phrase.h"
 #include "moses/TargetPhraseCollection.h"
@@ -39,123 +41,89 @@ namespace Moses
 typedef std::vector<TargetPhrase> TargetPhraseVector;
 typedef boost::shared_ptr<TargetPhraseVector> TargetPhraseVectorPtr;
 
-/** Implementation of Persistent Cache **/
+/** Cache of decoded target phrase collections, shared by all threads.
+ *  Entries are spread over independently locked shards, and each shard
+ *  evicts with the CLOCK algorithm once its share of the byte budget is
+ *  used up. Cached vectors are never modified, only copied by readers.
+ **/
 class TargetPhraseCollectionCache
 {
-private:
-  size_t m_max;
-  float m_tolerance;
-
-  struct LastUsed {
-    clock_t m_clock;
-    TargetPhraseVectorPtr m_tpv;
-    size_t m_bitsLeft;
+public:
+  struct Stats {
+    size_t hits, misses, evictions, entries, bytes;
+    Stats() : hits(0), misses(0), evictions(0), entries(0), bytes(0) {}
+  };
 
-    LastUsed() : m_clock(0), m_bitsLeft(0) {}
+  TargetPhraseCollectionCache(size_t maxBytes = 64 * 1024 * 1024,
+                              size_t numShards = 64);
 
-    LastUsed(clock_t clock, TargetPhraseVectorPtr tpv, size_t bitsLeft = 0)
-      : m_clock(clock), m_tpv(tpv), m_bitsLeft(bitsLeft) {}
-  };
+  /** add translations for source phrase to the cache **/
+  void Cache(const Phrase &sourcePhrase, TargetPhraseVectorPtr tpv,
+             size_t bitsLeft = 0, size_t maxRank = 0);
 
-  typedef std::map<Phrase, LastUsed> CacheMap;
-  static boost::thread_specific_ptr<CacheMap> m_phraseCache;
+  /** retrieve translations for source phrase from the cache **/
+  std::pair<TargetPhraseVectorPtr, size_t> Retrieve(const Phrase &sourcePhrase);
 
-public:
+  /** evict entries until every shard is within budget **/
+  void Prune();
 
-  typedef CacheMap::iterator iterator;
-  typedef CacheMap::const_iterator const_iterator;
+  void CleanUp();
 
-  TargetPhraseCollectionCache(size_t max = 5000, float tolerance = 0.2)
-    : m_max(max), m_tolerance(tolerance) {
+  void SetMaxBytes(size_t maxBytes) {
+    m_maxBytes = maxBytes;
   }
-
-  iterator Begin() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->begin();
+  size_t GetMaxBytes() const {
+    return m_maxBytes;
   }
 
-  const_iterator Begin() const {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->begin();
-  }
+  Stats GetStats() const;
 
-  iterator End() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->end();
-  }
+private:
+  struct Entry {
+    TargetPhraseVectorPtr m_tpv;
+    size_t m_bitsLeft;
+    size_t m_bytes;
+    size_t m_slot; // position on the clock
 
-  const_iterator End() const {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    return m_phraseCache->end();
-  }
+    Entry() : m_bitsLeft(0), m_bytes(0), m_slot(0) {}
+  };
 
-  /** retrieve translations for source phrase from persistent cache **/
-  void Cache(const Phrase &sourcePhrase, TargetPhraseVectorPtr tpv,
-             size_t bitsLeft = 0, size_t maxRank = 0) {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    // check if source phrase is already in cache
-    iterator it = m_phraseCache->find(sourcePhrase);
-    if(it != m_phraseCache->end())
-      // if found, just update clock
-      it->second.m_clock = clock();
-    else {
-      // else, add to cache
-      if(maxRank && tpv->size() > maxRank) {
-        TargetPhraseVectorPtr tpv_temp(new TargetPhraseVector());
-        tpv_temp->resize(maxRank);
-        std::copy(tpv->begin(), tpv->begin() + maxRank, tpv_temp->begin());
-        (*m_phraseCache)[sourcePhrase] = LastUsed(clock(), tpv_temp, bitsLeft);
-      } else
-        (*m_phraseCache)[sourcePhrase] = LastUsed(clock(), tpv, bitsLeft);
-    }
-  }
+  typedef boost::unordered_map<Phrase, Entry> CacheMap;
 
-  std::pair<TargetPhraseVectorPtr, size_t> Retrieve(const Phrase &sourcePhrase) {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    iterator it = m_phraseCache->find(sourcePhrase);
-    if(it != m_phraseCache->end()) {
-      LastUsed &lu = it->second;
-      lu.m_clock = clock();
-      return std::make_pair(lu.m_tpv, lu.m_bitsLeft);
-    } else
-      return std::make_pair(TargetPhraseVectorPtr(), 0);
-  }
+  struct Slot {
+    const Phrase *m_key; // NULL if free
+    bool m_referenced;
 
-  // if cache full, reduce
-  void Prune() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    if(m_phraseCache->size() > m_max * (1 + m_tolerance)) {
-      typedef std::set<std::pair<clock_t, Phrase> > Cands;
-      Cands cands;
-      for(CacheMap::iterator it = m_phraseCache->begin();
-          it != m_phraseCache->end(); it++) {
-        LastUsed &lu = it->second;
-        cands.insert(std::make_pair(lu.m_clock, it->first));
-      }
-
-      for(Cands::iterator it = cands.begin(); it != cands.end(); it++) {
-        const Phrase& p = it->second;
-        m_phraseCache->erase(p);
-
-        if(m_phraseCache->size() < (m_max * (1 - m_tolerance)))
-          break;
-      }
-    }
-  }
+    Slot() : m_key(NULL), m_referenced(false) {}
+  };
 
-  void CleanUp() {
-    if(!m_phraseCache.get())
-      m_phraseCache.reset(new CacheMap());
-    m_phraseCache->clear();
+  struct Shard {
+#ifdef WITH_THREADS
+    boost::mutex m_mutex;
+#endif
+    CacheMap m_map;
+    std::vector<Slot> m_clock;
+    std::vector<size_t> m_freeSlots;
+    size_t m_hand;
+    size_t m_bytes;
+    size_t m_hits, m_misses, m_evictions;
+
+    Shard() : m_hand(0), m_bytes(0), m_hits(0), m_misses(0), m_evictions(0) {}
+  };
+
+  size_t m_maxBytes;
+  std::vector<boost::shared_ptr<Shard> > m_shards;
+
+  Shard &GetShard(const Phrase &sourcePhrase) {
+    return *m_shards[hash_value(sourcePhrase) % m_shards.size()];
   }
 
+  //! evict one entry from the shard, which must not be empty
+  void EvictOne(Shard &shard);
+
+  //! rough memory footprint of a cache entry
+  static size_t EstimateBytes(const Phrase &sourcePhrase,
+                              const TargetPhraseVector &tpv);
 };
 
 }
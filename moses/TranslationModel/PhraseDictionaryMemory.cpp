@@ -84,7 +84,22 @@ PhraseDictionaryNodeMemory &PhraseDictionaryMemory::GetOrCreateNode(const Phrase
     , const TargetPhrase &target
     , const Word *sourceLHS)
 {
-  const size_t size = source.GetSize();
+  return GetOrCreateNode(source, target, source.GetSize());
+}
+
+// The children of the root are all created before rules are inserted
+// concurrently, so that the threads only ever write below distinct children.
+const void *PhraseDictionaryMemory::GetOrCreateShard(const Phrase &source
+    , const TargetPhrase &target)
+{
+  return &GetOrCreateNode(source, target, std::min<size_t>(source.GetSize(), 1));
+}
+
+PhraseDictionaryNodeMemory &PhraseDictionaryMemory::GetOrCreateNode(const Phrase &source
+    , const TargetPhrase &target
+    , size_t depth)
+{
+  const size_t size = depth;
 
   const AlignmentInfo &alignmentInfo = target.GetAlignNonTerm();
   AlignmentInfo::const_iterator iterAlign = alignmentInfo.begin();
@@ -135,7 +150,7 @@ ChartRuleLookupManager *PhraseDictionaryMemory::CreateRuleLookupManager(
 void PhraseDictionaryMemory::SortAndPrune()
 {
   if (GetTableLimit()) {
-    m_collection.Sort(GetTableLimit());
+    m_collection.Sort(GetTableLimit(), m_loadThreads);
   }
 }
 
@@ -73,6 +73,13 @@ protected:
   GetOrCreateNode(const Phrase &source, const TargetPhrase &target,
                   const Word *sourceLHS);
 
+  //! the node for the first depth symbols of source
+  PhraseDictionaryNodeMemory &
+  GetOrCreateNode(const Phrase &source, const TargetPhrase &target,
+                  size_t depth);
+
+  const void *GetOrCreateShard(const Phrase &source, const TargetPhrase &target);
+
   void SortAndPrune();
 
   PhraseDictionaryNodeMemory m_collection;
@@ -17,9 +17,15 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 #include "util/exception.hh"
+#include "util/murmur_hash.hh"
 #include "util/string_stream.hh"
 
 #include "moses/TranslationModel/PhraseDictionaryMultiModel.h"
+#include "moses/InputPath.h"
+
+#include <algorithm>
+
+#include <boost/functional/hash.hpp>
 
 using namespace std;
 
@@ -31,6 +37,9 @@ PhraseDictionaryMultiModel::
 PhraseDictionaryMultiModel(const std::string &line)
   : PhraseDictionary(line, true)
 {
+  // the cache would keep combined phrases after a component changes, so
+  // only cache with an explicit cache-size
+  m_maxCacheSize = 0;
   ReadParameters();
 
   if (m_mode == "interpolate") {
@@ -51,6 +60,7 @@ PhraseDictionaryMultiModel::
 PhraseDictionaryMultiModel(int type, const std::string &line)
   :PhraseDictionary(line, true)
 {
+  m_maxCacheSize = 0;
   if (type == 1) {
     // PhraseDictionaryMultiModelCounts
     UTIL_THROW_IF2(m_pdStr.size() != m_multimodelweights.size() &&
@@ -94,24 +104,90 @@ void PhraseDictionaryMultiModel::Load(AllOptions::ptr const& opts)
   }
 }
 
+namespace
+{
+size_t HashWeights(const std::vector<std::vector<float> > &multimodelweights)
+{
+  size_t seed = 0;
+  for (size_t i = 0; i < multimodelweights.size(); ++i) {
+    boost::hash_range(seed, multimodelweights[i].begin(), multimodelweights[i].end());
+  }
+  return seed;
+}
+}
+
 TargetPhraseCollection::shared_ptr
 PhraseDictionaryMultiModel::
 GetTargetPhraseCollectionLEGACY(const Phrase& src) const
 {
+  std::vector<std::vector<float> > multimodelweights;
+  multimodelweights = getWeights(m_numScoreComponents, true);
 
+  MultiModelStatistics allStats(m_numScoreComponents, m_numModels);
+  return GetTargetPhraseCollection(src, multimodelweights,
+                                   HashWeights(multimodelweights), allStats);
+}
+
+void
+PhraseDictionaryMultiModel::
+GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
+{
   std::vector<std::vector<float> > multimodelweights;
   multimodelweights = getWeights(m_numScoreComponents, true);
-  TargetPhraseCollection::shared_ptr ret;
+  size_t weightsHash = HashWeights(multimodelweights);
 
-  std::map<std::string, multiModelStats*>* allStats;
-  allStats = new(std::map<std::string,multiModelStats*>);
+  MultiModelStatistics allStats(m_numScoreComponents, m_numModels);
+
+  InputPathList::const_iterator iter;
+  for (iter = inputPathQueue.begin(); iter != inputPathQueue.end(); ++iter) {
+    InputPath &inputPath = **iter;
+
+    // backoff
+    if (!SatisfyBackoff(inputPath)) {
+      continue;
+    }
+
+    const Phrase &phrase = inputPath.GetPhrase();
+    TargetPhraseCollection::shared_ptr targetPhrases
+    = GetTargetPhraseCollection(phrase, multimodelweights, weightsHash, allStats);
+    inputPath.SetTargetPhrases(*this, targetPhrases, NULL);
+  }
+}
+
+// Combine the component tables' translations of src, or take them from the
+// cache, which is keyed by the source phrase and the weights.
+TargetPhraseCollection::shared_ptr
+PhraseDictionaryMultiModel::
+GetTargetPhraseCollection(const Phrase& src,
+                          std::vector<std::vector<float> > &multimodelweights,
+                          size_t weightsHash,
+                          MultiModelStatistics &allStats) const
+{
+  size_t hash = 0;
+  if (m_maxCacheSize) {
+    hash = hash_value(src);
+    boost::hash_combine(hash, weightsHash);
+
+    CacheColl &cache = GetCache();
+    CacheColl::iterator iter = cache.find(hash);
+    if (iter != cache.end()) {
+      iter->second.second = clock();
+      return iter->second.first;
+    }
+  }
+
+  allStats.Clear();
   CollectSufficientStatistics(src, allStats);
-  ret = CreateTargetPhraseCollectionLinearInterpolation(src, allStats, multimodelweights);
-  RemoveAllInMap(*allStats);
-  delete allStats; // ??? Why the detour through malloc? UG
+  TargetPhraseCollection::shared_ptr ret
+  = CreateTargetPhraseCollectionLinearInterpolation(src, allStats, multimodelweights);
+  allStats.Clear();
 
   ret->NthElement(m_tableLimit); // sort the phrases for pruning later
-  const_cast<PhraseDictionaryMultiModel*>(this)->CacheForCleanup(ret);
+  if (m_maxCacheSize) {
+    GetCache()[hash] = CacheCollEntry(ret, clock());
+  } else {
+    const_cast<PhraseDictionaryMultiModel*>(this)->CacheForCleanup(ret);
+  }
 
   return ret;
 }
@@ -119,7 +195,7 @@ GetTargetPhraseCollectionLEGACY(const Phrase& src) const
 void
 PhraseDictionaryMultiModel::
 CollectSufficientStatistics
-(const Phrase& src, std::map<std::string, multiModelStats*>* allStats) const
+(const Phrase& src, MultiModelStatistics &allStats) const
 {
   for(size_t i = 0; i < m_numModels; ++i) {
     const PhraseDictionary &pd = *m_pd[i];
@@ -127,6 +203,7 @@ CollectSufficientStatistics
     TargetPhraseCollection::shared_ptr ret_raw;
     ret_raw = pd.GetTargetPhraseCollectionLEGACY(src);
     if (ret_raw != NULL) {
+      allStats.Hold(ret_raw);
 
       TargetPhraseCollection::const_iterator iterTargetPhrase, iterLast;
       if (m_tableLimit != 0 && ret_raw->GetSize() > m_tableLimit) {
@@ -135,39 +212,15 @@ CollectSufficientStatistics
         iterLast = ret_raw->end();
       }
 
+      const size_t offset = pd.GetIndex();
       for (iterTargetPhrase = ret_raw->begin(); iterTargetPhrase != iterLast;  ++iterTargetPhrase) {
         const TargetPhrase * targetPhrase = *iterTargetPhrase;
-        std::vector<float> raw_scores = targetPhrase->GetScoreBreakdown().GetScoresForProducer(&pd);
-
-        std::string targetString = targetPhrase->GetStringRep(m_output);
-        if (allStats->find(targetString) == allStats->end()) {
-
-          multiModelStats * statistics = new multiModelStats;
-          statistics->targetPhrase = new TargetPhrase(*targetPhrase); //make a copy so that we don't overwrite the original phrase table info
-          statistics->p.resize(m_numScoreComponents);
-          for(size_t j = 0; j < m_numScoreComponents; ++j) {
-            statistics->p[j].resize(m_numModels);
-          }
-
-          //correct future cost estimates and total score
-          statistics->targetPhrase->GetScoreBreakdown().InvertDenseFeatures(&pd);
-          vector<FeatureFunction*> pd_feature;
-          pd_feature.push_back(m_pd[i]);
-          const vector<FeatureFunction*> pd_feature_const(pd_feature);
-          statistics->targetPhrase->EvaluateInIsolation(src, pd_feature_const);
-          // zero out scores from original phrase table
-          statistics->targetPhrase->GetScoreBreakdown().ZeroDenseFeatures(&pd);
-
-          (*allStats)[targetString] = statistics;
-
-        }
-        multiModelStats * statistics = (*allStats)[targetString];
+        const FVector &raw_scores = targetPhrase->GetScoreBreakdown().GetScoresVector();
 
+        size_t index = allStats.FindOrInsert(*targetPhrase, i, m_output);
         for(size_t j = 0; j < m_numScoreComponents; ++j) {
-          statistics->p[j][i] = UntransformScore(raw_scores[j]);
+          allStats.GetProbabilities(index, j)[i] = UntransformScore(raw_scores[offset + j]);
         }
-
-        (*allStats)[targetString] = statistics;
       }
     }
   }
@@ -177,34 +230,47 @@ TargetPhraseCollection::shared_ptr
 PhraseDictionaryMultiModel::
 CreateTargetPhraseCollectionLinearInterpolation
 ( const Phrase& src,
-  std::map<std::string,multiModelStats*>* allStats,
+  const MultiModelStatistics &allStats,
   std::vector<std::vector<float> > &multimodelweights) const
 {
+  std::vector<std::vector<FeatureFunction*> > pd_features(m_numModels);
+  for (size_t i = 0; i < m_numModels; ++i) {
+    pd_features[i].push_back(m_pd[i]);
+  }
+  vector<FeatureFunction*> pd_feature;
+  pd_feature.push_back(const_cast<PhraseDictionaryMultiModel*>(this));
+
   TargetPhraseCollection::shared_ptr ret(new TargetPhraseCollection);
-  for ( std::map< std::string, multiModelStats*>::const_iterator iter = allStats->begin(); iter != allStats->end(); ++iter ) {
+  for (size_t index = 0; index < allStats.GetSize(); ++index) {
+    const size_t model = allStats.GetModel(index);
+    const PhraseDictionary &pd = *m_pd[model];
 
-    multiModelStats * statistics = iter->second;
+    //make a copy so that we don't overwrite the original phrase table info
+    TargetPhrase *targetPhrase = new TargetPhrase(allStats.GetTargetPhrase(index));
+
+    //correct future cost estimates and total score
+    targetPhrase->GetScoreBreakdown().InvertDenseFeatures(&pd);
+    targetPhrase->EvaluateInIsolation(src, pd_features[model]);
+    // zero out scores from original phrase table
+    targetPhrase->GetScoreBreakdown().ZeroDenseFeatures(&pd);
 
     Scores scoreVector(m_numScoreComponents);
 
     for(size_t i = 0; i < m_numScoreComponents; ++i) {
-      scoreVector[i] = TransformScore(std::inner_product(statistics->p[i].begin(), statistics->p[i].end(), multimodelweights[i].begin(), 0.0));
+      const float *p = allStats.GetProbabilities(index, i);
+      scoreVector[i] = TransformScore(std::inner_product(p, p + m_numModels, multimodelweights[i].begin(), 0.0));
     }
 
-    statistics->targetPhrase->GetScoreBreakdown().Assign(this, scoreVector);
+    targetPhrase->GetScoreBreakdown().Assign(this, scoreVector);
 
     //correct future cost estimates and total score
-    vector<FeatureFunction*> pd_feature;
-    pd_feature.push_back(const_cast<PhraseDictionaryMultiModel*>(this));
-    const vector<FeatureFunction*> pd_feature_const(pd_feature);
-    statistics->targetPhrase->EvaluateInIsolation(src, pd_feature_const);
+    targetPhrase->EvaluateInIsolation(src, pd_feature);
 
-    ret->Add(new TargetPhrase(*statistics->targetPhrase));
+    ret->Add(targetPhrase);
   }
   return ret;
 }
 
-//TODO: is it worth caching the results as long as weights don't change?
 std::vector<std::vector<float> >
 PhraseDictionaryMultiModel::
 getWeights(size_t numWeights, bool normalize) const
@@ -299,6 +365,7 @@ CleanUpAfterSentenceProcessing(const InputType &source)
   // PhraseCache temp;
   // temp.swap(ref);
   GetPhraseCache().clear();
+  ReduceCache();
 
   CleanUpComponentModels(source);
 
@@ -364,29 +431,31 @@ MinimizePerplexity(vector<pair<string, string> > &phrase_pair_vector)
     string source_string = phrase_pair.first;
     string target_string = phrase_pair.second;
 
-    vector<float> fs(m_numModels);
-    map<string,multiModelStats*>* allStats = new(map<string,multiModelStats*>);
+    MultiModelStatistics allStats(m_numScoreComponents, m_numModels);
 
     Phrase sourcePhrase(0);
     sourcePhrase.CreateFromString(Input, m_input, source_string, NULL);
 
     CollectSufficientStatistics(sourcePhrase, allStats); //optimization potential: only call this once per source phrase
 
+    Phrase targetPhrase(0);
+    targetPhrase.CreateFromString(Output, m_output, target_string, NULL);
+
     //phrase pair not found; leave cache empty
-    if (allStats->find(target_string) == allStats->end()) {
-      RemoveAllInMap(*allStats);
-      delete allStats;
+    size_t index;
+    if (!allStats.Find(targetPhrase, m_output, index)) {
       continue;
     }
 
     multiModelStatsOptimization* targetStatistics = new multiModelStatsOptimization();
-    targetStatistics->targetPhrase = new TargetPhrase(*(*allStats)[target_string]->targetPhrase);
-    targetStatistics->p = (*allStats)[target_string]->p;
+    targetStatistics->targetPhrase = new TargetPhrase(allStats.GetTargetPhrase(index));
+    targetStatistics->p.resize(m_numScoreComponents);
+    for (size_t j = 0; j < m_numScoreComponents; ++j) {
+      const float *p = allStats.GetProbabilities(index, j);
+      targetStatistics->p[j].assign(p, p + m_numModels);
+    }
     targetStatistics->f = iter->second;
     optimizerStats.push_back(targetStatistics);
-
-    RemoveAllInMap(*allStats);
-    delete allStats;
   }
 
   Sentence sentence;
@@ -481,6 +550,108 @@ double CrossEntropy::operator() ( const dlib::matrix<double,0,1>& arg) const
 
 #endif
 
+MultiModelStatistics::
+MultiModelStatistics(size_t numScoreComponents, size_t numModels)
+  : m_numScoreComponents(numScoreComponents)
+  , m_numModels(numModels)
+{
+}
+
+void
+MultiModelStatistics::
+Clear()
+{
+  if (m_entries.empty() && m_collections.empty()) {
+    return;
+  }
+  m_table.Clear();
+  m_entries.clear();
+  m_ids.clear();
+  m_p.clear();
+  m_collections.clear();
+}
+
+// Hash the ids of the output factors, which are left in m_factorIds;
+// factors are unique per string, so equal target phrases get equal ids.
+// 0 is the table's empty key.
+uint64_t
+MultiModelStatistics::
+Hash(const Phrase &target, const std::vector<FactorType> &output) const
+{
+  m_factorIds.clear();
+  for (size_t pos = 0; pos < target.GetSize(); ++pos) {
+    for (size_t i = 0; i < output.size(); ++i) {
+      const Factor *factor = target.GetFactor(pos, output[i]);
+      m_factorIds.push_back(factor ? factor->GetId() : uint64_t(-1));
+    }
+  }
+  uint64_t hash = util::MurmurHashNative(m_factorIds.empty() ? NULL : &m_factorIds[0],
+                                         m_factorIds.size() * sizeof(uint64_t),
+                                         target.GetSize());
+  return hash ? hash : 1;
+}
+
+// Whether entry index has the factor ids left in m_factorIds by Hash().
+bool
+MultiModelStatistics::
+HasFactorIds(size_t index) const
+{
+  const Entry &entry = m_entries[index];
+  return entry.idEnd - entry.idBegin == m_factorIds.size()
+         && std::equal(m_factorIds.begin(), m_factorIds.end(), m_ids.begin() + entry.idBegin);
+}
+
+size_t
+MultiModelStatistics::
+FindOrInsert(const TargetPhrase &targetPhrase, size_t model,
+             const std::vector<FactorType> &output)
+{
+  TableEntry entry;
+  entry.key = Hash(targetPhrase, output);
+  entry.index = m_entries.size();
+
+  // different phrases with the same hash are chained behind the first
+  Table::MutableIterator it;
+  size_t last = NOT_FOUND;
+  if (m_table.FindOrInsert(entry, it)) {
+    for (size_t index = it->index; index != NOT_FOUND; index = m_entries[index].next) {
+      if (HasFactorIds(index)) {
+        return index;
+      }
+      last = index;
+    }
+    m_entries[last].next = entry.index;
+  }
+
+  Entry created;
+  created.targetPhrase = &targetPhrase;
+  created.model = model;
+  created.idBegin = m_ids.size();
+  m_ids.insert(m_ids.end(), m_factorIds.begin(), m_factorIds.end());
+  created.idEnd = m_ids.size();
+  created.next = NOT_FOUND;
+  m_entries.push_back(created);
+  m_p.resize(m_entries.size() * m_numScoreComponents * m_numModels, 0.0f);
+  return entry.index;
+}
+
+bool
+MultiModelStatistics::
+Find(const Phrase &target, const std::vector<FactorType> &output,
+     size_t &index) const
+{
+  Table::ConstIterator it;
+  if (!m_table.Find(Hash(target, output), it)) {
+    return false;
+  }
+  for (index = it->index; index != NOT_FOUND; index = m_entries[index].next) {
+    if (HasFactorIds(index)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 PhraseDictionary *FindPhraseDictionary(const string &ptName)
 {
   const std::vector<PhraseDictionary*> &pts = PhraseDictionary::GetColl();
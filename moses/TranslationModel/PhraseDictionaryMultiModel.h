@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/StaticData.h"
 #include "moses/TargetPhrase.h"
 #include "moses/Util.h"
+#include "util/probing_hash_table.hh"
 
 #ifdef WITH_DLIB
 #include <dlib/optimization.h>
@@ -48,6 +49,90 @@ struct multiModelStatsOptimization: multiModelStats {
   size_t f;
 };
 
+/** Probabilities of the target phrases of one source phrase in each
+ * component model.  Target phrases are merged by the ids of their output
+ * factors, found by their hash in an open-addressing table, and their
+ * probabilities are pooled in one array, numModels per score component.
+ * Clear() keeps the memory for the next source phrase.
+ */
+class MultiModelStatistics
+{
+public:
+  MultiModelStatistics(size_t numScoreComponents, size_t numModels);
+
+  void Clear();
+
+  //! keep a component collection alive while its target phrases are used
+  void Hold(TargetPhraseCollection::shared_ptr coll) {
+    m_collections.push_back(coll);
+  }
+
+  //! index of the entry for targetPhrase, created from model if it is new
+  size_t FindOrInsert(const TargetPhrase &targetPhrase, size_t model,
+                      const std::vector<FactorType> &output);
+
+  //! index of the entry for target, false if there is none
+  bool Find(const Phrase &target, const std::vector<FactorType> &output,
+            size_t &index) const;
+
+  size_t GetSize() const {
+    return m_entries.size();
+  }
+
+  //! the target phrase that created entry index
+  const TargetPhrase &GetTargetPhrase(size_t index) const {
+    return *m_entries[index].targetPhrase;
+  }
+
+  //! the component model of that target phrase
+  size_t GetModel(size_t index) const {
+    return m_entries[index].model;
+  }
+
+  //! probabilities of entry index for one score component, one per model
+  float *GetProbabilities(size_t index, size_t scoreComponent) {
+    return &m_p[(index * m_numScoreComponents + scoreComponent) * m_numModels];
+  }
+  const float *GetProbabilities(size_t index, size_t scoreComponent) const {
+    return &m_p[(index * m_numScoreComponents + scoreComponent) * m_numModels];
+  }
+
+private:
+  struct TableEntry {
+    typedef uint64_t Key;
+    uint64_t key;
+    size_t index;
+    uint64_t GetKey() const {
+      return key;
+    }
+    void SetKey(uint64_t to) {
+      key = to;
+    }
+  };
+  typedef util::AutoProbing<TableEntry, util::IdentityHash> Table;
+
+  struct Entry {
+    const TargetPhrase *targetPhrase;
+    size_t model;
+    // output factor ids of targetPhrase are m_ids[idBegin, idEnd)
+    size_t idBegin, idEnd;
+    // next entry with the same hash, NOT_FOUND if none
+    size_t next;
+  };
+
+  uint64_t Hash(const Phrase &target, const std::vector<FactorType> &output) const;
+  bool HasFactorIds(size_t index) const;
+
+  size_t m_numScoreComponents;
+  size_t m_numModels;
+  Table m_table;
+  std::vector<Entry> m_entries;
+  std::vector<uint64_t> m_ids;
+  std::vector<float> m_p;
+  std::vector<TargetPhraseCollection::shared_ptr> m_collections;
+  mutable std::vector<uint64_t> m_factorIds;
+};
+
 class OptimizationObjective;
 
 struct multiModelPhrase {
@@ -74,12 +159,12 @@ public:
 
   virtual void
   CollectSufficientStatistics
-  (const Phrase& src, std::map<std::string,multiModelStats*>* allStats)
+  (const Phrase& src, MultiModelStatistics &allStats)
   const;
 
   virtual TargetPhraseCollection::shared_ptr
   CreateTargetPhraseCollectionLinearInterpolation
-  (const Phrase& src, std::map<std::string,multiModelStats*>* allStats,
+  (const Phrase& src, const MultiModelStatistics &allStats,
    std::vector<std::vector<float> > &multimodelweights) const;
 
   std::vector<std::vector<float> >
@@ -106,6 +191,10 @@ public:
   virtual TargetPhraseCollection::shared_ptr
   GetTargetPhraseCollectionLEGACY(const Phrase& src) const;
 
+  // the weights are only computed once for all phrases of a sentence
+  virtual void
+  GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const;
+
   virtual void
   InitializeForInput(ttasksptr const& ttask) {
     // Don't do anything source specific here as this object is shared
@@ -126,6 +215,12 @@ public:
   SetTemporaryMultiModelWeightsVector(std::vector<float> weights);
 
 protected:
+  TargetPhraseCollection::shared_ptr
+  GetTargetPhraseCollection(const Phrase& src,
+                            std::vector<std::vector<float> > &multimodelweights,
+                            size_t weightsHash,
+                            MultiModelStatistics &allStats) const;
+
   std::string m_mode;
   std::vector<std::string> m_pdStr;
   std::vector<PhraseDictionary*> m_pd;
@@ -92,6 +92,10 @@ public:
   void FillLexicalCountsMarginal(Word &wordS, std::vector<float> &count, const std::vector<lexicalTable*> &tables) const;
   void LoadLexicalTable( std::string &fileName, lexicalTable* ltable);
   TargetPhraseCollection::shared_ptr  GetTargetPhraseCollectionLEGACY(const Phrase& src) const;
+  // phrase by phrase, through the method above
+  void GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const {
+    PhraseDictionary::GetTargetPhraseCollectionBatch(inputPathQueue);
+  }
 #ifdef WITH_DLIB
   std::vector<float> MinimizePerplexity(std::vector<std::pair<std::string, std::string> > &phrase_pair_vector);
 #endif
@@ -23,11 +23,29 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/TargetPhrase.h"
 #include "moses/TranslationModel/PhraseDictionary.h"
 
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include "moses/ThreadPool.h"
+#endif
+
 using namespace std;
 
 namespace Moses
 {
 
+#ifdef WITH_THREADS
+namespace
+{
+void SortNodes(const std::vector<PhraseDictionaryNodeMemory*> &nodes,
+               size_t tableLimit, size_t begin, size_t end)
+{
+  for (size_t i = begin; i < end; ++i) {
+    nodes[i]->Sort(tableLimit);
+  }
+}
+}
+#endif
+
 void PhraseDictionaryNodeMemory::Prune(size_t tableLimit)
 {
   // recusively prune
@@ -56,6 +74,31 @@ void PhraseDictionaryNodeMemory::Sort(size_t tableLimit)
   m_targetPhraseCollection->Sort(true, tableLimit);
 }
 
+void PhraseDictionaryNodeMemory::Sort(size_t tableLimit, size_t numThreads)
+{
+#ifdef WITH_THREADS
+  if (numThreads > 1) {
+    std::vector<PhraseDictionaryNodeMemory*> children;
+    children.reserve(m_sourceTermMap.size() + m_nonTermMap.size());
+    for (TerminalMap::iterator p = m_sourceTermMap.begin(); p != m_sourceTermMap.end(); ++p) {
+      children.push_back(&p->second);
+    }
+    for (NonTerminalMap::iterator p = m_nonTermMap.begin(); p != m_nonTermMap.end(); ++p) {
+      children.push_back(&p->second);
+    }
+
+    // the subtries are disjoint; many small chunks even out their sizes
+    ThreadPool pool(numThreads - 1);
+    ParallelFor(pool, children.size(), numThreads * 16,
+                boost::bind(&SortNodes, boost::cref(children), tableLimit, _1, _2));
+
+    m_targetPhraseCollection->Sort(true, tableLimit);
+    return;
+  }
+#endif
+  Sort(tableLimit);
+}
+
 PhraseDictionaryNodeMemory*
 PhraseDictionaryNodeMemory::GetOrCreateChild(const Word &sourceTerm)
 {
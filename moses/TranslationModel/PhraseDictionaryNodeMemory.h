@@ -143,6 +143,8 @@ public:
 
   void Prune(size_t tableLimit);
   void Sort(size_t tableLimit);
+  //! Sort() with the subtries of the children spread over numThreads threads
+  void Sort(size_t tableLimit, size_t numThreads);
   PhraseDictionaryNodeMemory *GetOrCreateChild(const Word &sourceTerm);
   const PhraseDictionaryNodeMemory *GetChild(const Word &sourceTerm) const;
 #if defined(UNLABELLED_SOURCE)
@@ -123,6 +123,14 @@ void ProbingPT::InitializeForInput(ttasksptr const& ttask)
 
 void ProbingPT::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
 {
+  // Look up all source phrases of the sentence together, one step at a time,
+  // so that the cache misses on the hash table and then on the target phrases
+  // of every phrase are in flight at once instead of one after another.
+  std::vector<InputPath*> paths;
+  std::vector<uint64_t> keys;
+  paths.reserve(inputPathQueue.size());
+  keys.reserve(inputPathQueue.size());
+
   InputPathList::const_iterator iter;
   for (iter = inputPathQueue.begin(); iter != inputPathQueue.end(); ++iter) {
     InputPath &inputPath = **iter;
@@ -132,33 +140,46 @@ void ProbingPT::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQue
       continue;
     }
 
-    TargetPhraseCollection::shared_ptr tpColl = CreateTargetPhrase(sourcePhrase);
-    inputPath.SetTargetPhrases(*this, tpColl, NULL);
-  }
-}
+    std::pair<bool, uint64_t> keyStruct = GetKey(sourcePhrase);
+    if (!keyStruct.first) {
+      // source phrase contains a word unknown in the pt
+      inputPath.SetTargetPhrases(*this, TargetPhraseCollection::shared_ptr(), NULL);
+      continue;
+    }
 
-TargetPhraseCollection::shared_ptr ProbingPT::CreateTargetPhrase(const Phrase &sourcePhrase) const
-{
-  // create a target phrase from the 1st word of the source, prefix with 'ProbingPT:'
-  assert(sourcePhrase.GetSize());
+    // check in cache
+    CachePb::const_iterator iterCache = m_cachePb.find(keyStruct.second);
+    if (iterCache != m_cachePb.end()) {
+      TargetPhraseCollection *tps = iterCache->second;
+      inputPath.SetTargetPhrases(*this, TargetPhraseCollection::shared_ptr(tps), NULL);
+      continue;
+    }
+
+    paths.push_back(&inputPath);
+    keys.push_back(keyStruct.second);
+  }
 
-  std::pair<bool, uint64_t> keyStruct = GetKey(sourcePhrase);
-  if (!keyStruct.first) {
-    return TargetPhraseCollection::shared_ptr();
+  if (keys.empty()) {
+    return;
   }
 
-  // check in cache
-  CachePb::const_iterator iter = m_cachePb.find(keyStruct.second);
-  if (iter != m_cachePb.end()) {
-    //cerr << "FOUND IN CACHE " << keyStruct.second << " " << sourcePhrase.Debug(mgr.system) << endl;
-    TargetPhraseCollection *tps = iter->second;
-    return TargetPhraseCollection::shared_ptr(tps);
+  // query pt. 1st=found, 2nd=target file offset
+  std::vector<std::pair<bool, uint64_t> > results(keys.size());
+  m_engine->query(&keys[0], keys.size(), &results[0]);
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    if (results[i].first) {
+      prefetchMem(data + results[i].second);
+    }
   }
 
-  // query pt
-  TargetPhraseCollection *tps = CreateTargetPhrases(sourcePhrase,
-                                keyStruct.second);
-  return TargetPhraseCollection::shared_ptr(tps);
+  for (size_t i = 0; i < paths.size(); ++i) {
+    TargetPhraseCollection *tps = NULL;
+    if (results[i].first) {
+      tps = CreateTargetPhrases(paths[i]->GetPhrase(), data + results[i].second);
+    }
+    paths[i]->SetTargetPhrases(*this, TargetPhraseCollection::shared_ptr(tps), NULL);
+  }
 }
 
 std::pair<bool, uint64_t> ProbingPT::GetKey(const Phrase &sourcePhrase) const
@@ -220,35 +241,25 @@ uint64_t ProbingPT::GetSourceProbingId(const Word &word) const
 }
 
 TargetPhraseCollection *ProbingPT::CreateTargetPhrases(
-  const Phrase &sourcePhrase, uint64_t key) const
+  const Phrase &sourcePhrase, const char *offset) const
 {
-  TargetPhraseCollection *tps = NULL;
+  uint64_t *numTP = (uint64_t*) offset;
 
-  //Actual lookup
-  std::pair<bool, uint64_t> query_result; // 1st=found, 2nd=target file offset
-  query_result = m_engine->query(key);
-  //cerr << "key2=" << query_result.second << endl;
+  TargetPhraseCollection *tps = new TargetPhraseCollection();
 
-  if (query_result.first) {
-    const char *offset = data + query_result.second;
-    uint64_t *numTP = (uint64_t*) offset;
+  offset += sizeof(uint64_t);
+  for (size_t i = 0; i < *numTP; ++i) {
+    TargetPhrase *tp = CreateTargetPhrase(offset);
+    assert(tp);
+    tp->EvaluateInIsolation(sourcePhrase, GetFeaturesToApply());
 
-    tps = new TargetPhraseCollection();
+    tps->Add(tp);
 
-    offset += sizeof(uint64_t);
-    for (size_t i = 0; i < *numTP; ++i) {
-      TargetPhrase *tp = CreateTargetPhrase(offset);
-      assert(tp);
-      tp->EvaluateInIsolation(sourcePhrase, GetFeaturesToApply());
-
-      tps->Add(tp);
-
-    }
-
-    tps->Prune(true, m_tableLimit);
-    //cerr << *tps << endl;
   }
 
+  tps->Prune(true, m_tableLimit);
+  //cerr << *tps << endl;
+
   return tps;
 
 }
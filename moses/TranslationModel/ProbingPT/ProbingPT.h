@@ -55,8 +55,6 @@ protected:
 
   void CreateAlignmentMap(const std::string path);
 
-  TargetPhraseCollection::shared_ptr CreateTargetPhrase(const Phrase &sourcePhrase) const;
-
   std::pair<bool, uint64_t> GetKey(const Phrase &sourcePhrase) const;
   void GetSourceProbingIds(const Phrase &sourcePhrase, bool &ok,
                            uint64_t probingSource[]) const;
@@ -64,7 +62,7 @@ protected:
   uint64_t GetSourceProbingId(const Factor *factor) const;
 
   TargetPhraseCollection *CreateTargetPhrases(
-    const Phrase &sourcePhrase, uint64_t key) const;
+    const Phrase &sourcePhrase, const char *offset) const;
   TargetPhrase *CreateTargetPhrase(
     const char *&offset) const;
 
@@ -39,6 +39,14 @@ char * readTable(const char * filename, size_t size);
 
 uint64_t getKey(const uint64_t source_phrase[], size_t size);
 
+//Hint that memory will be read soon. Used to overlap cache misses on the mmapped table
+inline void prefetchMem(const void *addr)
+{
+#ifdef __GNUC__
+  __builtin_prefetch(addr);
+#endif
+}
+
 struct TargetPhraseInfo {
   uint32_t alignTerm;
   uint32_t alignNonTerm;
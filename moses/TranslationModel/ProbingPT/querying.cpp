@@ -115,6 +115,21 @@ std::pair<bool, uint64_t> QueryEngine::query(uint64_t key)
   return ret;
 }
 
+void QueryEngine::query(const uint64_t keys[], size_t size, std::pair<bool, uint64_t> results[]) const
+{
+  for (size_t i = 0; i < size; ++i) {
+    prefetchMem(table.Ideal(keys[i]));
+  }
+
+  for (size_t i = 0; i < size; ++i) {
+    const Entry * entry;
+    results[i].first = table.Find(keys[i], entry);
+    if (results[i].first) {
+      results[i].second = entry->value;
+    }
+  }
+}
+
 void QueryEngine::read_alignments(const std::string &alignPath)
 {
   std::ifstream strm(alignPath.c_str());
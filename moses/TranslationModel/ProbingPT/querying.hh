@@ -38,6 +38,10 @@ public:
 
   std::pair<bool, uint64_t> query(uint64_t key);
 
+  //Same as query() for many keys. The buckets of all keys are prefetched
+  //before any of them is probed, so that the cache misses overlap
+  void query(const uint64_t keys[], size_t size, std::pair<bool, uint64_t> results[]) const;
+
   const std::map<uint64_t, std::string> &getSourceVocab() const {
     return source_vocabids;
   }
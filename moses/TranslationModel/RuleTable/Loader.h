@@ -59,6 +59,13 @@ protected:
     return ruleTable.GetOrCreateTargetPhraseCollection(source, target,
            sourceLHS);
   }
+
+  // Provide access to RuleTableTrie's private GetOrCreateShard function.
+  const void *GetOrCreateShard(RuleTableTrie &ruleTable,
+                               const Phrase &source,
+                               const TargetPhrase &target) {
+    return ruleTable.GetOrCreateShard(source, target);
+  }
 };
 
 }  // namespace Moses
@@ -41,6 +41,13 @@
 #include "util/tokenize_piece.hh"
 #include "util/double-conversion/double-conversion.h"
 #include "util/exception.hh"
+#include "util/usage.hh"
+
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/unordered_map.hpp>
+#include "moses/ThreadPool.h"
+#endif
 
 using namespace std;
 using namespace boost::algorithm;
@@ -140,120 +147,291 @@ void ReformatHieroRule(const string &lineOrig, string &out)
   out = ret.str();
 }
 
-bool RuleTableLoaderStandard::Load(AllOptions const& opts, FormatType format
-                                   , const std::vector<FactorType> &input
-                                   , const std::vector<FactorType> &output
-                                   , const std::string &inFile
-                                   , size_t /* tableLimit */
-                                   , RuleTableTrie &ruleTable)
+// A rule parsed from one line of the table, before it goes into the trie.
+struct RuleTableLoaderStandard::ParsedRule {
+  ParsedRule() : targetPhrase(NULL), sourceLHS(NULL) {}
+
+  Phrase sourcePhrase;
+  TargetPhrase *targetPhrase;  // NULL if the line is skipped
+  Word *sourceLHS;
+};
+
+// Turns lines of the table into rules. Parse() only reads the parser and the
+// rule table, so lines can be parsed on several threads.
+class RuleTableLoaderStandard::RuleParser
 {
-  PrintUserTime(string("Start loading text phrase table. ") + (format==MosesFormat?"Moses":"Hiero") + " format");
+public:
+  RuleParser(AllOptions const& opts
+             , FormatType format
+             , const std::vector<FactorType> &input
+             , const std::vector<FactorType> &output
+             , RuleTableTrie &ruleTable)
+    : m_opts(opts)
+    , m_format(format)
+    , m_input(input)
+    , m_output(output)
+    , m_ruleTable(ruleTable)
+    , m_converter(double_conversion::StringToDoubleConverter::NO_FLAGS, NAN, NAN, "inf", "nan") {
+  }
 
-  // const StaticData &staticData = StaticData::Instance();
+  bool Parse(StringPiece line, size_t count, ParsedRule &rule) const;
 
-  string lineOrig;
-  size_t count = 0;
+  // Parse lines[begin, end), the first of which is line firstLine of the table.
+  void ParseLines(const std::vector<std::string> &lines, size_t firstLine,
+                  std::vector<ParsedRule> &rules, size_t begin, size_t end) const {
+    for (size_t i = begin; i < end; ++i) {
+      Parse(lines[i], firstLine + i, rules[i]);
+    }
+  }
 
-  std::ostream *progress = NULL;
-  IFVERBOSE(1) progress = &std::cerr;
-  util::FilePiece in(inFile.c_str(), progress);
+private:
+  AllOptions const& m_opts;
+  const FormatType m_format;
+  const std::vector<FactorType> &m_input;
+  const std::vector<FactorType> &m_output;
+  RuleTableTrie &m_ruleTable;
+  const double_conversion::StringToDoubleConverter m_converter;
+};
+
+bool RuleTableLoaderStandard::RuleParser::Parse(StringPiece line, size_t count, ParsedRule &rule) const
+{
+  rule = ParsedRule();
 
-  // reused variables
-  vector<float> scoreVector;
-  StringPiece line;
   std::string hiero_before, hiero_after;
+  if (m_format == HieroFormat) { // inefficiently reformat line
+    hiero_before.assign(line.data(), line.size());
+    ReformatHieroRule(hiero_before, hiero_after);
+    line = hiero_after;
+  }
 
-  double_conversion::StringToDoubleConverter converter(double_conversion::StringToDoubleConverter::NO_FLAGS, NAN, NAN, "inf", "nan");
+  util::TokenIter<util::MultiCharacter> pipes(line, "|||");
+  StringPiece sourcePhraseString(*pipes);
+  StringPiece targetPhraseString(*++pipes);
+  StringPiece scoreString(*++pipes);
 
-  while(true) {
-    try {
-      line = in.ReadLine();
-    } catch (const util::EndOfFileException &e) {
-      break;
-    }
+  StringPiece alignString;
+  if (++pipes) {
+    StringPiece temp(*pipes);
+    alignString = temp;
+  }
 
-    if (format == HieroFormat) { // inefficiently reformat line
-      hiero_before.assign(line.data(), line.size());
-      ReformatHieroRule(hiero_before, hiero_after);
-      line = hiero_after;
-    }
+  bool isLHSEmpty = (sourcePhraseString.find_first_not_of(" \t", 0) == string::npos);
+  if (isLHSEmpty && !m_opts.unk.word_deletion_enabled) {
+    TRACE_ERR( m_ruleTable.GetFilePath() << ":" << count << ": pt entry contains empty target, skipping\n");
+    return false;
+  }
 
-    util::TokenIter<util::MultiCharacter> pipes(line, "|||");
-    StringPiece sourcePhraseString(*pipes);
-    StringPiece targetPhraseString(*++pipes);
-    StringPiece scoreString(*++pipes);
+  vector<float> scoreVector;
+  for (util::TokenIter<util::AnyCharacter, true> s(scoreString, " \t"); s; ++s) {
+    int processed;
+    float score = m_converter.StringToFloat(s->data(), s->length(), &processed);
+    UTIL_THROW_IF2(isnan(score), "Bad score " << *s << " on line " << count);
+    scoreVector.push_back(FloorScore(TransformScore(score)));
+  }
+  const size_t numScoreComponents = m_ruleTable.GetNumScoreComponents();
+  if (scoreVector.size() != numScoreComponents) {
+    UTIL_THROW2("Size of scoreVector != number (" << scoreVector.size() << "!="
+                << numScoreComponents << ") of score components on line " << count);
+  }
 
-    StringPiece alignString;
-    if (++pipes) {
-      StringPiece temp(*pipes);
-      alignString = temp;
-    }
+  // parse source & find pt node
 
-    bool isLHSEmpty = (sourcePhraseString.find_first_not_of(" \t", 0) == string::npos);
-    if (isLHSEmpty && !opts.unk.word_deletion_enabled) {
-      TRACE_ERR( ruleTable.GetFilePath() << ":" << count << ": pt entry contains empty target, skipping\n");
-      continue;
-    }
+  // constituent labels
+  Word *targetLHS;
 
-    scoreVector.clear();
-    for (util::TokenIter<util::AnyCharacter, true> s(scoreString, " \t"); s; ++s) {
-      int processed;
-      float score = converter.StringToFloat(s->data(), s->length(), &processed);
-      UTIL_THROW_IF2(isnan(score), "Bad score " << *s << " on line " << count);
-      scoreVector.push_back(FloorScore(TransformScore(score)));
-    }
-    const size_t numScoreComponents = ruleTable.GetNumScoreComponents();
-    if (scoreVector.size() != numScoreComponents) {
-      UTIL_THROW2("Size of scoreVector != number (" << scoreVector.size() << "!="
-                  << numScoreComponents << ") of score components on line " << count);
-    }
+  // create target phrase obj
+  TargetPhrase *targetPhrase = new TargetPhrase(&m_ruleTable);
+  targetPhrase->CreateFromString(Output, m_output, targetPhraseString, &targetLHS);
+  // source
+  rule.sourcePhrase.CreateFromString(Input, m_input, sourcePhraseString, &rule.sourceLHS);
 
-    // parse source & find pt node
+  // rest of target phrase
+  targetPhrase->SetAlignmentInfo(alignString);
+  targetPhrase->SetTargetLHS(targetLHS);
 
-    // constituent labels
-    Word *sourceLHS = NULL;
-    Word *targetLHS;
+  ++pipes;  // skip over counts field
 
-    // create target phrase obj
-    TargetPhrase *targetPhrase = new TargetPhrase(&ruleTable);
-    targetPhrase->CreateFromString(Output, output, targetPhraseString, &targetLHS);
-    // source
-    Phrase sourcePhrase;
-    sourcePhrase.CreateFromString(Input, input, sourcePhraseString, &sourceLHS);
+  if (++pipes) {
+    StringPiece sparseString(*pipes);
+    targetPhrase->SetSparseScore(&m_ruleTable, sparseString);
+  }
 
-    // rest of target phrase
-    targetPhrase->SetAlignmentInfo(alignString);
-    targetPhrase->SetTargetLHS(targetLHS);
+  if (++pipes) {
+    StringPiece propertiesString(*pipes);
+    targetPhrase->SetProperties(propertiesString);
+  }
 
-    ++pipes;  // skip over counts field
+  targetPhrase->GetScoreBreakdown().Assign(&m_ruleTable, scoreVector);
+  targetPhrase->EvaluateInIsolation(rule.sourcePhrase, m_ruleTable.GetFeaturesToApply());
 
-    if (++pipes) {
-      StringPiece sparseString(*pipes);
-      targetPhrase->SetSparseScore(&ruleTable, sparseString);
-    }
+  rule.targetPhrase = targetPhrase;
+  return true;
+}
+
+void RuleTableLoaderStandard::InsertRule(RuleTableTrie &ruleTable, ParsedRule &rule)
+{
+  if (rule.targetPhrase == NULL) {
+    return;
+  }
+
+  TargetPhraseCollection::shared_ptr phraseColl
+  = GetOrCreateTargetPhraseCollection(ruleTable, rule.sourcePhrase,
+                                      *rule.targetPhrase, rule.sourceLHS);
+  phraseColl->Add(rule.targetPhrase);
+  rule.targetPhrase = NULL;
+
+  // not implemented correctly in memory pt. just delete it for now
+  delete rule.sourceLHS;
+  rule.sourceLHS = NULL;
+}
+
+void RuleTableLoaderStandard::InsertRules(RuleTableTrie &ruleTable, std::vector<ParsedRule> &rules)
+{
+  for (size_t i = 0; i < rules.size(); ++i) {
+    InsertRule(ruleTable, rules[i]);
+  }
+}
 
-    if (++pipes) {
-      StringPiece propertiesString(*pipes);
-      targetPhrase->SetProperties(propertiesString);
+// Insert the rules of shards[begin, end), each shard in table order.
+void RuleTableLoaderStandard::InsertShards(RuleTableTrie &ruleTable
+    , std::vector<ParsedRule> &rules
+    , const std::vector<std::vector<size_t> > &shards
+    , size_t begin, size_t end)
+{
+  for (size_t shard = begin; shard < end; ++shard) {
+    const std::vector<size_t> &indices = shards[shard];
+    for (size_t i = 0; i < indices.size(); ++i) {
+      InsertRule(ruleTable, rules[indices[i]]);
     }
+  }
+}
+
+#ifdef WITH_THREADS
+namespace
+{
+// lines parsed together with load-threads
+const size_t LOAD_CHUNK_LINES = 100000;
+
+// Read up to maxLines lines. Returns false at the end of the file.
+bool ReadLines(util::FilePiece &in, std::vector<std::string> &lines, size_t maxLines)
+{
+  lines.clear();
+  StringPiece line;
+  while (lines.size() < maxLines && in.ReadLineOrEOF(line)) {
+    lines.push_back(line.as_string());
+  }
+  return !lines.empty();
+}
+}
+#endif
+
+bool RuleTableLoaderStandard::Load(AllOptions const& opts, FormatType format
+                                   , const std::vector<FactorType> &input
+                                   , const std::vector<FactorType> &output
+                                   , const std::string &inFile
+                                   , size_t /* tableLimit */
+                                   , RuleTableTrie &ruleTable)
+{
+  PrintUserTime(string("Start loading text phrase table. ") + (format==MosesFormat?"Moses":"Hiero") + " format");
+  const double startTime = util::WallTime();
+
+  // const StaticData &staticData = StaticData::Instance();
+
+  size_t lineNum = 0;
+  size_t count = 0;
+
+  std::ostream *progress = NULL;
+  IFVERBOSE(1) progress = &std::cerr;
+  util::FilePiece in(inFile.c_str(), progress);
 
-    targetPhrase->GetScoreBreakdown().Assign(&ruleTable, scoreVector);
-    targetPhrase->EvaluateInIsolation(sourcePhrase, ruleTable.GetFeaturesToApply());
+  const RuleParser parser(opts, format, input, output, ruleTable);
+  const size_t numThreads = ruleTable.GetLoadThreads();
+
+#ifdef WITH_THREADS
+  if (numThreads > 1) {
+    // Read the table in chunks. The lines of a chunk are parsed in parallel,
+    // then inserted in parallel by the root's child they go under, since
+    // those subtries are disjoint.
+    ThreadPool pool(numThreads - 1);
+    std::vector<std::string> lines;
+    std::vector<ParsedRule> rules;
+    std::vector<std::vector<size_t> > shards;
+    boost::unordered_map<const void*, size_t> shardIndex;
+
+    while (ReadLines(in, lines, LOAD_CHUNK_LINES)) {
+      rules.clear();
+      rules.resize(lines.size());
+      ParallelFor(pool, lines.size(), numThreads * 4,
+                  boost::bind(&RuleParser::ParseLines, &parser, boost::cref(lines),
+                              lineNum, boost::ref(rules), _1, _2));
+
+      // InsertRule takes the target phrases, so count before inserting
+      for (size_t i = 0; i < rules.size(); ++i) {
+        if (rules[i].targetPhrase != NULL) {
+          ++count;
+        }
+      }
 
-    TargetPhraseCollection::shared_ptr phraseColl
-    = GetOrCreateTargetPhraseCollection(ruleTable, sourcePhrase,
-                                        *targetPhrase, sourceLHS);
-    phraseColl->Add(targetPhrase);
+      shards.clear();
+      shardIndex.clear();
+      bool sharded = true;
+      for (size_t i = 0; i < rules.size() && sharded; ++i) {
+        if (rules[i].targetPhrase == NULL) {
+          continue;
+        }
+        const void *key = GetOrCreateShard(ruleTable, rules[i].sourcePhrase, *rules[i].targetPhrase);
+        if (key == NULL) {
+          sharded = false;
+          break;
+        }
+        std::pair<boost::unordered_map<const void*, size_t>::iterator, bool> p
+          = shardIndex.insert(std::make_pair(key, shards.size()));
+        if (p.second) {
+          shards.push_back(std::vector<size_t>());
+        }
+        shards[p.first->second].push_back(i);
+      }
 
-    // not implemented correctly in memory pt. just delete it for now
-    delete sourceLHS;
+      if (sharded) {
+        ParallelFor(pool, shards.size(), numThreads * 16,
+                    boost::bind(&RuleTableLoaderStandard::InsertShards, this,
+                                boost::ref(ruleTable), boost::ref(rules),
+                                boost::cref(shards), _1, _2));
+      } else {
+        InsertRules(ruleTable, rules);
+      }
 
-    count++;
+      lineNum += lines.size();
+    }
+  } else
+#endif
+  {
+    StringPiece line;
+    ParsedRule rule;
+    while (true) {
+      try {
+        line = in.ReadLine();
+      } catch (const util::EndOfFileException &e) {
+        break;
+      }
+
+      if (parser.Parse(line, lineNum, rule)) {
+        InsertRule(ruleTable, rule);
+        count++;
+      }
+      lineNum++;
+    }
   }
 
   // sort and prune each target phrase collection
   SortAndPrune(ruleTable);
 
+  IFVERBOSE(1) {
+    std::cerr << "Loaded " << count << " rules of " << inFile << " in "
+              << (util::WallTime() - startTime) << " seconds with " << numThreads
+              << " thread(s), peak RSS " << (util::RSSMax() >> 20) << " MB" << endl;
+  }
+
   return true;
 }
 
@@ -21,6 +21,8 @@
 
 #include "Loader.h"
 
+#include <vector>
+
 namespace Moses
 {
 
@@ -36,6 +38,15 @@ protected:
             const std::string &inFile,
             size_t tableLimit,
             RuleTableTrie &);
+
+  struct ParsedRule;
+  class RuleParser;
+
+  void InsertRule(RuleTableTrie &, ParsedRule &);
+  void InsertRules(RuleTableTrie &, std::vector<ParsedRule> &);
+  void InsertShards(RuleTableTrie &, std::vector<ParsedRule> &,
+                    const std::vector<std::vector<size_t> > &shards,
+                    size_t begin, size_t end);
 public:
   bool Load(AllOptions const& opts,
             const std::vector<FactorType> &input,
@@ -19,15 +19,7 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  ***********************************************************************/
 
-#include <cstdio>
-#include <cstdlib>
-#include <cstring>
-#include <climits>
-#include <sys/types.h>
-#include <unistd.h>
-#include <dirent.h>
-
-#include <fstream>
+#include <sstream>
 #include <string>
 #include <iterator>
 #include <algorithm>
@@ -37,52 +29,23 @@
 #include "moses/FactorCollection.h"
 #include "moses/Word.h"
 #include "moses/Util.h"
-#include "moses/InputFileStream.h"
 #include "moses/StaticData.h"
 #include "moses/Range.h"
 #include "moses/TranslationModel/CYKPlusParser/ChartRuleLookupManagerMemoryPerSentence.h"
 #include "moses/TranslationModel/fuzzy-match/FuzzyMatchWrapper.h"
 #include "moses/TranslationModel/fuzzy-match/SentenceAlignment.h"
 #include "moses/TranslationTask.h"
-#include "util/file.hh"
 #include "util/exception.hh"
-#include "util/random.hh"
 
 using namespace std;
 
-#if defined __MINGW32__ && !defined mkdtemp
-#include <windows.h>
-#include <cerrno>
-char *mkdtemp(char *tempbuf)
-{
-  int rand_value = 0;
-  char* tempbase = NULL;
-  char tempbasebuf[MAX_PATH] = "";
-
-  if (strcmp(&tempbuf[strlen(tempbuf)-6], "XXXXXX")) {
-    errno = EINVAL;
-    return NULL;
-  }
-
-  util::rand_init();
-  rand_value = util::rand_excl(1e6);
-  tempbase = strrchr(tempbuf, '/');
-  tempbase = tempbase ? tempbase+1 : tempbuf;
-  strcpy(tempbasebuf, tempbase);
-  sprintf(&tempbasebuf[strlen(tempbasebuf)-6], "%d", rand_value);
-  ::GetTempPath(MAX_PATH, tempbuf);
-  strcat(tempbuf, tempbasebuf);
-  ::CreateDirectory(tempbuf, NULL);
-  return tempbuf;
-}
-#endif
-
 namespace Moses
 {
 
 PhraseDictionaryFuzzyMatch::PhraseDictionaryFuzzyMatch(const std::string &line)
   :PhraseDictionary(line, true)
   ,m_config(3)
+  ,m_matchThreads(1)
   ,m_FuzzyMatchWrapper(NULL)
 {
   ReadParameters();
@@ -98,7 +61,7 @@ void PhraseDictionaryFuzzyMatch::Load(AllOptions::ptr const& opts)
   m_options = opts;
   SetFeaturesToApply();
 
-  m_FuzzyMatchWrapper = new tmmt::FuzzyMatchWrapper(m_config[0], m_config[1], m_config[2]);
+  m_FuzzyMatchWrapper = new tmmt::FuzzyMatchWrapper(m_config[0], m_config[1], m_config[2], m_matchThreads);
 }
 
 ChartRuleLookupManager *PhraseDictionaryFuzzyMatch::CreateRuleLookupManager(
@@ -119,145 +82,40 @@ SetParameter(const std::string& key, const std::string& value)
     m_config[1] = value;
   } else if (key == "alignment") {
     m_config[2] = value;
+  } else if (key == "match-threads") {
+    m_matchThreads = std::max<size_t>(Scan<size_t>(value), 1);
+#ifndef WITH_THREADS
+    UTIL_THROW_IF2(m_matchThreads > 1,
+                   "match-threads=" << value << " but moses not built with thread support");
+#endif
   } else {
     PhraseDictionary::SetParameter(key, value);
   }
 }
 
-int removedirectoryrecursively(const char *dirname)
-{
-#if defined __MINGW32__
-  //TODO(jie): replace this function with boost implementation
-#else
-  DIR *dir;
-  struct dirent *entry;
-  char path[PATH_MAX];
-
-  dir = opendir(dirname);
-  if (dir == NULL) {
-    perror("Error opendir()");
-    return 0;
-  }
-
-  while ((entry = readdir(dir)) != NULL) {
-    if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, "..")) {
-      snprintf(path, (size_t) PATH_MAX, "%s/%s", dirname, entry->d_name);
-      if (entry->d_type == DT_DIR) {
-        removedirectoryrecursively(path);
-      }
-
-      remove(path);
-      /*
-       * Here, the actual deletion must be done.  Beacuse this is
-       * quite a dangerous thing to do, and this program is not very
-       * well tested, we are just printing as if we are deleting.
-       */
-      //printf("(not really) Deleting: %s\n", path);
-      /*
-       * When you are finished testing this and feel you are ready to do the real
-       * deleting, use this: remove*STUB*(path);
-       * (see "man 3 remove")
-       * Please note that I DONT TAKE RESPONSIBILITY for data you delete with this!
-       */
-    }
-
-  }
-  closedir(dir);
-
-  rmdir(dirname);
-  /*
-   * Now the directory is emtpy, finally delete the directory itself. (Just
-   * printing here, see above)
-   */
-  //printf("(not really) Deleting: %s\n", dirname);
-#endif
-  return 1;
-}
-
 void PhraseDictionaryFuzzyMatch::InitializeForInput(ttasksptr const& ttask)
 {
   InputType const& inputSentence = *ttask->GetSource();
-#if defined __MINGW32__
-  char dirName[] = "moses.XXXXXX";
-#else
-  char dirName[] = "/tmp/moses.XXXXXX";
-#endif // defined
-  char *temp = mkdtemp(dirName);
-  UTIL_THROW_IF2(temp == NULL,
-                 "Couldn't create temporary directory " << dirName);
-
-  string dirNameStr(dirName);
-
-  string inFileName(dirNameStr + "/in");
-
-  ofstream inFile(inFileName.c_str());
 
+  ostringstream strme;
   for (size_t i = 1; i < inputSentence.GetSize() - 1; ++i) {
-    inFile << inputSentence.GetWord(i);
+    strme << inputSentence.GetWord(i);
   }
-  inFile << endl;
-  inFile.close();
+  vector<string> input = Tokenize(strme.str());
 
-  long translationId = inputSentence.GetTranslationId();
-  string ptFileName = m_FuzzyMatchWrapper->Extract(translationId, dirNameStr);
+  vector<tmmt::FuzzyMatchWrapper::Rule> rules;
+  m_FuzzyMatchWrapper->Extract(input, rules);
 
   // populate with rules for this sentence
+  long translationId = inputSentence.GetTranslationId();
   PhraseDictionaryNodeMemory &rootNode = m_collection[translationId];
-  FormatType format = MosesFormat;
-
-  // data from file
-  InputFileStream inStream(ptFileName);
-
-  // copied from class LoaderStandard
-  PrintUserTime("Start loading fuzzy-match phrase model");
-
-  const StaticData &staticData = StaticData::Instance();
-
-
-  string lineOrig;
-  size_t count = 0;
-
-  while(getline(inStream, lineOrig)) {
-    const string *line;
-    if (format == HieroFormat) { // reformat line
-      UTIL_THROW(util::Exception, "Cannot be Hiero format");
-      //line = ReformatHieroRule(lineOrig);
-    } else {
-      // do nothing to format of line
-      line = &lineOrig;
-    }
-
-    vector<string> tokens;
-    vector<float> scoreVector;
-
-    TokenizeMultiCharSeparator(tokens, *line , "|||" );
 
-    if (tokens.size() != 4 && tokens.size() != 5) {
-      UTIL_THROW2("Syntax error at " << ptFileName << ":" << count);
-    }
-
-    const string &sourcePhraseString = tokens[0]
-                                       , &targetPhraseString = tokens[1]
-                                           , &scoreString        = tokens[2]
-                                               , &alignString        = tokens[3];
-
-    bool isLHSEmpty = (sourcePhraseString.find_first_not_of(" \t", 0) == string::npos);
-    if (isLHSEmpty && !ttask->options()->unk.word_deletion_enabled) {
-      TRACE_ERR( ptFileName << ":" << count << ": pt entry contains empty target, skipping\n");
-      continue;
-    }
-
-    Tokenize<float>(scoreVector, scoreString);
-    const size_t numScoreComponents = GetNumScoreComponents();
-    if (scoreVector.size() != numScoreComponents) {
-      UTIL_THROW2("Size of scoreVector != number (" << scoreVector.size() << "!="
-                  << numScoreComponents << ") of score components on line " << count);
-    }
+  const size_t numScoreComponents = GetNumScoreComponents();
+  UTIL_THROW_IF2(numScoreComponents != 2,
+                 "Fuzzy match rules have 2 scores, not " << numScoreComponents);
 
-    UTIL_THROW_IF2(scoreVector.size() != numScoreComponents,
-                   "Number of scores incorrectly specified");
-
-    // parse source & find pt node
+  for (size_t i = 0; i < rules.size(); ++i) {
+    const tmmt::FuzzyMatchWrapper::Rule &rule = rules[i];
 
     // constituent labels
     Word *sourceLHS;
@@ -265,18 +123,18 @@ void PhraseDictionaryFuzzyMatch::InitializeForInput(ttasksptr const& ttask)
 
     // source
     Phrase sourcePhrase( 0);
-    sourcePhrase.CreateFromString(Input, m_input, sourcePhraseString, &sourceLHS);
+    sourcePhrase.CreateFromString(Input, m_input, rule.source, &sourceLHS);
 
     // create target phrase obj
     TargetPhrase *targetPhrase = new TargetPhrase(this);
-    targetPhrase->CreateFromString(Output, m_output, targetPhraseString, &targetLHS);
+    targetPhrase->CreateFromString(Output, m_output, rule.target, &targetLHS);
 
     // rest of target phrase
-    targetPhrase->SetAlignmentInfo(alignString);
+    targetPhrase->SetAlignmentInfo(rule.alignment);
     targetPhrase->SetTargetLHS(targetLHS);
-    //targetPhrase->SetDebugOutput(string("New Format pt ") + line);
 
     // component score, for n-best output
+    vector<float> scoreVector(rule.scores);
     std::transform(scoreVector.begin(),scoreVector.end(),scoreVector.begin(),TransformScore);
     std::transform(scoreVector.begin(),scoreVector.end(),scoreVector.begin(),FloorScore);
 
@@ -288,20 +146,11 @@ void PhraseDictionaryFuzzyMatch::InitializeForInput(ttasksptr const& ttask)
                                         *targetPhrase, sourceLHS);
     phraseColl->Add(targetPhrase);
 
-    count++;
-
-    if (format == HieroFormat) { // reformat line
-      delete line;
-    } else {
-      // do nothing
-    }
-
+    delete sourceLHS;
   }
 
   // sort and prune each target phrase collection
   SortAndPrune(rootNode);
-
-  //removedirectoryrecursively(dirName);
 }
 
 TargetPhraseCollection::shared_ptr
@@ -320,7 +169,6 @@ PhraseDictionaryNodeMemory &PhraseDictionaryFuzzyMatch::GetOrCreateNode(PhraseDi
     , const TargetPhrase &target
     , const Word *sourceLHS)
 {
-  cerr << source << endl << target << endl;
   const size_t size = source.GetSize();
 
   const AlignmentInfo &alignmentInfo = target.GetAlignNonTerm();
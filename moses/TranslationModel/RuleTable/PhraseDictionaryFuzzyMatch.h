@@ -76,6 +76,7 @@ protected:
 
   std::map<long, PhraseDictionaryNodeMemory> m_collection;
   std::vector<std::string> m_config;
+  size_t m_matchThreads;
 
   tmmt::FuzzyMatchWrapper *m_FuzzyMatchWrapper;
 
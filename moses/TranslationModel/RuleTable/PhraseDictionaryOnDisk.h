@@ -29,11 +29,7 @@
 #include "OnDiskPt/Word.h"
 #include "OnDiskPt/PhraseNode.h"
 
-#ifdef WITH_THREADS
-#include <boost/thread/tss.hpp>
-#else
 #include <boost/scoped_ptr.hpp>
-#endif
 
 namespace Moses
 {
@@ -51,11 +47,8 @@ class PhraseDictionaryOnDisk : public PhraseDictionary
   friend class ChartRuleLookupManagerOnDisk;
 
 protected:
-#ifdef WITH_THREADS
-  boost::thread_specific_ptr<OnDiskPt::OnDiskWrapper> m_implementation;
-#else
+  // loaded once and shared by all threads. Reading only touches the mapped files
   boost::scoped_ptr<OnDiskPt::OnDiskWrapper> m_implementation;
-#endif
 
   size_t m_maxSpanDefault, m_maxSpanLabelled;
 
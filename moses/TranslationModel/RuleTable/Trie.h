@@ -41,13 +41,24 @@ class RuleTableTrie : public PhraseDictionary
 {
 public:
   RuleTableTrie(const std::string &line)
-    : PhraseDictionary(line, true) {
+    : PhraseDictionary(line, true)
+    , m_loadThreads(1) {
   }
 
   virtual ~RuleTableTrie();
 
   void Load(AllOptions::ptr const& opts);
 
+  void SetParameter(const std::string& key, const std::string& value);
+
+  //! number of threads that parse and insert the rules of a text table
+  size_t GetLoadThreads() const {
+    return m_loadThreads;
+  }
+
+protected:
+  size_t m_loadThreads;
+
 private:
   friend class RuleTableLoader;
 
@@ -56,6 +67,16 @@ private:
                                     const TargetPhrase &target,
                                     const Word *sourceLHS) = 0;
 
+  /** Create the child of the root that the rule would be inserted under and
+   *  return it as a shard key.  Rules with different shard keys may then be
+   *  inserted concurrently.  Returns NULL if the trie can only be filled
+   *  from one thread.
+   */
+  virtual const void *
+  GetOrCreateShard(const Phrase &source, const TargetPhrase &target) {
+    return NULL;
+  }
+
   virtual void SortAndPrune() = 0;
 
 };
@@ -0,0 +1,107 @@
+//
+//  EditDistance.h
+//  fuzzy-match
+//
+
+#ifndef fuzzy_match_EditDistance_h
+#define fuzzy_match_EditDistance_h
+
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace tmmt
+{
+
+/* Levenshtein distance (insertions, deletions and substitutions cost 1)
+ between a fixed pattern and any number of texts, with the bit-parallel
+ algorithm of
+   Gene Myers, "A fast bit-vector algorithm for approximate string
+   matching based on dynamic programming", JACM 46(3), 1999
+ in the blocked form of
+   Heikki Hyyrö, "A bit-vector algorithm for computing Levenshtein and
+   Damerau edit distances", Nordic Journal of Computing 10(1), 2003.
+ A text of length n costs n * ceil(m / 64) word operations for a pattern
+ of length m. Only the distance is computed, not the path. */
+
+template <typename Symbol>
+class EditDistance
+{
+public:
+  template <typename Iterator>
+  EditDistance(Iterator begin, Iterator end)
+    : m_length(end - begin)
+    , m_blocks((m_length + 63) / 64) {
+    for (size_t i = 0; begin != end; ++begin, ++i) {
+      std::vector<boost::uint64_t> &eq = m_peq[*begin];
+      eq.resize(m_blocks, 0);
+      eq[i / 64] |= boost::uint64_t(1) << (i % 64);
+    }
+  }
+
+  template <typename Iterator>
+  unsigned int Distance(Iterator begin, Iterator end) const {
+    if (m_length == 0) {
+      return end - begin;
+    }
+    // vertical deltas of column 0 are all +1, D[i][0] = i
+    std::vector<boost::uint64_t> pv(m_blocks, ~boost::uint64_t(0));
+    std::vector<boost::uint64_t> mv(m_blocks, 0);
+    const boost::uint64_t lastBit = boost::uint64_t(1) << ((m_length - 1) % 64);
+    const boost::uint64_t highBit = boost::uint64_t(1) << 63;
+
+    unsigned int score = m_length;
+    for (; begin != end; ++begin) {
+      typename PeqMap::const_iterator hit = m_peq.find(*begin);
+      const boost::uint64_t *peq = (hit == m_peq.end()) ? NULL : &hit->second[0];
+
+      // horizontal delta entering the top row is +1, D[0][j] = j
+      int hin = 1;
+      for (size_t b = 0; b < m_blocks; ++b) {
+        boost::uint64_t eq = peq ? peq[b] : 0;
+        const boost::uint64_t Pv = pv[b], Mv = mv[b];
+        const boost::uint64_t Xv = eq | Mv;
+        if (hin < 0) {
+          eq |= 1;
+        }
+        const boost::uint64_t Xh = (((eq & Pv) + Pv) ^ Pv) | eq;
+        boost::uint64_t Ph = Mv | ~(Xh | Pv);
+        boost::uint64_t Mh = Pv & Xh;
+
+        // the delta leaving the block: at the pattern's last row in the
+        // last block, which is not full
+        const boost::uint64_t outBit = (b + 1 == m_blocks) ? lastBit : highBit;
+        int hout = 0;
+        if (Ph & outBit) {
+          hout = 1;
+        } else if (Mh & outBit) {
+          hout = -1;
+        }
+
+        Ph <<= 1;
+        Mh <<= 1;
+        if (hin < 0) {
+          Mh |= 1;
+        } else if (hin > 0) {
+          Ph |= 1;
+        }
+        pv[b] = Mh | ~(Xv | Ph);
+        mv[b] = Ph & Xv;
+        hin = hout;
+      }
+      score += hin;
+    }
+    return score;
+  }
+
+private:
+  typedef boost::unordered_map<Symbol, std::vector<boost::uint64_t> > PeqMap;
+
+  size_t m_length;
+  size_t m_blocks;
+  PeqMap m_peq;
+};
+
+}
+
+#endif
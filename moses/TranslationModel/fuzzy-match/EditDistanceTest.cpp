@@ -0,0 +1,90 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "EditDistance.h"
+
+using namespace tmmt;
+
+namespace
+{
+// the textbook dynamic programme
+unsigned int QuadraticDistance(const std::vector<int> &a, const std::vector<int> &b)
+{
+  std::vector<unsigned int> prev(b.size() + 1), curr(b.size() + 1);
+  for (size_t j = 0; j <= b.size(); ++j) {
+    prev[j] = j;
+  }
+  for (size_t i = 1; i <= a.size(); ++i) {
+    curr[0] = i;
+    for (size_t j = 1; j <= b.size(); ++j) {
+      curr[j] = std::min(std::min(prev[j] + 1, curr[j-1] + 1),
+                         prev[j-1] + (a[i-1] == b[j-1] ? 0 : 1));
+    }
+    prev.swap(curr);
+  }
+  return prev[b.size()];
+}
+
+std::vector<int> RandomSentence(size_t length, int vocabSize, unsigned int &seed)
+{
+  std::vector<int> ret(length);
+  for (size_t i = 0; i < length; ++i) {
+    seed = seed * 1103515245 + 12345;
+    ret[i] = (seed >> 16) % vocabSize;
+  }
+  return ret;
+}
+}
+
+BOOST_AUTO_TEST_SUITE(edit_distance)
+
+BOOST_AUTO_TEST_CASE(letters)
+{
+  std::string their("their"), there("there"), empty;
+  EditDistance<char> fromTheir(their.begin(), their.end());
+  BOOST_CHECK_EQUAL(2, fromTheir.Distance(there.begin(), there.end()));
+  BOOST_CHECK_EQUAL(0, fromTheir.Distance(their.begin(), their.end()));
+  BOOST_CHECK_EQUAL(5, fromTheir.Distance(empty.begin(), empty.end()));
+
+  EditDistance<char> fromEmpty(empty.begin(), empty.end());
+  BOOST_CHECK_EQUAL(5, fromEmpty.Distance(there.begin(), there.end()));
+}
+
+// patterns longer than one machine word span several blocks
+BOOST_AUTO_TEST_CASE(matches_dynamic_programme)
+{
+  unsigned int seed = 42;
+  for (size_t m = 0; m < 150; m += 7) {
+    for (size_t n = 0; n < 150; n += 11) {
+      std::vector<int> a = RandomSentence(m, 4, seed);
+      std::vector<int> b = RandomSentence(n, 4, seed);
+      EditDistance<int> editDistance(a.begin(), a.end());
+      BOOST_CHECK_EQUAL(QuadraticDistance(a, b),
+                        editDistance.Distance(b.begin(), b.end()));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
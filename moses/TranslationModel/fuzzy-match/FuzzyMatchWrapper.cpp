@@ -6,21 +6,25 @@
 //  Copyright 2012 __MyCompanyName__. All rights reserved.
 //
 
+#include <algorithm>
 #include <iostream>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
 #include "FuzzyMatchWrapper.h"
 #include "SentenceAlignment.h"
 #include "Match.h"
 #include "create_xml.h"
 #include "moses/Util.h"
-#include "moses/StaticData.h"
-#include "util/file.hh"
+#include "moses/ThreadPool.h"
+#include "util/exception.hh"
 
 using namespace std;
 
 namespace tmmt
 {
 
-FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::string &targetPath, const std::string &alignmentPath)
+FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::string &targetPath, const std::string &alignmentPath, size_t numThreads)
   :basic_flag(false)
   ,lsed_flag(true)
   ,refined_flag(true)
@@ -30,6 +34,7 @@ FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::s
   ,multiple_flag(true)
   ,multiple_slack(0)
   ,multiple_max(100)
+  ,m_numThreads(numThreads)
 {
   cerr << "creating suffix array" << endl;
   suffixArray = new tmmt::SuffixArray( sourcePath );
@@ -46,121 +51,148 @@ FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::s
   // create suffix array
   //load_corpus(m_config[0], input);
 
+#ifdef WITH_THREADS
+  if (m_numThreads > 1) {
+    // the thread that decodes the sentence verifies candidates as well
+    m_threadPool.reset(new Moses::ThreadPool(m_numThreads - 1));
+  }
+#endif
+
   cerr << "loading completed" << endl;
 }
 
-string FuzzyMatchWrapper::Extract(long translationId, const string &dirNameStr)
+FuzzyMatchWrapper::~FuzzyMatchWrapper()
 {
-  const Moses::StaticData &staticData = Moses::StaticData::Instance();
+  delete suffixArray;
+}
 
-  WordIndex wordIndex;
+void FuzzyMatchWrapper::Extract(const vector< string > &inputToks, vector< Rule > &rules)
+{
+  const std::vector< std::vector< WORD_ID > > &source = suffixArray->GetCorpus();
 
-  string fuzzyMatchFile = ExtractTM(wordIndex, translationId, dirNameStr);
-
-  // create extrac files
-  create_xml(fuzzyMatchFile);
-
-  // create phrase table with usual Moses scoring and consolidate programs
-  string cmd;
-  cmd = "LC_ALL=C sort " + fuzzyMatchFile + ".extract | gzip -c > "
-        + fuzzyMatchFile + ".extract.sorted.gz";
-  system(cmd.c_str());
-  cmd = "LC_ALL=C sort " + fuzzyMatchFile + ".extract.inv | gzip -c > "
-        + fuzzyMatchFile + ".extract.inv.sorted.gz";
-  system(cmd.c_str());
-
-#ifdef IS_XCODE
-  cmd = "/Users/hieuhoang/unison/workspace/github/moses-smt/bin";
-#elif IS_ECLIPSE
-  cmd = "/home/hieu/workspace/github/moses-smt/bin";
-#else
-  cmd = staticData.GetBinDirectory();
-#endif
+  vector< WORD_ID > input;
+  string inputStr;
+  for (size_t pos = 0; pos < inputToks.size(); ++pos) {
+    input.push_back( GetVocabulary().StoreIfNew( inputToks[pos] ) );
+    inputStr += inputToks[pos] + " ";
+  }
 
-  cmd += string("/../scripts/training/train-model.perl -dont-zip -first-step 6 -last-step 6 -f en -e fr -hierarchical ")
-         + " -extract-file " + fuzzyMatchFile + ".extract -lexical-file - -score-options \"--NoLex\" "
-         + " -phrase-translation-table " + fuzzyMatchFile + ".pt";
-  system(cmd.c_str());
+  clock_t start_clock = clock();
 
+  // n-gram matches in the suffix array, and the best cost they guarantee
+  boost::unordered_map< int, vector< Match > > sentence_match;
+  int best_cost = find_matches( input, sentence_match );
 
-  return fuzzyMatchFile + ".pt.gz";
-}
+  clock_t clock_matches = clock();
 
-string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, const string &dirNameStr)
-{
-  const std::vector< std::vector< WORD_ID > > &source = suffixArray->GetCorpus();
+  // verify the candidate sentences
+  vector< int > best_tm;
+  best_cost = validate_matches( input, sentence_match, best_cost, best_tm );
 
-  string inputPath = dirNameStr + "/in";
-  string fuzzyMatchFile = dirNameStr + "/fuzzyMatchFile";
-  ofstream fuzzyMatchStream(fuzzyMatchFile.c_str());
+  clock_t clock_validation = clock();
 
-  vector< vector< WORD_ID > > input;
-  load_corpus(inputPath, input);
+  LetterSEDCache lsed;
 
-  assert(input.size() == 1);
-  size_t sentenceInd = 0;
+  // do not try to find the best ... report multiple matches
+  if (multiple_flag) {
+    for(size_t si=0; si<best_tm.size(); si++) {
+      int s = best_tm[si];
+      string path;
+      sed( input, source[s], path, true, lsed );
+      create_rules(source[s], targetAndAlignment[s], inputStr, path, rules);
+    }
+  } // if (multiple_flag)
+  else {
 
-  clock_t start_clock = clock();
-  // if (i % 10 == 0) cerr << ".";
+    // find the best matches according to letter sed
+    string best_path = "";
+    int best_match = -1;
+    unsigned int best_letter_cost;
+    if (lsed_flag) {
+      best_letter_cost = compute_length( input ) * min_match / 100 + 1;
+      for(size_t si=0; si<best_tm.size(); si++) {
+        int s = best_tm[si];
+        string path;
+        unsigned int letter_cost = sed( input, source[s], path, true, lsed );
+        if (letter_cost < best_letter_cost) {
+          best_letter_cost = letter_cost;
+          best_path = path;
+          best_match = s;
+        }
+      }
+    }
+    // if letter sed turned off, just compute path for first match
+    else {
+      if (best_tm.size() > 0) {
+        string path;
+        sed( input, source[best_tm[0]], path, false, lsed );
+        best_path = path;
+        best_match = best_tm[0];
+      }
+    }
+
+    if (best_match == -1) {
+      UTIL_THROW_IF2(source.size() == 0, "Empty source phrase");
+      best_match = 0;
+    }
 
-  // establish some basic statistics
+    create_rules(source[best_match], targetAndAlignment[best_match], inputStr, best_path, rules);
 
-  // int input_length = compute_length( input[i] );
-  int input_length = input[sentenceInd].size();
+  } // else if (multiple_flag)
+
+  score_rules(rules);
+
+  cerr << "elapsed: " << (1000 * (clock()-start_clock) / CLOCKS_PER_SEC)
+       << " ( match: " << (1000 * (clock_matches-start_clock) / CLOCKS_PER_SEC)
+       << " validation: " << (1000 * (clock_validation-clock_matches) / CLOCKS_PER_SEC)
+       << " rules: " << (1000 * (clock()-clock_validation) / CLOCKS_PER_SEC)
+       << " )" << endl;
+}
+
+/* find n-gram matches between the input and the tm in the suffix array.
+ returns the best cost that the matches guarantee */
+
+int FuzzyMatchWrapper::find_matches( const vector< WORD_ID > &input, boost::unordered_map< int, vector< Match > > &sentence_match )
+{
+  // int input_length = compute_length( input );
+  int input_length = input.size();
   int best_cost = input_length * (100-min_match) / 100 + 1;
 
   int match_count = 0; // how many substring matches to be considered
-  //cerr << endl << "sentence " << i << ", length " << input_length << ", best_cost " << best_cost << endl;
 
   // find match ranges in suffix array
   vector< vector< pair< SuffixArray::INDEX, SuffixArray::INDEX > > > match_range;
-  for(int start=0; start<input[sentenceInd].size(); start++) {
+  for(int start=0; start<input.size(); start++) {
     SuffixArray::INDEX prior_first_match = 0;
     SuffixArray::INDEX prior_last_match = suffixArray->GetSize()-1;
     vector< string > substring;
     bool stillMatched = true;
     vector< pair< SuffixArray::INDEX, SuffixArray::INDEX > > matchedAtThisStart;
-    //cerr << "start: " << start;
-    for(size_t word=start; stillMatched && word<input[sentenceInd].size(); word++) {
-      substring.push_back( GetVocabulary().GetWord( input[sentenceInd][word] ) );
+    for(size_t word=start; stillMatched && word<input.size(); word++) {
+      substring.push_back( GetVocabulary().GetWord( input[word] ) );
 
-      // only look up, if needed (i.e. no unnecessary short gram lookups)
-      //				if (! word-start+1 <= short_match_max_length( input_length ) )
-      //			{
       SuffixArray::INDEX first_match, last_match;
       stillMatched = false;
       if (suffixArray->FindMatches( substring, first_match, last_match, prior_first_match, prior_last_match ) ) {
         stillMatched = true;
         matchedAtThisStart.push_back( make_pair( first_match, last_match ) );
-        //cerr << " (" << first_match << "," << last_match << ")";
-        //cerr << " " << ( last_match - first_match + 1 );
         prior_first_match = first_match;
         prior_last_match = last_match;
       }
-      //}
     }
-    //cerr << endl;
     match_range.push_back( matchedAtThisStart );
   }
 
-  clock_t clock_range = clock();
-
-  map< int, vector< Match > > sentence_match;
-  map< int, int > sentence_match_word_count;
-
   // go through all matches, longest first
-  for(int length = input[sentenceInd].size(); length >= 1; length--) {
+  for(int length = input.size(); length >= 1; length--) {
     // do not create matches, if these are handled by the short match function
     if (length <= short_match_max_length( input_length ) ) {
       continue;
     }
 
-    unsigned int count = 0;
-    for(int start = 0; start <= input[sentenceInd].size() - length; start++) {
+    for(int start = 0; start <= input.size() - length; start++) {
       if (match_range[start].size() >= length) {
         pair< SuffixArray::INDEX, SuffixArray::INDEX > &range = match_range[start][length-1];
-        // cerr << " (" << range.first << "," << range.second << ")";
-        count += range.second - range.first + 1;
 
         for(SuffixArray::INDEX i=range.first; i<=range.second; i++) {
           size_t position = suffixArray->GetPosition( i );
@@ -169,10 +201,6 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
           size_t sentence_id = suffixArray->GetSentence( position );
           int sentence_length = suffixArray->GetSentenceLength( sentence_id );
           int diff = abs( (int)sentence_length - (int)input_length );
-          // cerr << endl << i << "\tsentence " << sentence_id << ", length " << sentence_length;
-          //if (length <= 2 && input_length>=5 &&
-          //		sentence_match.find( sentence_id ) == sentence_match.end())
-          //	continue;
 
           if (diff > best_cost)
             continue;
@@ -180,8 +208,6 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
           // compute minimal cost
           int start_pos = suffixArray->GetWordInSentence( position );
           int end_pos = start_pos + length-1;
-          // cerr << endl << "\t" << start_pos << "-" << end_pos << " (" << sentence_length << ") vs. "
-          // << start << "-" << (start+length-1) << " (" << input_length << ")";
           // different number of prior words -> cost is at least diff
           int min_cost = abs( start - start_pos );
 
@@ -199,7 +225,6 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
                && end_pos != sentence_length-1 )
             min_cost++;
 
-          // cerr << " -> min_cost " << min_cost;
           if (min_cost > best_cost)
             continue;
 
@@ -210,54 +235,109 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
           int max_cost = max( start, start_pos )
                          + max( sentence_length-1 - end_pos,
                                 input_length-1 - (start+length-1) );
-          // cerr << ", max_cost " << max_cost;
 
           Match m = Match( start, start+length-1,
                            start_pos, start_pos+length-1,
                            min_cost, max_cost, 0);
           sentence_match[ sentence_id ].push_back( m );
-          sentence_match_word_count[ sentence_id ] += length;
 
           if (max_cost < best_cost) {
             best_cost = max_cost;
             if (best_cost == 0) break;
           }
-          //if (match_count >= MAX_MATCH_COUNT) break;
         }
       }
-      // cerr << endl;
       if (best_cost == 0) break;
-      //if (match_count >= MAX_MATCH_COUNT) break;
     }
-    // cerr << count << " matches at length " << length << " in " << sentence_match.size() << " tm." << endl;
 
     if (best_cost == 0) break;
-    //if (match_count >= MAX_MATCH_COUNT) break;
   }
   cerr << match_count << " matches in " << sentence_match.size() << " sentences." << endl;
 
-  clock_t clock_matches = clock();
+  return best_cost;
+}
 
-  // consider each sentence for which we have matches
-  int old_best_cost = best_cost;
-  int tm_count_word_match = 0;
-  int tm_count_word_match2 = 0;
-  int pruned_match_count = 0;
-  if (short_match_max_length( input_length )) {
-    init_short_matches(wordIndex, translationId, input[sentenceInd] );
+/* state of the verification of one input sentence, shared by the
+ threads that verify its candidates */
+
+struct FuzzyMatchWrapper::Validation {
+  Validation(const vector< WORD_ID > &input, int best_cost)
+    : input(input)
+    , editDistance(input.begin(), input.end())
+    , bound(best_cost) {
   }
-  vector< int > best_tm;
-  typedef map< int, vector< Match > >::iterator I;
 
-  clock_t clock_validation_sum = 0;
+  const vector< WORD_ID > &input;
+  WordIndex wordIndex;
+  EditDistance< WORD_ID > editDistance;
+  vector< int > candidates;
+  vector< vector< Match >* > matches;
+  vector< int > cost; // -1 if filtered out
 
+  // best cost found so far, lowered by every thread
+  boost::atomic< int > bound;
+};
+
+/* verify each sentence for which we have matches. the cost of the
+ best sentences is returned, their ids are added to best_tm in order */
+
+int FuzzyMatchWrapper::validate_matches( const vector< WORD_ID > &input, boost::unordered_map< int, vector< Match > > &sentence_match, int best_cost, vector< int > &best_tm )
+{
+  Validation v(input, best_cost);
+  if (short_match_max_length( input.size() )) {
+    init_short_matches( v.wordIndex, input );
+  }
+
+  typedef boost::unordered_map< int, vector< Match > >::iterator I;
   for(I tm=sentence_match.begin(); tm!=sentence_match.end(); tm++) {
-    int tmID = tm->first;
-    int tm_length = suffixArray->GetSentenceLength(tmID);
-    vector< Match > &match = tm->second;
-    add_short_matches(wordIndex, translationId, match, source[tmID], input_length, best_cost );
+    v.candidates.push_back( tm->first );
+  }
+  std::sort( v.candidates.begin(), v.candidates.end() );
+  for(size_t c=0; c<v.candidates.size(); c++) {
+    v.matches.push_back( &sentence_match[ v.candidates[c] ] );
+  }
+  v.cost.resize( v.candidates.size(), -1 );
 
-    //cerr << "match in sentence " << tmID << ": " << match.size() << " [" << tm_length << "]" << endl;
+  boost::function<void (size_t, size_t)> body
+  = boost::bind(&FuzzyMatchWrapper::validate_range, this, boost::ref(v), _1, _2);
+#ifdef WITH_THREADS
+  if (m_threadPool) {
+    // small ranges, so that a lower bound found in one reaches the others
+    Moses::ParallelFor(*m_threadPool, v.candidates.size(), m_numThreads * 8, body);
+  } else
+#endif
+  {
+    body(0, v.candidates.size());
+  }
+
+  best_cost = v.bound;
+  int tm_count_validated = 0;
+  for(size_t c=0; c<v.candidates.size(); c++) {
+    if (v.cost[c] < 0)
+      continue;
+    tm_count_validated++;
+    if (v.cost[c] == best_cost)
+      best_tm.push_back( v.candidates[c] );
+  }
+
+  cerr << "tm considered: " << v.candidates.size()
+       << " validated: " << tm_count_validated
+       << " best: " << best_tm.size() << " (cost " << best_cost << ")" << endl;
+
+  return best_cost;
+}
+
+void FuzzyMatchWrapper::validate_range( Validation &v, size_t begin, size_t end )
+{
+  const std::vector< std::vector< WORD_ID > > &source = suffixArray->GetCorpus();
+  int input_length = v.input.size();
+
+  for(size_t c=begin; c<end; c++) {
+    int tmID = v.candidates[c];
+    int tm_length = suffixArray->GetSentenceLength(tmID);
+    vector< Match > &match = *v.matches[c];
+    int best_cost = v.bound;
+    add_short_matches(v.wordIndex, match, source[tmID], input_length, best_cost );
 
     // quick look: how many words are matched
     int words_matched = 0;
@@ -269,7 +349,6 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     if (max(input_length,tm_length) - words_matched > best_cost) {
       if (length_filter_flag) continue;
     }
-    tm_count_word_match++;
 
     // prune, check again how many words are matched
     vector< Match > pruned = prune_matches( match, best_cost );
@@ -280,135 +359,20 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     if (max(input_length,tm_length) - words_matched > best_cost) {
       if (length_filter_flag) continue;
     }
-    tm_count_word_match2++;
 
-    pruned_match_count += pruned.size();
-    int prior_best_cost = best_cost;
     int cost;
-
-    clock_t clock_validation_start = clock();
     if (! parse_flag ||
         pruned.size()>=10) { // to prevent worst cases
-      string path;
-      cost = sed( input[sentenceInd], source[tmID], path, false );
-      if (cost <  best_cost) {
-        best_cost = cost;
-      }
-    }
-
-    else {
+      cost = v.editDistance.Distance( source[tmID].begin(), source[tmID].end() );
+    } else {
       cost = parse_matches( pruned, input_length, tm_length, best_cost );
-      if (prior_best_cost != best_cost) {
-        best_tm.clear();
-      }
-    }
-    clock_validation_sum += clock() - clock_validation_start;
-    if (cost == best_cost) {
-      best_tm.push_back( tmID );
     }
-  }
-  cerr << "reduced best cost from " << old_best_cost << " to " << best_cost << endl;
-  cerr << "tm considered: " << sentence_match.size()
-       << " word-matched: " << tm_count_word_match
-       << " word-matched2: " << tm_count_word_match2
-       << " best: " << best_tm.size() << endl;
-
-  cerr << "pruned matches: " << ((float)pruned_match_count/(float)tm_count_word_match2) << endl;
-
-  // create xml and extract files
-  string inputStr, sourceStr;
-  for (size_t pos = 0; pos < input_length; ++pos) {
-    inputStr += GetVocabulary().GetWord(input[sentenceInd][pos]) + " ";
-  }
+    v.cost[c] = cost;
 
-  // do not try to find the best ... report multiple matches
-  if (multiple_flag) {
-    for(size_t si=0; si<best_tm.size(); si++) {
-      int s = best_tm[si];
-      string path;
-      sed( input[sentenceInd], source[s], path, true );
-      const vector<WORD_ID> &sourceSentence = source[s];
-      vector<SentenceAlignment> &targets = targetAndAlignment[s];
-      create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, path, fuzzyMatchStream);
-
-    }
-  } // if (multiple_flag)
-  else {
-
-    // find the best matches according to letter sed
-    string best_path = "";
-    int best_match = -1;
-    unsigned int best_letter_cost;
-    if (lsed_flag) {
-      best_letter_cost = compute_length( input[sentenceInd] ) * min_match / 100 + 1;
-      for(size_t si=0; si<best_tm.size(); si++) {
-        int s = best_tm[si];
-        string path;
-        unsigned int letter_cost = sed( input[sentenceInd], source[s], path, true );
-        if (letter_cost < best_letter_cost) {
-          best_letter_cost = letter_cost;
-          best_path = path;
-          best_match = s;
-        }
-      }
-    }
-    // if letter sed turned off, just compute path for first match
-    else {
-      if (best_tm.size() > 0) {
-        string path;
-        sed( input[sentenceInd], source[best_tm[0]], path, false );
-        best_path = path;
-        best_match = best_tm[0];
-      }
+    // lower the shared bound, unless another thread got further
+    int bound = v.bound;
+    while (cost < bound && !v.bound.compare_exchange_weak(bound, cost)) {
     }
-    cerr << "elapsed: " << (1000 * (clock()-start_clock) / CLOCKS_PER_SEC)
-         << " ( range: " << (1000 * (clock_range-start_clock) / CLOCKS_PER_SEC)
-         << " match: " << (1000 * (clock_matches-clock_range) / CLOCKS_PER_SEC)
-         << " tm: " << (1000 * (clock()-clock_matches) / CLOCKS_PER_SEC)
-         << " (validation: " << (1000 * (clock_validation_sum) / CLOCKS_PER_SEC) << ")"
-         << " )" << endl;
-    if (lsed_flag) {
-      //cout << best_letter_cost << "/" << compute_length( input[sentenceInd] ) << " (";
-    }
-    //cout << best_cost <<"/" << input_length;
-    if (lsed_flag) {
-      //cout << ")";
-    }
-    //cout << " ||| " << best_match << " ||| " << best_path << endl;
-
-    if (best_match == -1) {
-      UTIL_THROW_IF2(source.size() == 0, "Empty source phrase");
-      best_match = 0;
-    }
-
-    // creat xml & extracts
-    const vector<WORD_ID> &sourceSentence = source[best_match];
-    vector<SentenceAlignment> &targets = targetAndAlignment[best_match];
-    create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, best_path, fuzzyMatchStream);
-
-  } // else if (multiple_flag)
-
-  fuzzyMatchStream.close();
-
-  return fuzzyMatchFile;
-}
-
-void FuzzyMatchWrapper::load_corpus( const std::string &fileName, vector< vector< WORD_ID > > &corpus )
-{
-  // source
-  ifstream fileStream;
-  fileStream.open(fileName.c_str());
-  if (!fileStream) {
-    cerr << "file not found: " << fileName << endl;
-    exit(1);
-  }
-  cerr << "loading " << fileName << endl;
-
-  istream *fileStreamP = &fileStream;
-
-  string line;
-  while(getline(*fileStreamP, line)) {
-    corpus.push_back( GetVocabulary().Tokenize( line.c_str() ) );
   }
 }
 
@@ -511,85 +475,32 @@ void FuzzyMatchWrapper::load_alignment(const std::string &fileName, vector< vect
   }
 }
 
-bool FuzzyMatchWrapper::GetLSEDCache(const std::pair< WORD_ID, WORD_ID > &key, unsigned int &value) const
-{
-#ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
-#endif
-  map< pair< WORD_ID, WORD_ID >, unsigned int >::const_iterator lookup = m_lsed.find( key );
-  if (lookup != m_lsed.end()) {
-    value = lookup->second;
-    return true;
-  }
-
-  return false;
-}
-
-void FuzzyMatchWrapper::SetLSEDCache(const std::pair< WORD_ID, WORD_ID > &key, const unsigned int &value)
-{
-#ifdef WITH_THREADS
-  boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
-#endif
-  m_lsed[ key ] = value;
-}
-
 /* Letter string edit distance, e.g. sub 'their' to 'there' costs 2 */
 
-unsigned int FuzzyMatchWrapper::letter_sed( WORD_ID aIdx, WORD_ID bIdx )
+unsigned int FuzzyMatchWrapper::letter_sed( WORD_ID aIdx, WORD_ID bIdx, LetterSEDCache &cache )
 {
   // check if already computed -> lookup in cache
   pair< WORD_ID, WORD_ID > pIdx = make_pair( aIdx, bIdx );
-  unsigned int value;
-  bool ret = GetLSEDCache(pIdx, value);
-  if (ret) {
-    return value;
+  LetterSEDCache::const_iterator lookup = cache.find( pIdx );
+  if (lookup != cache.end()) {
+    return lookup->second;
   }
 
   // get surface strings for word indices
   const string &a = GetVocabulary().GetWord( aIdx );
   const string &b = GetVocabulary().GetWord( bIdx );
 
-  // initialize cost matrix
-  unsigned int **cost  = (unsigned int**) calloc( sizeof( unsigned int*  ), a.size()+1 );
-  for( unsigned int i=0; i<=a.size(); i++ ) {
-    cost[i] = (unsigned int*) calloc( sizeof(unsigned int), b.size()+1 );
-    cost[i][0] = i;
-  }
-  for( unsigned int j=0; j<=b.size(); j++ ) {
-    cost[0][j] = j;
-  }
-
-  // core string edit distance loop
-  for( unsigned int i=1; i<=a.size(); i++ ) {
-    for( unsigned int j=1; j<=b.size(); j++ ) {
-
-      unsigned int ins = cost[i-1][j] + 1;
-      unsigned int del = cost[i][j-1] + 1;
-      bool match = (a.substr(i-1,1).compare( b.substr(j-1,1) ) == 0);
-      unsigned int diag = cost[i-1][j-1] + (match ? 0 : 1);
-
-      unsigned int min = (ins < del) ? ins : del;
-      min = (diag < min) ? diag : min;
-
-      cost[i][j] = min;
-    }
-  }
-
-  // clear out memory
-  unsigned int final = cost[a.size()][b.size()];
-  for( unsigned int i=0; i<=a.size(); i++ ) {
-    free( cost[i] );
-  }
-  free( cost );
+  EditDistance< char > editDistance( a.begin(), a.end() );
+  unsigned int final = editDistance.Distance( b.begin(), b.end() );
 
   // cache and return result
-  SetLSEDCache(pIdx, final);
+  cache[ pIdx ] = final;
   return final;
 }
 
 /* string edit distance implementation */
 
-unsigned int FuzzyMatchWrapper::sed( const vector< WORD_ID > &a, const vector< WORD_ID > &b, string &best_path, bool use_letter_sed )
+unsigned int FuzzyMatchWrapper::sed( const vector< WORD_ID > &a, const vector< WORD_ID > &b, string &best_path, bool use_letter_sed, LetterSEDCache &cache )
 {
 
   // initialize cost and path matrices
@@ -635,7 +546,7 @@ unsigned int FuzzyMatchWrapper::sed( const vector< WORD_ID > &a, const vector< W
       if (use_letter_sed) {
         ins += GetVocabulary().GetWord( a[i-1] ).size();
         del += GetVocabulary().GetWord( b[j-1] ).size();
-        match = letter_sed( a[i-1], b[j-1] );
+        match = letter_sed( a[i-1], b[j-1], cache );
       } else {
         ins++;
         del++;
@@ -703,6 +614,8 @@ unsigned int FuzzyMatchWrapper::compute_length( const vector< WORD_ID > &sentenc
 void FuzzyMatchWrapper::basic_fuzzy_match( vector< vector< WORD_ID > > source,
     vector< vector< WORD_ID > > input )
 {
+  LetterSEDCache lsed;
+
   // go through input set...
   for(unsigned int i=0; i<input.size(); i++) {
     bool use_letter_sed = false;
@@ -733,7 +646,7 @@ void FuzzyMatchWrapper::basic_fuzzy_match( vector< vector< WORD_ID > > source,
 
       // compute string edit distance
       string path;
-      unsigned int cost = sed( input[i], source[s], path, use_letter_sed );
+      unsigned int cost = sed( input[i], source[s], path, use_letter_sed, lsed );
 
       // update if new best
       if (cost < best_cost) {
@@ -767,7 +680,7 @@ int FuzzyMatchWrapper::short_match_max_length( int input_length )
  (to be used by the next function)
  (done here, because this has be done only once for an input sentence) */
 
-void FuzzyMatchWrapper::init_short_matches(WordIndex &wordIndex, long translationId, const vector< WORD_ID > &input )
+void FuzzyMatchWrapper::init_short_matches(WordIndex &wordIndex, const vector< WORD_ID > &input )
 {
   int max_length = short_match_max_length( input.size() );
   if (max_length == 0)
@@ -777,30 +690,26 @@ void FuzzyMatchWrapper::init_short_matches(WordIndex &wordIndex, long translatio
 
   // store input words and their positions in hash map
   for(size_t i=0; i<input.size(); i++) {
-    if (wordIndex.find( input[i] ) == wordIndex.end()) {
-      vector< int > position_vector;
-      wordIndex[ input[i] ] = position_vector;
-    }
     wordIndex[ input[i] ].push_back( i );
   }
 }
 
 /* add all short matches to list of matches for a sentence */
 
-void FuzzyMatchWrapper::add_short_matches(WordIndex &wordIndex, long translationId, vector< Match > &match, const vector< WORD_ID > &tm, int input_length, int best_cost )
+void FuzzyMatchWrapper::add_short_matches(const WordIndex &wordIndex, vector< Match > &match, const vector< WORD_ID > &tm, int input_length, int best_cost )
 {
   int max_length = short_match_max_length( input_length );
   if (max_length == 0)
     return;
 
   int tm_length = tm.size();
-  map< WORD_ID,vector< int > >::iterator input_word_hit;
+  WordIndex::const_iterator input_word_hit;
   for(int t_pos=0; t_pos<tm.size(); t_pos++) {
     input_word_hit = wordIndex.find( tm[t_pos] );
     if (input_word_hit != wordIndex.end()) {
-      vector< int > &position_vector = input_word_hit->second;
+      const vector< int > &position_vector = input_word_hit->second;
       for(size_t j=0; j<position_vector.size(); j++) {
-        int &i_pos = position_vector[j];
+        int i_pos = position_vector[j];
 
         // before match
         int max_cost = max( i_pos , t_pos );
@@ -1000,7 +909,10 @@ int FuzzyMatchWrapper::parse_matches( vector< Match > &match, int input_length,
 }
 
 
-void FuzzyMatchWrapper::create_extract(int sentenceInd, int cost, const vector< WORD_ID > &sourceSentence, const vector<SentenceAlignment> &targets, const string &inputStr, const string  &path, ofstream &outputFile)
+/* create the rules that turn a tm sentence into the input, one for each
+ of its translations */
+
+void FuzzyMatchWrapper::create_rules(const vector< WORD_ID > &sourceSentence, const vector<SentenceAlignment> &targets, const string &inputStr, const string &path, vector< Rule > &rules)
 {
   string sourceStr;
   for (size_t pos = 0; pos < sourceSentence.size(); ++pos) {
@@ -1013,17 +925,50 @@ void FuzzyMatchWrapper::create_extract(int sentenceInd, int cost, const vector<
     string targetStr = sentenceAlignment.getTargetString(GetVocabulary());
     string alignStr = sentenceAlignment.getAlignmentString();
 
-    outputFile
-        << sentenceInd << endl
-        << cost << endl
-        << sourceStr << endl
-        << inputStr << endl
-        << targetStr << endl
-        << alignStr << endl
-        << path << endl
-        << sentenceAlignment.count << endl;
+    CreateXMLRetValues ret = createXML(rules.size() + 1, sourceStr, inputStr, targetStr, alignStr, path + "X");
 
+    Rule rule;
+    rule.source = ret.ruleS + " [X]";
+    rule.target = ret.ruleT + " [X]";
+    rule.alignment = ret.ruleAlignment;
+    rule.count = sentenceAlignment.count;
+    rules.push_back(rule);
   }
 }
 
+/* score the rules as relative frequencies, as the phrase table scorer
+ does without lexical weights. identical rules are merged, keeping the
+ alignment of the first one */
+
+void FuzzyMatchWrapper::score_rules(vector< Rule > &rules)
+{
+  vector< Rule > merged;
+  boost::unordered_map< pair< string, string >, size_t > ruleIndex;
+  for (size_t i = 0; i < rules.size(); ++i) {
+    pair< string, string > key(rules[i].source, rules[i].target);
+    std::pair< boost::unordered_map< pair< string, string >, size_t >::iterator, bool > ret
+    = ruleIndex.insert(make_pair(key, merged.size()));
+    if (ret.second) {
+      merged.push_back(rules[i]);
+    } else {
+      merged[ret.first->second].count += rules[i].count;
+    }
+  }
+
+  boost::unordered_map< string, float > countF, countE;
+  for (size_t i = 0; i < merged.size(); ++i) {
+    countF[merged[i].source] += merged[i].count;
+    countE[merged[i].target] += merged[i].count;
+  }
+
+  for (size_t i = 0; i < merged.size(); ++i) {
+    Rule &rule = merged[i];
+    rule.scores.resize(2);
+    rule.scores[0] = rule.count / countE[rule.target];
+    rule.scores[1] = rule.count / countF[rule.source];
+  }
+
+  rules.swap(merged);
+}
+
 } // namespace
@@ -9,17 +9,21 @@
 #ifndef moses_FuzzyMatchWrapper_h
 #define moses_FuzzyMatchWrapper_h
 
-#ifdef WITH_THREADS
-#include <boost/thread/shared_mutex.hpp>
-#endif
-
-#include <fstream>
 #include <string>
+#include <vector>
+#include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
 #include "SuffixArray.h"
 #include "Vocabulary.h"
 #include "Match.h"
+#include "EditDistance.h"
 #include "moses/InputType.h"
 
+namespace Moses
+{
+class ThreadPool;
+}
+
 namespace tmmt
 {
 class Match;
@@ -28,9 +32,20 @@ struct SentenceAlignment;
 class FuzzyMatchWrapper
 {
 public:
-  FuzzyMatchWrapper(const std::string &source, const std::string &target, const std::string &alignment);
+  /* a rule of the per-sentence table, with the scores the phrase table
+   scorer gives it with --NoLex: p(f|e) and p(e|f) */
+  struct Rule {
+    std::string source, target, alignment;
+    float count;
+    std::vector<float> scores;
+  };
 
-  std::string Extract(long translationId, const std::string &dirNameStr);
+  FuzzyMatchWrapper(const std::string &source, const std::string &target, const std::string &alignment, size_t numThreads = 1);
+  ~FuzzyMatchWrapper();
+
+  /* find the best tm matches for a tokenized input sentence and
+   create the rules for it */
+  void Extract(const std::vector< std::string > &input, std::vector< Rule > &rules);
 
 protected:
   // tm-mt
@@ -46,16 +61,16 @@ protected:
   int multiple_slack;
   int multiple_max;
 
-  typedef std::map< WORD_ID,std::vector< int > > WordIndex;
-
-  // global cache for word pairs
-  std::map< std::pair< WORD_ID, WORD_ID >, unsigned int > m_lsed;
+  size_t m_numThreads;
 #ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::shared_mutex m_accessLock;
+  boost::scoped_ptr<Moses::ThreadPool> m_threadPool;
 #endif
 
-  void load_corpus( const std::string &fileName, std::vector< std::vector< tmmt::WORD_ID > > &corpus );
+  typedef boost::unordered_map< WORD_ID,std::vector< int > > WordIndex;
+
+  // letter sed of word pairs, kept for one input sentence
+  typedef boost::unordered_map< std::pair< WORD_ID, WORD_ID >, unsigned int > LetterSEDCache;
+
   void load_target( const std::string &fileName, std::vector< std::vector< tmmt::SentenceAlignment > > &corpus);
   void load_alignment( const std::string &fileName, std::vector< std::vector< tmmt::SentenceAlignment > > &corpus );
 
@@ -66,24 +81,26 @@ protected:
   /** utlility function: compute length of sentence in characters
    (spaces do not count) */
   unsigned int compute_length( const std::vector< tmmt::WORD_ID > &sentence );
-  unsigned int letter_sed( WORD_ID aIdx, WORD_ID bIdx );
-  unsigned int sed( const std::vector< WORD_ID > &a, const std::vector< WORD_ID > &b, std::string &best_path, bool use_letter_sed );
-  void init_short_matches(WordIndex &wordIndex, long translationId, const std::vector< WORD_ID > &input );
+  unsigned int letter_sed( WORD_ID aIdx, WORD_ID bIdx, LetterSEDCache &cache );
+  unsigned int sed( const std::vector< WORD_ID > &a, const std::vector< WORD_ID > &b, std::string &best_path, bool use_letter_sed, LetterSEDCache &cache );
+  void init_short_matches(WordIndex &wordIndex, const std::vector< WORD_ID > &input );
   int short_match_max_length( int input_length );
-  void add_short_matches(WordIndex &wordIndex, long translationId, std::vector< Match > &match, const std::vector< WORD_ID > &tm, int input_length, int best_cost );
+  void add_short_matches(const WordIndex &wordIndex, std::vector< Match > &match, const std::vector< WORD_ID > &tm, int input_length, int best_cost );
   std::vector< Match > prune_matches( const std::vector< Match > &match, int best_cost );
   int parse_matches( std::vector< Match > &match, int input_length, int tm_length, int &best_cost );
 
-  void create_extract(int sentenceInd, int cost, const std::vector< WORD_ID > &sourceSentence, const std::vector<SentenceAlignment> &targets, const std::string &inputStr, const std::string  &path, std::ofstream &outputFile);
+  int find_matches( const std::vector< WORD_ID > &input, boost::unordered_map< int, std::vector< Match > > &sentence_match );
+  struct Validation;
+  void validate_range( Validation &v, size_t begin, size_t end );
+  int validate_matches( const std::vector< WORD_ID > &input, boost::unordered_map< int, std::vector< Match > > &sentence_match, int best_cost, std::vector< int > &best_tm );
+
+  void create_rules(const std::vector< WORD_ID > &sourceSentence, const std::vector<SentenceAlignment> &targets, const std::string &inputStr, const std::string &path, std::vector< Rule > &rules);
+  void score_rules(std::vector< Rule > &rules);
 
-  std::string ExtractTM(WordIndex &wordIndex, long translationId, const std::string &inputPath);
   Vocabulary &GetVocabulary() {
     return suffixArray->GetVocabulary();
   }
 
-  bool GetLSEDCache(const std::pair< WORD_ID, WORD_ID > &key, unsigned int &value) const;
-  void SetLSEDCache(const std::pair< WORD_ID, WORD_ID > &key, const unsigned int &value);
-
 };
 
 }
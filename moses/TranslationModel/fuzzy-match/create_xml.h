@@ -2,4 +2,12 @@
 
 #include <string>
 
-void create_xml(const std::string &inPath);
+class CreateXMLRetValues
+{
+public:
+  std::string frame, ruleS, ruleT, ruleAlignment, ruleAlignmentInv;
+};
+
+/* build the hierarchical rule that turns a tm source sentence into the
+ input, given the edit path between them (terminated by an 'X') */
+CreateXMLRetValues createXML(int ruleCount, const std::string &source, const std::string &input, const std::string &target, const std::string &align, const std::string &path);
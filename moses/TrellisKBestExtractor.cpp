@@ -0,0 +1,217 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2014 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "TrellisKBestExtractor.h"
+
+#include "util/exception.hh"
+
+#include <cassert>
+#include <vector>
+
+using namespace std;
+
+namespace Moses
+{
+
+TrellisKBestExtractor::TrellisKBestExtractor(
+  const std::vector<const Hypothesis*> &finalHypos)
+  : m_finalHypos(finalHypos)
+  , m_target(NULL)
+{
+}
+
+// Get the k-th best full derivation, filling the lists as far as needed.
+boost::shared_ptr<const TrellisKBestExtractor::Derivation>
+TrellisKBestExtractor::Get(std::size_t k)
+{
+  LazyKthBest(m_target, k + 1);
+  if (k < m_target.kBestList.size()) {
+    return m_target.kBestList[k];
+  }
+  return boost::shared_ptr<const Derivation>();
+}
+
+void TrellisKBestExtractor::GetEdges(const Derivation &d,
+                                     std::vector<const Hypothesis*> &edges)
+{
+  edges.clear();
+  for (const Derivation *p = &d; p != NULL; p = p->prefix.get()) {
+    edges.push_back(p->edge);
+  }
+}
+
+// Generate the target-side yield of the derivation d, restricted to the
+// output factors.
+Phrase TrellisKBestExtractor::GetOutputPhrase(
+  const Derivation &d, const std::vector<FactorType> &outputFactors)
+{
+  std::vector<const Hypothesis*> edges;
+  GetEdges(d, edges);
+
+  Phrase ret(ARRAY_SIZE_INCR);
+  // don't do the empty hypo at the back
+  for (int node = (int) edges.size() - 2; node >= 0; --node) {
+    const TargetPhrase &phrase = edges[node]->GetCurrTargetPhrase();
+    for (std::size_t pos = 0; pos < phrase.GetSize(); ++pos) {
+      Word &newWord = ret.AddWord();
+      for (std::size_t i = 0; i < outputFactors.size(); ++i) {
+        const FactorType factorType = outputFactors[i];
+        const Factor *factor = phrase.GetFactor(pos, factorType);
+        UTIL_THROW_IF2(factor == NULL,
+                       "No factor " << factorType << " at position " << pos);
+        newWord[factorType] = factor;
+      }
+    }
+  }
+  return ret;
+}
+
+// Look for the vertex corresponding to a given winning Hypothesis, creating
+// a new one if necessary.
+TrellisKBestExtractor::Vertex &
+TrellisKBestExtractor::FindOrCreateVertex(const Hypothesis &h)
+{
+  VertexMap::value_type element(&h, boost::shared_ptr<Vertex>());
+  std::pair<VertexMap::iterator, bool> p = m_vertexMap.insert(element);
+  boost::shared_ptr<Vertex> &sp = p.first->second;
+  if (p.second) {
+    sp.reset(new Vertex(&h));
+  }
+  return *sp;
+}
+
+// Create the 1-best derivation that ends at edge and add it to v's
+// candidate queue.
+void TrellisKBestExtractor::AddCandidate(Vertex &v, const Hypothesis &edge)
+{
+  Vertex *tail = NULL;
+  // Hypotheses are only expanded from pruned and recombined stacks, so the
+  // predecessor of an edge is always a winning hypothesis.
+  if (const Hypothesis *prevHypo = edge.GetPrevHypo()) {
+    tail = &FindOrCreateVertex(*prevHypo);
+    LazyKthBest(*tail, 1);
+    if (tail->kBestList.empty()) {
+      return;
+    }
+  }
+  v.candidates.push(boost::shared_ptr<Derivation>(new Derivation(edge, tail)));
+}
+
+// Create the 1-best derivation for each edge in BS(v) and add it to v's
+// candidate queue.  The queue never holds more than one derivation per edge.
+void TrellisKBestExtractor::GetCandidates(Vertex &v)
+{
+  std::vector<const Hypothesis*> heads;
+  if (v.hypothesis) {
+    heads.push_back(v.hypothesis);
+  } else {
+    heads = m_finalHypos;
+  }
+
+  for (std::size_t i = 0; i < heads.size(); ++i) {
+    const Hypothesis &head = *heads[i];
+    AddCandidate(v, head);
+    const ArcList *arcList = head.GetArcList();
+    if (arcList) {
+      for (std::size_t j = 0; j < arcList->size(); ++j) {
+        AddCandidate(v, *(*arcList)[j]);
+      }
+    }
+  }
+}
+
+// Lazily fill v's k-best list.
+void TrellisKBestExtractor::LazyKthBest(Vertex &v, std::size_t k)
+{
+  if (v.exhausted) {
+    return;
+  }
+  // If this is the first visit to vertex v then initialize the priority queue.
+  if (v.visited == false) {
+    GetCandidates(v);
+    v.visited = true;
+  }
+  // Add derivations to the k-best list until it contains k or there are none
+  // left to add.
+  while (v.kBestList.size() < k) {
+    // Update the priority queue by adding the successor of the last
+    // derivation.
+    if (!v.kBestList.empty()) {
+      boost::shared_ptr<Derivation> d(v.kBestList.back());
+      LazyNext(v, *d);
+    }
+    // Check if there are any derivations left in the queue.
+    if (v.candidates.empty()) {
+      v.exhausted = true;
+      break;
+    }
+    // Get the next best derivation, delete it from the queue and add it to
+    // the k-best list.
+    v.kBestList.push_back(v.candidates.top());
+    v.candidates.pop();
+  }
+}
+
+// Create the neighbour of Derivation d and add it to v's candidate queue.
+// With a single tail per edge, it is the only one, so no derivation is
+// ever created twice.
+void TrellisKBestExtractor::LazyNext(Vertex &v, const Derivation &d)
+{
+  if (d.tail == NULL) {
+    return;
+  }
+  // Ensure that the tail's k-best list contains enough derivations.
+  std::size_t k = d.backPointer + 2;
+  LazyKthBest(*d.tail, k);
+  if (d.tail->kBestList.size() < k) {
+    // the tail's derivations have been exhausted.
+    return;
+  }
+  v.candidates.push(boost::shared_ptr<Derivation>(new Derivation(d, k - 1)));
+}
+
+// Construct the 1-best Derivation that ends at edge e.
+TrellisKBestExtractor::Derivation::Derivation(const Hypothesis &e, Vertex *t)
+  : edge(&e)
+  , tail(t)
+  , backPointer(0)
+{
+  if (tail) {
+    assert(tail->kBestList.size() >= 1);
+    prefix = tail->kBestList[0];
+    // recombined predecessors share their state, so the score of the edge
+    // does not depend on the path that leads to it
+    score = prefix->score + e.GetScore() - e.GetPrevHypo()->GetScore();
+  } else {
+    score = e.GetScore();
+  }
+}
+
+// Construct the Derivation that neighbours an existing Derivation, using the
+// j-th best derivation of its tail.
+TrellisKBestExtractor::Derivation::Derivation(const Derivation &d, std::size_t j)
+  : edge(d.edge)
+  , tail(d.tail)
+  , backPointer(j)
+  , prefix(d.tail->kBestList[j])
+  , score(d.score - d.prefix->score + prefix->score)
+{
+}
+
+}  // namespace Moses
@@ -0,0 +1,114 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2014 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include "Hypothesis.h"
+#include "Phrase.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <queue>
+#include <vector>
+
+namespace Moses
+{
+
+// k-best list extractor for the phrase-based search graph.  This is the
+// lattice case of algorithm 3 from
+//
+//  Liang Huang and David Chiang
+//  "Better k-best parsing"
+//  In Proceedings of IWPT 2005
+//
+// as ChartKBestExtractor implements it for hypergraphs.  A vertex is a
+// winning hypothesis, its incoming edges are the hypothesis itself and the
+// arcs recombined into it.  Every edge has a single tail, so a derivation is
+// an edge plus a pointer to a derivation of the tail vertex, and derivations
+// of a vertex share their prefixes with those of its predecessors.
+class TrellisKBestExtractor
+{
+public:
+  struct Vertex;
+
+  struct Derivation {
+    Derivation(const Hypothesis &, Vertex *);
+    Derivation(const Derivation &, std::size_t);
+
+    const Hypothesis *edge;    // the hypothesis or arc that ends the path
+    Vertex *tail;              // vertex of the edge's predecessor, or NULL
+    std::size_t backPointer;   // index into tail's k-best list
+    boost::shared_ptr<Derivation> prefix;
+    float score;
+  };
+
+  struct DerivationOrderer {
+    bool operator()(const boost::shared_ptr<Derivation> &d1,
+                    const boost::shared_ptr<Derivation> &d2) const {
+      return d1->score < d2->score;
+    }
+  };
+
+  struct Vertex {
+    typedef std::priority_queue<boost::shared_ptr<Derivation>,
+            std::vector<boost::shared_ptr<Derivation> >,
+            DerivationOrderer> DerivationQueue;
+
+    // hypothesis is NULL for the vertex above the final hypotheses
+    Vertex(const Hypothesis *h) : hypothesis(h), visited(false), exhausted(false) {}
+
+    const Hypothesis *hypothesis;
+    std::vector<boost::shared_ptr<Derivation> > kBestList;
+    DerivationQueue candidates;
+    bool visited;
+    bool exhausted;  // kBestList holds all of the vertex's derivations
+  };
+
+  // finalHypos are the winning hypotheses of the last stack.
+  TrellisKBestExtractor(const std::vector<const Hypothesis*> &finalHypos);
+
+  // Get the k-th best (0-based) derivation of a full translation, or NULL
+  // when the search graph has fewer derivations.  The lists are only
+  // extended as far as needed.
+  boost::shared_ptr<const Derivation> Get(std::size_t k);
+
+  // The hypotheses on a derivation, last one first, as in TrellisPath.
+  static void GetEdges(const Derivation &, std::vector<const Hypothesis*> &);
+
+  // The output factors of the target side of the derivation.
+  static Phrase GetOutputPhrase(const Derivation &,
+                                const std::vector<FactorType> &outputFactors);
+
+private:
+  typedef boost::unordered_map<const Hypothesis *,
+          boost::shared_ptr<Vertex> > VertexMap;
+
+  Vertex &FindOrCreateVertex(const Hypothesis &);
+  void AddCandidate(Vertex &, const Hypothesis &edge);
+  void GetCandidates(Vertex &);
+  void LazyKthBest(Vertex &, std::size_t);
+  void LazyNext(Vertex &, const Derivation &);
+
+  std::vector<const Hypothesis*> m_finalHypos;
+  Vertex m_target;
+  VertexMap m_vertexMap;
+};
+
+}  // namespace Moses
@@ -77,6 +77,13 @@ TrellisPath::TrellisPath(const TrellisPath &copy, size_t edgeIndex, const Hypoth
   InitTotalScore();
 }
 
+TrellisPath::TrellisPath(const TrellisKBestExtractor::Derivation &derivation)
+  :m_prevEdgeChanged(NOT_FOUND)
+{
+  TrellisKBestExtractor::GetEdges(derivation, m_path);
+  InitTotalScore();
+}
+
 TrellisPath::TrellisPath(const vector<const Hypothesis*> edges)
   :m_prevEdgeChanged(NOT_FOUND)
 {
@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <vector>
 #include <limits>
 #include "Hypothesis.h"
+#include "TrellisKBestExtractor.h"
 #include "TypeDef.h"
 #include <boost/shared_ptr.hpp>
 
@@ -76,6 +77,9 @@ public:
   	*/
   TrellisPath(const TrellisPath &copy, size_t edgeIndex, const Hypothesis *arc);
 
+  //! create path from a derivation of TrellisKBestExtractor
+  explicit TrellisPath(const TrellisKBestExtractor::Derivation &derivation);
+
   //! get score for this path throught trellis
   inline float GetFutureScore() const {
     return m_totalScore;
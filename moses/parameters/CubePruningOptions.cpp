@@ -9,6 +9,7 @@ namespace Moses
     : pop_limit(DEFAULT_CUBE_PRUNING_POP_LIMIT)
     , diversity(DEFAULT_CUBE_PRUNING_DIVERSITY)
     , lazy_scoring(false)
+    , lazy_batch_size(DEFAULT_CUBE_PRUNING_LAZY_BATCH_SIZE)
     , deterministic_search(false)
   {}
 
@@ -21,6 +22,8 @@ namespace Moses
     param.SetParameter(diversity, "cube-pruning-diversity",
 		       DEFAULT_CUBE_PRUNING_DIVERSITY);
     param.SetParameter(lazy_scoring, "cube-pruning-lazy-scoring", false);
+    param.SetParameter(lazy_batch_size, "cube-pruning-lazy-batch-size",
+		       DEFAULT_CUBE_PRUNING_LAZY_BATCH_SIZE);
     param.SetParameter(deterministic_search, "cube-pruning-deterministic-search", false);
     return true;
   }
@@ -54,6 +57,9 @@ namespace Moses
 	      }
 	    }
 
+      si = params.find("cube-pruning-lazy-batch-size");
+      if (si != params.end()) lazy_batch_size = xmlrpc_c::value_int(si->second);
+
       si = params.find("cube-pruning-deterministic-search");
       if (si != params.end())
       {
@@ -20,6 +20,7 @@ namespace Moses
     std::pair<std::string,std::string> xml_brackets; 
     // strings to use as XML tags' opening and closing brackets. 
     // Default are "<" and ">"
+    size_t threads; // threads that parse input ahead of decoding, 0 for none
 
     InputOptions();
 
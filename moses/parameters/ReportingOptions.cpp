@@ -22,6 +22,8 @@ namespace Moses {
     , PrintPassThrough(false)
     , include_lhs_in_search_graph(false)
     , lattice_sample_size(0)
+    , reorder_window(0)
+    , unordered(false)
   {
     factor_order.assign(1,0);
     factor_delimiter = "|";
@@ -103,6 +105,9 @@ namespace Moses {
       if (factor_order.empty()) factor_order.assign(1,0);
     }
     
+    param.SetParameter(reorder_window, "output-reorder-window", size_t(0));
+    param.SetParameter(unordered, "output-unordered", false);
+
     param.SetParameter(factor_delimiter, "factor-delimiter", std::string("|"));
     param.SetParameter(factor_delimiter, "output-factor-delimiter", factor_delimiter);
     
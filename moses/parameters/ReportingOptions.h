@@ -50,6 +50,9 @@ namespace Moses
     std::string lattice_sample_filepath; 
     size_t lattice_sample_size;
 
+    size_t reorder_window; // max. sentences ahead of the first unwritten one
+    bool unordered; // write translations as they finish, tagged with ids
+
     bool init(Parameter const& param);
 
     /// do we need to keep the search graph from decoding?
@@ -40,6 +40,7 @@ ServerOptions()
   , numThreads(15) // why 15?
   , sessionTimeout(1800) // = 30 min
   , sessionCacheSize(25)
+  , resultCacheSize(0)
   , port(8080)
   , maxConn(15)
   , maxConnBacklog(15)
@@ -78,6 +79,9 @@ init(Parameter const& P)
   this->sessionTimeout = parse_timespec(timeout_spec);
   P.SetParameter(this->sessionCacheSize, "session-cache_size", size_t(25));
 
+  // repeated requests are answered from this cache; 0 disables it
+  P.SetParameter(this->resultCacheSize, "server-result-cache-size", size_t(0));
+
   return true;
 }
 } // namespace Moses
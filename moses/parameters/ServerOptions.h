@@ -13,6 +13,7 @@ namespace Moses
     
     size_t sessionTimeout;   // this is related to Moses translation sessions
     size_t sessionCacheSize; // this is related to Moses translation sessions
+    size_t resultCacheSize;  // max. number of cached translation results
 
     int port;              // this is for the abyss server
     std::string logfile;   // this is for the abyss server
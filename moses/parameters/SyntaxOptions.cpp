@@ -15,6 +15,7 @@ namespace Moses {
     , default_non_term_only_for_empty_range(false)
     , source_label_overlap(SourceLabelOverlapAdd)
     , rule_limit(DEFAULT_MAX_TRANS_OPT_SIZE)
+    , chart_threads(1)
   { }
 
   bool
@@ -22,6 +23,7 @@ namespace Moses {
   init(Parameter const& param)
   {
     param.SetParameter(rule_limit, "rule-limit", DEFAULT_MAX_TRANS_OPT_SIZE);
+    param.SetParameter(chart_threads, "chart-threads", size_t(1));
     param.SetParameter(s2t_parsing_algo, "s2t-parsing-algorithm", 
                        RecursiveCYKPlus);
     param.SetParameter(default_non_term_only_for_empty_range,
@@ -22,6 +22,7 @@ namespace Moses
     UnknownLHSList unknown_lhs;
     SourceLabelOverlap source_label_overlap; // m_sourceLabelOverlap;
     size_t rule_limit;
+    size_t chart_threads; // threads working on one sentence
 
     SyntaxOptions();
 
@@ -1,4 +1,5 @@
 #include "Optimizer.h"
+#include "Server.h"
 #include <iostream>
 
 namespace MosesServer
@@ -6,7 +7,8 @@ namespace MosesServer
 using namespace std;
 
 Optimizer::
-Optimizer()
+Optimizer(Server& server)
+  : m_server(server)
 {
   // signature and help strings are documentation -- the client
   // can query this information with a system.methodSignature and
@@ -53,6 +55,7 @@ execute(xmlrpc_c::paramList const& paramList,
   // = (PhraseDictionaryMultiModel*) FindPhraseDictionary(model_name);
   PhraseDictionaryMultiModel* pdmm = FindPhraseDictionary(model_name);
   vector<float> weight_vector = pdmm->MinimizePerplexity(phrase_pairs);
+  m_server.result_cache().invalidate();
 
   vector<xmlrpc_c::value> weight_vector_ret;
   for (size_t i=0; i < weight_vector.size(); i++)
@@ -1,4 +1,5 @@
 // -*- c++ -*-
+#pragma once
 
 #include <xmlrpc-c/base.hpp>
 #include <xmlrpc-c/registry.hpp>
@@ -6,11 +7,14 @@
 
 namespace MosesServer
 {
+class Server;
+
 class
   Optimizer : public xmlrpc_c::method
 {
+  Server& m_server;
 public:
-  Optimizer();
+  Optimizer(Server& server);
   void execute(xmlrpc_c::paramList const& paramList,
                xmlrpc_c::value *   const  retvalP);
 };
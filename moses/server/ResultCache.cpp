@@ -0,0 +1,177 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#include "ResultCache.h"
+#include "moses/ContextScope.h"
+#include "moses/StaticData.h"
+#include "moses/Util.h"
+#include <sstream>
+
+namespace MosesServer
+{
+  using namespace std;
+
+  namespace
+  {
+    // Unambiguous rendering of a request parameter. Structs are std::maps,
+    // so their members come out in a canonical order.
+    void
+    serialize(xmlrpc_c::value const& v, ostream& out)
+    {
+      switch (v.type()) {
+      case xmlrpc_c::value::TYPE_INT:
+        out << 'i' << int(xmlrpc_c::value_int(v));
+        break;
+      case xmlrpc_c::value::TYPE_I8:
+        out << 'l' << (long long)(xmlrpc_c::value_i8(v));
+        break;
+      case xmlrpc_c::value::TYPE_BOOLEAN:
+        out << 'b' << bool(xmlrpc_c::value_boolean(v));
+        break;
+      case xmlrpc_c::value::TYPE_DOUBLE:
+        out << 'd' << double(xmlrpc_c::value_double(v));
+        break;
+      case xmlrpc_c::value::TYPE_STRING: {
+        string const s = xmlrpc_c::value_string(v);
+        out << 's' << s.size() << ':' << s;
+        break;
+      }
+      case xmlrpc_c::value::TYPE_ARRAY: {
+        vector<xmlrpc_c::value> const a
+          = xmlrpc_c::value_array(v).vectorValueValue();
+        out << 'a' << a.size() << '[';
+        for (size_t i = 0; i < a.size(); ++i) serialize(a[i], out);
+        out << ']';
+        break;
+      }
+      case xmlrpc_c::value::TYPE_STRUCT: {
+        typedef map<string, xmlrpc_c::value> tmap;
+        tmap const m = static_cast<tmap>(xmlrpc_c::value_struct(v));
+        out << 'm' << m.size() << '{';
+        for (tmap::const_iterator i = m.begin(); i != m.end(); ++i) {
+          out << i->first.size() << ':' << i->first;
+          serialize(i->second, out);
+        }
+        out << '}';
+        break;
+      }
+      default:
+        out << 't' << int(v.type());
+      }
+    }
+  }
+
+  ResultCache::
+  ResultCache(size_t capacity)
+    : m_capacity(capacity), m_generation(0), m_hits(0), m_misses(0)
+  { }
+
+  string
+  ResultCache::
+  make_key(map<string, xmlrpc_c::value> const& params,
+           Moses::ContextScope& scope)
+  {
+    ostringstream key;
+    key.precision(17);
+
+    // the input with whitespace normalized
+    map<string, xmlrpc_c::value>::const_iterator si = params.find("text");
+    if (si != params.end()) {
+      vector<string> const words
+        = Moses::Tokenize(string(xmlrpc_c::value_string(si->second)));
+      for (size_t i = 0; i < words.size(); ++i)
+        key << words[i] << ' ';
+    }
+    key << '\n';
+
+    // output options, multi-model weights etc.; the session id itself is
+    // irrelevant, only the weights of its scope are
+    for (si = params.begin(); si != params.end(); ++si) {
+      if (si->first == "text" || si->first == "session-id") continue;
+      key << si->first.size() << ':' << si->first;
+      serialize(si->second, key);
+    }
+    key << '\n';
+
+    SPTR<map<string, float> const> cw = scope.GetContextWeights();
+    if (cw) {
+      map<string, float>::const_iterator i;
+      for (i = cw->begin(); i != cw->end(); ++i)
+        key << i->first.size() << ':' << i->first << '=' << i->second << ' ';
+    }
+    return key.str();
+  }
+
+  uint64_t
+  ResultCache::
+  generation() const
+  {
+#ifdef WITH_THREADS
+    boost::lock_guard<boost::mutex> lock(m_lock);
+#endif
+    return m_generation;
+  }
+
+  bool
+  ResultCache::
+  lookup(string const& key, result_t& result)
+  {
+#ifdef WITH_THREADS
+    boost::lock_guard<boost::mutex> lock(m_lock);
+#endif
+    boost::unordered_map<string, entries_t::iterator>::iterator m
+      = m_index.find(key);
+    bool const hit = m != m_index.end();
+    if (hit) {
+      ++m_hits;
+      m_entries.splice(m_entries.begin(), m_entries, m->second);
+      result = m->second->second;
+    } else {
+      ++m_misses;
+    }
+    if ((m_hits + m_misses) % 1000 == 0) report();
+    return hit;
+  }
+
+  void
+  ResultCache::
+  insert(string const& key, uint64_t generation, result_t const& result)
+  {
+#ifdef WITH_THREADS
+    boost::lock_guard<boost::mutex> lock(m_lock);
+#endif
+    // computed with models or weights that have changed since
+    if (generation != m_generation) return;
+    if (m_index.find(key) != m_index.end()) return;
+
+    m_entries.push_front(make_pair(key, result));
+    m_index[key] = m_entries.begin();
+    if (m_entries.size() > m_capacity) {
+      m_index.erase(m_entries.back().first);
+      m_entries.pop_back();
+    }
+  }
+
+  void
+  ResultCache::
+  invalidate()
+  {
+#ifdef WITH_THREADS
+    boost::lock_guard<boost::mutex> lock(m_lock);
+#endif
+    ++m_generation;
+    m_entries.clear();
+    m_index.clear();
+    XVERBOSE(1, "Result cache invalidated" << endl);
+    report();
+  }
+
+  void
+  ResultCache::
+  report() const
+  {
+    uint64_t const total = m_hits + m_misses;
+    XVERBOSE(1, "Result cache: " << m_entries.size() << " entries, "
+             << m_hits << " hits in " << total << " lookups ("
+             << (total ? 100.0 * m_hits / total : 0.0) << "%)" << endl);
+  }
+
+}
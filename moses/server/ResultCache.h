@@ -0,0 +1,70 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#pragma once
+#include <list>
+#include <map>
+#include <string>
+#include <stdint.h>
+#include <boost/unordered_map.hpp>
+#include <xmlrpc-c/base.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#endif
+
+namespace Moses
+{
+class ContextScope;
+}
+
+namespace MosesServer
+{
+
+  // LRU cache of translation results, so that repeated requests (UI strings,
+  // boilerplate) don't go through the decoder again. The key covers the
+  // normalized input and everything else in the request that can change the
+  // result; the cache is cleared whenever the models or weights are updated.
+  class ResultCache
+  {
+  public:
+    typedef std::map<std::string, xmlrpc_c::value> result_t;
+
+    ResultCache(size_t capacity);
+
+    bool enabled() const { return m_capacity > 0; }
+
+    // key for a translation request in the given session scope
+    static std::string
+    make_key(std::map<std::string, xmlrpc_c::value> const& params,
+             Moses::ContextScope& scope);
+
+    // current generation, to be passed to insert() for a result
+    // computed from now on
+    uint64_t generation() const;
+
+    // copy the cached result for key into result; false if there is none
+    bool lookup(std::string const& key, result_t& result);
+
+    // result is dropped if the cache was invalidated since generation
+    void insert(std::string const& key, uint64_t generation,
+                result_t const& result);
+
+    // drop everything, eg. after the weights or models changed
+    void invalidate();
+
+  private:
+    typedef std::list<std::pair<std::string, result_t> > entries_t;
+
+    size_t const m_capacity;
+    entries_t m_entries; // most recently used first
+    boost::unordered_map<std::string, entries_t::iterator> m_index;
+    uint64_t m_generation;
+    uint64_t m_hits, m_misses;
+#ifdef WITH_THREADS
+    mutable boost::mutex m_lock;
+#endif
+
+    void report() const;
+  };
+
+}
@@ -7,8 +7,9 @@ namespace MosesServer
   Server::
   Server(Moses::Parameter& params)
     : m_server_options(params),
-      m_updater(new Updater),
-      m_optimizer(new Optimizer),
+      m_result_cache(m_server_options.resultCacheSize),
+      m_updater(new Updater(*this)),
+      m_optimizer(new Optimizer(*this)),
       m_translator(new Translator(*this)),
       m_close_session(new CloseSession(*this))
   {
@@ -73,6 +74,13 @@ namespace MosesServer
     return m_session_cache[session_id];
   }
 
+  ResultCache&
+  Server::
+  result_cache()
+  {
+    return m_result_cache;
+  }
+
   void
   Server::
   delete_session(uint64_t const session_id)
@@ -15,6 +15,7 @@
 #include "Updater.h"
 #include "CloseSession.h"
 #include "Session.h"
+#include "ResultCache.h"
 #include "moses/parameters/ServerOptions.h"
 #include <string>
 
@@ -24,6 +25,7 @@ namespace MosesServer
   {
     Moses::ServerOptions m_server_options;
     SessionCache   m_session_cache;
+    ResultCache    m_result_cache;
     xmlrpc_c::registry m_registry;
     xmlrpc_c::methodPtr const m_updater;
     xmlrpc_c::methodPtr const m_optimizer;
@@ -42,5 +44,8 @@ namespace MosesServer
     Session const& 
     get_session(uint64_t session_id);
 
+    ResultCache&
+    result_cache();
+
   };
 }
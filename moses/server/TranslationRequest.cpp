@@ -21,6 +21,7 @@ using Moses::TranslationOptionList;
 using Moses::TranslationOption;
 using Moses::TargetPhrase;
 using Moses::FValue;
+using Moses::FCoreVector;
 using Moses::PhraseDictionaryMultiModel;
 using Moses::FindPhraseDictionary;
 using Moses::Sentence;
@@ -64,10 +65,29 @@ Run()
   
   Moses::StaticData const& SD = Moses::StaticData::Instance();
 
-  if (is_syntax(m_options->search.algo))
-    run_chart_decoder();
-  else
-    run_phrase_decoder();
+  ResultCache& cache = m_translator->get_result_cache();
+  std::string cache_key;
+  uint64_t cache_generation = 0;
+  bool cached = false;
+  if (cache.enabled()) {
+    cache_key = ResultCache::make_key(params, *m_scope);
+    cache_generation = cache.generation();
+    cached = cache.lookup(cache_key, m_retData);
+  }
+
+  if (cached) {
+    // the result may have been computed in another session
+    m_retData.erase("session-id");
+    if (m_session_id)
+      m_retData["session-id"] = xmlrpc_c::value_int(m_session_id);
+  } else {
+    if (is_syntax(m_options->search.algo))
+      run_chart_decoder();
+    else
+      run_phrase_decoder();
+    if (cache.enabled())
+      cache.insert(cache_key, cache_generation, m_retData);
+  }
 
   {
     boost::lock_guard<boost::mutex> lock(m_mutex);
@@ -206,7 +226,7 @@ insertTranslationOptions(Moses::Manager& manager,
         toptXml["start"]  = xmlrpc_c::value_int(s);
         toptXml["end"]    = xmlrpc_c::value_int(e);
         vector<xmlrpc_c::value> scoresXml;
-        const std::valarray<FValue> &scores
+        const FCoreVector &scores
 	  = topt->GetScoreBreakdown().getCoreFeatures();
         for (size_t j = 0; j < scores.size(); ++j)
           scoresXml.push_back(xmlrpc_c::value_double(scores[j]));
@@ -45,4 +45,11 @@ get_session(uint64_t const id)
   return m_server.get_session(id);
 }
 
+ResultCache&
+Translator::
+get_result_cache()
+{
+  return m_server.result_cache();
+}
+
 }
@@ -3,6 +3,7 @@
 
 #include "moses/parameters/ServerOptions.h"
 #include "Session.h"
+#include "ResultCache.h"
 #include <xmlrpc-c/base.hpp>
 #include <xmlrpc-c/registry.hpp>
 #include <xmlrpc-c/server_abyss.hpp>
@@ -28,6 +29,8 @@ namespace MosesServer
 		 xmlrpc_c::value *   const  retvalP);
     
     Session const& get_session(uint64_t session_id);
+
+    ResultCache& get_result_cache();
   private:
     Moses::ThreadPool m_threadPool;
   };
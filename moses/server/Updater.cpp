@@ -1,5 +1,6 @@
 // -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
 #include "Updater.h"
+#include "Server.h"
 
 namespace MosesServer
 {
@@ -7,7 +8,8 @@ using namespace Moses;
 using namespace std;
 
 Updater::
-Updater()
+Updater(Server& server)
+  : m_server(server)
 {
   // signature and help strings are documentation -- the client
   // can query this information with a system.methodSignature and
@@ -26,6 +28,7 @@ execute(xmlrpc_c::paramList const& paramList,
   breakOutParams(params);
   Mmsapt* pdsa = reinterpret_cast<Mmsapt*>(PhraseDictionary::GetColl()[0]);
   pdsa->add(m_src, m_trg, m_aln);
+  m_server.result_cache().invalidate();
   XVERBOSE(1,"Done inserting\n");
   *retvalP = xmlrpc_c::value_string("Phrase table updated");
 #endif
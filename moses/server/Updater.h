@@ -19,9 +19,12 @@
 
 namespace MosesServer
 {
+class Server;
+
 class
   Updater: public xmlrpc_c::method
 {
+  Server& m_server;
 
   typedef std::map<std::string, xmlrpc_c::value> params_t;
 
@@ -30,7 +33,7 @@ class
   bool m_bounded, m_add2ORLM;
 
 public:
-  Updater();
+  Updater(Server& server);
 
   void
   execute(xmlrpc_c::paramList const& paramList,
@@ -0,0 +1,104 @@
+#include "CorpusReader.h"
+
+#include <cstdlib>
+#include <iostream>
+
+#include "util/exception.hh"
+#include "util/tokenize_piece.hh"
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+CorpusReader::CorpusReader(const std::string &targetFile,
+                           const std::string &sourceFile,
+                           const std::string &alignmentFile,
+                           Vocabulary &sourceVocab, Vocabulary &targetVocab)
+  : m_targetStream(targetFile)
+  , m_sourceStream(sourceFile)
+  , m_alignmentStream(alignmentFile)
+  , m_sourceVocab(sourceVocab)
+  , m_targetVocab(targetVocab)
+  , m_lineNum(0)
+{
+}
+
+bool CorpusReader::Read(std::vector<SentencePair> &batch, std::size_t size)
+{
+  batch.resize(size);
+  std::size_t i = 0;
+  for (; i < size && getline(m_targetStream, m_targetLine); ++i) {
+    ++m_lineNum;
+    if (m_lineNum%10000 == 0) {
+      std::cerr << "." << std::flush;
+    }
+    UTIL_THROW_IF(!getline(m_sourceStream, m_sourceLine) ||
+                  !getline(m_alignmentStream, m_alignmentLine),
+                  util::Exception,
+                  "source or alignment file is shorter than the target file");
+
+    SentencePair &sentence = batch[i];
+    sentence.lineNum = m_lineNum;
+    Tokenize(m_sourceLine, m_sourceVocab, sentence.source);
+    Tokenize(m_targetLine, m_targetVocab, sentence.target);
+    if (sentence.source.empty() || sentence.target.empty() ||
+        !ParseAlignment(sentence)) {
+      std::cerr << "WARNING: skipping sentence " << m_lineNum << std::endl;
+      sentence.source.clear();
+      sentence.target.clear();
+      sentence.alignment.clear();
+    }
+  }
+  batch.resize(i);
+  return i > 0;
+}
+
+void CorpusReader::Tokenize(const std::string &line, Vocabulary &vocab,
+                            std::vector<WordId> &words)
+{
+  words.clear();
+  for (util::TokenIter<util::AnyCharacter, true> it(line, util::AnyCharacter(" \t"));
+       it; ++it) {
+    it->CopyToString(&m_word);
+    words.push_back(vocab.Insert(m_word));
+  }
+}
+
+bool CorpusReader::ParseAlignment(SentencePair &sentence) const
+{
+  sentence.alignment.clear();
+  for (util::TokenIter<util::AnyCharacter, true> it(m_alignmentLine, util::AnyCharacter(" \t"));
+       it; ++it) {
+    // source-target
+    const char *begin = it->data();
+    char *end;
+    long s = std::strtol(begin, &end, 10);
+    if (end == begin || *end != '-') {
+      std::cerr << "WARNING: " << *it << " is a bad alignment point in sentence "
+                << sentence.lineNum << std::endl;
+      return false;
+    }
+    begin = end + 1;
+    long t = std::strtol(begin, &end, 10);
+    if (end == begin) {
+      std::cerr << "WARNING: " << *it << " is a bad alignment point in sentence "
+                << sentence.lineNum << std::endl;
+      return false;
+    }
+    if (s < 0 || t < 0 ||
+        static_cast<std::size_t>(s) >= sentence.source.size() ||
+        static_cast<std::size_t>(t) >= sentence.target.size()) {
+      std::cerr << "WARNING: sentence " << sentence.lineNum
+                << " has alignment point (" << s << ", " << t
+                << ") out of bounds (" << sentence.source.size() << ", "
+                << sentence.target.size() << ")" << std::endl;
+      return false;
+    }
+    sentence.alignment.push_back(std::make_pair(int(s), int(t)));
+  }
+  return true;
+}
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
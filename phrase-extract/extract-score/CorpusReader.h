@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "InputFileStream.h"
+
+#include "SentencePair.h"
+#include "Vocabulary.h"
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+// Reads the target, source and alignment files line by line and maps the
+// words to ids.  Lines with bad alignments are reported and come back as
+// empty sentence pairs.
+class CorpusReader
+{
+public:
+  CorpusReader(const std::string &targetFile, const std::string &sourceFile,
+               const std::string &alignmentFile,
+               Vocabulary &sourceVocab, Vocabulary &targetVocab);
+
+  // Fills batch with up to size sentence pairs, reusing its memory.
+  // Returns false if the corpus is exhausted.
+  bool Read(std::vector<SentencePair> &batch, std::size_t size);
+
+  std::size_t LineNum() const {
+    return m_lineNum;
+  }
+
+private:
+  void Tokenize(const std::string &line, Vocabulary &, std::vector<WordId> &);
+  bool ParseAlignment(SentencePair &) const;
+
+  Moses::InputFileStream m_targetStream;
+  Moses::InputFileStream m_sourceStream;
+  Moses::InputFileStream m_alignmentStream;
+  Vocabulary &m_sourceVocab;
+  Vocabulary &m_targetVocab;
+  std::size_t m_lineNum;
+  std::string m_targetLine;
+  std::string m_sourceLine;
+  std::string m_alignmentLine;
+  std::string m_word;
+};
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
@@ -0,0 +1,124 @@
+#include "ExtractPhrasePairs.h"
+
+#include <cstring>
+
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "moses/ThreadPool.h"
+#include "util/pcqueue.hh"
+
+#include "PhrasePairExtractor.h"
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+namespace
+{
+
+void ExtractChunk(const PairLayout &layout, ExtractPhrasePairs::Chunk &chunk)
+{
+  PhrasePairExtractor extractor(layout);
+  chunk.records.clear();
+  for (std::size_t i = 0; i < chunk.sentences.size(); ++i) {
+    if (!chunk.sentences[i].source.empty()) {
+      extractor.Extract(chunk.sentences[i], chunk.records);
+    }
+  }
+}
+
+#ifdef WITH_THREADS
+class ExtractTask : public Moses::Task
+{
+public:
+  ExtractTask(const PairLayout &layout, ExtractPhrasePairs::Chunk &chunk,
+              util::PCQueue<ExtractPhrasePairs::Chunk*> &done)
+    : m_layout(layout), m_chunk(chunk), m_done(done) {}
+
+  virtual void Run() {
+    ExtractChunk(m_layout, m_chunk);
+    m_done.Produce(&m_chunk);
+  }
+
+private:
+  const PairLayout &m_layout;
+  ExtractPhrasePairs::Chunk &m_chunk;
+  util::PCQueue<ExtractPhrasePairs::Chunk*> &m_done;
+};
+#endif
+
+}  // namespace
+
+ExtractPhrasePairs::ExtractPhrasePairs(CorpusReader &reader,
+                                       const PairLayout &layout,
+                                       std::size_t threads)
+  : m_reader(reader)
+  , m_layout(layout)
+  , m_threads(threads)
+  , m_count(0)
+{
+}
+
+void ExtractPhrasePairs::Run(const util::stream::ChainPosition &position)
+{
+  util::stream::Stream out(position);
+
+#ifdef WITH_THREADS
+  if (m_threads > 1) {
+    // Two chunks per thread keep the workers busy while this thread reads
+    // the next chunk or copies a finished one into the chain.
+    boost::ptr_vector<Chunk> chunks;
+    std::vector<Chunk*> free;
+    for (std::size_t i = 0; i < 2 * m_threads; ++i) {
+      chunks.push_back(new Chunk);
+      free.push_back(&chunks.back());
+    }
+    util::PCQueue<Chunk*> done(chunks.size());
+    Moses::ThreadPool pool(m_threads);
+
+    bool more = true;
+    while (true) {
+      if (more && !free.empty()) {
+        Chunk *chunk = free.back();
+        more = m_reader.Read(chunk->sentences, kChunkSentences);
+        if (more) {
+          free.pop_back();
+          pool.Submit(boost::shared_ptr<Moses::Task>(
+                        new ExtractTask(m_layout, *chunk, done)));
+        }
+        continue;
+      }
+      if (free.size() == chunks.size()) {
+        break;
+      }
+      Chunk *chunk = done.Consume();
+      Write(*chunk, out);
+      free.push_back(chunk);
+    }
+    out.Poison();
+    return;
+  }
+#endif
+
+  Chunk chunk;
+  while (m_reader.Read(chunk.sentences, kChunkSentences)) {
+    ExtractChunk(m_layout, chunk);
+    Write(chunk, out);
+  }
+  out.Poison();
+}
+
+void ExtractPhrasePairs::Write(const Chunk &chunk, util::stream::Stream &out)
+{
+  const std::size_t size = m_layout.Size();
+  for (std::size_t offset = 0; offset < chunk.records.size(); offset += size) {
+    std::memcpy(out.Get(), &chunk.records[offset], size);
+    ++out;
+    ++m_count;
+  }
+}
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "util/stream/stream.hh"
+
+#include "CorpusReader.h"
+#include "PhrasePair.h"
+#include "SentencePair.h"
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+// Head of the first chain: reads the corpus and writes a record for every
+// extracted phrase pair.  The chain thread does the reading and copying,
+// while the extraction itself runs on a pool of worker threads, on a bounded
+// number of chunks of sentences at a time.
+class ExtractPhrasePairs
+{
+public:
+  ExtractPhrasePairs(CorpusReader &reader, const PairLayout &layout,
+                     std::size_t threads);
+
+  void Run(const util::stream::ChainPosition &position);
+
+  // Number of records written.
+  uint64_t Count() const {
+    return m_count;
+  }
+
+  struct Chunk {
+    std::vector<SentencePair> sentences;
+    std::vector<char> records;
+  };
+
+private:
+  static const std::size_t kChunkSentences = 256;
+
+  void Write(const Chunk &, util::stream::Stream &out);
+
+  CorpusReader &m_reader;
+  PairLayout m_layout;
+  std::size_t m_threads;
+  uint64_t m_count;
+};
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
@@ -0,0 +1,277 @@
+#include "ExtractScore.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <boost/program_options.hpp>
+#include <boost/ref.hpp>
+
+#include "util/stream/chain.hh"
+#include "util/stream/config.hh"
+#include "util/stream/sort.hh"
+#include "util/usage.hh"
+
+#include "InputFileStream.h"
+#include "OutputFileStream.h"
+
+#include "CorpusReader.h"
+#include "ExtractPhrasePairs.h"
+#include "LexicalTable.h"
+#include "MergePairs.h"
+#include "TableWriter.h"
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+namespace
+{
+
+struct VocabOrder {
+  explicit VocabOrder(const Vocabulary &vocab) : m_vocab(vocab) {}
+  bool operator()(WordId a, WordId b) const {
+    return m_vocab.Lookup(a) < m_vocab.Lookup(b);
+  }
+  const Vocabulary &m_vocab;
+};
+
+}  // namespace
+
+int ExtractScore::Main(int argc, char *argv[])
+{
+  // Process command-line options.
+  ProcessOptions(argc, argv, m_options);
+
+  // Load lexical tables.  This also starts the vocabularies.
+  Vocabulary sourceVocab;
+  Vocabulary targetVocab;
+  LexicalTable lexF2E(sourceVocab, targetVocab);
+  LexicalTable lexE2F(targetVocab, sourceVocab);
+  {
+    std::cerr << "Loading lexical translation table from "
+              << m_options.lexF2EFile;
+    Moses::InputFileStream lexStream(m_options.lexF2EFile);
+    lexF2E.Load(lexStream);
+  }
+  {
+    std::cerr << "Loading lexical translation table from "
+              << m_options.lexE2FFile;
+    Moses::InputFileStream lexStream(m_options.lexE2FFile);
+    lexE2F.Load(lexStream);
+  }
+
+  // Open output files.
+  Moses::OutputFileStream tableStream;
+  Moses::OutputFileStream reorderingStream;
+  OpenOutputFileOrDie(m_options.tableFile, tableStream);
+  if (!m_options.reorderingFile.empty()) {
+    OpenOutputFileOrDie(m_options.reorderingFile, reorderingStream);
+  }
+
+  // Memory: the first phase has one chain.  The later ones have up to two
+  // chains and the lazy merge of a sort, which takes about half.
+  const PairLayout layout(m_options.maxPhraseLength);
+  const std::size_t memory = util::ParseSize(m_options.memory);
+  util::stream::SortConfig sortConfig;
+  sortConfig.temp_prefix = m_options.tempPrefix;
+  sortConfig.buffer_size = std::min<std::size_t>(64 << 20, memory / 8);
+  sortConfig.total_memory = memory / 2;
+  sortConfig.threads = m_options.threads;
+  const util::stream::ChainConfig firstChainConfig(layout.Size(), 2, memory / 2);
+  const util::stream::ChainConfig chainConfig(layout.Size(), 2, memory / 4);
+
+  // Extract and sort by target phrase.
+  CorpusReader reader(m_options.targetFile, m_options.sourceFile,
+                      m_options.alignmentFile, sourceVocab, targetVocab);
+  ExtractPhrasePairs extractor(reader, layout, m_options.threads);
+  util::stream::Chain extraction(firstChainConfig);
+  extraction >> boost::ref(extractor);
+  util::stream::Sort<TargetOrder, CombinePairs> byTarget(
+    extraction, sortConfig, TargetOrder(layout));
+  extraction.Wait();
+  std::cerr << std::endl << "Extracted " << extractor.Count()
+            << " phrase pairs from " << reader.LineNum()
+            << " sentence pairs" << std::endl;
+
+  // The word ids follow the corpus.  Rank them so that the tables come out
+  // sorted.
+  std::vector<WordId> sourceRank;
+  std::vector<WordId> targetRank;
+  RankWords(sourceVocab, sourceRank);
+  RankWords(targetVocab, targetRank);
+
+  // Merge the occurrences of each pair, count c(e) and sort by source
+  // phrase.
+  std::cerr << "Merging phrase pairs" << std::endl;
+  util::stream::Chain byTargetChain(chainConfig);
+  util::stream::Chain pairs(chainConfig);
+  byTarget.Output(byTargetChain);
+  byTargetChain >> MergePairs(layout, pairs.Add()) >> util::stream::kRecycle;
+  util::stream::Sort<SourceOrder> bySource(
+    pairs, sortConfig, SourceOrder(layout, sourceRank, targetRank));
+  byTargetChain.Wait();
+  pairs.Wait();
+
+  // Score and write the tables.
+  std::cerr << "Writing phrase table" << std::endl;
+  TableWriter writer(layout, sourceVocab, targetVocab, lexF2E, lexE2F,
+                     tableStream,
+                     m_options.reorderingFile.empty() ? NULL : &reorderingStream,
+                     m_options.reorderingSmoothing);
+  util::stream::Chain bySourceChain(chainConfig);
+  bySource.Output(bySourceChain);
+  bySourceChain >> boost::ref(writer) >> util::stream::kRecycle;
+  bySourceChain.Wait();
+
+  tableStream.Close();
+  if (!m_options.reorderingFile.empty()) {
+    reorderingStream.Close();
+  }
+  return 0;
+}
+
+void ExtractScore::RankWords(const Vocabulary &vocab,
+                             std::vector<WordId> &rank)
+{
+  std::vector<WordId> ids(vocab.Size());
+  for (std::size_t i = 0; i < ids.size(); ++i) {
+    ids[i] = i;
+  }
+  std::sort(ids.begin(), ids.end(), VocabOrder(vocab));
+  rank.resize(ids.size());
+  for (std::size_t i = 0; i < ids.size(); ++i) {
+    rank[ids[i]] = i;
+  }
+}
+
+void ExtractScore::ProcessOptions(int argc, char *argv[],
+                                  Options &options) const
+{
+  namespace po = boost::program_options;
+  namespace cls = boost::program_options::command_line_style;
+
+  // Construct the 'top' of the usage message: the bit that comes before the
+  // options list.
+  std::ostringstream usageTop;
+  usageTop << "Usage: " << name()
+           << " [OPTION]... TARGET SOURCE ALIGNMENT LEX_F2E LEX_E2F TABLE\n\n"
+           << "Phrase extraction and scoring in one pass over a word-aligned corpus.\n"
+           << "Writes the same phrase table as extract, score, score --Inverse and\n"
+           << "consolidate without extra options.\n\n"
+           << "Options";
+
+  // Construct the 'bottom' of the usage message.
+  std::ostringstream usageBottom;
+  usageBottom << "\nThe reordering table is the word-based msd-bidirectional-fe model with\n"
+              << "constant smoothing.";
+
+  // Declare the command line options that are visible to the user.
+  po::options_description visible(usageTop.str());
+  visible.add_options()
+  ("help",
+   "print this help message and exit")
+  ("MaxPhraseLength",
+   po::value(&options.maxPhraseLength)->
+   default_value(options.maxPhraseLength),
+   "maximum phrase length")
+  ("Memory",
+   po::value(&options.memory)->default_value(options.memory),
+   "memory for sorting, with a suffix like in lmplz -S")
+  ("Reordering",
+   po::value(&options.reorderingFile),
+   "also write a msd-bidirectional-fe reordering table to arg")
+  ("ReorderingSmoothing",
+   po::value(&options.reorderingSmoothing)->
+   default_value(options.reorderingSmoothing),
+   "constant added to the orientation counts")
+  ("TempPrefix",
+   po::value(&options.tempPrefix)->default_value(options.tempPrefix),
+   "prefix for the (unlinked) temporary files of the sorts")
+  ("Threads",
+   po::value(&options.threads)->default_value(options.threads),
+   "number of phrase extraction threads")
+  ;
+
+  // Declare the command line options that are hidden from the user
+  // (these are used as positional options).
+  po::options_description hidden("Hidden options");
+  hidden.add_options()
+  ("TargetFile",
+   po::value(&options.targetFile),
+   "target side of the corpus")
+  ("SourceFile",
+   po::value(&options.sourceFile),
+   "source side of the corpus")
+  ("AlignmentFile",
+   po::value(&options.alignmentFile),
+   "word alignment")
+  ("LexF2EFile",
+   po::value(&options.lexF2EFile),
+   "lexical probability file lex.f2e")
+  ("LexE2FFile",
+   po::value(&options.lexE2FFile),
+   "lexical probability file lex.e2f")
+  ("TableFile",
+   po::value(&options.tableFile),
+   "output file")
+  ;
+
+  // Compose the full set of command-line options.
+  po::options_description cmdLineOptions;
+  cmdLineOptions.add(visible).add(hidden);
+
+  // Register the positional options.
+  po::positional_options_description p;
+  p.add("TargetFile", 1);
+  p.add("SourceFile", 1);
+  p.add("AlignmentFile", 1);
+  p.add("LexF2EFile", 1);
+  p.add("LexE2FFile", 1);
+  p.add("TableFile", 1);
+
+  // Process the command-line.
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).style(MosesOptionStyle()).
+              options(cmdLineOptions).positional(p).run(), vm);
+    po::notify(vm);
+  } catch (const std::exception &e) {
+    std::ostringstream msg;
+    msg << e.what() << "\n\n" << visible << usageBottom.str();
+    Error(msg.str());
+  }
+
+  if (vm.count("help")) {
+    std::cout << visible << usageBottom.str() << std::endl;
+    std::exit(0);
+  }
+
+  // Check all positional options were given.
+  if (!vm.count("TargetFile") ||
+      !vm.count("SourceFile") ||
+      !vm.count("AlignmentFile") ||
+      !vm.count("LexF2EFile") ||
+      !vm.count("LexE2FFile") ||
+      !vm.count("TableFile")) {
+    std::cerr << visible << usageBottom.str() << std::endl;
+    std::exit(1);
+  }
+
+  if (options.maxPhraseLength == 0 ||
+      options.maxPhraseLength > kMaxPhraseLength) {
+    std::ostringstream msg;
+    msg << "MaxPhraseLength must be between 1 and "
+        << kMaxPhraseLength;
+    Error(msg.str());
+  }
+  if (options.threads == 0) {
+    Error("Threads must be at least 1");
+  }
+}
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include "syntax-common/tool.h"
+
+#include "Options.h"
+#include "PhrasePair.h"
+#include "Vocabulary.h"
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+// Builds a phrase table (and optionally a reordering table) from a
+// word-aligned corpus in one run, instead of extract, sort, score (twice) and
+// consolidate.  Phrase pairs never go through text: they are fixed-size
+// records in util::stream chains, sorted with bounded memory and unlinked
+// temporary files.
+//
+//   1. extract, in parallel           -> sort by target phrase
+//   2. merge occurrences, count c(e)  -> sort by source phrase
+//   3. count c(f), score and write the tables
+class ExtractScore : public Syntax::Tool
+{
+public:
+  ExtractScore() : Syntax::Tool("extract-score") {}
+
+  virtual int Main(int argc, char *argv[]);
+
+private:
+  void ProcessOptions(int, char *[], Options &) const;
+
+  // rank[id] is the position of word id in byte order.
+  static void RankWords(const Vocabulary &, std::vector<WordId> &rank);
+
+  Options m_options;
+};
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
@@ -0,0 +1,92 @@
+#include "LexicalTable.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "util/tokenize_piece.hh"
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+LexicalTable::LexicalTable(Vocabulary &givenVocab, Vocabulary &predictedVocab)
+  : m_givenVocab(givenVocab)
+  , m_predictedVocab(predictedVocab)
+  , m_null(Vocabulary::NullId())
+{
+}
+
+void LexicalTable::Load(std::istream &input)
+{
+  const util::AnyCharacter delimiter(" \t");
+
+  std::string line;
+  std::string tmp;
+  int i = 0;
+  while (getline(input, line)) {
+    ++i;
+    if (i%100000 == 0) {
+      std::cerr << ".";
+    }
+
+    util::TokenIter<util::AnyCharacter, true> it(line, delimiter);
+
+    // Predicted word.
+    it->CopyToString(&tmp);
+    WordId predicted = m_predictedVocab.Insert(tmp);
+    ++it;
+
+    // Given word.
+    it->CopyToString(&tmp);
+    WordId given = m_givenVocab.Insert(tmp);
+    ++it;
+
+    // Probability.
+    it->CopyToString(&tmp);
+    m_table[Key(given, predicted)] = std::atof(tmp.c_str());
+  }
+  std::cerr << std::endl;
+
+  m_null = m_givenVocab.Lookup("NULL");
+}
+
+double LexicalTable::Weight(const WordId *given, const WordId *predicted,
+                            std::size_t predictedLength,
+                            const AlignMask *alignment,
+                            std::size_t givenLength, bool givenIsSource) const
+{
+  // all predicted words have to be explained
+  double weight = 1.0;
+  for (std::size_t p = 0; p < predictedLength; ++p) {
+    double sum = 0.0;
+    std::size_t aligned = 0;
+    if (givenIsSource) {
+      for (std::size_t g = 0; g < givenLength; ++g) {
+        if (alignment[g] & (1 << p)) {
+          sum += PermissiveLookup(given[g], predicted[p]);
+          ++aligned;
+        }
+      }
+    } else {
+      for (std::size_t g = 0; g < givenLength; ++g) {
+        if (alignment[p] & (1 << g)) {
+          sum += PermissiveLookup(given[g], predicted[p]);
+          ++aligned;
+        }
+      }
+    }
+    if (aligned) {
+      // average over the aligned words
+      weight *= sum / aligned;
+    } else {
+      // explain unaligned word by NULL
+      weight *= PermissiveLookup(m_null, predicted[p]);
+    }
+  }
+  return weight;
+}
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
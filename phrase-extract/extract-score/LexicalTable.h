@@ -0,0 +1,52 @@
+#pragma once
+
+#include <istream>
+
+#include <boost/unordered_map.hpp>
+
+#include "PhrasePair.h"
+#include "Vocabulary.h"
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+// Word translation probabilities w(predicted|given), as in the lex.f2e and
+// lex.e2f files written by train-model.perl.
+class LexicalTable
+{
+public:
+  LexicalTable(Vocabulary &givenVocab, Vocabulary &predictedVocab);
+
+  // Reads lines "predicted given probability".
+  void Load(std::istream &);
+
+  // Returns 1.0 for unknown word pairs, like score does.
+  double PermissiveLookup(WordId given, WordId predicted) const {
+    Table::const_iterator p = m_table.find(Key(given, predicted));
+    return p == m_table.end() ? 1.0 : p->second;
+  }
+
+  // Lexical weight of the predicted phrase given the other phrase of the
+  // pair.  alignment holds one AlignMask per given position if
+  // givenIsSource, and one per predicted position otherwise.
+  double Weight(const WordId *given, const WordId *predicted,
+                std::size_t predictedLength, const AlignMask *alignment,
+                std::size_t givenLength, bool givenIsSource) const;
+
+private:
+  typedef boost::unordered_map<uint64_t, double> Table;
+
+  static uint64_t Key(WordId given, WordId predicted) {
+    return (static_cast<uint64_t>(given) << 32) | predicted;
+  }
+
+  Vocabulary &m_givenVocab;
+  Vocabulary &m_predictedVocab;
+  Table m_table;
+  WordId m_null;
+};
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
@@ -0,0 +1,143 @@
+#include "MergePairs.h"
+
+#include <cstring>
+
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+namespace
+{
+
+// Compares two sets of positions, given as bit masks, like std::set does.
+bool SetLess(uint32_t a, uint32_t b)
+{
+  const uint32_t differ = a ^ b;
+  if (!differ) {
+    return false;
+  }
+  // the lowest position in only one of them
+  const uint32_t lowest = differ & -differ;
+  // the set without it is smaller if it ends there
+  const uint32_t above = ~((lowest << 1) - 1);
+  return (a & lowest) ? (b & above) != 0 : !(a & above);
+}
+
+// The order of score's target-to-source alignments: by the set of source
+// positions of each target position.
+bool TargetToSourceLess(const AlignMask *a, const AlignMask *b,
+                        std::size_t maxLength)
+{
+  for (std::size_t t = 0; t < maxLength; ++t) {
+    uint32_t setA = 0, setB = 0;
+    for (std::size_t s = 0; s < maxLength; ++s) {
+      setA |= ((a[s] >> t) & 1) << s;
+      setB |= ((b[s] >> t) & 1) << s;
+    }
+    if (setA != setB) {
+      return SetLess(setA, setB);
+    }
+  }
+  return false;
+}
+
+// The same for score --Inverse, which sees the source positions as target.
+bool SourceToTargetLess(const AlignMask *a, const AlignMask *b,
+                        std::size_t maxLength)
+{
+  for (std::size_t s = 0; s < maxLength; ++s) {
+    if (a[s] != b[s]) {
+      return SetLess(a[s], b[s]);
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+MergePairs::MergePairs(const PairLayout &layout,
+                       const util::stream::ChainPosition &output)
+  : m_layout(layout)
+  , m_output(output)
+  , m_run(layout.Size())
+  , m_runCount(0)
+  , m_bestCount(0)
+  , m_bestInverseCount(0)
+{
+}
+
+void MergePairs::Run(const util::stream::ChainPosition &position)
+{
+  util::stream::Stream out(m_output);
+  for (util::stream::Stream in(position); in; ++in) {
+    if (!m_group.empty() &&
+        !m_layout.SameTarget(&m_group[m_group.size() - m_layout.Size()], in.Get())) {
+      Flush(out);
+    }
+    Add(in.Get());
+  }
+  Flush(out);
+  out.Poison();
+}
+
+void MergePairs::Add(const void *record)
+{
+  const std::size_t size = m_layout.Size();
+  const float count = m_layout.Value(record).count;
+  void *last = m_group.empty() ? NULL : &m_group[m_group.size() - size];
+
+  if (last && m_layout.SameSource(last, record)) {
+    // another occurrence of the last pair
+    m_layout.AddCounts(last, record);
+    if (m_layout.SameAlignment(&m_run[0], record)) {
+      m_runCount += count;
+    } else {
+      std::memcpy(&m_run[0], record, size);
+      m_runCount = count;
+    }
+    // keep the most frequent alignment, on ties the greatest one in the order
+    // of score and score --Inverse respectively
+    const std::size_t maxLength = m_layout.MaxLength();
+    const AlignMask *run = m_layout.Alignment(&m_run[0]);
+    AlignMask *best = m_layout.Alignment(last);
+    AlignMask *bestInverse = m_layout.InverseAlignment(last);
+    if (m_runCount > m_bestCount ||
+        (m_runCount == m_bestCount &&
+         TargetToSourceLess(best, run, maxLength))) {
+      m_bestCount = m_runCount;
+      std::memcpy(best, run, maxLength * sizeof(AlignMask));
+    }
+    if (m_runCount > m_bestInverseCount ||
+        (m_runCount == m_bestInverseCount &&
+         SourceToTargetLess(bestInverse, run, maxLength))) {
+      m_bestInverseCount = m_runCount;
+      std::memcpy(bestInverse, run, maxLength * sizeof(AlignMask));
+    }
+    return;
+  }
+
+  m_group.resize(m_group.size() + size);
+  std::memcpy(&m_group[m_group.size() - size], record, size);
+  std::memcpy(&m_run[0], record, size);
+  m_runCount = m_bestCount = m_bestInverseCount = count;
+}
+
+void MergePairs::Flush(util::stream::Stream &out)
+{
+  const std::size_t size = m_layout.Size();
+  float targetCount = 0;
+  for (std::size_t offset = 0; offset < m_group.size(); offset += size) {
+    targetCount += m_layout.Value(&m_group[offset]).count;
+  }
+  for (std::size_t offset = 0; offset < m_group.size(); offset += size) {
+    m_layout.Value(&m_group[offset]).targetCount = targetCount;
+    std::memcpy(out.Get(), &m_group[offset], size);
+    ++out;
+  }
+  m_group.clear();
+}
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include "util/stream/stream.hh"
+
+#include "PhrasePair.h"
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+// Reads the extracted phrase pairs in TargetOrder, merges the occurrences of
+// each pair and writes one record per distinct pair to the output chain, with
+// the summed counts, its most frequent alignments and c(e).
+class MergePairs
+{
+public:
+  MergePairs(const PairLayout &layout,
+             const util::stream::ChainPosition &output);
+
+  void Run(const util::stream::ChainPosition &position);
+
+private:
+  void Add(const void *record);
+  void Flush(util::stream::Stream &out);
+
+  PairLayout m_layout;
+  util::stream::ChainPosition m_output;
+
+  // distinct pairs of the current target phrase
+  std::vector<char> m_group;
+  // the current alignment run of the last pair, and its count
+  std::vector<char> m_run;
+  float m_runCount;
+  // counts of the alignments picked for the last pair
+  float m_bestCount;
+  float m_bestInverseCount;
+};
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+struct Options {
+public:
+  Options()
+    : maxPhraseLength(7)
+    , reorderingSmoothing(0.5)
+    , threads(1)
+    , memory("1G")
+    , tempPrefix("/tmp/") {}
+
+  // Positional options
+  std::string targetFile;
+  std::string sourceFile;
+  std::string alignmentFile;
+  std::string lexF2EFile;
+  std::string lexE2FFile;
+  std::string tableFile;
+
+  // All other options
+  std::size_t maxPhraseLength;
+  std::string reorderingFile;
+  double reorderingSmoothing;
+  std::size_t threads;
+  std::string memory;
+  std::string tempPrefix;
+};
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include <stdint.h>
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+typedef uint32_t WordId;
+
+// Alignment of one source word: bit i is set if it is aligned to target
+// word i of the phrase.
+typedef uint16_t AlignMask;
+
+// Padding after the last word of a phrase.
+const WordId kNoWord = static_cast<WordId>(-1);
+
+const std::size_t kMaxPhraseLength = sizeof(AlignMask) * 8;
+
+// Counts and scores that travel with a phrase pair through the pipeline.
+struct PairValue {
+  // c(f,e)
+  float count;
+  // Word-based msd orientation counts: previous mono, swap and
+  // discontinuous, then the same for next.
+  float orientation[6];
+  // c(e), filled in once all pairs with the same target phrase are seen
+  float targetCount;
+};
+
+// The layout of a fixed-size phrase pair record in a util::stream chain:
+//
+//   PairValue | source words | target words | alignment | inverse alignment
+//
+// Both phrases are padded with kNoWord up to the maximum phrase length and
+// the alignments hold one AlignMask per source position.  The phrases and
+// the alignment are the key of a record.  The inverse alignment is only set
+// by MergePairs: score and score --Inverse may each pick a different one of
+// the alignments of a pair for the lexical weights.
+class PairLayout
+{
+public:
+  explicit PairLayout(std::size_t maxLength)
+    : m_maxLength(maxLength)
+    , m_sourceOffset(sizeof(PairValue))
+    , m_targetOffset(m_sourceOffset + maxLength * sizeof(WordId))
+    , m_alignOffset(m_targetOffset + maxLength * sizeof(WordId))
+    , m_inverseAlignOffset(m_alignOffset + maxLength * sizeof(AlignMask))
+    , m_keySize(m_inverseAlignOffset - m_sourceOffset) {
+    // keep the floats of consecutive records aligned
+    m_size = m_inverseAlignOffset + maxLength * sizeof(AlignMask);
+    m_size += (sizeof(float) - m_size % sizeof(float)) % sizeof(float);
+  }
+
+  std::size_t MaxLength() const {
+    return m_maxLength;
+  }
+  std::size_t Size() const {
+    return m_size;
+  }
+
+  PairValue &Value(void *record) const {
+    return *static_cast<PairValue*>(record);
+  }
+  const PairValue &Value(const void *record) const {
+    return *static_cast<const PairValue*>(record);
+  }
+
+  WordId *Source(void *record) const {
+    return reinterpret_cast<WordId*>(static_cast<char*>(record) + m_sourceOffset);
+  }
+  const WordId *Source(const void *record) const {
+    return reinterpret_cast<const WordId*>(static_cast<const char*>(record) + m_sourceOffset);
+  }
+
+  WordId *Target(void *record) const {
+    return reinterpret_cast<WordId*>(static_cast<char*>(record) + m_targetOffset);
+  }
+  const WordId *Target(const void *record) const {
+    return reinterpret_cast<const WordId*>(static_cast<const char*>(record) + m_targetOffset);
+  }
+
+  AlignMask *Alignment(void *record) const {
+    return reinterpret_cast<AlignMask*>(static_cast<char*>(record) + m_alignOffset);
+  }
+  const AlignMask *Alignment(const void *record) const {
+    return reinterpret_cast<const AlignMask*>(static_cast<const char*>(record) + m_alignOffset);
+  }
+
+  AlignMask *InverseAlignment(void *record) const {
+    return reinterpret_cast<AlignMask*>(static_cast<char*>(record) + m_inverseAlignOffset);
+  }
+  const AlignMask *InverseAlignment(const void *record) const {
+    return reinterpret_cast<const AlignMask*>(static_cast<const char*>(record) + m_inverseAlignOffset);
+  }
+
+  // Number of words of a padded phrase.
+  std::size_t Length(const WordId *phrase) const {
+    return std::find(phrase, phrase + m_maxLength, kNoWord) - phrase;
+  }
+
+  bool SameSource(const void *a, const void *b) const {
+    return !std::memcmp(Source(a), Source(b), m_maxLength * sizeof(WordId));
+  }
+  bool SameTarget(const void *a, const void *b) const {
+    return !std::memcmp(Target(a), Target(b), m_maxLength * sizeof(WordId));
+  }
+  bool SameAlignment(const void *a, const void *b) const {
+    return !std::memcmp(Alignment(a), Alignment(b), m_maxLength * sizeof(AlignMask));
+  }
+  // Same phrases and alignment.
+  bool SameKey(const void *a, const void *b) const {
+    return !std::memcmp(Source(a), Source(b), m_keySize);
+  }
+
+  // Add the counts of other to those of into.
+  void AddCounts(void *into, const void *other) const {
+    PairValue &to = Value(into);
+    const PairValue &from = Value(other);
+    to.count += from.count;
+    for (std::size_t i = 0; i < 6; ++i) {
+      to.orientation[i] += from.orientation[i];
+    }
+  }
+
+private:
+  std::size_t m_maxLength;
+  std::size_t m_sourceOffset;
+  std::size_t m_targetOffset;
+  std::size_t m_alignOffset;
+  std::size_t m_inverseAlignOffset;
+  std::size_t m_keySize;
+  std::size_t m_size;
+};
+
+// Orders by target phrase, then source phrase, then alignment, so that the
+// occurrences of a phrase pair and the pairs of a target phrase are adjacent.
+// Word ids are compared as they are, which groups but does not sort
+// alphabetically.
+class TargetOrder
+{
+public:
+  explicit TargetOrder(const PairLayout &layout) : m_layout(layout) {}
+
+  const PairLayout &Layout() const {
+    return m_layout;
+  }
+
+  bool operator()(const void *a, const void *b) const {
+    const std::size_t length = m_layout.MaxLength();
+    const WordId *ta = m_layout.Target(a), *tb = m_layout.Target(b);
+    for (std::size_t i = 0; i < length; ++i) {
+      if (ta[i] != tb[i]) return ta[i] < tb[i];
+    }
+    const WordId *sa = m_layout.Source(a), *sb = m_layout.Source(b);
+    for (std::size_t i = 0; i < length; ++i) {
+      if (sa[i] != sb[i]) return sa[i] < sb[i];
+    }
+    return std::memcmp(m_layout.Alignment(a), m_layout.Alignment(b),
+                       length * sizeof(AlignMask)) < 0;
+  }
+
+private:
+  PairLayout m_layout;
+};
+
+// Sums the counts of identical records while the sorter merges.
+struct CombinePairs {
+  bool operator()(void *into, const void *other, const TargetOrder &order) const {
+    if (!order.Layout().SameKey(into, other)) return false;
+    order.Layout().AddCounts(into, other);
+    return true;
+  }
+};
+
+// Orders by source phrase, then target phrase, comparing words by their
+// rank in the sorted vocabulary.  A phrase comes before its extensions, so
+// the phrase table is sorted word by word in byte order.
+class SourceOrder
+{
+public:
+  // Ranks may be filled in after construction, but before the first
+  // comparison.
+  SourceOrder(const PairLayout &layout,
+              const std::vector<WordId> &sourceRank,
+              const std::vector<WordId> &targetRank)
+    : m_layout(layout)
+    , m_sourceRank(&sourceRank)
+    , m_targetRank(&targetRank) {}
+
+  bool operator()(const void *a, const void *b) const {
+    const std::size_t length = m_layout.MaxLength();
+    const WordId *sa = m_layout.Source(a), *sb = m_layout.Source(b);
+    for (std::size_t i = 0; i < length; ++i) {
+      if (sa[i] != sb[i]) return Rank(*m_sourceRank, sa[i]) < Rank(*m_sourceRank, sb[i]);
+    }
+    const WordId *ta = m_layout.Target(a), *tb = m_layout.Target(b);
+    for (std::size_t i = 0; i < length; ++i) {
+      if (ta[i] != tb[i]) return Rank(*m_targetRank, ta[i]) < Rank(*m_targetRank, tb[i]);
+    }
+    return false;
+  }
+
+private:
+  static WordId Rank(const std::vector<WordId> &rank, WordId id) {
+    return id == kNoWord ? 0 : rank[id] + 1;
+  }
+
+  PairLayout m_layout;
+  const std::vector<WordId> *m_sourceRank;
+  const std::vector<WordId> *m_targetRank;
+};
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
@@ -0,0 +1,154 @@
+#include "PhrasePairExtractor.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+void PhrasePairExtractor::Extract(const SentencePair &sentence,
+                                  std::vector<char> &out)
+{
+  m_countE = sentence.target.size();
+  m_countF = sentence.source.size();
+  const int maxLength = m_layout.MaxLength();
+
+  m_alignedToT.resize(m_countE);
+  for (int e = 0; e < m_countE; ++e) {
+    m_alignedToT[e].clear();
+  }
+  m_alignedCountS.assign(m_countF, 0);
+  m_aligned.assign(m_countF * m_countE, 0);
+  for (std::size_t i = 0; i < sentence.alignment.size(); ++i) {
+    int f = sentence.alignment[i].first;
+    int e = sentence.alignment[i].second;
+    m_alignedToT[e].push_back(f);
+    m_alignedCountS[f]++;
+    m_aligned[f * m_countE + e] = 1;
+  }
+
+  // check alignments for target phrase startE...endE
+  for (int startE = 0; startE < m_countE; ++startE) {
+    for (int endE = startE;
+         endE < m_countE && endE < startE + maxLength; ++endE) {
+
+      int minF = std::numeric_limits<int>::max();
+      int maxF = -1;
+      m_usedF = m_alignedCountS;
+      for (int ei = startE; ei <= endE; ++ei) {
+        for (std::size_t i = 0; i < m_alignedToT[ei].size(); ++i) {
+          int fi = m_alignedToT[ei][i];
+          minF = std::min(minF, fi);
+          maxF = std::max(maxF, fi);
+          m_usedF[fi]--;
+        }
+      }
+
+      // aligned to any source words at all, and within limits
+      if (maxF < 0 || maxF - minF >= maxLength) {
+        continue;
+      }
+
+      // check if source words are aligned to out of bound target words
+      bool outOfBounds = false;
+      for (int fi = minF; fi <= maxF && !outOfBounds; ++fi) {
+        outOfBounds = m_usedF[fi] > 0;
+      }
+      if (outOfBounds) {
+        continue;
+      }
+
+      // start point of source phrase may retreat over unaligned
+      for (int startF = minF;
+           startF >= 0 && startF > maxF - maxLength &&
+           (startF == minF || m_alignedCountS[startF] == 0);
+           --startF) {
+        // end point of source phrase may advance over unaligned
+        for (int endF = maxF;
+             endF < m_countF && endF < startF + maxLength &&
+             (endF == maxF || m_alignedCountS[endF] == 0);
+             ++endF) {
+          AddPhrase(sentence, startE, endE, startF, endF, out);
+        }
+      }
+    }
+  }
+}
+
+bool PhrasePairExtractor::IsAligned(int f, int e) const
+{
+  // the corners outside the sentence count as aligned
+  if (e == -1 && f == -1) {
+    return true;
+  }
+  if (e <= -1 || f <= -1) {
+    return false;
+  }
+  if (e == m_countE && f == m_countF) {
+    return true;
+  }
+  if (e >= m_countE || f >= m_countF) {
+    return false;
+  }
+  return m_aligned[f * m_countE + e];
+}
+
+PhrasePairExtractor::Orientation PhrasePairExtractor::GetOrientation(
+  bool connectedLeftTop, bool connectedRightTop) const
+{
+  if (connectedLeftTop && !connectedRightTop) {
+    return kMono;
+  }
+  if (!connectedLeftTop && connectedRightTop) {
+    return kSwap;
+  }
+  return kOther;
+}
+
+void PhrasePairExtractor::AddPhrase(const SentencePair &sentence,
+                                    int startE, int endE, int startF,
+                                    int endF, std::vector<char> &out) const
+{
+  const std::size_t offset = out.size();
+  out.resize(offset + m_layout.Size());
+  void *record = &out[offset];
+
+  PairValue &value = m_layout.Value(record);
+  value.count = 1.0f;
+  std::fill(value.orientation, value.orientation + 6, 0.0f);
+  value.targetCount = 0.0f;
+
+  const Orientation prev = GetOrientation(IsAligned(startF-1, startE-1),
+                                          IsAligned(endF+1, startE-1));
+  const Orientation next = GetOrientation(IsAligned(endF+1, endE+1),
+                                          IsAligned(startF-1, endE+1));
+  value.orientation[prev] = 1.0f;
+  value.orientation[3 + next] = 1.0f;
+
+  const std::size_t maxLength = m_layout.MaxLength();
+  WordId *source = m_layout.Source(record);
+  std::fill(source, source + maxLength, kNoWord);
+  std::copy(sentence.source.begin() + startF,
+            sentence.source.begin() + endF + 1, source);
+
+  WordId *target = m_layout.Target(record);
+  std::fill(target, target + maxLength, kNoWord);
+  std::copy(sentence.target.begin() + startE,
+            sentence.target.begin() + endE + 1, target);
+
+  AlignMask *alignment = m_layout.Alignment(record);
+  std::fill(alignment, alignment + maxLength, 0);
+  for (int ei = startE; ei <= endE; ++ei) {
+    for (std::size_t i = 0; i < m_alignedToT[ei].size(); ++i) {
+      int fi = m_alignedToT[ei][i];
+      alignment[fi - startF] |= 1 << (ei - startE);
+    }
+  }
+  std::copy(alignment, alignment + maxLength,
+            m_layout.InverseAlignment(record));
+}
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+
+#include "PhrasePair.h"
+#include "SentencePair.h"
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+// Extracts the phrase pairs that are consistent with the word alignment of a
+// sentence pair, like extract with the default word-based msd orientation
+// model, and writes them as PairLayout records with a count of one.
+class PhrasePairExtractor
+{
+public:
+  explicit PhrasePairExtractor(const PairLayout &layout) : m_layout(layout) {}
+
+  // Appends the records to out.  Not thread-safe but cheap to copy, so give
+  // each thread its own.
+  void Extract(const SentencePair &, std::vector<char> &out);
+
+private:
+  enum Orientation {
+    kMono = 0,
+    kSwap = 1,
+    kOther = 2
+  };
+
+  bool IsAligned(int f, int e) const;
+
+  Orientation GetOrientation(bool connectedLeftTop,
+                             bool connectedRightTop) const;
+
+  void AddPhrase(const SentencePair &, int startE, int endE, int startF,
+                 int endF, std::vector<char> &out) const;
+
+  PairLayout m_layout;
+
+  // per sentence
+  int m_countE;
+  int m_countF;
+  std::vector<std::vector<int> > m_alignedToT;
+  std::vector<int> m_alignedCountS;
+  std::vector<char> m_aligned;
+  std::vector<int> m_usedF;
+};
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
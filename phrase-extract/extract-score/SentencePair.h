@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "PhrasePair.h"
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+// A line of the word-aligned parallel corpus, with the words mapped to ids.
+struct SentencePair {
+  std::size_t lineNum;
+  std::vector<WordId> source;
+  std::vector<WordId> target;
+  // (source position, target position)
+  std::vector<std::pair<int, int> > alignment;
+};
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
@@ -0,0 +1,125 @@
+#include "TableWriter.h"
+
+#include <cstring>
+
+#include "util/stream/stream.hh"
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+TableWriter::TableWriter(const PairLayout &layout,
+                         const Vocabulary &sourceVocab,
+                         const Vocabulary &targetVocab,
+                         const LexicalTable &lexF2E,
+                         const LexicalTable &lexE2F,
+                         std::ostream &table, std::ostream *reordering,
+                         double reorderingSmoothing)
+  : m_layout(layout)
+  , m_sourceVocab(sourceVocab)
+  , m_targetVocab(targetVocab)
+  , m_lexF2E(lexF2E)
+  , m_lexE2F(lexE2F)
+  , m_table(table)
+  , m_reordering(reordering)
+  , m_reorderingSmoothing(reorderingSmoothing)
+{
+}
+
+void TableWriter::Run(const util::stream::ChainPosition &position)
+{
+  const std::size_t size = m_layout.Size();
+  for (util::stream::Stream in(position); in; ++in) {
+    if (!m_group.empty() &&
+        !m_layout.SameSource(&m_group[m_group.size() - size], in.Get())) {
+      Flush();
+    }
+    m_group.resize(m_group.size() + size);
+    std::memcpy(&m_group[m_group.size() - size], in.Get(), size);
+  }
+  Flush();
+}
+
+void TableWriter::Flush()
+{
+  const std::size_t size = m_layout.Size();
+  float sourceCount = 0;
+  for (std::size_t offset = 0; offset < m_group.size(); offset += size) {
+    sourceCount += m_layout.Value(&m_group[offset]).count;
+  }
+
+  for (std::size_t offset = 0; offset < m_group.size(); offset += size) {
+    const void *record = &m_group[offset];
+    const PairValue &value = m_layout.Value(record);
+    const WordId *source = m_layout.Source(record);
+    const WordId *target = m_layout.Target(record);
+    const AlignMask *alignment = m_layout.Alignment(record);
+    const AlignMask *inverseAlignment = m_layout.InverseAlignment(record);
+    const std::size_t sourceLength = m_layout.Length(source);
+    const std::size_t targetLength = m_layout.Length(target);
+
+    // phrases
+    WritePhrase(source, m_sourceVocab, m_table);
+    m_table << "||| ";
+    WritePhrase(target, m_targetVocab, m_table);
+    m_table << "|||";
+
+    // p(f|e) lex(f|e) p(e|f) lex(e|f)
+    m_table << " " << double(value.count) / value.targetCount
+            << " " << m_lexE2F.Weight(target, source, sourceLength, inverseAlignment,
+                                      targetLength, false)
+            << " " << double(value.count) / sourceCount
+            << " " << m_lexF2E.Weight(source, target, targetLength, alignment,
+                                      sourceLength, true);
+
+    // alignment, ordered by target position
+    m_table << " |||";
+    for (std::size_t t = 0; t < targetLength; ++t) {
+      for (std::size_t s = 0; s < sourceLength; ++s) {
+        if (alignment[s] & (1 << t)) {
+          m_table << " " << s << "-" << t;
+        }
+      }
+    }
+
+    // counts
+    m_table << " ||| " << value.targetCount << " " << sourceCount << " "
+            << value.count << " ||| |||\n";
+
+    if (m_reordering) {
+      WritePhrase(source, m_sourceVocab, *m_reordering);
+      *m_reordering << "||| ";
+      WritePhrase(target, m_targetVocab, *m_reordering);
+      *m_reordering << "|||";
+      WriteOrientation(value.orientation, *m_reordering);
+      WriteOrientation(value.orientation + 3, *m_reordering);
+      *m_reordering << "\n";
+    }
+  }
+  m_group.clear();
+}
+
+void TableWriter::WritePhrase(const WordId *phrase, const Vocabulary &vocab,
+                              std::ostream &out) const
+{
+  for (std::size_t i = 0; i < m_layout.MaxLength() && phrase[i] != kNoWord; ++i) {
+    out << vocab.Lookup(phrase[i]) << " ";
+  }
+}
+
+void TableWriter::WriteOrientation(const float *counts, std::ostream &out) const
+{
+  // mono, swap, discontinuous with constant smoothing, like
+  // lexical-reordering/score
+  double sum = 0.0;
+  for (std::size_t i = 0; i < 3; ++i) {
+    sum += counts[i] + m_reorderingSmoothing;
+  }
+  for (std::size_t i = 0; i < 3; ++i) {
+    out << " " << (counts[i] + m_reorderingSmoothing) / sum;
+  }
+}
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
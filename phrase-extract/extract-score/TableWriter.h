@@ -0,0 +1,50 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+#include "util/stream/chain.hh"
+
+#include "LexicalTable.h"
+#include "PhrasePair.h"
+#include "Vocabulary.h"
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+// End of the last chain: reads the distinct phrase pairs in SourceOrder,
+// computes c(f) and all scores and writes the phrase table in the format of
+// consolidate, plus optionally a msd-bidirectional-fe reordering table.
+class TableWriter
+{
+public:
+  TableWriter(const PairLayout &layout,
+              const Vocabulary &sourceVocab, const Vocabulary &targetVocab,
+              const LexicalTable &lexF2E, const LexicalTable &lexE2F,
+              std::ostream &table, std::ostream *reordering,
+              double reorderingSmoothing);
+
+  void Run(const util::stream::ChainPosition &position);
+
+private:
+  void Flush();
+  void WritePhrase(const WordId *, const Vocabulary &, std::ostream &) const;
+  void WriteOrientation(const float *counts, std::ostream &) const;
+
+  PairLayout m_layout;
+  const Vocabulary &m_sourceVocab;
+  const Vocabulary &m_targetVocab;
+  const LexicalTable &m_lexF2E;
+  const LexicalTable &m_lexE2F;
+  std::ostream &m_table;
+  std::ostream *m_reordering;
+  double m_reorderingSmoothing;
+
+  // pairs of the current source phrase
+  std::vector<char> m_group;
+};
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+#include "syntax-common/numbered_set.h"
+
+#include "PhrasePair.h"
+
+namespace MosesTraining
+{
+namespace ExtractScore
+{
+
+typedef Syntax::NumberedSet<std::string, WordId> Vocabulary;
+
+}  // namespace ExtractScore
+}  // namespace MosesTraining
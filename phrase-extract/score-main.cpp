@@ -27,6 +27,11 @@
 #include <algorithm>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/unordered_map.hpp>
+#ifdef WITH_THREADS
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#endif
 
 #include "ScoreFeature.h"
 #include "tables-core.h"
@@ -36,6 +41,13 @@
 #include "OutputFileStream.h"
 
 #include "moses/Util.h"
+#ifdef WITH_THREADS
+#include "moses/OutputCollector.h"
+#include "moses/ThreadPool.h"
+#endif
+#include "util/ersatz_progress.hh"
+#include "util/file.hh"
+#include "util/usage.hh"
 
 using namespace boost::algorithm;
 using namespace MosesTraining;
@@ -96,6 +108,11 @@ std::vector<float> orientationClassPriorsR2L(4,0); // mono swap dleft dright
 Vocabulary vcbT;
 Vocabulary vcbS;
 
+#ifdef WITH_THREADS
+// guards the count of counts and the label statistics above
+boost::mutex statisticsMutex;
+#endif
+
 } // namespace
 
 
@@ -104,6 +121,9 @@ void processLine( std::string line,
                   PHRASE *phraseSource, PHRASE *phraseTarget, ALIGNMENT *targetToSourceAlignment,
                   std::string &additionalPropertiesString,
                   float &count, float &pcfgSum );
+bool sameSourcePhrase( const std::string &line1, const std::string &line2 );
+void scoreLines( const std::vector< std::string > &lines, int firstLineID, std::ostream &phraseTableFile,
+                 const ScoreFeatureManager& featureManager, const MaybeLog& maybeLogProb );
 void writeCountOfCounts( const std::string &fileNameCountOfCounts );
 void writeLeftHandSideLabelCounts( const boost::unordered_map<std::string,float> &countsLabelLHS,
                                    const boost::unordered_map<std::string, boost::unordered_map<std::string,float>* > &jointCountsLabelLHS,
@@ -125,6 +145,38 @@ void printTargetPhrase( const PHRASE *phraseSource, const PHRASE *phraseTarget,
 void invertAlignment( const PHRASE *phraseSource, const PHRASE *phraseTarget, const ALIGNMENT *inTargetToSourceAlignment, ALIGNMENT *outSourceToTargetAlignment );
 size_t NumNonTerminal(const PHRASE *phraseSource);
 
+#ifdef WITH_THREADS
+// Scores a batch of lines that holds all phrase pairs of its source phrases.
+class ScoreTask : public Moses::Task
+{
+public:
+  ScoreTask( int batchID, int firstLineID, std::vector< std::string > &lines,
+             Moses::OutputCollector &outputCollector,
+             const ScoreFeatureManager& featureManager, const MaybeLog& maybeLogProb )
+    : m_batchID(batchID)
+    , m_firstLineID(firstLineID)
+    , m_outputCollector(outputCollector)
+    , m_featureManager(featureManager)
+    , m_maybeLogProb(maybeLogProb) {
+    m_lines.swap(lines);
+  }
+
+  void Run() {
+    std::ostringstream out;
+    scoreLines( m_lines, m_firstLineID, out, m_featureManager, m_maybeLogProb );
+    m_outputCollector.Write( m_batchID, out.str() );
+  }
+
+private:
+  int m_batchID;
+  int m_firstLineID;
+  std::vector< std::string > m_lines;
+  Moses::OutputCollector &m_outputCollector;
+  const ScoreFeatureManager &m_featureManager;
+  const MaybeLog &m_maybeLogProb;
+};
+#endif
+
 
 int main(int argc, char* argv[])
 {
@@ -154,7 +206,8 @@ int main(int argc, char* argv[])
               "[--TargetSyntacticPreferences] "
               "[--UnpairedExtractFormat] "
               "[--ConditionOnTargetLHS] "
-              "[--CrossedNonTerm]"
+              "[--CrossedNonTerm] "
+              "[--Threads num]"
               << std::endl;
     std::cerr << featureManager.usage() << std::endl;
     exit(1);
@@ -172,6 +225,7 @@ int main(int argc, char* argv[])
   std::string fileNameLeftHandSideTargetSyntacticPreferencesLabelCounts;
   std::string fileNameLeftHandSideRuleTargetTargetSyntacticPreferencesLabelCounts;
   std::string fileNamePhraseOrientationPriors;
+  size_t threadCount = 1;
   // All unknown args are passed to feature manager.
   std::vector<std::string> featureArgs;
 
@@ -287,6 +341,18 @@ int main(int argc, char* argv[])
     } else if (strcmp(argv[i],"--NonTermContextTarget") == 0) {
       nonTermContextTarget = true;
       std::cerr << "non-term context (target)" << std::endl;
+    } else if (strcmp(argv[i],"--Threads") == 0) {
+      if (i+1==argc) {
+        std::cerr << "ERROR: specify number of threads!" << std::endl;
+        exit(1);
+      }
+      threadCount = std::max(1, std::atoi( argv[++i] ));
+#ifdef WITH_THREADS
+      std::cerr << "scoring with " << threadCount << " threads" << std::endl;
+#else
+      std::cerr << "thread support not compiled in" << std::endl;
+      threadCount = 1;
+#endif
     } else if (strcmp(argv[i],"--TargetConstituentBoundaries") == 0) {
       targetConstituentBoundariesFlag = true;
       std::cerr << "including target constituent boundaries information" << std::endl;
@@ -350,8 +416,145 @@ int main(int argc, char* argv[])
     phraseTableFile = outputFile;
   }
 
-  // loop through all extracted phrase translations
-  std::string line, lastLine;
+  // Progress over the bytes read, if the size is known.
+  uint64_t extractFileSize = util::kBadSize;
+  if (!boost::algorithm::ends_with(fileNameExtract, ".gz")) {
+    util::scoped_fd extractFd(util::OpenReadOrThrow(fileNameExtract.c_str()));
+    extractFileSize = util::SizeFile(extractFd.get());
+  }
+  const bool sizeKnown = extractFileSize != util::kBadSize;
+  util::ErsatzProgress progress(sizeKnown ? extractFileSize : 0,
+                                sizeKnown ? &std::cerr : NULL, "Scoring");
+
+#ifdef WITH_THREADS
+  // Batches are written in order.  Bound how far the reader may run ahead of
+  // the oldest batch that is still being scored.
+  boost::scoped_ptr<Moses::OutputCollector> outputCollector;
+  boost::scoped_ptr<Moses::ThreadPool> pool;
+  if (threadCount > 1) {
+    outputCollector.reset(new Moses::OutputCollector(phraseTableFile));
+    outputCollector->SetReorderWindow(2 * threadCount);
+    pool.reset(new Moses::ThreadPool(threadCount));
+  }
+#endif
+
+  // Read the extract file in batches that end at a change of source phrase.
+  // All phrase pairs of a source phrase are then in one batch, and batches
+  // can be scored independently of each other.
+  const size_t batchLines = 10000;
+  std::vector< std::string > batch;
+  std::string line;
+  int batchID = 0;
+  int firstLineID = 1;
+  int i = 0;
+  const double startTime = util::WallTime();
+
+  for (bool more = true; more; ) {
+    more = !getline(extractFile, line).fail();
+    if (more) {
+      ++i;
+      if (sizeKnown) {
+        progress += line.size() + 1;
+      } else if ( i % 100000 == 0 ) {
+        // Print progress dots to stderr.
+        std::cerr << "." << std::flush;
+      }
+      if (batch.size() < batchLines || sameSourcePhrase(batch.back(), line)) {
+        batch.push_back(line);
+        continue;
+      }
+    }
+    if (batch.empty()) {
+      continue;
+    }
+
+#ifdef WITH_THREADS
+    if (pool) {
+      outputCollector->WaitForWindow(batchID);
+      pool->Submit(boost::shared_ptr<Moses::Task>(
+                     new ScoreTask(batchID, firstLineID, batch, *outputCollector,
+                                   featureManager, maybeLogProb)));
+    } else
+#endif
+    {
+      scoreLines( batch, firstLineID, *phraseTableFile, featureManager, maybeLogProb );
+    }
+    batch.clear();
+    ++batchID;
+    firstLineID = i;
+    if (more) {
+      batch.push_back(line);
+    }
+  }
+
+#ifdef WITH_THREADS
+  if (pool) {
+    pool->Stop(true);
+  }
+#endif
+
+  if (sizeKnown) {
+    progress.Finished();
+  } else {
+    // We've been printing progress dots to stderr.  End the line.
+    std::cerr << std::endl;
+  }
+  const double seconds = util::WallTime() - startTime;
+  std::cerr << "scored " << i << " lines in " << seconds << " seconds ("
+            << (seconds > 0 ? i / seconds : 0) << " lines/s)" << std::endl;
+
+  phraseTableFile->flush();
+  if (phraseTableFile != &std::cout) {
+    delete phraseTableFile;
+  }
+
+  // output count of count statistics
+  if (goodTuringFlag || kneserNeyFlag) {
+    writeCountOfCounts( fileNameCountOfCounts );
+  }
+
+  // source syntax labels
+  if (sourceSyntaxLabelsFlag && !inverseFlag) {
+    writeLabelSet( sourceLabelSet, fileNameSourceLabelSet );
+  }
+  if (sourceSyntaxLabelsFlag && sourceSyntaxLabelCountsLHSFlag && !inverseFlag) {
+    writeLeftHandSideLabelCounts( sourceLHSCounts,
+                                  targetLHSAndSourceLHSJointCounts,
+                                  fileNameLeftHandSideSourceLabelCounts,
+                                  fileNameLeftHandSideTargetSourceLabelCounts );
+  }
+
+  // parts-of-speech
+  if (partsOfSpeechFlag && !inverseFlag) {
+    writeLabelSet( partsOfSpeechSet, fileNamePartsOfSpeechSet );
+  }
+
+  // target syntactic preferences labels
+  if (targetSyntacticPreferencesFlag && !inverseFlag) {
+    writeLabelSet( targetSyntacticPreferencesLabelSet, fileNameTargetSyntacticPreferencesLabelSet );
+    writeLeftHandSideLabelCounts( targetSyntacticPreferencesLHSCounts,
+                                  ruleTargetLHSAndTargetSyntacticPreferencesLHSJointCounts,
+                                  fileNameLeftHandSideTargetSyntacticPreferencesLabelCounts,
+                                  fileNameLeftHandSideRuleTargetTargetSyntacticPreferencesLabelCounts );
+  }
+}
+
+
+bool sameSourcePhrase( const std::string &line1, const std::string &line2 )
+{
+  size_t end1 = line1.find("|||");
+  size_t end2 = line2.find("|||");
+  if (line1.compare(0, end1, line2, 0, end2) == 0) {
+    return true;
+  }
+  // extract writes single spaces, but compare the words to be safe
+  return Moses::Tokenize(line1.substr(0, end1)) == Moses::Tokenize(line2.substr(0, end2));
+}
+
+
+void scoreLines( const std::vector< std::string > &lines, int firstLineID, std::ostream &phraseTableFile,
+                 const ScoreFeatureManager& featureManager, const MaybeLog& maybeLogProb )
+{
   ExtractionPhrasePair *phrasePair = NULL;
   std::vector< ExtractionPhrasePair* > phrasePairsWithSameSource;
   std::vector< ExtractionPhrasePair* > phrasePairsWithSameSourceAndTarget; // required for hierarchical rules only, as non-terminal alignments might make the phrases incompatible
@@ -362,42 +565,13 @@ int main(int argc, char* argv[])
   std::string tmpAdditionalPropertiesString;
   float tmpCount=0.0f, tmpPcfgSum=0.0f;
 
-  int i=0;
-  if ( getline(extractFile, line) ) {
-    ++i;
-    tmpPhraseSource = new PHRASE();
-    tmpPhraseTarget = new PHRASE();
-    tmpTargetToSourceAlignment = new ALIGNMENT();
-    processLine( std::string(line),
-                 i, featureManager.includeSentenceId(), tmpSentenceId,
-                 tmpPhraseSource, tmpPhraseTarget, tmpTargetToSourceAlignment,
-                 tmpAdditionalPropertiesString,
-                 tmpCount, tmpPcfgSum);
-    phrasePair = new ExtractionPhrasePair( tmpPhraseSource, tmpPhraseTarget,
-                                           tmpTargetToSourceAlignment,
-                                           tmpCount, tmpPcfgSum );
-    phrasePair->AddProperties( tmpAdditionalPropertiesString, tmpCount );
-    featureManager.addPropertiesToPhrasePair( *phrasePair, tmpCount, tmpSentenceId );
-    phrasePairsWithSameSource.push_back( phrasePair );
-    if ( hierarchicalFlag ) {
-      phrasePairsWithSameSourceAndTarget.push_back( phrasePair );
-    }
-    lastLine = line;
-  }
-
-  while ( getline(extractFile, line) ) {
-
-    // Print progress dots to stderr.
-    if ( ++i % 100000 == 0 ) {
-      std::cerr << "." << std::flush;
-    }
+  for (size_t l = 0; l < lines.size(); ++l) {
+    const std::string &line = lines[l];
 
     // identical to last line? just add count
-    if (line == lastLine) {
+    if (l > 0 && line == lines[l-1]) {
       phrasePair->IncrementPrevious(tmpCount,tmpPcfgSum);
       continue;
-    } else {
-      lastLine = line;
     }
 
     tmpPhraseSource = new PHRASE();
@@ -405,7 +579,7 @@ int main(int argc, char* argv[])
     tmpTargetToSourceAlignment = new ALIGNMENT();
     tmpAdditionalPropertiesString.clear();
     processLine( std::string(line),
-                 i, featureManager.includeSentenceId(), tmpSentenceId,
+                 firstLineID + l, featureManager.includeSentenceId(), tmpSentenceId,
                  tmpPhraseSource, tmpPhraseTarget, tmpTargetToSourceAlignment,
                  tmpAdditionalPropertiesString,
                  tmpCount, tmpPcfgSum);
@@ -417,7 +591,9 @@ int main(int argc, char* argv[])
     // ExtractionPhrasePair::Matches() checks them in order and does not continue with the others
     // once the first of them has been found to have to be set to false
 
-    if ( hierarchicalFlag ) {
+    if ( phrasePair == NULL ) {
+      sourceMatch = targetMatch = alignmentMatch = false;
+    } else if ( hierarchicalFlag ) {
       for ( std::vector< ExtractionPhrasePair* >::const_iterator iter = phrasePairsWithSameSourceAndTarget.begin();
             iter != phrasePairsWithSameSourceAndTarget.end(); ++iter ) {
         if ( (*iter)->Matches( tmpPhraseSource, tmpPhraseTarget, tmpTargetToSourceAlignment,
@@ -447,7 +623,7 @@ int main(int argc, char* argv[])
 
       if ( !phrasePairsWithSameSource.empty() &&
            !sourceMatch ) {
-        processPhrasePairs( phrasePairsWithSameSource, *phraseTableFile, featureManager, maybeLogProb );
+        processPhrasePairs( phrasePairsWithSameSource, phraseTableFile, featureManager, maybeLogProb );
         for ( std::vector< ExtractionPhrasePair* >::const_iterator iter=phrasePairsWithSameSource.begin();
               iter!=phrasePairsWithSameSource.end(); ++iter) {
           delete *iter;
@@ -476,54 +652,13 @@ int main(int argc, char* argv[])
         phrasePairsWithSameSourceAndTarget.push_back(phrasePair);
       }
     }
-
   }
 
-  // We've been printing progress dots to stderr.  End the line.
-  std::cerr << std::endl;
-
-  processPhrasePairs( phrasePairsWithSameSource, *phraseTableFile, featureManager, maybeLogProb );
+  processPhrasePairs( phrasePairsWithSameSource, phraseTableFile, featureManager, maybeLogProb );
   for ( std::vector< ExtractionPhrasePair* >::const_iterator iter=phrasePairsWithSameSource.begin();
         iter!=phrasePairsWithSameSource.end(); ++iter) {
     delete *iter;
   }
-  phrasePairsWithSameSource.clear();
-
-
-  phraseTableFile->flush();
-  if (phraseTableFile != &std::cout) {
-    delete phraseTableFile;
-  }
-
-  // output count of count statistics
-  if (goodTuringFlag || kneserNeyFlag) {
-    writeCountOfCounts( fileNameCountOfCounts );
-  }
-
-  // source syntax labels
-  if (sourceSyntaxLabelsFlag && !inverseFlag) {
-    writeLabelSet( sourceLabelSet, fileNameSourceLabelSet );
-  }
-  if (sourceSyntaxLabelsFlag && sourceSyntaxLabelCountsLHSFlag && !inverseFlag) {
-    writeLeftHandSideLabelCounts( sourceLHSCounts,
-                                  targetLHSAndSourceLHSJointCounts,
-                                  fileNameLeftHandSideSourceLabelCounts,
-                                  fileNameLeftHandSideTargetSourceLabelCounts );
-  }
-
-  // parts-of-speech
-  if (partsOfSpeechFlag && !inverseFlag) {
-    writeLabelSet( partsOfSpeechSet, fileNamePartsOfSpeechSet );
-  }
-
-  // target syntactic preferences labels
-  if (targetSyntacticPreferencesFlag && !inverseFlag) {
-    writeLabelSet( targetSyntacticPreferencesLabelSet, fileNameTargetSyntacticPreferencesLabelSet );
-    writeLeftHandSideLabelCounts( targetSyntacticPreferencesLHSCounts,
-                                  ruleTargetLHSAndTargetSyntacticPreferencesLHSJointCounts,
-                                  fileNameLeftHandSideTargetSyntacticPreferencesLabelCounts,
-                                  fileNameLeftHandSideRuleTargetTargetSyntacticPreferencesLabelCounts );
-  }
 }
 
 
@@ -725,6 +860,9 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
 
   // collect count of count statistics
   if (goodTuringFlag || kneserNeyFlag) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(statisticsMutex);
+#endif
     totalDistinct++;
     int countInt = count + 0.99999;
     if ((countInt <= COC_MAX) &&
@@ -874,7 +1012,12 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
 
   // parts-of-speech
   if (partsOfSpeechFlag && !inverseFlag) {
-    phrasePair.UpdateVocabularyFromValueTokens("POS", partsOfSpeechSet);
+    {
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(statisticsMutex);
+#endif
+      phrasePair.UpdateVocabularyFromValueTokens("POS", partsOfSpeechSet);
+    }
     const std::string *bestPartOfSpeech = phrasePair.FindBestPropertyValue("POS");
     if (bestPartOfSpeech) {
       phraseTableFile << " {{POS " << *bestPartOfSpeech << "}}";
@@ -891,6 +1034,9 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
     // source syntax labels
     if (sourceSyntaxLabelsFlag) {
       std::string sourceLabelCounts;
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(statisticsMutex);
+#endif
       sourceLabelCounts = phrasePair.CollectAllLabelsSeparateLHSAndRHS("SourceLabels",
                           sourceLabelSet,
                           sourceLHSCounts,
@@ -908,6 +1054,9 @@ void outputPhrasePair(const ExtractionPhrasePair &phrasePair,
     // target syntactic preferences labels
     if (targetSyntacticPreferencesFlag) {
       std::string targetSyntacticPreferencesLabelCounts;
+#ifdef WITH_THREADS
+      boost::mutex::scoped_lock lock(statisticsMutex);
+#endif
       targetSyntacticPreferencesLabelCounts = phrasePair.CollectAllLabelsSeparateLHSAndRHS("TargetPreferences",
                                               targetSyntacticPreferencesLabelSet,
                                               targetSyntacticPreferencesLHSCounts,
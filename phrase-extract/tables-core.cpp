@@ -11,27 +11,71 @@ using namespace std;
 namespace MosesTraining
 {
 
-WORD_ID Vocabulary::storeIfNew( const WORD& word )
+Vocabulary::Vocabulary()
+  : m_size(0)
+  , m_blocks(new WORD*[kMaxBlocks]())
 {
-  map<WORD, WORD_ID>::iterator i = lookup.find( word );
+}
 
-  if( i != lookup.end() )
+Vocabulary::~Vocabulary()
+{
+  for (size_t i = 0; i < kMaxBlocks && m_blocks[i]; ++i) {
+    delete [] m_blocks[i];
+  }
+  delete [] m_blocks;
+}
+
+Vocabulary::Shard &Vocabulary::getShard( const WORD& word )
+{
+  return m_shards[ boost::hash<WORD>()( word ) % kShards ];
+}
+
+WORD_ID Vocabulary::storeIfNew( const WORD& word )
+{
+  Shard &shard = getShard( word );
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(shard.lock);
+#endif
+  boost::unordered_map<WORD, WORD_ID>::const_iterator i = shard.lookup.find( word );
+  if( i != shard.lookup.end() )
     return i->second;
 
-  WORD_ID id = vocab.size();
-  vocab.push_back( word );
-  lookup[ word ] = id;
+  WORD_ID id = m_size++;
+  store( id, word );
+  shard.lookup[ word ] = id;
   return id;
 }
 
 WORD_ID Vocabulary::getWordID( const WORD& word )
 {
-  map<WORD, WORD_ID>::iterator i = lookup.find( word );
-  if( i == lookup.end() )
+  Shard &shard = getShard( word );
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(shard.lock);
+#endif
+  boost::unordered_map<WORD, WORD_ID>::const_iterator i = shard.lookup.find( word );
+  if( i == shard.lookup.end() )
     return 0;
   return i->second;
 }
 
+void Vocabulary::store( WORD_ID id, const WORD& word )
+{
+  size_t block = id >> kBlockBits;
+  if (block >= kMaxBlocks) {
+    cerr << "ERROR: vocabulary too large" << endl;
+    exit(1);
+  }
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_blocksLock);
+#endif
+    if (!m_blocks[block]) {
+      m_blocks[block] = new WORD[kBlockSize];
+    }
+  }
+  m_blocks[block][id & (kBlockSize - 1)] = word;
+}
+
 PHRASE_ID PhraseTable::storeIfNew( const PHRASE& phrase )
 {
   map< PHRASE, PHRASE_ID >::iterator i = lookup.find( phrase );
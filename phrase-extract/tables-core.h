@@ -10,24 +10,64 @@
 #include <string>
 #include <queue>
 #include <map>
+#include <vector>
 #include <cmath>
 
+#include <boost/atomic.hpp>
+#include <boost/unordered_map.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
 namespace MosesTraining
 {
 
 typedef std::string WORD;
 typedef unsigned int WORD_ID;
 
+// May be shared by threads.  The lookup is split into shards by hash, each
+// with its own lock.  Words are stored in blocks that never move, so that
+// getWord needs no lock: whoever has an id got it from storeIfNew or
+// getWordID, after the thread that stored the word.
 class Vocabulary
 {
 public:
-  std::map<WORD, WORD_ID>  lookup;
-  std::vector< WORD > vocab;
+  Vocabulary();
+  ~Vocabulary();
+
   WORD_ID storeIfNew( const WORD& );
   WORD_ID getWordID( const WORD& );
-  inline WORD &getWord( const WORD_ID id ) {
-    return vocab[ id ];
+  inline const WORD &getWord( const WORD_ID id ) const {
+    return m_blocks[ id >> kBlockBits ][ id & (kBlockSize - 1) ];
   }
+
+private:
+  static const std::size_t kShards = 16;
+  static const unsigned kBlockBits = 16;
+  static const std::size_t kBlockSize = 1 << kBlockBits;
+  static const std::size_t kMaxBlocks = 1 << 16;
+
+  struct Shard {
+    boost::unordered_map<WORD, WORD_ID> lookup;
+#ifdef WITH_THREADS
+    boost::mutex lock;
+#endif
+  };
+
+  Shard &getShard( const WORD& );
+  void store( WORD_ID id, const WORD& );
+
+  Shard m_shards[kShards];
+  boost::atomic<std::size_t> m_size;
+  WORD **m_blocks;
+#ifdef WITH_THREADS
+  boost::mutex m_blocksLock;
+#endif
+
+  // noncopyable
+  Vocabulary( const Vocabulary& );
+  Vocabulary &operator=( const Vocabulary& );
 };
 
 typedef std::vector< WORD_ID > PHRASE;
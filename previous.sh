@@ -0,0 +1,2 @@
+#!/bin/sh
+./bjam -j1 -q link=static cxxflags=-std=gnu++11
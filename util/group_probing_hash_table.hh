@@ -0,0 +1,237 @@
+#ifndef UTIL_GROUP_PROBING_HASH_TABLE_H
+#define UTIL_GROUP_PROBING_HASH_TABLE_H
+
+#include "util/exception.hh"
+#include "util/probing_hash_table.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace util {
+
+namespace detail {
+
+// One control byte per bucket: 0 for empty, else 0x80 | the low 7 bits of
+// the hash.  Buckets are probed a group of kGroupWidth at a time.
+const std::size_t kGroupWidth = 16;
+
+// Bit i is set if control byte i of the group is tag.
+inline unsigned GroupMatch(const uint8_t *group, uint8_t tag) {
+#ifdef __SSE2__
+  __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(static_cast<char>(tag))));
+#else
+  unsigned ret = 0;
+  for (std::size_t i = 0; i < kGroupWidth; ++i) {
+    ret |= static_cast<unsigned>(group[i] == tag) << i;
+  }
+  return ret;
+#endif
+}
+
+inline unsigned GroupEmpty(const uint8_t *group) {
+  return GroupMatch(group, 0);
+}
+
+inline unsigned LowestBit(unsigned mask) {
+#ifdef __GNUC__
+  return __builtin_ctz(mask);
+#else
+  unsigned ret = 0;
+  for (; !(mask & 1); mask >>= 1) ++ret;
+  return ret;
+#endif
+}
+
+} // namespace detail
+
+/* Open addressing hash table that probes a group of 16 buckets at once, in
+ * the style of Abseil's SwissTable.  A separate array holds a control byte
+ * per bucket with 7 bits of the hash, so a lookup compares 16 of those with
+ * one SSE2 instruction and only looks at the entries whose bits match.  Unlike
+ * ProbingHashTable, this needs no invalid key.
+ *
+ * The interface follows ProbingHashTable: memory is externalized, zeroed
+ * memory is an empty table, buckets are fixed and only insert and lookup are
+ * supported.  The layout is different, so this is not a drop-in for tables
+ * that are already in binary files.
+ *
+ * The group comes from the high bits of the hash and the control byte from
+ * the low 7 bits, so the hash should mix all of them.
+ */
+template <class EntryT, class HashT, class EqualT = std::equal_to<typename EntryT::Key> > class GroupProbingHashTable {
+  public:
+    typedef EntryT Entry;
+    typedef typename Entry::Key Key;
+    typedef const Entry *ConstIterator;
+    typedef Entry *MutableIterator;
+    typedef HashT Hash;
+    typedef EqualT Equal;
+
+    static uint64_t Size(uint64_t entries, float multiplier) {
+      uint64_t buckets = Power2Mod::RoundBuckets(std::max<uint64_t>(
+          std::max(entries + 1, static_cast<uint64_t>(multiplier * static_cast<float>(entries))),
+          detail::kGroupWidth));
+      return buckets * (1 + sizeof(Entry));
+    }
+
+    // Must be assigned to later.
+    GroupProbingHashTable() : control_(NULL), begin_(NULL), buckets_(0), group_mask_(0), entries_(0) {}
+
+    GroupProbingHashTable(void *start, std::size_t allocated, const Hash &hash_func = Hash(), const Equal &equal_func = Equal())
+      : buckets_(RoundDown(allocated / (1 + sizeof(Entry)))),
+        group_mask_(buckets_ / detail::kGroupWidth - 1),
+        hash_(hash_func),
+        equal_(equal_func),
+        entries_(0) {
+      UTIL_THROW_IF(buckets_ < detail::kGroupWidth, ProbingSizeException, "Group probing hash table needs at least " << detail::kGroupWidth << " buckets, not " << buckets_ << ".");
+      Relocate(start);
+    }
+
+    void Relocate(void *new_base) {
+      control_ = static_cast<uint8_t*>(new_base);
+      begin_ = reinterpret_cast<MutableIterator>(control_ + buckets_);
+    }
+
+    template <class T> MutableIterator Insert(const T &t) {
+      UTIL_THROW_IF(++entries_ >= buckets_, ProbingSizeException, "Hash table with " << buckets_ << " buckets is full.");
+      uint64_t hash = hash_(t.GetKey());
+      Probe probe(hash, group_mask_);
+      std::size_t bucket = FirstEmpty(probe);
+      control_[bucket] = Tag(hash);
+      begin_[bucket] = t;
+      return begin_ + bucket;
+    }
+
+    // Return true if the value was found (and not inserted).  This is consistent with Find but the opposite of hash_map!
+    template <class T> bool FindOrInsert(const T &t, MutableIterator &out) {
+      uint64_t hash = hash_(t.GetKey());
+      Probe probe(hash, group_mask_);
+      std::size_t bucket;
+      if (FindFrom(t.GetKey(), Tag(hash), probe, bucket)) {
+        out = begin_ + bucket;
+        return true;
+      }
+      UTIL_THROW_IF(++entries_ >= buckets_, ProbingSizeException, "Hash table with " << buckets_ << " buckets is full.");
+      // The search stopped at the first group with an empty bucket.
+      bucket = probe.Group() + detail::LowestBit(detail::GroupEmpty(control_ + probe.Group()));
+      control_[bucket] = Tag(hash);
+      begin_[bucket] = t;
+      out = begin_ + bucket;
+      return false;
+    }
+
+    void FinishedInserting() {}
+
+    // Don't change anything related to GetKey,
+    template <class Key> bool UnsafeMutableFind(const Key key, MutableIterator &out) {
+      uint64_t hash = hash_(key);
+      Probe probe(hash, group_mask_);
+      std::size_t bucket;
+      if (!FindFrom(key, Tag(hash), probe, bucket)) return false;
+      out = begin_ + bucket;
+      return true;
+    }
+
+    template <class Key> bool Find(const Key key, ConstIterator &out) const {
+      uint64_t hash = hash_(key);
+      Probe probe(hash, group_mask_);
+      std::size_t bucket;
+      if (!FindFrom(key, Tag(hash), probe, bucket)) return false;
+      out = begin_ + bucket;
+      return true;
+    }
+
+    // Like Find but we're sure it must be there.
+    template <class Key> ConstIterator MustFind(const Key key) const {
+      ConstIterator ret;
+      bool found = Find(key, ret);
+      assert(found);
+      (void)found;
+      return ret;
+    }
+
+    void Clear() {
+      std::memset(control_, 0, buckets_);
+      entries_ = 0;
+    }
+
+    // Return number of entries assuming no serialization went on.
+    std::size_t SizeNoSerialization() const {
+      return entries_;
+    }
+
+    std::size_t Buckets() const {
+      return buckets_;
+    }
+
+  private:
+    // Visits every group once with triangular steps, since the number of
+    // groups is a power of 2.
+    class Probe {
+      public:
+        Probe(uint64_t hash, std::size_t group_mask)
+          : group_(static_cast<std::size_t>(hash >> 7) & group_mask), mask_(group_mask), step_(0) {}
+
+        // First bucket of the group.
+        std::size_t Group() const { return group_ * detail::kGroupWidth; }
+
+        void Next() {
+          group_ = (group_ + ++step_) & mask_;
+        }
+
+      private:
+        std::size_t group_, mask_, step_;
+    };
+
+    static std::size_t RoundDown(std::size_t buckets) {
+      if (!buckets) return 0;
+      std::size_t up = Power2Mod::RoundBuckets(buckets);
+      return up == buckets ? up : up / 2;
+    }
+
+    static uint8_t Tag(uint64_t hash) {
+      return static_cast<uint8_t>(0x80 | (hash & 0x7f));
+    }
+
+    // Leaves probe at the group where the search ended.
+    template <class Key> bool FindFrom(const Key key, uint8_t tag, Probe &probe, std::size_t &bucket) const {
+      for (;; probe.Next()) {
+        const uint8_t *group = control_ + probe.Group();
+        for (unsigned match = detail::GroupMatch(group, tag); match; match &= match - 1) {
+          bucket = probe.Group() + detail::LowestBit(match);
+          if (equal_(begin_[bucket].GetKey(), key)) return true;
+        }
+        if (detail::GroupEmpty(group)) return false;
+      }
+    }
+
+    std::size_t FirstEmpty(Probe &probe) const {
+      for (;; probe.Next()) {
+        unsigned empty = detail::GroupEmpty(control_ + probe.Group());
+        if (empty) return probe.Group() + detail::LowestBit(empty);
+      }
+    }
+
+    uint8_t *control_;
+    MutableIterator begin_;
+    std::size_t buckets_;
+    std::size_t group_mask_;
+    Hash hash_;
+    Equal equal_;
+
+    std::size_t entries_;
+};
+
+} // namespace util
+
+#endif // UTIL_GROUP_PROBING_HASH_TABLE_H
@@ -0,0 +1,116 @@
+#include "util/group_probing_hash_table.hh"
+
+#include "util/murmur_hash.hh"
+#include "util/scoped.hh"
+
+#define BOOST_TEST_MODULE GroupProbingHashTableTest
+#include <boost/test/unit_test.hpp>
+#include <boost/functional/hash.hpp>
+#include <cstring>
+#include <stdint.h>
+
+namespace util {
+namespace {
+
+struct Entry64 {
+  uint64_t key;
+  uint64_t value;
+  typedef uint64_t Key;
+
+  Entry64() {}
+
+  Entry64(uint64_t key_in, uint64_t value_in) : key(key_in), value(value_in) {}
+
+  Key GetKey() const { return key; }
+};
+
+struct MurmurHashEntry64 {
+  std::size_t operator()(uint64_t value) const {
+    return util::MurmurHash64A(&value, 8);
+  }
+};
+
+typedef GroupProbingHashTable<Entry64, MurmurHashEntry64> Table64;
+
+BOOST_AUTO_TEST_CASE(simple) {
+  size_t size = Table64::Size(10, 1.2);
+  scoped_malloc mem(CallocOrThrow(size));
+  Table64 table(mem.get(), size);
+  BOOST_CHECK_EQUAL(16U, table.Buckets());
+  const Entry64 *i = NULL;
+  BOOST_CHECK(!table.Find(2, i));
+  // No key is reserved, so 0 works too.
+  table.Insert(Entry64(0, 17));
+  table.Insert(Entry64(3, 328920));
+  BOOST_REQUIRE(table.Find(3, i));
+  BOOST_CHECK_EQUAL(3U, i->GetKey());
+  BOOST_CHECK_EQUAL(328920U, i->value);
+  BOOST_REQUIRE(table.Find(0, i));
+  BOOST_CHECK_EQUAL(17U, i->value);
+  BOOST_CHECK(!table.Find(2, i));
+  BOOST_CHECK_EQUAL(2U, table.SizeNoSerialization());
+}
+
+BOOST_AUTO_TEST_CASE(FindOrInsert) {
+  size_t size = Table64::Size(100, 1.5);
+  scoped_malloc mem(CallocOrThrow(size));
+  Table64 table(mem.get(), size);
+  Table64::MutableIterator out;
+  BOOST_CHECK(!table.FindOrInsert(Entry64(5, 1), out));
+  BOOST_CHECK_EQUAL(1U, out->value);
+  BOOST_CHECK(table.FindOrInsert(Entry64(5, 2), out));
+  BOOST_CHECK_EQUAL(1U, out->value);
+  out->value = 3;
+  BOOST_CHECK_EQUAL(3U, table.MustFind(5)->value);
+  BOOST_CHECK(table.UnsafeMutableFind(5, out));
+  BOOST_CHECK_EQUAL(1U, table.SizeNoSerialization());
+  table.Clear();
+  Table64::ConstIterator it;
+  BOOST_CHECK(!table.Find(5, it));
+  BOOST_CHECK_EQUAL(0U, table.SizeNoSerialization());
+}
+
+// A bad hash puts everything in one group, so probes have to move on.
+struct CollideHash {
+  std::size_t operator()(uint64_t value) const {
+    return value & 0x7f;
+  }
+};
+
+BOOST_AUTO_TEST_CASE(Overflow) {
+  typedef GroupProbingHashTable<Entry64, CollideHash> Table;
+  size_t size = Table::Size(100, 1.1);
+  scoped_malloc mem(CallocOrThrow(size));
+  Table table(mem.get(), size);
+  BOOST_REQUIRE_EQUAL(128U, table.Buckets());
+  for (uint64_t i = 0; i < 127; ++i) {
+    table.Insert(Entry64(i * 3, i));
+  }
+  BOOST_CHECK_THROW(table.Insert(Entry64(1, 1)), ProbingSizeException);
+  Table::ConstIterator it;
+  for (uint64_t i = 0; i < 127; ++i) {
+    BOOST_REQUIRE(table.Find(i * 3, it));
+    BOOST_CHECK_EQUAL(i, it->value);
+  }
+  BOOST_CHECK(!table.Find(1, it));
+  BOOST_CHECK(!table.Find(3 * 127, it));
+}
+
+BOOST_AUTO_TEST_CASE(Many) {
+  const uint64_t kEntries = 10000;
+  size_t size = Table64::Size(kEntries, 1.1);
+  scoped_malloc mem(CallocOrThrow(size));
+  Table64 table(mem.get(), size);
+  for (uint64_t i = 0; i < kEntries; ++i) {
+    table.Insert(Entry64(i * 7, i));
+  }
+  Table64::ConstIterator it;
+  for (uint64_t i = 0; i < kEntries * 7; ++i) {
+    bool found = table.Find(i, it);
+    BOOST_REQUIRE_EQUAL(i % 7 == 0, found);
+    if (found) BOOST_CHECK_EQUAL(i / 7, it->value);
+  }
+}
+
+} // namespace
+} // namespace util
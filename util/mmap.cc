@@ -339,6 +339,17 @@ void *MapZeroedWrite(const char *name, std::size_t size, scoped_fd &file) {
   }
 }
 
+void CopyToImage(int from, int to) {
+  uint64_t size = SizeOrThrow(from);
+  if (!size) {
+    ResizeOrThrow(to, 0);
+    return;
+  }
+  scoped_mmap image(MapZeroedWrite(to, size), size);
+  SeekOrThrow(from, 0);
+  ReadOrThrow(from, image.get(), size);
+}
+
 Rolling::Rolling(const Rolling &copy_from, uint64_t increase) {
   *this = copy_from;
   IncreaseBase(increase);
@@ -147,6 +147,14 @@ void MapRead(LoadMethod method, int fd, uint64_t offset, std::size_t size, scope
 void *MapZeroedWrite(int fd, std::size_t size);
 void *MapZeroedWrite(const char *name, std::size_t size, scoped_fd &file);
 
+/* Copy all of from into to through a shared mapping.  When to is on tmpfs
+ * (e.g. /dev/shm), the copy stays in memory as one image that every process
+ * mapping it shares, already faulted in.  The mapping asks for huge pages,
+ * which Linux honours on tmpfs if
+ * /sys/kernel/mm/transparent_hugepage/shmem_enabled is advise or always.
+ */
+void CopyToImage(int from, int to);
+
 // Forward rolling memory map with no overlap.
 class Rolling {
   public:
@@ -1,4 +1,5 @@
 #include "util/file.hh"
+#include "util/group_probing_hash_table.hh"
 #include "util/probing_hash_table.hh"
 #include "util/mmap.hh"
 #include "util/usage.hh"
@@ -118,8 +119,19 @@ std::size_t Size(uint64_t entries, float multiplier = 1.5) {
   return Power2Mod::RoundBuckets(Table::Size(entries, multiplier) / sizeof(Entry)) * sizeof(Entry);
 }
 
+typedef util::GroupProbingHashTable<Entry, util::IdentityHash> GroupTable;
+
+template <class Table> std::size_t TableSize(uint64_t entries, float multiplier) {
+  return Size(entries, multiplier);
+}
+
+// Already a power of 2 buckets, plus a control byte for each.
+template <> std::size_t TableSize<GroupTable>(uint64_t entries, float multiplier) {
+  return GroupTable::Size(entries, multiplier);
+}
+
 template <class Queue> bool Test(URandom &rn, uint64_t entries, const uint64_t *const queries_begin, const uint64_t *const queries_end, bool ordinary_malloc, float multiplier = 1.5) {
-  std::size_t size = Size(entries, multiplier);
+  std::size_t size = TableSize<typename Queue::Table>(entries, multiplier);
   scoped_memory backing;
   if (ordinary_malloc) {
     backing.reset(util::CallocOrThrow(size), size, scoped_memory::MALLOC_ALLOCATED);
@@ -165,6 +177,8 @@ bool TestRun(uint64_t lookups = 20000000, float multiplier = 1.5) {
     meaningless ^= util::Test<PrefetchQueue<Table, 4> >(rn, i / multiplier, queries_begin, queries_begin + lookups, false, multiplier);
     meaningless ^= util::Test<PrefetchQueue<Table, 8> >(rn, i / multiplier, queries_begin, queries_begin + lookups, false, multiplier);
     meaningless ^= util::Test<PrefetchQueue<Table, 16> >(rn, i / multiplier, queries_begin, queries_begin + lookups, false, multiplier);
+    meaningless ^= util::Test<Immediate<GroupTable> >(rn, i / multiplier, queries_begin, queries_begin + lookups, true, multiplier);
+    meaningless ^= util::Test<Immediate<GroupTable> >(rn, i / multiplier, queries_begin, queries_begin + lookups, false, multiplier);
     std::cout << std::endl;
   }
   return meaningless;
@@ -176,6 +190,11 @@ bool TestRun(uint64_t lookups = 20000000, float multiplier = 1.5) {
 int main() {
   bool meaningless = false;
   std::cout << "#CPU time\n";
-  meaningless ^= util::TestRun();
+  // Load factors of about 0.9, 0.67 and 0.5 before rounding up to a power of 2.
+  const float multipliers[] = {1.1, 1.5, 2.0};
+  for (const float *m = multipliers; m != multipliers + sizeof(multipliers) / sizeof(float); ++m) {
+    std::cout << "#multiplier " << *m << '\n';
+    meaningless ^= util::TestRun(20000000, *m);
+  }
   std::cerr << "Meaningless: " << meaningless << '\n';
 }
@@ -49,6 +49,9 @@ struct ChainConfig {
  */
 struct SortConfig {
 
+  /** Constructs a configuration that sorts and merges in one thread. */
+  SortConfig() : threads(1) {}
+
   /** Filename prefix where temporary files should be placed. */
   std::string temp_prefix;
 
@@ -57,6 +60,13 @@ struct SortConfig {
 
   /** Total memory to use when running alone. */
   std::size_t total_memory;
+
+  /**
+   * Number of threads that sort each block as it arrives and that merge
+   * blocks in the merge passes before the final, lazy merge.  Sorting costs
+   * no extra memory.  Merging divides total_memory between the threads.
+   */
+  std::size_t threads;
 };
 
 }} // namespaces
@@ -29,10 +29,16 @@
 #include "util/scoped.hh"
 #include "util/sized_iterator.hh"
 
+#include <boost/ref.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <algorithm>
 #include <iostream>
 #include <queue>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace util {
 namespace stream {
@@ -43,7 +49,8 @@ struct NeverCombine {
   }
 };
 
-// Manage the offsets of sorted blocks in a file.
+// Manage the offsets of sorted blocks in a file.  A block may be followed by
+// padding, unused bytes that readers skip.
 class Offsets {
   public:
     explicit Offsets(int fd) : log_(fd) {
@@ -52,21 +59,22 @@ class Offsets {
 
     int File() const { return log_; }
 
-    void Append(uint64_t length) {
+    void Append(uint64_t length, uint64_t padding = 0) {
       if (!length) return;
       ++block_count_;
-      if (length == cur_.length) {
+      if (length == cur_.length && padding == cur_.padding) {
         ++cur_.run;
         return;
       }
       WriteOrThrow(log_, &cur_, sizeof(Entry));
       cur_.length = length;
+      cur_.padding = padding;
       cur_.run = 1;
     }
 
     void FinishedAppending() {
       WriteOrThrow(log_, &cur_, sizeof(Entry));
-      SeekOrThrow(log_, sizeof(Entry)); // Skip 0,0 at beginning.
+      SeekOrThrow(log_, sizeof(Entry)); // Skip 0,0,0 at beginning.
       cur_.run = 0;
       if (block_count_) {
         ReadOrThrow(log_, &cur_, sizeof(Entry));
@@ -86,7 +94,7 @@ class Offsets {
     uint64_t NextSize() {
       assert(block_count_);
       uint64_t ret = cur_.length;
-      output_sum_ += ret;
+      output_sum_ += ret + cur_.padding;
 
       --cur_.run;
       --block_count_;
@@ -102,6 +110,7 @@ class Offsets {
       SeekOrThrow(log_, 0);
       ResizeOrThrow(log_, 0);
       cur_.length = 0;
+      cur_.padding = 0;
       cur_.run = 0;
       block_count_ = 0;
       output_sum_ = 0;
@@ -112,6 +121,7 @@ class Offsets {
 
     struct Entry {
       uint64_t length;
+      uint64_t padding;
       uint64_t run;
     };
     Entry cur_;
@@ -354,11 +364,159 @@ template <class Compare, class Combine> class OwningMergingReader : public Mergi
     Offsets offsets_;
 };
 
+/* Don't use this directly.  A merge pass of Sort::Merge on several threads.
+ * The blocks are grouped as MergingReader would with each thread's memory,
+ * and the threads take groups in turn.  Each group is written where its input
+ * would go if nothing combined, so groups need not wait for each other; what
+ * a combiner saves is left as padding after the group.
+ */
+template <class Compare, class Combine> class ParallelMerger {
+  public:
+    ParallelMerger(int in, int out, std::size_t reading_memory, std::size_t buffer_size, std::size_t entry_size, const Compare &compare, const Combine &combine)
+      : in_(in), out_(out),
+        reading_memory_(reading_memory), buffer_size_(buffer_size), entry_size_(entry_size),
+        compare_(compare), combine_(combine), next_(0) {}
+
+    // Merge the remaining blocks of in_offsets and record the output in out_offsets.
+    void Run(Offsets &in_offsets, Offsets &out_offsets, std::size_t threads) {
+      Plan(in_offsets);
+      boost::thread_group workers;
+      for (std::size_t i = 0; i < threads; ++i) {
+        workers.add_thread(new boost::thread(&ParallelMerger::Work, this));
+      }
+      workers.join_all();
+      UTIL_THROW_IF(!error_.empty(), Exception, "Merging on several threads failed: " << error_);
+      for (std::size_t i = 0; i < groups_.size(); ++i) {
+        const Group &group = groups_[i];
+        const uint64_t end = (i + 1 < groups_.size()) ? groups_[i + 1].output : group.output + group.written;
+        out_offsets.Append(group.written, end - group.output - group.written);
+      }
+      out_offsets.FinishedAppending();
+    }
+
+  private:
+    struct Group {
+      // offset and size of each block in the input
+      std::vector<std::pair<uint64_t, uint64_t> > blocks;
+      uint64_t per_buffer;
+      // offset in the output
+      uint64_t output;
+      uint64_t written;
+    };
+
+    void Plan(Offsets &in_offsets) {
+      uint64_t output = 0;
+      while (in_offsets.RemainingBlocks()) {
+        groups_.push_back(Group());
+        Group &group = groups_.back();
+        group.per_buffer = std::max<uint64_t>(buffer_size_, reading_memory_ / in_offsets.RemainingBlocks());
+        group.per_buffer -= group.per_buffer % entry_size_;
+        group.output = output;
+        group.written = 0;
+        for (uint64_t used = 0; in_offsets.RemainingBlocks() && used + std::min(group.per_buffer, in_offsets.PeekSize()) <= reading_memory_;) {
+          uint64_t offset = in_offsets.TotalOffset();
+          uint64_t size = in_offsets.NextSize();
+          group.blocks.push_back(std::make_pair(offset, size));
+          used += std::min(size, group.per_buffer);
+          output += size;
+        }
+        assert(!group.blocks.empty());
+      }
+    }
+
+    void Work() {
+      try {
+        scoped_malloc memory(MallocOrThrow(reading_memory_ + buffer_size_));
+        while (true) {
+          std::size_t index;
+          {
+            boost::mutex::scoped_lock lock(mutex_);
+            if (next_ == groups_.size() || !error_.empty()) return;
+            index = next_++;
+          }
+          Merge(groups_[index], static_cast<uint8_t*>(memory.get()));
+        }
+      } catch (const std::exception &e) {
+        boost::mutex::scoped_lock lock(mutex_);
+        if (error_.empty()) error_ = e.what();
+      }
+    }
+
+    void Merge(Group &group, uint8_t *memory) const {
+      Combine combine(combine_);
+      MergeQueue<Compare> queue(in_, group.per_buffer, entry_size_, compare_);
+      uint8_t *buf = memory;
+      for (std::size_t i = 0; i < group.blocks.size(); ++i) {
+        queue.Push(buf, group.blocks[i].first, group.blocks[i].second);
+        buf += static_cast<std::size_t>(std::min(group.blocks[i].second, group.per_buffer));
+      }
+
+      // Write out all but the last entry when the buffer fills, as the next
+      // entry may still combine into it.
+      uint8_t *const out_begin = memory + reading_memory_;
+      uint8_t *const out_end = out_begin + buffer_size_;
+      uint8_t *out = out_begin;
+      memcpy(out, queue.Top(), entry_size_);
+      for (queue.Pop(); !queue.Empty(); queue.Pop()) {
+        if (!combine(out, queue.Top(), compare_)) {
+          out += entry_size_;
+          if (out == out_end) {
+            Write(group, out_begin, out);
+            out = out_begin;
+          }
+          memcpy(out, queue.Top(), entry_size_);
+        }
+      }
+      Write(group, out_begin, out + entry_size_);
+    }
+
+    void Write(Group &group, const uint8_t *begin, const uint8_t *end) const {
+      ErsatzPWrite(out_, begin, end - begin, group.output + group.written);
+      group.written += end - begin;
+    }
+
+    const int in_, out_;
+    const std::size_t reading_memory_, buffer_size_, entry_size_;
+    const Compare compare_;
+    const Combine combine_;
+
+    std::vector<Group> groups_;
+
+    boost::mutex mutex_;
+    std::size_t next_;
+    std::string error_;
+};
+
+// Below this many entries, a range is not worth another thread.
+const std::ptrdiff_t kMinParallelSort = 1 << 16;
+
+/* Sort entries in place using up to the given number of threads.  The range
+ * is split at its median by nth_element, which needs no extra memory, and the
+ * halves are sorted concurrently.  The result is the same as std::sort's up to
+ * the order of equal entries, which std::sort does not define either.
+ */
+template <class Compare> void SortEntries(SizedIterator begin, SizedIterator end, const SizedCompare<Compare> &compare, std::size_t threads) {
+#if defined(_WIN32) || defined(_WIN64)
+  std::stable_sort(begin, end, compare);
+#else
+  if (threads <= 1 || end - begin < kMinParallelSort) {
+    std::sort(begin, end, compare);
+    return;
+  }
+  SizedIterator middle(begin + (end - begin) / 2);
+  std::nth_element(begin, middle, end, compare);
+  const std::size_t left = threads / 2;
+  boost::thread other(&SortEntries<Compare>, begin, middle, boost::cref(compare), left);
+  SortEntries(middle, end, compare, threads - left);
+  other.join();
+#endif
+}
+
 // Don't use this directly.  Worker that sorts blocks.
 template <class Compare> class BlockSorter {
   public:
-    BlockSorter(Offsets &offsets, const Compare &compare) :
-      offsets_(&offsets), compare_(compare) {}
+    BlockSorter(Offsets &offsets, const Compare &compare, std::size_t threads = 1) :
+      offsets_(&offsets), compare_(compare), threads_(threads) {}
 
     void Run(const ChainPosition &position) {
       const std::size_t entry_size = position.GetChain().EntrySize();
@@ -366,14 +524,7 @@ template <class Compare> class BlockSorter {
         // Record the size of each block in a separate file.
         offsets_->Append(link->ValidSize());
         void *end = static_cast<uint8_t*>(link->Get()) + link->ValidSize();
-#if defined(_WIN32) || defined(_WIN64)
-        std::stable_sort
-#else
-        std::sort
-#endif
-          (SizedIt(link->Get(), entry_size),
-           SizedIt(end, entry_size),
-           compare_);
+        SortEntries(SizedIt(link->Get(), entry_size), SizedIt(end, entry_size), compare_, threads_);
       }
       offsets_->FinishedAppending();
     }
@@ -381,6 +532,7 @@ template <class Compare> class BlockSorter {
   private:
     Offsets *offsets_;
     SizedCompare<Compare> compare_;
+    std::size_t threads_;
 };
 
 class BadSortConfig : public Exception {
@@ -404,7 +556,7 @@ template <class Compare, class Combine = NeverCombine> class Sort {
       config_.buffer_size -= config_.buffer_size % entry_size_;
       UTIL_THROW_IF(!config_.buffer_size, BadSortConfig, "Sort buffer too small");
       UTIL_THROW_IF(config_.total_memory < config_.buffer_size * 4, BadSortConfig, "Sorting memory " << config_.total_memory << " is too small for four buffers (two read and two write).");
-      in >> BlockSorter<Compare>(offsets_, compare_) >> WriteAndRecycle(data_.get());
+      in >> BlockSorter<Compare>(offsets_, compare_, config_.threads) >> WriteAndRecycle(data_.get());
     }
 
     uint64_t Size() const {
@@ -443,17 +595,28 @@ template <class Compare, class Combine = NeverCombine> class Sort {
         if (size < static_cast<uint64_t>(reading_memory)) {
           reading_memory = static_cast<std::size_t>(size);
         }
-        SeekOrThrow(fd_in, 0);
-        chain >>
-          MergingReader<Compare, Combine>(
-              fd_in,
-              offsets_in, offsets_out,
+        const std::size_t threads = MergeThreads(offsets_in->RemainingBlocks(), reading_memory);
+        if (threads > 1) {
+          // The chain keeps its two buffers; the threads share the rest.
+          ParallelMerger<Compare, Combine>(
+              fd_in, fd_out,
+              (config_.total_memory - 2 * config_.buffer_size) / threads - config_.buffer_size,
               config_.buffer_size,
-              reading_memory,
-              compare_, combine_) >>
-          WriteAndRecycle(fd_out);
-        chain.Wait();
-        offsets_out->FinishedAppending();
+              entry_size_,
+              compare_, combine_).Run(*offsets_in, *offsets_out, threads);
+        } else {
+          SeekOrThrow(fd_in, 0);
+          chain >>
+            MergingReader<Compare, Combine>(
+                fd_in,
+                offsets_in, offsets_out,
+                config_.buffer_size,
+                reading_memory,
+                compare_, combine_) >>
+            WriteAndRecycle(fd_out);
+          chain.Wait();
+          offsets_out->FinishedAppending();
+        }
         ResizeOrThrow(fd_in, 0);
         offsets_in->Reset();
         std::swap(fd_in, fd_out);
@@ -524,6 +687,17 @@ template <class Compare, class Combine = NeverCombine> class Sort {
     }
 
   private:
+    /* Threads for a merge pass of this many blocks.  Each thread merges with
+     * a share of the memory and so fewer blocks at once, so several threads
+     * are only used if one thread would also leave several blocks to merge
+     * again.
+     */
+    std::size_t MergeThreads(uint64_t blocks, std::size_t reading_memory) const {
+      if (config_.threads <= 1 || blocks <= reading_memory / config_.buffer_size) return 1;
+      // Each thread needs to read two blocks and to write.
+      return std::min<std::size_t>(config_.threads, (config_.total_memory - 2 * config_.buffer_size) / (3 * config_.buffer_size));
+    }
+
     SortConfig config_;
 
     scoped_fd data_;
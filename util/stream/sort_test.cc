@@ -59,4 +59,123 @@ BOOST_AUTO_TEST_CASE(FromShuffled) {
   BOOST_CHECK(!sorted);
 }
 
+BOOST_AUTO_TEST_CASE(ThreadedBlocks) {
+  // Large enough that SortEntries splits it several times.
+  const uint64_t size = kMinParallelSort * 5;
+  std::vector<uint64_t> shuffled;
+  shuffled.reserve(size);
+  for (uint64_t i = 0; i < size; ++i) {
+    // Include duplicates.
+    shuffled.push_back(i / 3);
+  }
+  std::random_shuffle(shuffled.begin(), shuffled.end());
+
+  ChainConfig config;
+  config.entry_size = 8;
+  config.total_memory = size * 8;
+  config.block_count = 2;
+
+  SortConfig merge_config;
+  merge_config.temp_prefix = "sort_test_temp";
+  merge_config.buffer_size = 8 << 10;
+  merge_config.total_memory = 64 << 10;
+  merge_config.threads = 3;
+
+  Chain chain(config);
+  chain >> Putter(shuffled);
+  BlockingSort(chain, merge_config, CompareUInt64(), NeverCombine());
+  Stream sorted;
+  chain >> sorted >> kRecycle;
+  for (uint64_t i = 0; i < size; ++i, ++sorted) {
+    BOOST_REQUIRE_EQUAL(i / 3, *static_cast<const uint64_t*>(sorted.Get()));
+  }
+  BOOST_CHECK(!sorted);
+}
+
+BOOST_AUTO_TEST_CASE(ThreadedMerge) {
+  std::vector<uint64_t> shuffled;
+  shuffled.reserve(kSize);
+  for (uint64_t i = 0; i < kSize; ++i) {
+    shuffled.push_back(i);
+  }
+  std::random_shuffle(shuffled.begin(), shuffled.end());
+
+  // Thousands of small blocks, so that there are merge passes on threads.
+  ChainConfig config;
+  config.entry_size = 8;
+  config.total_memory = 800;
+  config.block_count = 3;
+
+  SortConfig merge_config;
+  merge_config.temp_prefix = "sort_test_temp";
+  merge_config.buffer_size = 800;
+  merge_config.total_memory = 800 * 32;
+  merge_config.threads = 3;
+
+  Chain chain(config);
+  chain >> Putter(shuffled);
+  BlockingSort(chain, merge_config, CompareUInt64(), NeverCombine());
+  Stream sorted;
+  chain >> sorted >> kRecycle;
+  for (uint64_t i = 0; i < kSize; ++i, ++sorted) {
+    BOOST_REQUIRE_EQUAL(i, *static_cast<const uint64_t*>(sorted.Get()));
+  }
+  BOOST_CHECK(!sorted);
+}
+
+// Entries of a key and a count; equal keys are combined by adding counts.
+struct AddCounts {
+  bool operator()(void *into, const void *option, const CompareUInt64 &compare) const {
+    if (compare(into, option)) return false;
+    static_cast<uint64_t*>(into)[1] += static_cast<const uint64_t*>(option)[1];
+    return true;
+  }
+};
+
+struct CountPutter {
+  CountPutter(std::vector<uint64_t> &shuffled) : shuffled_(shuffled) {}
+
+  void Run(const ChainPosition &position) {
+    Stream put_shuffled(position);
+    for (uint64_t i = 0; i < shuffled_.size(); ++i, ++put_shuffled) {
+      static_cast<uint64_t*>(put_shuffled.Get())[0] = shuffled_[i];
+      static_cast<uint64_t*>(put_shuffled.Get())[1] = 1;
+    }
+    put_shuffled.Poison();
+  }
+  std::vector<uint64_t> &shuffled_;
+};
+
+BOOST_AUTO_TEST_CASE(ThreadedMergeCombine) {
+  // Each key three times, so that the threads leave padding.
+  std::vector<uint64_t> shuffled;
+  shuffled.reserve(kSize * 3);
+  for (uint64_t i = 0; i < kSize * 3; ++i) {
+    shuffled.push_back(i / 3);
+  }
+  std::random_shuffle(shuffled.begin(), shuffled.end());
+
+  ChainConfig config;
+  config.entry_size = 16;
+  config.total_memory = 1600;
+  config.block_count = 3;
+
+  SortConfig merge_config;
+  merge_config.temp_prefix = "sort_test_temp";
+  merge_config.buffer_size = 1600;
+  merge_config.total_memory = 1600 * 32;
+  merge_config.threads = 3;
+
+  Chain chain(config);
+  chain >> CountPutter(shuffled);
+  BlockingSort(chain, merge_config, CompareUInt64(), AddCounts());
+  Stream sorted;
+  chain >> sorted >> kRecycle;
+  for (uint64_t i = 0; i < kSize; ++i, ++sorted) {
+    BOOST_REQUIRE_EQUAL(i, static_cast<const uint64_t*>(sorted.Get())[0]);
+    BOOST_REQUIRE_EQUAL(3, static_cast<const uint64_t*>(sorted.Get())[1]);
+  }
+  BOOST_CHECK(!sorted);
+}
+
 }}} // namespaces